@@ -4,6 +4,7 @@ from asyncio import IncompleteReadError  # only import the exception class
 import time
 import threading
 import json
+import struct
 
 class SocketStreamReader:
     def __init__(self, sock: socket.socket, default_timeout=1):
@@ -15,12 +16,15 @@ class SocketStreamReader:
     def read(self, num_bytes: int = -1) -> bytes:
         raise NotImplementedError
 
-    def readexactly(self, num_bytes: int) -> bytes:
+    def readexactly(self, num_bytes: int, timeout=None) -> bytes:
+        if timeout is None:
+            timeout = self.default_timeout
         buf = bytearray(num_bytes)
         pos = 0
+        time_limit = time.time() + timeout
         while pos < num_bytes:
             n = self._recv_into(memoryview(buf)[pos:])
-            if n == 0:
+            if n == 0 and time.time() > time_limit:
                 raise IncompleteReadError(bytes(buf[:pos]), num_bytes)
             pos += n
         return bytes(buf)
@@ -65,10 +69,14 @@ class SocketStreamReader:
         if bytes_read == len(view):
             return bytes_read
         try:
-            bytes_read += self._sock.recv_into(view[bytes_read:], 0)
-        except:
-            pass
-        return bytes_read
+            n = self._sock.recv_into(view[bytes_read:], 0)
+        except BlockingIOError:
+            # no data available yet
+            return bytes_read
+        if n == 0:
+            # recv returns 0 only if the GUI closed the connection, no more data will arrive
+            raise ConnectionError("Connection closed by the GUI")
+        return bytes_read + n
 
 class libreVNA:
     def __init__(self, host='localhost', port=19542,
@@ -113,6 +121,19 @@ class libreVNA:
         self.sock.send(b"\n")
         return self.__read_response(timeout=timeout)
 
+    def query_block(self, query, timeout=None):
+        # Reads an IEEE 488.2 definite length block response (see FORMat:DATA) and returns the contained bytes
+        self.sock.sendall(query.encode())
+        self.sock.send(b"\n")
+        header = self.reader.readexactly(2, timeout=timeout)
+        if header[0:1] != b"#" or not header[1:2].isdigit() or header[1:2] == b"0":
+            raise Exception(f"Expected block response but got '{header.decode(errors='replace')}'")
+        length = int(self.reader.readexactly(int(header[1:2]), timeout=timeout))
+        data = self.reader.readexactly(length, timeout=timeout)
+        # remove terminating newline
+        self.reader.readline(timeout=timeout)
+        return data
+
     def get_status(self, timeout=None):
         resp = self.query("*ESR?", timeout=timeout)
         if not re.match(r'^\d+$', resp):
@@ -193,6 +214,13 @@ class libreVNA:
             ret.append((freq, complex(real, imag)))
         return ret
     
+    @staticmethod
+    def parse_VNA_trace_block(data, bits=32, little_endian=False):
+        # converts the block returned by VNA:TRACe:DATA? after FORMat:DATA REAL,<bits>
+        fmt = ("<" if little_endian else ">") + ("f" if bits == 32 else "d")
+        values = [v[0] for v in struct.iter_unpack(fmt, data)]
+        return [(values[i], complex(values[i+1], values[i+2])) for i in range(0, len(values) - 2, 3)]
+
     @staticmethod
     def parse_SA_trace_data(data):
         ret = []
@@ -0,0 +1,38 @@
+#!/usr/bin/env python3
+
+# Measures the VNA point rate reached by a running LibreVNA-GUI. Start the GUI with a simulated device running as
+# fast as possible, once with and once without graphical user interface:
+#   ./LibreVNA-GUI --port 19542 --simulate 0
+#   ./LibreVNA-GUI --port 19542 --simulate 0 --no-gui --lazy-traces
+
+import sys
+import time
+from libreVNA import libreVNA
+
+port = int(sys.argv[1]) if len(sys.argv) > 1 else 19542
+duration = 10
+
+vna = libreVNA('localhost', port)
+vna.cmd(":DEV:CONN SIMULATION")
+if vna.query(":DEV:CONN?") != "SIMULATION":
+    print("Not connected to the simulated device, aborting")
+    exit(-1)
+
+# the sweep configuration of the point rates in the programming guide
+vna.cmd(":DEV:MODE VNA")
+vna.cmd(":VNA:SWEEP FREQUENCY")
+vna.cmd(":VNA:STIM:LVL -10")
+vna.cmd(":VNA:ACQ:IFBW 10000")
+vna.cmd(":VNA:ACQ:AVG 1")
+vna.cmd(":VNA:ACQ:POINTS 1001")
+vna.cmd(":VNA:FREQuency:START 1000000")
+vna.cmd(":VNA:FREQuency:STOP 6000000000")
+vna.cmd(":VNA:ACQ:RUN")
+
+# let the sweep settle before measuring
+time.sleep(2)
+vna.cmd(":DEV:MET:RES")
+time.sleep(duration)
+points = float(vna.query(":DEV:MET:VAL? librevna_vna_points_total"))
+missed = float(vna.query(":DEV:MET:VAL? librevna_vna_points_missed_total"))
+print("Received "+str(round(points / duration))+" points per second ("+str(int(missed))+" points missed)")
@@ -0,0 +1,31 @@
+QT += widgets network
+
+CONFIG += qt console warn_on depend_includepath
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+include(../LibreVNA-GUI/LibreVNA-GUI.pri)
+
+SOURCES +=  \
+    benchmark.cpp \
+    devicebenchmarks.cpp \
+    filebenchmarks.cpp \
+    main.cpp \
+    mathbenchmarks.cpp \
+    processingbenchmarks.cpp \
+    protocolbenchmarks.cpp \
+    renderbenchmarks.cpp
+
+HEADERS += \
+    benchmark.h \
+    devicebenchmarks.h \
+    filebenchmarks.h \
+    mathbenchmarks.h \
+    processingbenchmarks.h \
+    protocolbenchmarks.h \
+    renderbenchmarks.h
+
+# timing results of debug builds are meaningless
+CONFIG -= debug
+CONFIG += release
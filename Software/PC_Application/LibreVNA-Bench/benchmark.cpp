@@ -0,0 +1,109 @@
+#include "benchmark.h"
+
+#include "unit.h"
+
+#include <QElapsedTimer>
+#include <QTextStream>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+BenchmarkRunner::BenchmarkRunner()
+    : batches(10),
+      minBatchTime(0.05)
+{
+
+}
+
+void BenchmarkRunner::add(QString name, double items, QString unit, std::function<void ()> iteration)
+{
+    benchmarks.push_back(Benchmark{name, items, unit, iteration});
+}
+
+QStringList BenchmarkRunner::getNames()
+{
+    QStringList names;
+    for(auto &b : benchmarks) {
+        names.append(b.name);
+    }
+    return names;
+}
+
+nlohmann::json BenchmarkRunner::run()
+{
+    nlohmann::json j;
+    for(auto &b : benchmarks) {
+        if(!filter.match(b.name).hasMatch()) {
+            continue;
+        }
+        j.push_back(run(b));
+    }
+    return j;
+}
+
+nlohmann::json BenchmarkRunner::run(Benchmark &b)
+{
+    QElapsedTimer timer;
+    const double minBatchNs = minBatchTime * 1e9;
+
+    // find the number of iterations per batch, this also serves as warmup
+    quint64 iterations = 1;
+    while(true) {
+        timer.start();
+        for(quint64 i=0;i<iterations;i++) {
+            b.iteration();
+        }
+        double ns = timer.nsecsElapsed();
+        if(ns >= minBatchNs) {
+            break;
+        }
+        auto required = (quint64) ceil(iterations * minBatchNs / max(ns, 1.0));
+        iterations = max(iterations * 2, required);
+    }
+
+    vector<double> nsPerIteration;
+    for(unsigned int i=0;i<batches;i++) {
+        timer.start();
+        for(quint64 n=0;n<iterations;n++) {
+            b.iteration();
+        }
+        nsPerIteration.push_back((double) timer.nsecsElapsed() / iterations);
+    }
+
+    sort(nsPerIteration.begin(), nsPerIteration.end());
+    auto count = nsPerIteration.size();
+    double median = count % 2 ? nsPerIteration[count / 2] : (nsPerIteration[count / 2 - 1] + nsPerIteration[count / 2]) / 2;
+    double mean = 0.0;
+    for(auto ns : nsPerIteration) {
+        mean += ns;
+    }
+    mean /= count;
+    double variance = 0.0;
+    for(auto ns : nsPerIteration) {
+        variance += (ns - mean) * (ns - mean);
+    }
+    double stddev = count > 1 ? sqrt(variance / (count - 1)) : 0.0;
+    double throughput = b.items * 1e9 / median;
+
+    QTextStream(stderr) << b.name.leftJustified(45) << " "
+                        << Unit::ToString(median * 1e-9, "s", "pnum ", 4).rightJustified(10) << " "
+                        << Unit::ToString(throughput, b.unit + "/s", " kMG", 4).rightJustified(20)
+                        << Qt::endl;
+
+    nlohmann::json j;
+    j["name"] = b.name.toStdString();
+    j["items"] = b.items;
+    j["unit"] = b.unit.toStdString();
+    j["batches"] = batches;
+    j["iterations"] = iterations;
+    j["ns_per_iteration"] = {
+        {"min", nsPerIteration.front()},
+        {"median", median},
+        {"mean", mean},
+        {"stddev", stddev},
+    };
+    j["items_per_second"] = throughput;
+    return j;
+}
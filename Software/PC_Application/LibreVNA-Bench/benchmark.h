@@ -0,0 +1,57 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include "json.hpp"
+
+#include <QString>
+#include <QRegularExpression>
+
+#include <functional>
+#include <vector>
+
+/**
+ * @brief BenchmarkRunner
+ *
+ * Collects and runs the benchmarks. A benchmark is a function performing one iteration of the measured
+ * operation on fixed input data. The iteration is repeated in batches which take at least minBatchTime,
+ * several batches are run and their time per iteration is reported (minimum, median, mean and standard
+ * deviation). Batches are sized after a warmup call, so slow and fast benchmarks get comparable accuracy.
+ *
+ * All input data is generated deterministically (fixed seeds, no files from outside the benchmark), the
+ * results of two runs only differ by the timing.
+ */
+class BenchmarkRunner
+{
+public:
+    BenchmarkRunner();
+
+    // items is the number of items (points, bytes, ...) processed by one iteration, unit their name
+    void add(QString name, double items, QString unit, std::function<void(void)> iteration);
+
+    // only benchmarks whose name matches the regular expression are run
+    void setFilter(QString filter) {this->filter = QRegularExpression(filter);}
+    void setBatches(unsigned int batches) {this->batches = batches;}
+    void setMinBatchTime(double seconds) {minBatchTime = seconds;}
+
+    QStringList getNames();
+
+    // Runs all matching benchmarks and prints a summary line for each of them to stderr. Returns the results
+    nlohmann::json run();
+
+private:
+    class Benchmark {
+    public:
+        QString name;
+        double items;
+        QString unit;
+        std::function<void(void)> iteration;
+    };
+    nlohmann::json run(Benchmark &b);
+
+    std::vector<Benchmark> benchmarks;
+    QRegularExpression filter;
+    unsigned int batches;
+    double minBatchTime;
+};
+
+#endif // BENCHMARK_H
@@ -0,0 +1,130 @@
+#include "devicebenchmarks.h"
+
+#include "Device/LibreVNA/librevnasimulator.h"
+#include "Device/LibreVNA/librevnatcpdriver.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+
+#include <memory>
+
+using namespace std;
+
+static constexpr unsigned int points = 1001;
+
+namespace {
+
+// The simulator and the driver connected to it. The simulator listens on fixed ports, all benchmarks share one
+// instance which is only created when the first of them runs
+class SimulatedDevice {
+public:
+    SimulatedDevice()
+        : received(0), blocks(false), halfPrecision(false), sweeping(false)
+    {
+        simulator.setPointsPerSecond(0);
+        if(!simulator.start()) {
+            qFatal("Failed to start the simulator");
+        }
+        driver.GetAvailableDevices();
+        if(!driver.connectDevice("SIMULATION", true)) {
+            qFatal("Failed to connect to the simulator");
+        }
+        waitFor([=](){return driver.supports(DeviceDriver::Feature::VNA);});
+        QObject::connect(&driver, &DeviceDriver::VNAmeasurementReceived, &driver, [=](){
+            received++;
+        });
+    }
+    ~SimulatedDevice() {
+        driver.disconnectDevice();
+        simulator.stop();
+    }
+
+    // Continuous sweep with the given datapoint format, restarted if the format changes
+    void sweep(bool blocks, bool halfPrecision) {
+        if(sweeping && blocks == this->blocks && halfPrecision == this->halfPrecision) {
+            return;
+        }
+        if(sweeping) {
+            // points of the previous format must not be counted
+            driver.setIdle();
+            drain();
+        }
+        for(auto s : driver.driverSpecificSettings()) {
+            if(s.name == "LibreVNATCPDriver.datapointBlocks") {
+                s.var.setValue(blocks);
+            } else if(s.name == "LibreVNATCPDriver.halfPrecision") {
+                s.var.setValue(halfPrecision);
+            }
+        }
+        DeviceDriver::VNASettings s;
+        s.freqStart = 1000000;
+        s.freqStop = 6000000000;
+        s.dBmStart = -10;
+        s.dBmStop = -10;
+        s.IFBW = 10000;
+        s.points = points;
+        s.logSweep = false;
+        s.excitedPorts = {1, 2};
+        if(!driver.setVNA(s)) {
+            qFatal("Failed to start the sweep");
+        }
+        this->blocks = blocks;
+        this->halfPrecision = halfPrecision;
+        sweeping = true;
+    }
+    void receive(unsigned long long n) {
+        auto target = received + n;
+        waitFor([=](){return received >= target;});
+    }
+
+private:
+    void waitFor(std::function<bool(void)> condition) {
+        QElapsedTimer timeout;
+        timeout.start();
+        while(!condition()) {
+            if(timeout.elapsed() > 10000) {
+                qFatal("Timeout while waiting for the simulator");
+            }
+            QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+        }
+    }
+    // processes events until no points have been received for a while
+    void drain() {
+        unsigned long long last;
+        do {
+            last = received;
+            QElapsedTimer t;
+            t.start();
+            while(t.elapsed() < 100) {
+                QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+            }
+        } while(received != last);
+    }
+
+    LibreVNASimulator simulator;
+    LibreVNATCPDriver driver;
+    unsigned long long received;
+    bool blocks, halfPrecision;
+    bool sweeping;
+};
+
+}
+
+void addDeviceBenchmarks(BenchmarkRunner &runner)
+{
+    // The time includes generating the synthetic points in the simulator (the same for all formats) and the
+    // loopback TCP connection, the differences between the formats are the per point overhead of the protocol
+    auto device = make_shared<unique_ptr<SimulatedDevice>>();
+    auto add = [=, &runner](QString name, bool blocks, bool halfPrecision) {
+        runner.add("Device/Simulator/VNA/"+name, points, "points", [=](){
+            if(!*device) {
+                *device = make_unique<SimulatedDevice>();
+            }
+            (*device)->sweep(blocks, halfPrecision);
+            (*device)->receive(points);
+        });
+    };
+    add("VNADatapoint", false, false);
+    add("VNADatapointBlock", true, false);
+    add("VNADatapointBlock/Half", true, true);
+}
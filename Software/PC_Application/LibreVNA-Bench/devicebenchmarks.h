@@ -0,0 +1,9 @@
+#ifndef DEVICEBENCHMARKS_H
+#define DEVICEBENCHMARKS_H
+
+#include "benchmark.h"
+
+// VNA points from the simulated device through the LibreVNA/TCP driver, with the different datapoint formats
+void addDeviceBenchmarks(BenchmarkRunner &runner);
+
+#endif // DEVICEBENCHMARKS_H
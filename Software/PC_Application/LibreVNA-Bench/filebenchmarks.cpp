@@ -0,0 +1,78 @@
+#include "filebenchmarks.h"
+
+#include "touchstone.h"
+#include "csv.h"
+
+#include <QTemporaryDir>
+
+#include <memory>
+#include <random>
+
+using namespace std;
+
+static constexpr unsigned int points = 10001;
+
+void addFileBenchmarks(BenchmarkRunner &runner)
+{
+    // The files are created once and stay cached by the operating system, the benchmarks measure the parsing.
+    // The directory (and the files in it) are removed when the last benchmark using it is destroyed
+    auto dir = make_shared<QTemporaryDir>();
+    if(!dir->isValid()) {
+        qFatal("Failed to create temporary directory");
+    }
+
+    mt19937 rng(1);
+    uniform_real_distribution<double> value(-1.0, 1.0);
+
+    for(unsigned int ports : {1, 2, 4}) {
+        Touchstone t(ports);
+        for(unsigned int i=0;i<points;i++) {
+            Touchstone::Datapoint p;
+            p.frequency = 1000000.0 + i * 600000.0;
+            for(unsigned int j=0;j<ports*ports;j++) {
+                p.S.push_back(complex<double>(value(rng), value(rng)));
+            }
+            t.AddDatapoint(p);
+        }
+        auto filename = dir->filePath("bench.s"+QString::number(ports)+"p").toStdString();
+        t.toFile(QString::fromStdString(filename));
+        auto name = "Touchstone/fromFile/"+QString::number(ports)+"Port";
+        runner.add(name, points, "points", [=](){
+            if(Touchstone::fromFile(filename).points() != points) {
+                qFatal("Failed to parse touchstone file");
+            }
+        });
+        runner.add(name+"/Legacy", points, "points", [=](){
+            Q_UNUSED(dir)
+            if(Touchstone::fromFileLegacy(filename).points() != points) {
+                qFatal("Failed to parse touchstone file");
+            }
+        });
+    }
+
+    // trace export format: frequency and real/imaginary part of four traces
+    CSV csv;
+    vector<double> frequencies;
+    for(unsigned int i=0;i<points;i++) {
+        frequencies.push_back(1000000.0 + i * 600000.0);
+    }
+    csv.addColumn("Frequency", frequencies);
+    for(auto name : {"S11", "S12", "S21", "S22"}) {
+        vector<double> re, im;
+        for(unsigned int i=0;i<points;i++) {
+            re.push_back(value(rng));
+            im.push_back(value(rng));
+        }
+        csv.addColumn(QString(name)+"_real", re);
+        csv.addColumn(QString(name)+"_imag", im);
+    }
+    auto filename = dir->filePath("bench.csv");
+    csv.toFile(filename);
+    runner.add("CSV/fromFile", points, "rows", [=](){
+        Q_UNUSED(dir)
+        auto csv = CSV::fromFile(filename);
+        if(csv.columns() != 9 || csv.getColumn(0).size() != points) {
+            qFatal("Failed to parse CSV file");
+        }
+    });
+}
@@ -0,0 +1,9 @@
+#ifndef FILEBENCHMARKS_H
+#define FILEBENCHMARKS_H
+
+#include "benchmark.h"
+
+// Parsing of Touchstone and CSV files
+void addFileBenchmarks(BenchmarkRunner &runner);
+
+#endif // FILEBENCHMARKS_H
@@ -0,0 +1,94 @@
+#include "benchmark.h"
+#include "protocolbenchmarks.h"
+#include "processingbenchmarks.h"
+#include "mathbenchmarks.h"
+#include "filebenchmarks.h"
+#include "renderbenchmarks.h"
+#include "devicebenchmarks.h"
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QDebug>
+#include <QFile>
+#include <QLoggingCategory>
+#include <QSysInfo>
+#include <QTextStream>
+
+#include <iostream>
+
+int main(int argc, char *argv[])
+{
+    // rendering benchmarks must not depend on an available display
+    if(!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication a(argc, argv);
+    QApplication::setApplicationName("LibreVNA-Bench");
+    // the math threads are chatty, keep the output readable
+    QLoggingCategory::setFilterRules("*.debug=false");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Benchmarks of the LibreVNA-GUI measurement processing. The summary is printed to stderr, "
+                                     "the results are written as JSON to the output file (or stdout)");
+    parser.addHelpOption();
+    parser.addOption(QCommandLineOption({"f","filter"}, "Only run benchmarks whose name matches the regular expression", "regex"));
+    parser.addOption(QCommandLineOption({"o","output"}, "Write the JSON results to this file", "file"));
+    parser.addOption(QCommandLineOption("batches", "Number of timed batches per benchmark (default 10)", "batches"));
+    parser.addOption(QCommandLineOption("min-time", "Minimum duration of one batch in milliseconds (default 50)", "ms"));
+    parser.addOption(QCommandLineOption({"l","list"}, "List all benchmarks and exit"));
+    parser.process(a);
+
+    BenchmarkRunner runner;
+    addProtocolBenchmarks(runner);
+    addProcessingBenchmarks(runner);
+    addMathBenchmarks(runner);
+    addFileBenchmarks(runner);
+    addRenderBenchmarks(runner);
+    addDeviceBenchmarks(runner);
+
+    if(parser.isSet("list")) {
+        for(auto name : runner.getNames()) {
+            QTextStream(stdout) << name << Qt::endl;
+        }
+        return 0;
+    }
+    if(parser.isSet("filter")) {
+        runner.setFilter(parser.value("filter"));
+    }
+    if(parser.isSet("batches")) {
+        runner.setBatches(std::max(parser.value("batches").toUInt(), 1U));
+    }
+    if(parser.isSet("min-time")) {
+        runner.setMinBatchTime(parser.value("min-time").toDouble() / 1000.0);
+    }
+
+    nlohmann::json j;
+    j["commit"] = GITHASH;
+    j["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate).toStdString();
+    j["qt"] = qVersion();
+#ifdef __VERSION__
+    j["compiler"] = __VERSION__;
+#endif
+#ifdef QT_DEBUG
+    j["build"] = "debug";
+#else
+    j["build"] = "release";
+#endif
+    j["os"] = QSysInfo::prettyProductName().toStdString();
+    j["cpu"] = QSysInfo::currentCpuArchitecture().toStdString();
+    j["benchmarks"] = runner.run();
+
+    auto output = j.dump(4);
+    if(parser.isSet("output")) {
+        QFile file(parser.value("output"));
+        if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            qCritical() << "Failed to open output file" << file.fileName();
+            return 1;
+        }
+        file.write(output.c_str());
+    } else {
+        std::cout << output << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,118 @@
+#include "mathbenchmarks.h"
+
+#include "Traces/trace.h"
+#include "Traces/Math/tdr.h"
+#include "Traces/Math/dft.h"
+#include "Traces/Math/timegate.h"
+#include "Traces/Math/medianfilter.h"
+#include "Traces/Math/expression.h"
+#include "preferences.h"
+
+#include <QSemaphore>
+
+#include <memory>
+#include <random>
+
+using namespace std;
+
+static constexpr unsigned int points = 1001;
+// evenly spaced all the way down to DC, as required for the TDR step response
+static constexpr double stepFreq = 6000000;
+
+static shared_ptr<Trace> createTrace()
+{
+    mt19937 rng(1);
+    normal_distribution<double> noise(0.0, 1e-3);
+    auto t = make_shared<Trace>("S11", Qt::darkYellow, "S11");
+    for(unsigned int i=0;i<points;i++) {
+        Trace::Data d;
+        d.x = stepFreq * (i + 1);
+        // two reflections at different distances
+        d.y = 0.3 * exp(complex<double>(0, -2 * M_PI * d.x * 2e-9)) + 0.1 * exp(complex<double>(0, -2 * M_PI * d.x * 5e-9));
+        d.y += complex<double>(noise(rng), noise(rng));
+        t->addData(d, TraceMath::DataType::Frequency);
+    }
+    return t;
+}
+
+// TDR and DFT calculate in their own thread, this waits for the result
+class AsyncMath {
+public:
+    AsyncMath(TraceMath *math, TraceMath *input)
+        : math(math),
+          done(make_shared<QSemaphore>())
+    {
+        auto sem = done;
+        QObject::connect(math, &TraceMath::outputSamplesChanged, [=](){
+            sem->release();
+        });
+        // assigning the input already triggers the first calculation
+        math->assignInput(input);
+        done->acquire();
+    }
+    ~AsyncMath() {
+        delete math;
+    }
+    void calculate() {
+        // drop results of calculations that were not triggered here
+        done->tryAcquire(done->available());
+        math->inputSamplesChanged(0, math->getInput()->numSamples());
+        done->acquire();
+    }
+    TraceMath *get() {return math;}
+
+private:
+    TraceMath *math;
+    shared_ptr<QSemaphore> done;
+};
+
+void addMathBenchmarks(BenchmarkRunner &runner)
+{
+    // the calculation rate of the TDR and DFT must not be limited
+    Preferences::getInstance().Acquisition.limitDFT = false;
+
+    auto trace = createTrace();
+
+    auto tdr = make_shared<AsyncMath>(new Math::TDR(), trace.get());
+    runner.add("Math/TDR/Lowpass", points, "points", [=](){
+        tdr->calculate();
+    });
+
+    auto bandpass = new Math::TDR();
+    bandpass->setMode(Math::TDR::Mode::Bandpass);
+    auto tdrBandpass = make_shared<AsyncMath>(bandpass, trace.get());
+    runner.add("Math/TDR/Bandpass", points, "points", [=](){
+        tdrBandpass->calculate();
+    });
+
+    // time domain data for the remaining operations
+    auto timeDomain = make_shared<AsyncMath>(new Math::TDR(), trace.get());
+    auto timeSamples = timeDomain->get()->numSamples();
+
+    auto dft = make_shared<AsyncMath>(new Math::DFT(), timeDomain->get());
+    runner.add("Math/DFT", timeSamples, "points", [=](){
+        dft->calculate();
+    });
+
+    auto gate = make_shared<Math::TimeGate>();
+    gate->fromJSON({{"center", 2e-9}, {"span", 1e-9}});
+    gate->assignInput(timeDomain->get());
+    runner.add("Math/TimeGate", timeSamples, "points", [=](){
+        // keep the time domain data alive as long as the gate uses it
+        gate->inputSamplesChanged(0, timeDomain->get()->numSamples());
+    });
+
+    auto median = make_shared<Math::MedianFilter>();
+    median->fromJSON({{"kernel", 11}});
+    median->assignInput(trace.get());
+    runner.add("Math/MedianFilter/11", points, "points", [=](){
+        median->inputSamplesChanged(0, trace->numSamples());
+    });
+
+    auto expression = make_shared<Math::Expression>();
+    expression->assignInput(trace.get());
+    expression->fromJSON({{"exp", "x*x+exp(-f/1e9)"}});
+    runner.add("Math/Expression", points, "points", [=](){
+        expression->inputSamplesChanged(0, trace->numSamples());
+    });
+}
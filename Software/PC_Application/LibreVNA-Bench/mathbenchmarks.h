@@ -0,0 +1,9 @@
+#ifndef MATHBENCHMARKS_H
+#define MATHBENCHMARKS_H
+
+#include "benchmark.h"
+
+// Trace math operations (TDR, DFT, time gate, median filter, expression)
+void addMathBenchmarks(BenchmarkRunner &runner);
+
+#endif // MATHBENCHMARKS_H
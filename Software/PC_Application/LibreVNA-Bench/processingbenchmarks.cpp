@@ -0,0 +1,211 @@
+#include "processingbenchmarks.h"
+
+#include "averaging.h"
+#include "Calibration/calibration.h"
+#include "VNA/Deembedding/deembedding.h"
+#include "VNA/Deembedding/deembeddingoption.h"
+#include "Traces/tracemodel.h"
+#include "Traces/trace.h"
+#include "Tools/parameters.h"
+
+#include <memory>
+#include <random>
+
+using namespace std;
+
+static constexpr unsigned int points = 1001;
+static constexpr double startFreq = 1000000;
+static constexpr double stopFreq = 6000000000;
+
+static double frequency(unsigned int point)
+{
+    return startFreq + (stopFreq - startFreq) * point / (points - 1);
+}
+
+// Synthetic DUT: mismatched load at every port, lossy line between all pairs of ports (with some noise)
+static vector<DeviceDriver::VNAMeasurement> createSweep(unsigned int ports, mt19937 &rng)
+{
+    normal_distribution<double> noise(0.0, 1e-3);
+    vector<DeviceDriver::VNAMeasurement> sweep;
+    for(unsigned int i=0;i<points;i++) {
+        DeviceDriver::VNAMeasurement m;
+        m.pointNum = i;
+        m.Z0 = 50.0;
+        m.dBm = -10.0;
+        m.frequency = frequency(i);
+        for(unsigned int src=1;src<=ports;src++) {
+            for(unsigned int rcv=1;rcv<=ports;rcv++) {
+                complex<double> S;
+                if(src == rcv) {
+                    S = 0.2 * exp(complex<double>(0, -2 * M_PI * m.frequency * 1e-9 * src));
+                } else {
+                    S = 0.9 / (1.0 + m.frequency / 6e9) * exp(complex<double>(0, -2 * M_PI * m.frequency * 2e-9));
+                }
+                S += complex<double>(noise(rng), noise(rng));
+                m.measurements["S"+QString::number(rcv)+QString::number(src)] = S;
+            }
+        }
+        sweep.push_back(m);
+    }
+    return sweep;
+}
+
+// Creates a SOLT calibration for the ports from ideal standards with a small error at every port
+static void createCalibration(Calibration &cal, unsigned int ports)
+{
+    auto &kit = cal.getKit();
+    kit.setIdealDefault();
+    map<CalStandard::Type, unsigned long long> standards;
+    for(auto s : kit.getStandards()) {
+        standards[s->getType()] = s->getID();
+    }
+
+    nlohmann::json j;
+    j["format"] = 3;
+    j["type"] = "SOLT";
+    nlohmann::json jports;
+    nlohmann::json jmeasurements;
+    for(unsigned int p=1;p<=ports;p++) {
+        jports.push_back(p);
+        auto reflection = [&](QString type, CalStandard::Type standard, complex<double> ideal) {
+            nlohmann::json jpoints;
+            for(unsigned int i=0;i<points;i++) {
+                // directivity and source match errors of the port
+                auto S = 0.02 * (double) p + ideal * 0.95 / (1.0 - 0.05 * ideal);
+                jpoints.push_back({{"frequency", frequency(i)}, {"real", S.real()}, {"imag", S.imag()}});
+            }
+            nlohmann::json jm;
+            jm["type"] = type.toStdString();
+            jm["data"] = {{"standard", standards[standard]}, {"port", p}, {"points", jpoints}};
+            jmeasurements.push_back(jm);
+        };
+        reflection("Open", CalStandard::Type::Open, 1.0);
+        reflection("Short", CalStandard::Type::Short, -1.0);
+        reflection("Load", CalStandard::Type::Load, 0.0);
+    }
+    for(unsigned int p1=1;p1<=ports;p1++) {
+        for(unsigned int p2=p1+1;p2<=ports;p2++) {
+            nlohmann::json jpoints;
+            for(unsigned int i=0;i<points;i++) {
+                Sparam S(0.02, 0.95, 0.95, 0.02);
+                jpoints.push_back({{"frequency", frequency(i)}, {"Sparam", S.toJSON()}});
+            }
+            nlohmann::json jm;
+            jm["type"] = "Through";
+            jm["data"] = {{"standard", standards[CalStandard::Type::Through]}, {"port1", p1}, {"port2", p2}, {"reverseStandard", false}, {"points", jpoints}};
+            jmeasurements.push_back(jm);
+        }
+    }
+    j["ports"] = jports;
+    j["measurements"] = jmeasurements;
+    cal.fromJSON(j);
+    if(cal.getCaltype().type != Calibration::Type::SOLT) {
+        qFatal("Failed to create the calibration");
+    }
+}
+
+// The de-embedding options only use the trace model while measuring, every chain gets its own empty model
+class DeembeddingChain {
+public:
+    DeembeddingChain() : deembedding(model) {}
+    TraceModel model;
+    Deembedding deembedding;
+};
+
+static DeembeddingOption *createOption(DeembeddingOption::Type type, nlohmann::json j)
+{
+    auto option = DeembeddingOption::create(type);
+    option->fromJSON(j);
+    return option;
+}
+
+void addProcessingBenchmarks(BenchmarkRunner &runner)
+{
+    mt19937 rng(1);
+
+    auto sweep2Port = make_shared<vector<DeviceDriver::VNAMeasurement>>(createSweep(2, rng));
+
+    for(auto mode : {Averaging::Mode::Mean, Averaging::Mode::Median}) {
+        auto avg = make_shared<Averaging>();
+        avg->setMode(mode);
+        avg->reset(points);
+        avg->setAverages(16);
+        // fill the averaging buffers, the benchmark measures the steady state
+        for(unsigned int i=0;i<16;i++) {
+            for(auto &m : *sweep2Port) {
+                avg->process(m);
+            }
+        }
+        QString name = mode == Averaging::Mode::Mean ? "Mean" : "Median";
+        runner.add("Averaging/"+name+"/16", points, "points", [=](){
+            for(auto &m : *sweep2Port) {
+                avg->process(m);
+            }
+        });
+    }
+
+    for(unsigned int ports=1;ports<=4;ports++) {
+        auto cal = make_shared<Calibration>();
+        createCalibration(*cal, ports);
+        auto sweep = make_shared<vector<DeviceDriver::VNAMeasurement>>(createSweep(ports, rng));
+        runner.add("Calibration/correctMeasurement/"+QString::number(ports)+"Port", points, "points", [=](){
+            for(auto m : *sweep) {
+                cal->correctMeasurement(m);
+            }
+        });
+    }
+
+    auto portExtensions = make_shared<DeembeddingChain>();
+    for(unsigned int port=1;port<=2;port++) {
+        portExtensions->deembedding.addOption(createOption(DeembeddingOption::Type::PortExtension, {{"port", port}, {"delay", 1e-9 * port}, {"DCloss", 0.1}, {"loss", 0.5}}));
+    }
+    runner.add("Deembedding/Deembed/PortExtension", points, "points", [=](){
+        for(auto m : *sweep2Port) {
+            portExtensions->deembedding.Deembed(m);
+        }
+    });
+    auto matching = make_shared<DeembeddingChain>();
+    matching->deembedding.addOption(createOption(DeembeddingOption::Type::MatchingNetwork, {{"port", 1}, {"addNetwork", false}, {"network", {
+                                                                            {{"component", "SeriesL"}, {"params", {{"value", 1e-9}}}},
+                                                                            {{"component", "ParallelC"}, {"params", {{"value", 1e-12}}}},
+                                                                        }}}));
+    runner.add("Deembedding/Deembed/MatchingNetwork", points, "points", [=](){
+        for(auto m : *sweep2Port) {
+            matching->deembedding.Deembed(m);
+        }
+    });
+    auto chain = make_shared<DeembeddingChain>();
+    for(unsigned int port=1;port<=2;port++) {
+        chain->deembedding.addOption(createOption(DeembeddingOption::Type::PortExtension, {{"port", port}, {"delay", 1e-9 * port}, {"DCloss", 0.1}, {"loss", 0.5}}));
+    }
+    chain->deembedding.addOption(createOption(DeembeddingOption::Type::MatchingNetwork, {{"port", 2}, {"addNetwork", false}, {"network", {
+                                                                         {{"component", "SeriesR"}, {"params", {{"value", 1.0}}}},
+                                                                         {{"component", "SeriesL"}, {"params", {{"value", 1e-9}}}},
+                                                                         {{"component", "ParallelC"}, {"params", {{"value", 1e-12}}}},
+                                                                     }}}));
+    chain->deembedding.addOption(createOption(DeembeddingOption::Type::ImpedanceRenormalization, {{"impedance", 75.0}}));
+    runner.add("Deembedding/Deembed/Chain", points, "points", [=](){
+        for(auto m : *sweep2Port) {
+            chain->deembedding.Deembed(m);
+        }
+    });
+
+    // everything the application does with a 2 port sweep before plotting it
+    auto sweepAvg = make_shared<Averaging>();
+    sweepAvg->reset(points);
+    sweepAvg->setAverages(4);
+    auto sweepCal = make_shared<Calibration>();
+    createCalibration(*sweepCal, 2);
+    auto sweepModel = make_shared<TraceModel>();
+    for(auto param : {"S11", "S12", "S21", "S22"}) {
+        sweepModel->addTrace(new Trace(param, Qt::darkYellow, param));
+    }
+    runner.add("Sweep/2Port", points, "points", [=](){
+        for(auto m : *sweep2Port) {
+            m = sweepAvg->process(m);
+            sweepCal->correctMeasurement(m);
+            chain->deembedding.Deembed(m);
+            sweepModel->addVNAData(m, TraceMath::DataType::Frequency, false);
+        }
+    });
+}
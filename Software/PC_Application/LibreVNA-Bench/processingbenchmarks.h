@@ -0,0 +1,9 @@
+#ifndef PROCESSINGBENCHMARKS_H
+#define PROCESSINGBENCHMARKS_H
+
+#include "benchmark.h"
+
+// Averaging, calibration and de-embedding of VNA points and the complete processing of a sweep
+void addProcessingBenchmarks(BenchmarkRunner &runner);
+
+#endif // PROCESSINGBENCHMARKS_H
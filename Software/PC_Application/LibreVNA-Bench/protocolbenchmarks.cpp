@@ -0,0 +1,191 @@
+#include "protocolbenchmarks.h"
+
+#include "../../VNA_embedded/Application/Communication/Protocol.hpp"
+
+#include <memory>
+#include <random>
+#include <cmath>
+#include <cstdint>
+
+using namespace std;
+
+static constexpr unsigned int packets = 1000;
+// the benchmark buffers are sized to the exact encoded length, every packet is smaller than this
+static constexpr uint16_t maxPacketSize = 512;
+
+static vector<uint8_t> encode(const vector<Protocol::PacketInfo> &infos, bool datapointCRC = false)
+{
+    vector<uint8_t> encoded;
+    uint8_t buffer[maxPacketSize];
+    for(auto &info : infos) {
+        auto len = Protocol::EncodePacket(info, buffer, sizeof(buffer), datapointCRC);
+        encoded.insert(encoded.end(), buffer, buffer + len);
+    }
+    return encoded;
+}
+
+// Combines the points into as few VNADatapointBlock packets as possible (as the firmware does)
+static vector<uint8_t> encodeBlocks(vector<Protocol::VNADatapoint<32>> &points, uint8_t flags)
+{
+    vector<uint8_t> encoded;
+    uint8_t buffer[maxPacketSize];
+    Protocol::VNADatapointBlock block;
+    block.clear(flags);
+    Protocol::PacketInfo info;
+    info.type = Protocol::PacketType::VNADatapointBlock;
+    info.VNAdatapointBlock = &block;
+    for(unsigned int i=0;i<=points.size();i++) {
+        if(i == points.size() || !block.addPoint(points[i])) {
+            auto len = Protocol::EncodePacket(info, buffer, sizeof(buffer));
+            encoded.insert(encoded.end(), buffer, buffer + len);
+            block.clear(flags);
+            if(i < points.size()) {
+                block.addPoint(points[i]);
+            }
+        }
+    }
+    return encoded;
+}
+
+static unsigned int decode(vector<uint8_t> &encoded)
+{
+    unsigned int decoded = 0;
+    size_t offset = 0;
+    while(offset < encoded.size()) {
+        Protocol::PacketInfo info;
+        auto len = min(encoded.size() - offset, (size_t) UINT16_MAX);
+        auto handled = Protocol::DecodeBuffer(&encoded[offset], len, &info);
+        if(!handled) {
+            break;
+        }
+        offset += handled;
+        if(info.type == Protocol::PacketType::VNADatapoint) {
+            delete info.VNAdatapoint;
+        } else if(info.type == Protocol::PacketType::VNADatapointBlock) {
+            // unpack the points like the driver does
+            Protocol::VNADatapoint<32> point;
+            for(unsigned int i=0;i<info.VNAdatapointBlock->getNumPoints();i++) {
+                info.VNAdatapointBlock->getPoint(i, point);
+            }
+            decoded += info.VNAdatapointBlock->getNumPoints();
+            delete info.VNAdatapointBlock;
+            continue;
+        }
+        if(info.type != Protocol::PacketType::None) {
+            decoded++;
+        }
+    }
+    return decoded;
+}
+
+void addProtocolBenchmarks(BenchmarkRunner &runner)
+{
+    mt19937 rng(1);
+    uniform_real_distribution<float> value(-1.0, 1.0);
+
+    // 2 port VNA points: both receivers and the reference for each of the two stages
+    auto points = make_shared<vector<Protocol::VNADatapoint<32>>>(packets);
+    vector<Protocol::PacketInfo> VNAinfos(packets);
+    for(unsigned int i=0;i<packets;i++) {
+        auto &p = (*points)[i];
+        p.pointNum = i;
+        p.frequency = 1000000 + (uint64_t) i * 6000000;
+        p.cdBm = -1000;
+        for(unsigned int stage=0;stage<2;stage++) {
+            p.addValue(value(rng), value(rng), stage, (int) Protocol::Source::Port1);
+            p.addValue(value(rng), value(rng), stage, (int) Protocol::Source::Port2);
+            p.addValue(value(rng), value(rng), stage, (int) Protocol::Source::Port1 | (int) Protocol::Source::Port2 | (int) Protocol::Source::Reference);
+        }
+        VNAinfos[i].type = Protocol::PacketType::VNADatapoint;
+        VNAinfos[i].VNAdatapoint = &p;
+    }
+
+    auto SAinfos = make_shared<vector<Protocol::PacketInfo>>(packets);
+    for(unsigned int i=0;i<packets;i++) {
+        auto &info = (*SAinfos)[i];
+        info.type = Protocol::PacketType::SpectrumAnalyzerResult;
+        info.spectrumResult = {};
+        info.spectrumResult.pointNum = i;
+        info.spectrumResult.frequency = 1000000 + (uint64_t) i * 6000000;
+        info.spectrumResult.port1 = abs(value(rng));
+        info.spectrumResult.port2 = abs(value(rng));
+    }
+
+    auto VNAencoded = make_shared<vector<uint8_t>>(encode(VNAinfos));
+    auto buffer = make_shared<vector<uint8_t>>(VNAencoded->size());
+    runner.add("Protocol/EncodePacket/VNADatapoint", packets, "packets", [=](){
+        size_t offset = 0;
+        for(auto &p : *points) {
+            Protocol::PacketInfo info;
+            info.type = Protocol::PacketType::VNADatapoint;
+            info.VNAdatapoint = &p;
+            offset += Protocol::EncodePacket(info, &(*buffer)[offset], maxPacketSize);
+        }
+    });
+    runner.add("Protocol/DecodeBuffer/VNADatapoint", packets, "packets", [=](){
+        if(decode(*VNAencoded) != packets) {
+            qFatal("Failed to decode VNA datapoints");
+        }
+    });
+
+    // same datapoints, protected by a CRC
+    auto VNAencodedCRC = make_shared<vector<uint8_t>>(encode(VNAinfos, true));
+    runner.add("Protocol/EncodePacket/VNADatapoint+CRC", packets, "packets", [=](){
+        size_t offset = 0;
+        for(auto &p : *points) {
+            Protocol::PacketInfo info;
+            info.type = Protocol::PacketType::VNADatapoint;
+            info.VNAdatapoint = &p;
+            offset += Protocol::EncodePacket(info, &(*buffer)[offset], maxPacketSize, true);
+        }
+    });
+    runner.add("Protocol/DecodeBuffer/VNADatapoint+CRC", packets, "packets", [=](){
+        if(decode(*VNAencodedCRC) != packets) {
+            qFatal("Failed to decode VNA datapoints with CRC");
+        }
+    });
+
+    // same datapoints, combined into blocks (frequency included and float32 or without frequency and float16).
+    // Counted in points to be comparable with the individual datapoints
+    for(uint8_t flags : {0, Protocol::VNADatapointBlock::HalfPrecision | Protocol::VNADatapointBlock::FrequencyOmitted}) {
+        QString name = flags ? "VNADatapointBlock/Half" : "VNADatapointBlock";
+        runner.add("Protocol/EncodePacket/"+name, packets, "points", [=](){
+            if(encodeBlocks(*points, flags).size() > VNAencoded->size()) {
+                qFatal("Blocks larger than the individual datapoints");
+            }
+        });
+        auto blocksEncoded = make_shared<vector<uint8_t>>(encodeBlocks(*points, flags));
+        runner.add("Protocol/DecodeBuffer/"+name, packets, "points", [=](){
+            if(decode(*blocksEncoded) != packets) {
+                qFatal("Failed to decode VNA datapoint blocks");
+            }
+        });
+    }
+
+    // both CRC implementations over the encoded datapoints
+    auto expectedCRC = Protocol::CRC32Bitwise(0, VNAencoded->data(), VNAencoded->size());
+    runner.add("Protocol/CRC32/Bitwise", VNAencoded->size(), "bytes", [=](){
+        if(Protocol::CRC32Bitwise(0, VNAencoded->data(), VNAencoded->size()) != expectedCRC) {
+            qFatal("Wrong CRC");
+        }
+    });
+    runner.add("Protocol/CRC32/Slicing-by-8", VNAencoded->size(), "bytes", [=](){
+        if(Protocol::CRC32(0, VNAencoded->data(), VNAencoded->size()) != expectedCRC) {
+            qFatal("Wrong CRC");
+        }
+    });
+
+    auto SAencoded = make_shared<vector<uint8_t>>(encode(*SAinfos));
+    auto SAbuffer = make_shared<vector<uint8_t>>(SAencoded->size());
+    runner.add("Protocol/EncodePacket/SpectrumAnalyzerResult", packets, "packets", [=](){
+        size_t offset = 0;
+        for(auto &info : *SAinfos) {
+            offset += Protocol::EncodePacket(info, &(*SAbuffer)[offset], maxPacketSize);
+        }
+    });
+    runner.add("Protocol/DecodeBuffer/SpectrumAnalyzerResult", packets, "packets", [=](){
+        if(decode(*SAencoded) != packets) {
+            qFatal("Failed to decode spectrum analyzer results");
+        }
+    });
+}
@@ -0,0 +1,9 @@
+#ifndef PROTOCOLBENCHMARKS_H
+#define PROTOCOLBENCHMARKS_H
+
+#include "benchmark.h"
+
+// Encoding and decoding of the measurement packets (Protocol::EncodePacket/DecodeBuffer) and the packet CRC
+void addProtocolBenchmarks(BenchmarkRunner &runner);
+
+#endif // PROTOCOLBENCHMARKS_H
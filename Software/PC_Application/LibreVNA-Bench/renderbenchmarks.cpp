@@ -0,0 +1,78 @@
+#include "renderbenchmarks.h"
+
+#include "Traces/tracemodel.h"
+#include "Traces/trace.h"
+#include "Traces/tracexyplot.h"
+#include "Traces/tracesmithchart.h"
+
+#include <QImage>
+
+#include <memory>
+#include <random>
+
+using namespace std;
+
+static constexpr int width = 1280;
+static constexpr int height = 720;
+
+static void addTraces(TraceModel &model, unsigned int points)
+{
+    mt19937 rng(1);
+    normal_distribution<double> noise(0.0, 1e-2);
+    for(auto param : {"S11", "S12", "S21", "S22"}) {
+        bool reflection = param[1] == param[2];
+        auto t = new Trace(param, Qt::darkYellow, param);
+        for(unsigned int i=0;i<points;i++) {
+            Trace::Data d;
+            d.x = 1000000.0 + (6000000000.0 - 1000000.0) * i / (points - 1);
+            auto delay = reflection ? 1e-9 : 2e-9;
+            d.y = (reflection ? 0.2 : 0.9) * exp(complex<double>(0, -2 * M_PI * d.x * delay)) + complex<double>(noise(rng), noise(rng));
+            t->addData(d, TraceMath::DataType::Frequency);
+        }
+        model.addTrace(t);
+    }
+}
+
+template<class Plot>
+static void addRenderBenchmark(BenchmarkRunner &runner, QString name, unsigned int points, std::function<bool(Trace*)> enable)
+{
+    // the plot references the model, both are destroyed together when the benchmark is removed
+    class Context {
+    public:
+        ~Context() {
+            delete plot;
+        }
+        TraceModel model;
+        Plot *plot;
+        QImage image;
+    };
+    auto c = make_shared<Context>();
+    addTraces(c->model, points);
+    c->plot = new Plot(c->model);
+    unsigned int traces = 0;
+    for(auto t : c->model.getTraces()) {
+        if(enable(t)) {
+            c->plot->enableTrace(t, true);
+            traces++;
+        }
+    }
+    c->plot->setAttribute(Qt::WA_DontShowOnScreen);
+    c->plot->resize(width, height);
+    c->plot->show();
+    c->image = QImage(width, height, QImage::Format_ARGB32_Premultiplied);
+    runner.add("Render/"+name+"/"+QString::number(points), traces * points, "points", [=](){
+        c->plot->render(&c->image);
+    });
+}
+
+void addRenderBenchmarks(BenchmarkRunner &runner)
+{
+    for(unsigned int points : {1001, 10001}) {
+        addRenderBenchmark<TraceXYPlot>(runner, "XYPlot", points, [](Trace*) {
+            return true;
+        });
+        addRenderBenchmark<TraceSmithChart>(runner, "SmithChart", points, [](Trace *t) {
+            return t->liveParameter() == "S11" || t->liveParameter() == "S22";
+        });
+    }
+}
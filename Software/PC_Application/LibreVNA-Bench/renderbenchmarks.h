@@ -0,0 +1,9 @@
+#ifndef RENDERBENCHMARKS_H
+#define RENDERBENCHMARKS_H
+
+#include "benchmark.h"
+
+// Offscreen rendering of XY plots and Smith charts
+void addRenderBenchmarks(BenchmarkRunner &runner);
+
+#endif // RENDERBENCHMARKS_H
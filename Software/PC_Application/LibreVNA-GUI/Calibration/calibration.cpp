@@ -4,6 +4,8 @@
 #include "Util/app_common.h"
 #include "unit.h"
 #include "Util/util.h"
+#include "Util/numberformatter.h"
+#include "Util/latencytracer.h"
 #include "LibreCAL/librecaldialog.h"
 
 #include "Eigen/Dense"
@@ -293,6 +295,69 @@ Calibration::Calibration()
         }
         return SCPI::getResultName(SCPI::Result::True);
     }, false));
+    add(new SCPICommand("TERM", nullptr, [=](QStringList params) -> QString {
+        lock_guard<recursive_mutex> guard(access);
+        if(params.size() < 2 || caltype.type == Type::None) {
+            return SCPI::getResultName(SCPI::Result::Error);
+        }
+        // convert port numbers to the index within the used ports
+        auto portIndex = [=](int param, unsigned int &index) -> bool {
+            unsigned long long port;
+            if(!SCPI::paramToULongLong(params, param, port)) {
+                return false;
+            }
+            auto it = find(caltype.usedPorts.begin(), caltype.usedPorts.end(), port);
+            if(it == caltype.usedPorts.end()) {
+                return false;
+            }
+            index = it - caltype.usedPorts.begin();
+            return true;
+        };
+        unsigned int src, rcv = 0;
+        if(!portIndex(1, src)) {
+            return SCPI::getResultName(SCPI::Result::Error);
+        }
+        // one-port terms only need a single port, the two-port terms also need the receiving port
+        std::function<complex<double>(const Point&)> term;
+        auto name = params[0];
+        if(SCPI::match("DIRectivity", name)) {
+            term = [=](const Point &p) {return p.D[src];};
+        } else if(SCPI::match("REFLection", name)) {
+            term = [=](const Point &p) {return p.R[src];};
+        } else if(SCPI::match("SOURce", name)) {
+            term = [=](const Point &p) {return p.S[src];};
+        } else if(params.size() == 3 && portIndex(2, rcv) && rcv != src) {
+            if(SCPI::match("RECeiver", name)) {
+                term = [=](const Point &p) {return p.L[src][rcv];};
+            } else if(SCPI::match("TRANSmission", name)) {
+                term = [=](const Point &p) {return p.T[src][rcv];};
+            } else if(SCPI::match("ISOLation", name)) {
+                term = [=](const Point &p) {return p.I[src][rcv];};
+            }
+        }
+        if(!term) {
+            return SCPI::getResultName(SCPI::Result::Error);
+        }
+        auto scpi = getRoot();
+        if(scpi && scpi->getDataFormat() != SCPI::DataFormat::ASCII) {
+            std::vector<double> values;
+            values.reserve(points.size() * 3);
+            for(auto &p : points) {
+                auto value = term(p);
+                values.push_back(p.frequency);
+                values.push_back(value.real());
+                values.push_back(value.imag());
+            }
+            return scpi->createBlock(values);
+        }
+        NumberFormatter ret(points.size() * 48);
+        for(auto &p : points) {
+            auto value = term(p);
+            ret.add('[').addFixed(p.frequency, 0).add(',').add(value.real()).add(',').add(value.imag()).add("],");
+        }
+        ret.chop();
+        return ret.toString();
+    }));
     add(&kit);
 }
 
@@ -320,6 +385,7 @@ Calibration::Type Calibration::TypeFromString(QString s)
 
 void Calibration::correctMeasurement(DeviceDriver::VNAMeasurement &d)
 {
+    LATENCY_SPAN("Calibration::correctMeasurement", "Processing", d.pointNum);
     lock_guard<recursive_mutex> guard(access);
     if(caltype.type == Type::None) {
         // no calibration active, nothing to do
@@ -1,18 +1,26 @@
 #include "devicepacketlog.h"
 
 #include "preferences.h"
+#include "Util/metrics.h"
 
-#include <exception>
-
-#include <QDateTime>
+#include <algorithm>
+#include <thread>
 
 using namespace std;
 
 DevicePacketLog::DevicePacketLog()
-    : usedStorageSize(0)
+    : head(0),
+      resetPosition(0),
+      enabled(false),
+      excludedTypes(0)
 {
+    for(auto &w : writing) {
+        w = 0;
+    }
     auto &pref = Preferences::getInstance();
-    maxStorageSize = pref.Debug.USBlogSizeLimit;
+    // the size can not change while other threads may be adding entries, changes apply after a restart
+    capacity = max((unsigned long long) (pref.Debug.USBlogSizeLimit / sizeof(uint64_t)), minimumCapacity);
+    applyPreferences();
 }
 
 DevicePacketLog::~DevicePacketLog()
@@ -22,43 +30,51 @@ DevicePacketLog::~DevicePacketLog()
 
 void DevicePacketLog::reset()
 {
-    std::lock_guard<mutex> guard(access);
-    entries.clear();
-    usedStorageSize = 0;
+    resetPosition = head.load();
+}
+
+void DevicePacketLog::addInvalidBytes(const uint8_t *bytes, uint16_t len, QString serial)
+{
+    static auto &decodeErrors = Metrics::getInstance().counter("librevna_decode_errors_total", "Sequences of received bytes that could not be decoded as a packet");
+    static auto &invalidBytes = Metrics::getInstance().counter("librevna_decode_invalid_bytes_total", "Received bytes that could not be decoded as a packet");
+    decodeErrors.increment();
+    invalidBytes.increment(len);
+    if(isEnabled()) {
+        addEntry(LogEntry::Type::InvalidBytes, Protocol::PacketType::None, bytes, len, serial, QDateTime::currentMSecsSinceEpoch());
+    }
+}
+
+void DevicePacketLog::setEnabled(bool enabled)
+{
+    if(enabled) {
+        allocate();
+    }
+    // release: threads seeing the log enabled also see the allocated buffer
+    this->enabled.store(enabled, memory_order_release);
 }
 
-void DevicePacketLog::addPacket(Protocol::PacketInfo &p, QString serial)
+void DevicePacketLog::setExcluded(Protocol::PacketType type, bool excluded)
 {
-    LogEntry e;
-    e.timestamp = QDateTime::currentDateTimeUtc();
-    e.serial = serial;
-    e.type = LogEntry::Type::Packet;
-    e.p = new Protocol::PacketInfo;
-    *e.p = p;
-    if(p.type == Protocol::PacketType::VNADatapoint) {
-        e.datapoint = new Protocol::VNADatapoint<32>(*p.VNAdatapoint);
+    if(excluded) {
+        excludedTypes.fetch_or(typeMask(type));
     } else {
-        e.datapoint = nullptr;
+        excludedTypes.fetch_and(~typeMask(type));
     }
-    addEntry(e);
 }
 
-void DevicePacketLog::addInvalidBytes(const uint8_t *bytes, uint16_t len, QString serial)
+void DevicePacketLog::applyPreferences()
 {
-    LogEntry e;
-    e.timestamp = QDateTime::currentDateTimeUtc();
-    e.serial = serial;
-    e.type = LogEntry::Type::InvalidBytes;
-    while(len--) {
-        e.bytes.push_back(*bytes++);
+    auto &pref = Preferences::getInstance();
+    setEnabled(pref.Debug.USBlogEnabled);
+    for(auto type : {Protocol::PacketType::VNADatapoint, Protocol::PacketType::VNADatapointBlock, Protocol::PacketType::SpectrumAnalyzerResult}) {
+        setExcluded(type, !pref.Debug.USBlogMeasurementData);
     }
-    addEntry(e);
 }
 
 nlohmann::json DevicePacketLog::toJSON()
 {
     nlohmann::json j;
-    for(auto &e : entries) {
+    for(auto &e : getEntries()) {
         j.push_back(e.toJSON());
     }
     return j;
@@ -66,63 +82,268 @@ nlohmann::json DevicePacketLog::toJSON()
 
 void DevicePacketLog::fromJSON(nlohmann::json j)
 {
+    allocate();
     reset();
     for(auto jd : j) {
         LogEntry e;
         e.fromJSON(jd);
-        addEntry(e);
+        addEntry(e.type, e.packetType, e.bytes.data(), e.bytes.size(), e.serial, e.timestamp.toMSecsSinceEpoch());
     }
 }
 
-DevicePacketLog::LogEntry DevicePacketLog::getEntry(unsigned int index)
+std::vector<DevicePacketLog::LogEntry> DevicePacketLog::getEntries()
 {
-    std::lock_guard<mutex> guard(access);
-    if(index < entries.size()) {
-        return entries[index];
-    } else {
-        throw std::runtime_error("Index too high");
-    }
+    unsigned long long position = 0;
+    return getEntries(position);
 }
 
-void DevicePacketLog::addEntry(const DevicePacketLog::LogEntry &e)
+std::vector<DevicePacketLog::LogEntry> DevicePacketLog::getEntries(unsigned long long &position, bool decode)
 {
-    std::lock_guard<mutex> guard(access);
-    usedStorageSize += e.storageSize();
-    while(usedStorageSize > maxStorageSize) {
-        usedStorageSize -= entries.front().storageSize();
-        entries.pop_front();
+    lock_guard<mutex> lock(access);
+    vector<LogEntry> entries;
+    if(!ring) {
+        return entries;
+    }
+    auto end = head.load(memory_order_acquire);
+    auto reset = resetPosition.load();
+    if(position < reset) {
+        // reset() is only called between records, so this is the start of a record
+        position = reset;
+    }
+    if(end > capacity && position < end - capacity) {
+        // the record at position has been overwritten, the start of the oldest remaining record is unknown
+        position = findRecord(max(end - capacity, reset), end);
+    }
+    while(position < end) {
+        entries.emplace_back();
+        auto words = readRecord(position, entries.back(), decode);
+        if(words) {
+            position += words;
+            continue;
+        }
+        entries.pop_back();
+        auto h = head.load();
+        if(h > position + capacity) {
+            // overwritten while reading, skip to the oldest remaining record
+            position = findRecord(h - capacity, h);
+        } else {
+            // not completely written yet, continue here with the next call
+            break;
+        }
     }
-    entries.push_back(e);
-    emit entryAdded(e);
+    return entries;
 }
 
 unsigned long DevicePacketLog::getMaxStorageSize() const
 {
-    return maxStorageSize;
+    return capacity * sizeof(uint64_t);
 }
 
 unsigned long DevicePacketLog::getUsedStorageSize() const
 {
-    return usedStorageSize;
+    return min(head.load() - resetPosition.load(), capacity) * sizeof(uint64_t);
+}
+
+void DevicePacketLog::allocate()
+{
+    lock_guard<mutex> lock(access);
+    if(!ring) {
+        ring = make_unique<atomic<uint64_t>[]>(capacity);
+        for(unsigned long long i=0;i<capacity;i++) {
+            // zero is the stamp of a position that is never reached
+            ring[i].store(0, memory_order_relaxed);
+        }
+    }
+}
+
+void DevicePacketLog::addEntry(LogEntry::Type type, Protocol::PacketType packetType, const uint8_t *bytes, uint16_t len, QString serial, qint64 timestamp)
+{
+    unsigned int serialLength = min((int) serial.size(), 255);
+    unsigned int dataBytes = serialLength * sizeof(char16_t) + len;
+    unsigned long long words = headerWords + (dataBytes + 7) / 8;
+    if(!ring || words > capacity) {
+        return;
+    }
+    auto position = head.fetch_add(words);
+    // readers that see any of the following stores also see the reservation (and detect overwritten records)
+    atomic_thread_fence(memory_order_release);
+    // register as a writer, newer records overlapping this one (after wrapping around) wait until it is complete
+    unsigned int slot = 0;
+    for(unsigned long long expected = 0;!writing[slot].compare_exchange_strong(expected, position + 1);expected = 0) {
+        slot = (slot + 1) % maxWriters;
+        if(slot == 0) {
+            this_thread::yield();
+        }
+    }
+    if(head.load() > position + capacity) {
+        // Other threads already went around the whole buffer while this thread was suspended, the reserved words
+        // belong to newer records and must not be written anymore
+        writing[slot].store(0, memory_order_release);
+        return;
+    }
+    // A writer that fell a whole lap behind may still be writing into the reserved words. It registered before
+    // checking for newer reservations above, so it is visible here. Wait for it, otherwise its stale words would
+    // end up in this record
+    for(unsigned int i=0;i<maxWriters;i++) {
+        unsigned long long other;
+        while((other = writing[i].load()) && other - 1 + capacity < position + words) {
+            this_thread::yield();
+        }
+    }
+    word(position + 1).store(len | serialLength << 16 | (uint64_t) type << 24 | (uint64_t) packetType << 32, memory_order_relaxed);
+    word(position + 2).store(timestamp, memory_order_relaxed);
+
+    auto next = position + headerWords;
+    uint64_t w = 0;
+    unsigned int shift = 0;
+    auto append = [&](uint8_t b) {
+        w |= (uint64_t) b << shift;
+        shift += 8;
+        if(shift == 64) {
+            word(next++).store(w, memory_order_relaxed);
+            w = 0;
+            shift = 0;
+        }
+    };
+    for(unsigned int i=0;i<serialLength;i++) {
+        auto c = serial.at(i).unicode();
+        append(c & 0xFF);
+        append(c >> 8);
+    }
+    for(unsigned int i=0;i<len;i++) {
+        append(bytes[i]);
+    }
+    if(shift) {
+        word(next).store(w, memory_order_relaxed);
+    }
+    // the record is complete
+    word(position).store(stamp(position), memory_order_release);
+    writing[slot].store(0, memory_order_release);
+}
+
+unsigned long long DevicePacketLog::findRecord(unsigned long long position, unsigned long long end) const
+{
+    for(;position<end;position++) {
+        if(word(position).load(memory_order_acquire) != stamp(position)) {
+            continue;
+        }
+        // a payload word might coincidentally look like a stamp, check that the header is plausible
+        auto header = word(position + 1).load(memory_order_relaxed);
+        unsigned int dataBytes = (header & 0xFFFF) + ((header >> 16) & 0xFF) * sizeof(char16_t);
+        if(((header >> 24) & 0xFF) <= (uint64_t) LogEntry::Type::InvalidBytes && position + headerWords + (dataBytes + 7) / 8 <= end) {
+            return position;
+        }
+    }
+    return end;
+}
+
+unsigned int DevicePacketLog::readRecord(unsigned long long position, LogEntry &e, bool decode) const
+{
+    if(word(position).load(memory_order_acquire) != stamp(position)) {
+        return 0;
+    }
+    auto header = word(position + 1).load(memory_order_relaxed);
+    auto timestamp = (qint64) word(position + 2).load(memory_order_relaxed);
+    unsigned int len = header & 0xFFFF;
+    unsigned int serialLength = (header >> 16) & 0xFF;
+    auto type = (header >> 24) & 0xFF;
+    unsigned int dataBytes = serialLength * sizeof(char16_t) + len;
+    unsigned int words = headerWords + (dataBytes + 7) / 8;
+
+    vector<uint8_t> data;
+    data.reserve(dataBytes);
+    for(auto next = position + headerWords; data.size() < dataBytes; next++) {
+        auto w = word(next).load(memory_order_relaxed);
+        for(unsigned int i=0;i<8 && data.size() < dataBytes;i++) {
+            data.push_back(w >> (8 * i));
+        }
+    }
+    // if any of the words has been overwritten, the new reservation is visible after this fence
+    atomic_thread_fence(memory_order_acquire);
+    if(head.load(memory_order_relaxed) > position + capacity || type > (uint64_t) LogEntry::Type::InvalidBytes) {
+        return 0;
+    }
+
+    e.type = (LogEntry::Type) type;
+    e.packetType = (Protocol::PacketType) ((header >> 32) & 0xFF);
+    e.timestamp = QDateTime::fromMSecsSinceEpoch(timestamp, Qt::TimeSpec::UTC);
+    e.serial.clear();
+    for(unsigned int i=0;i<serialLength;i++) {
+        e.serial.append(QChar((ushort) (data[2*i] | data[2*i+1] << 8)));
+    }
+    e.bytes.assign(data.begin() + serialLength * sizeof(char16_t), data.end());
+    if(e.type == LogEntry::Type::Packet && decode) {
+        e.decode();
+    }
+    return words;
 }
 
 DevicePacketLog::LogEntry::LogEntry(const DevicePacketLog::LogEntry &e)
+    : p(nullptr), datapoint(nullptr), datapointBlock(nullptr)
 {
+    *this = e;
+}
+
+DevicePacketLog::LogEntry &DevicePacketLog::LogEntry::operator=(const DevicePacketLog::LogEntry &e)
+{
+    if(this == &e) {
+        return *this;
+    }
     timestamp = e.timestamp;
     type = e.type;
+    packetType = e.packetType;
     serial = e.serial;
     bytes = e.bytes;
+    delete p;
+    delete datapoint;
+    delete datapointBlock;
+    p = nullptr;
+    datapoint = nullptr;
+    datapointBlock = nullptr;
     if(e.p) {
         p = new Protocol::PacketInfo;
         *p = *e.p;
-        if(p->type == Protocol::PacketType::VNADatapoint) {
+        if(p->type == Protocol::PacketType::VNADatapoint && e.datapoint) {
             datapoint = new Protocol::VNADatapoint<32>(*e.datapoint);
-        } else {
-            datapoint = nullptr;
+            p->VNAdatapoint = datapoint;
+        } else if(p->type == Protocol::PacketType::VNADatapointBlock && e.datapointBlock) {
+            datapointBlock = new Protocol::VNADatapointBlock(*e.datapointBlock);
+            p->VNAdatapointBlock = datapointBlock;
         }
-    } else {
-        datapoint = nullptr;
-        p = nullptr;
+    }
+    return *this;
+}
+
+void DevicePacketLog::LogEntry::decode()
+{
+    delete p;
+    delete datapoint;
+    delete datapointBlock;
+    p = nullptr;
+    datapoint = nullptr;
+    datapointBlock = nullptr;
+    // DecodeBuffer needs a modifiable buffer
+    auto buf = bytes;
+    Protocol::PacketInfo info;
+    unsigned int offset = 0;
+    while(offset < buf.size()) {
+        auto handled = Protocol::DecodeBuffer(buf.data() + offset, buf.size() - offset, &info);
+        if(info.type != Protocol::PacketType::None) {
+            p = new Protocol::PacketInfo;
+            *p = info;
+            if(info.type == Protocol::PacketType::VNADatapoint) {
+                // DecodeBuffer allocated the datapoint, it belongs to this entry now
+                datapoint = info.VNAdatapoint;
+            } else if(info.type == Protocol::PacketType::VNADatapointBlock) {
+                datapointBlock = info.VNAdatapointBlock;
+            }
+            return;
+        }
+        if(!handled) {
+            // incomplete packet
+            return;
+        }
+        offset += handled;
     }
 }
 
@@ -134,8 +355,12 @@ nlohmann::json DevicePacketLog::LogEntry::toJSON()
     j["serial"] = serial.toStdString();
     nlohmann::json jdata;
     if(type == Type::Packet) {
+        Protocol::PacketInfo info = {};
+        if(p) {
+            info = *p;
+        }
         for(unsigned int i=0;i<sizeof(Protocol::PacketInfo);i++) {
-            jdata.push_back(*(((uint8_t*) p) + i));
+            jdata.push_back(*(((uint8_t*) &info) + i));
         }
         if(datapoint) {
             nlohmann::json jdatapoint;
@@ -144,6 +369,12 @@ nlohmann::json DevicePacketLog::LogEntry::toJSON()
             }
             j["datapoint"] = jdatapoint;
         }
+        if(datapointBlock) {
+            // the payload of the block (without the packet framing)
+            std::vector<uint8_t> block(datapointBlock->requiredBufferSize());
+            datapointBlock->encode(block.data(), block.size());
+            j["datapointBlock"] = block;
+        }
     } else {
         for(auto b : bytes) {
             jdata.push_back(b);
@@ -158,14 +389,21 @@ void DevicePacketLog::LogEntry::fromJSON(nlohmann::json j)
     type = QString::fromStdString(j.value("type", "")) == "Packet" ? Type::Packet : Type::InvalidBytes;
     timestamp = QDateTime::fromMSecsSinceEpoch(j.value("timestamp", 0ULL), Qt::TimeSpec::UTC);
     serial = QString::fromStdString(j.value("serial", ""));
+    packetType = Protocol::PacketType::None;
+    delete p;
+    delete datapoint;
+    delete datapointBlock;
     datapoint = nullptr;
+    datapointBlock = nullptr;
     p = nullptr;
+    bytes.clear();
     if(type == Type::Packet) {
         p = new Protocol::PacketInfo;
         auto jdata = j["data"];
         for(unsigned int i=0;i<sizeof(Protocol::PacketInfo);i++) {
             *(((uint8_t*) p) + i) = jdata[i];
         }
+        packetType = p->type;
         if(j.contains("datapoint")) {
             datapoint = new Protocol::VNADatapoint<32>();
             auto jdatapoint = j["datapoint"];
@@ -173,6 +411,31 @@ void DevicePacketLog::LogEntry::fromJSON(nlohmann::json j)
                 *(((uint8_t*) datapoint) + i) = jdatapoint[i];
             }
         }
+        if(p->type == Protocol::PacketType::VNADatapoint) {
+            // the stored pointer is meaningless
+            p->VNAdatapoint = datapoint;
+            if(!datapoint) {
+                return;
+            }
+        } else if(p->type == Protocol::PacketType::VNADatapointBlock) {
+            p->VNAdatapointBlock = nullptr;
+            if(j.contains("datapointBlock")) {
+                auto block = j["datapointBlock"].get<std::vector<uint8_t>>();
+                datapointBlock = new Protocol::VNADatapointBlock();
+                if(!datapointBlock->decode(block.data(), block.size())) {
+                    delete datapointBlock;
+                    datapointBlock = nullptr;
+                }
+            }
+            p->VNAdatapointBlock = datapointBlock;
+            if(!datapointBlock) {
+                return;
+            }
+        }
+        // the log stores the encoded packet
+        uint8_t buffer[1024];
+        auto length = Protocol::EncodePacket(*p, buffer, sizeof(buffer));
+        bytes.assign(buffer, buffer + length);
     } else {
         for(auto v : j["data"]) {
             bytes.push_back(v);
@@ -5,12 +5,23 @@
 
 #include "savable.h"
 
-#include <deque>
 #include <cstdint>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
 #include <QDateTime>
 #include <QObject>
-#include <mutex>
 
+/*
+ * Log of all packets exchanged with the devices.
+ *
+ * The raw bytes of the packets are stored in a ring buffer of fixed size (Debug.USBlogSizeLimit, allocated when the
+ * log is enabled for the first time). Adding an entry is lock-free and can be done from any thread, once the buffer
+ * is full the oldest entries are overwritten. Packets are only decoded when the entries are read.
+ *
+ * A disabled log and packets of excluded types cost one atomic load per packet.
+ */
 class DevicePacketLog : public QObject, public Savable
 {
     Q_OBJECT
@@ -22,71 +33,126 @@ public:
     DevicePacketLog(const DevicePacketLog&) = delete;
     virtual ~DevicePacketLog();
 
-    void reset();
-
-    void addPacket(Protocol::PacketInfo &p, QString serial = "");
-    void addInvalidBytes(const uint8_t *bytes, uint16_t len, QString serial = "");
-
-    virtual nlohmann::json toJSON() override;
-    virtual void fromJSON(nlohmann::json j) override;
-
-
     class LogEntry : public Savable {
     public:
         LogEntry()
-            : type(Type::InvalidBytes), timestamp(QDateTime()), serial(""), p(nullptr), datapoint(nullptr) {}
+            : type(Type::InvalidBytes), packetType(Protocol::PacketType::None), timestamp(QDateTime()), serial(""), p(nullptr), datapoint(nullptr), datapointBlock(nullptr) {}
         ~LogEntry() {
             delete p;
             delete datapoint;
+            delete datapointBlock;
         }
 
         LogEntry(const LogEntry &e);
+        LogEntry &operator=(const LogEntry &e);
 
         enum class Type {
             Packet,
             InvalidBytes,
         };
         Type type;
+        // available without decoding the packet
+        Protocol::PacketType packetType;
         QDateTime timestamp;
         QString serial;
+        // the raw bytes as they were received/transmitted (for packets, the encoded packet)
         std::vector<uint8_t> bytes;
+        // decoded packet, only set for packets
         Protocol::PacketInfo *p;
         Protocol::VNADatapoint<32> *datapoint;
-        unsigned int storageSize() const {
-            unsigned long size = sizeof(type) + sizeof(timestamp) + serial.size();
-            switch(type) {
-            case Type::InvalidBytes: size += bytes.size(); break;
-            case Type::Packet:
-                size += sizeof(Protocol::PacketInfo);
-                if(p && p->type == Protocol::PacketType::VNADatapoint) {
-                    size += sizeof(Protocol::VNADatapoint<32>);
-                }
-                break;
-            }
-            return size;
-        }
+        Protocol::VNADatapointBlock *datapointBlock;
+
+        // Sets p and datapoint/datapointBlock from the raw bytes
+        void decode();
 
         virtual nlohmann::json toJSON() override;
         virtual void fromJSON(nlohmann::json j) override;
     };
 
-    LogEntry getEntry(unsigned int index);
+    void reset();
+
+    // Logs an encoded packet. Bytes in front of the packet are allowed, they are skipped when the packet is decoded
+    void addPacket(Protocol::PacketType type, const uint8_t *bytes, uint16_t len, QString serial = "") {
+        if(isLogged(type)) {
+            addEntry(LogEntry::Type::Packet, type, bytes, len, serial, QDateTime::currentMSecsSinceEpoch());
+        }
+    }
+    void addInvalidBytes(const uint8_t *bytes, uint16_t len, QString serial = "");
+
+    bool isEnabled() const {return enabled.load(std::memory_order_acquire);}
+    void setEnabled(bool enabled);
+    // Packets of excluded types are not added to the log
+    void setExcluded(Protocol::PacketType type, bool excluded);
+    bool isExcluded(Protocol::PacketType type) const {
+        return excludedTypes.load(std::memory_order_relaxed) & typeMask(type);
+    }
+    bool isLogged(Protocol::PacketType type) const {
+        return isEnabled() && !isExcluded(type);
+    }
+    // Takes over the enabled state and the excluded types from the preferences
+    void applyPreferences();
+
+    virtual nlohmann::json toJSON() override;
+    virtual void fromJSON(nlohmann::json j) override;
+
+    // Returns all entries that are still contained in the log (oldest entry first)
+    std::vector<LogEntry> getEntries();
+    // Returns the entries added since the last call with the same position variable (start with position = 0).
+    // Entries that have been overwritten in the meantime are skipped. Without decoding, only the raw bytes and the
+    // packet type are set, call LogEntry::decode() when the content is needed.
+    std::vector<LogEntry> getEntries(unsigned long long &position, bool decode = true);
 
     unsigned long getUsedStorageSize() const;
     unsigned long getMaxStorageSize() const;
 
-signals:
-    void entryAdded(const LogEntry &e);
-
 private:
     DevicePacketLog();
 
-    void addEntry(const LogEntry &e);
+    static uint64_t typeMask(Protocol::PacketType type) {
+        return 1ULL << ((unsigned int) type & 0x3F);
+    }
 
-    unsigned long maxStorageSize;
-    unsigned long usedStorageSize;
-    std::deque<LogEntry> entries;
+    // stamp, header and timestamp
+    static constexpr unsigned int headerWords = 3;
+    // the buffer must be able to hold any record
+    static constexpr unsigned long long minimumCapacity = 16384;
+
+    void allocate();
+    void addEntry(LogEntry::Type type, Protocol::PacketType packetType, const uint8_t *bytes, uint16_t len, QString serial, qint64 timestamp);
+    // Returns the position of the first record at or after position (but before end) or end if there is none
+    unsigned long long findRecord(unsigned long long position, unsigned long long end) const;
+    // Copies the record at position into e, returns the size of the record in words or zero if the record is not
+    // available (not completely written yet or already overwritten)
+    unsigned int readRecord(unsigned long long position, LogEntry &e, bool decode) const;
+    uint64_t stamp(unsigned long long position) const {
+        return position ^ 0x4C4F475245434F52ULL;
+    }
+    std::atomic<uint64_t> &word(unsigned long long position) const {
+        return ring[position % capacity];
+    }
 
+    /*
+     * The ring buffer consists of 64 bit words, all positions are counted in words since the creation of the log.
+     * Every record starts with a stamp (derived from its position), followed by a header word, the timestamp, the
+     * serial (UTF-16) and the raw bytes. The stamp is written last to mark the record as complete.
+     */
+    std::unique_ptr<std::atomic<uint64_t>[]> ring;
+    unsigned long long capacity;
+    // end of the last reserved record
+    std::atomic<unsigned long long> head;
+    // records before this position have been removed by reset()
+    std::atomic<unsigned long long> resetPosition;
+
+    std::atomic<bool> enabled;
+    // one bit per packet type
+    std::atomic<uint64_t> excludedTypes;
+
+    // reservations (position + 1) of the records that are currently being written, zero marks a free slot
+    static constexpr unsigned int maxWriters = 16;
+    std::atomic<unsigned long long> writing[maxWriters];
+
+    // serializes the allocation and the readers, adding entries does not lock (but may wait for writers that
+    // fell behind by a whole lap, see addEntry())
     std::mutex access;
 };
 
@@ -6,6 +6,7 @@
 
 #include <fstream>
 #include <iomanip>
+#include <algorithm>
 
 #include <QPushButton>
 #include <QFileDialog>
@@ -15,105 +16,291 @@
 
 using namespace std;
 
-DevicePacketLogView::DevicePacketLogView(QWidget *parent) :
-    QDialog(parent),
-    ui(new Ui::DevicePacketLogView)
+DevicePacketLogModel::DevicePacketLogModel(QObject *parent)
+    : QAbstractItemModel(parent),
+      firstEntry(0),
+      logPosition(0),
+      filter(this)
 {
-    setAttribute(Qt::WA_DeleteOnClose);
-    ui->setupUi(this);
+    connect(&updateTimer, &QTimer::timeout, this, &DevicePacketLogModel::update);
+    updateTimer.start(updateInterval);
+    update();
+}
 
-//    connect(&log, &DeviceUSBLog::entryAdded, this, &DeviceUSBLogView::addEntry);
-    connect(ui->buttonBox->button(QDialogButtonBox::Reset), &QPushButton::clicked, [=](){
-        DevicePacketLog::getInstance().reset();
-        updateTree();
-    });
-    connect(ui->buttonBox->button(QDialogButtonBox::Save), &QPushButton::clicked, [=](){
-        QString filename = QFileDialog::getSaveFileName(nullptr, "Load LibreVNA log data", "", "LibreVNA log files (*.vnalog)", nullptr, QFileDialog::DontUseNativeDialog);
-        if(filename.isEmpty()) {
-            // aborted selection
-            return;
-        }
-        if(!filename.endsWith(".vnalog")) {
-            filename.append(".vnalog");
+DevicePacketLogModel::~DevicePacketLogModel()
+{
+    filter.cancel();
+}
+
+QModelIndex DevicePacketLogModel::index(int row, int column, const QModelIndex &parent) const
+{
+    if(!hasIndex(row, column, parent)) {
+        return QModelIndex();
+    }
+    if(!parent.isValid()) {
+        // top level items (log entries) have no internal pointer
+        return createIndex(row, column, nullptr);
+    }
+    return createIndex(row, column, item(parent)->child(row));
+}
+
+QModelIndex DevicePacketLogModel::parent(const QModelIndex &child) const
+{
+    if(!child.isValid() || !child.internalPointer()) {
+        return QModelIndex();
+    }
+    auto parentItem = static_cast<QTreeWidgetItem*>(child.internalPointer())->parent();
+    if(parentItem->parent()) {
+        return createIndex(parentItem->parent()->indexOfChild(parentItem), 0, parentItem);
+    }
+    // the parent is the log entry itself
+    auto n = parentItem->data(0, Qt::UserRole).toULongLong();
+    auto it = lower_bound(visible.begin(), visible.end(), n);
+    if(it == visible.end() || *it != n) {
+        return QModelIndex();
+    }
+    return createIndex(it - visible.begin(), 0, nullptr);
+}
+
+int DevicePacketLogModel::rowCount(const QModelIndex &parent) const
+{
+    if(!parent.isValid()) {
+        return visible.size();
+    }
+    if(parent.column() > 0) {
+        return 0;
+    }
+    return item(parent)->childCount();
+}
+
+int DevicePacketLogModel::columnCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent)
+    return 4;
+}
+
+bool DevicePacketLogModel::hasChildren(const QModelIndex &parent) const
+{
+    if(!parent.isValid()) {
+        return !visible.empty();
+    }
+    if(parent.column() > 0) {
+        return false;
+    }
+    if(!parent.internalPointer()) {
+        // decide without decoding the packet
+        return !entry(parent.row()).bytes.empty();
+    }
+    return item(parent)->childCount() > 0;
+}
+
+QVariant DevicePacketLogModel::data(const QModelIndex &index, int role) const
+{
+    if(!index.isValid() || role != Qt::DisplayRole) {
+        return QVariant();
+    }
+    if(index.internalPointer()) {
+        return static_cast<QTreeWidgetItem*>(index.internalPointer())->data(index.column(), role);
+    }
+    auto &e = entry(index.row());
+    switch(index.column()) {
+    case 0: return e.timestamp.toString(Qt::DateFormat::ISODateWithMs);
+    case 1: return e.serial.size() > 0 ? e.serial : "LibreVNA-GUI";
+    case 2: return e.type == DevicePacketLog::LogEntry::Type::Packet ? "Packet" : "Invalid bytes";
+    case 3:
+        if(e.type == DevicePacketLog::LogEntry::Type::Packet) {
+            return "Type "+QString::number((int)e.packetType)+"("+packetName(e.packetType)+")";
+        } else {
+            return QString::number(e.bytes.size())+ " bytes";
         }
-        ofstream file;
-        file.open(filename.toStdString());
-        file << setw(1) << DevicePacketLog::getInstance().toJSON() << endl;
-        file.close();
-    });
-    connect(ui->buttonBox->button(QDialogButtonBox::Open), &QPushButton::clicked, [=](){
-        QString filename = QFileDialog::getOpenFileName(nullptr, "Load LibreVNA log data", "", "LibreVNA log files (*.vnalog)", nullptr, QFileDialog::DontUseNativeDialog);
-        if(filename.isEmpty()) {
-            // aborted selection
-            return;
+    }
+    return QVariant();
+}
+
+QVariant DevicePacketLogModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if(orientation == Qt::Horizontal && role == Qt::DisplayRole) {
+        static const QStringList headers = {"Timestamp","Source","Type","Content"};
+        return headers.value(section);
+    }
+    return QVariant();
+}
+
+void DevicePacketLogModel::clear()
+{
+    filter.cancel();
+    beginResetModel();
+    firstEntry += entries.size();
+    entries.clear();
+    visible.clear();
+    details.clear();
+    endResetModel();
+    emit entriesChanged();
+}
+
+void DevicePacketLogModel::reload()
+{
+    clear();
+    logPosition = 0;
+    update();
+}
+
+void DevicePacketLogModel::setFilter(QString text)
+{
+    filterText = text;
+    if(text.isEmpty()) {
+        filter.cancel();
+        beginResetModel();
+        visible.resize(entries.size());
+        for(unsigned int i=0;i<entries.size();i++) {
+            visible[i] = firstEntry + i;
         }
-        ifstream file;
-        file.open(filename.toStdString());
-        if(!file.is_open()) {
-            qWarning() << "Unable to open file:" << filename;
-            return;
+        endResetModel();
+        emit entriesChanged();
+        return;
+    }
+    // only the fields needed for matching are copied (the serial is implicitly shared), the
+    // strings are built by the filter thread
+    class Key {
+    public:
+        QString serial;
+        DevicePacketLog::LogEntry::Type type;
+        Protocol::PacketType packetType;
+    };
+    auto snapshot = make_shared<vector<Key>>();
+    snapshot->reserve(entries.size());
+    for(auto &e : entries) {
+        snapshot->push_back({e.serial, e.type, e.packetType});
+    }
+    auto snapshotEnd = firstEntry + entries.size();
+    auto snapshotFirst = firstEntry;
+    filter.start(snapshot->size(), [=](unsigned int row) {
+        auto &k = (*snapshot)[row];
+        return matchesText(k.serial, k.type, k.packetType, text);
+    }, [=](vector<unsigned int> matching) {
+        // entries may have been added or removed while filtering
+        beginResetModel();
+        visible.clear();
+        for(auto m : matching) {
+            if(snapshotFirst + m >= firstEntry) {
+                visible.push_back(snapshotFirst + m);
+            }
         }
-        nlohmann::json j;
-        try {
-            // TODO this can take a long time, move to thread
-            file >> j;
-        } catch (exception &e) {
-            InformationBox::ShowError("Error", "Failed to parse the USB log file (" + QString(e.what()) + ")");
-            qWarning() << "Parsing of USB log file failed: " << e.what();
-            file.close();
-            return;
+        for(auto n = max(snapshotEnd, firstEntry);n < firstEntry + entries.size();n++) {
+            if(matches(entries[n - firstEntry])) {
+                visible.push_back(n);
+            }
         }
-        file.close();
-        DevicePacketLog::getInstance().fromJSON(j);
-        updateTree();
+        endResetModel();
+        emit entriesChanged();
     });
+}
 
-    updateTree();
+void DevicePacketLogModel::update()
+{
+    auto added = DevicePacketLog::getInstance().getEntries(logPosition, false);
+    if(added.empty()) {
+        return;
+    }
+    auto first = firstEntry + entries.size();
+    unsigned int matching = 0;
+    for(auto &e : added) {
+        if(matches(e)) {
+            matching++;
+        }
+        entries.push_back(std::move(e));
+    }
+    if(matching) {
+        beginInsertRows(QModelIndex(), visible.size(), visible.size() + matching - 1);
+        for(auto n = first;n < firstEntry + entries.size();n++) {
+            if(matches(entries[n - firstEntry])) {
+                visible.push_back(n);
+            }
+        }
+        endInsertRows();
+    }
+    trim();
+    emit entriesChanged();
 }
 
-DevicePacketLogView::~DevicePacketLogView()
+void DevicePacketLogModel::trim()
 {
-    delete ui;
+    if(entries.size() <= maxEntries) {
+        return;
+    }
+    auto remove = entries.size() - maxEntries;
+    unsigned int removedRows = 0;
+    while(removedRows < visible.size() && visible[removedRows] < firstEntry + remove) {
+        removedRows++;
+    }
+    if(removedRows) {
+        beginRemoveRows(QModelIndex(), 0, removedRows - 1);
+        visible.erase(visible.begin(), visible.begin() + removedRows);
+    }
+    entries.erase(entries.begin(), entries.begin() + remove);
+    firstEntry += remove;
+    details.erase(details.begin(), details.lower_bound(firstEntry));
+    if(removedRows) {
+        endRemoveRows();
+    }
 }
 
-void DevicePacketLogView::updateTree()
+bool DevicePacketLogModel::matches(const DevicePacketLog::LogEntry &e) const
 {
-    auto &log = DevicePacketLog::getInstance();
+    if(filterText.isEmpty()) {
+        return true;
+    }
+    return matchesText(e.serial, e.type, e.packetType, filterText);
+}
 
-    ui->tree->clear();
-    ui->tree->setColumnCount(4);
-    ui->tree->setHeaderLabels({"Timestamp","Source","Type","Content"});
+bool DevicePacketLogModel::matchesText(const QString &serial, DevicePacketLog::LogEntry::Type type, Protocol::PacketType packetType, const QString &text)
+{
+    QString source = serial.size() > 0 ? serial : "LibreVNA-GUI";
+    QString typeName = type == DevicePacketLog::LogEntry::Type::Packet ? "Packet" : "Invalid bytes";
+    QString content = type == DevicePacketLog::LogEntry::Type::Packet ? packetName(packetType) : "";
+    return source.contains(text, Qt::CaseInsensitive) || typeName.contains(text, Qt::CaseInsensitive)
+            || content.contains(text, Qt::CaseInsensitive);
+}
 
-    unsigned int i=0;
-    try {
-        // will throw once all entries have been added (number of entries may change while the loop is running)
-        for(i=0;;i++) {
-            addEntry(log.getEntry(i));
-        }
-    } catch (...) {
+const DevicePacketLog::LogEntry &DevicePacketLogModel::entry(int row) const
+{
+    return entries[visible[row] - firstEntry];
+}
+
+QTreeWidgetItem *DevicePacketLogModel::item(const QModelIndex &index) const
+{
+    if(index.internalPointer()) {
+        return static_cast<QTreeWidgetItem*>(index.internalPointer());
     }
+    auto n = visible[index.row()];
+    auto it = details.find(n);
+    if(it == details.end()) {
+        auto root = createDetails(entries[n - firstEntry]);
+        root->setData(0, Qt::UserRole, n);
+        it = details.emplace(n, unique_ptr<QTreeWidgetItem>(root)).first;
+    }
+    return it->second.get();
+}
 
-    QString status = "Log contains "+QString::number(i) + " entries, using ";
-    status += Unit::ToString(log.getUsedStorageSize(), "B", " kMG") + " (maximum: "+Unit::ToString(log.getMaxStorageSize(), "B", " kMG")+")";
-    ui->status->setText(status);
+QString DevicePacketLogModel::packetName(Protocol::PacketType type)
+{
+    static const QStringList packetNames = {"None", "Datapoint", "SweepSettings", "ManualStatus", "ManualControl", "DeviceInfo", "FirmwarePacket", "Ack",
+                                           "ClearFlash", "PerformFirmwareUpdate", "Nack", "Reference", "Generator", "SpectrumAnalyzerSettings",
+                                           "SpectrumAnalyzerResult", "RequestDeviceInfo", "RequestSourceCal", "RequestReceiverCal", "SourceCalPoint",
+                                           "ReceiverCalPoint", "SetIdle", "RequestFrequencyCorrection", "FrequencyCorrection", "RequestDeviceConfiguration",
+                                           "DeviceConfiguration", "DeviceStatus", "RequestDeviceStatus", "VNADatapoint", "SetTrigger", "ClearTrigger",
+                                           "StopStatusUpdates", "StartStatusUpdates", "InitiateSweep", "VNADatapointBlock", "DatapointFormat"};
+    return packetNames.value((int) type, "Unknown");
 }
 
-void DevicePacketLogView::addEntry(const DevicePacketLog::LogEntry &e)
+QTreeWidgetItem *DevicePacketLogModel::createDetails(const DevicePacketLog::LogEntry &entry)
 {
     auto item = new QTreeWidgetItem;
-    item->setData(0, Qt::DisplayRole, e.timestamp.toString(Qt::DateFormat::ISODateWithMs));
-    item->setData(1, Qt::DisplayRole, e.serial.size() > 0 ? e.serial : "LibreVNA-GUI");
-    item->setData(2, Qt::DisplayRole, e.type == DevicePacketLog::LogEntry::Type::Packet ? "Packet" : "Invalid bytes");
+    auto e = entry;
     if(e.type == DevicePacketLog::LogEntry::Type::Packet) {
-        item->setData(2, Qt::DisplayRole, "Packet");
-
-        static const QStringList packetNames = {"None", "Datapoint", "SweepSettings", "ManualStatus", "ManualControl", "DeviceInfo", "FirmwarePacket", "Ack",
-                                               "ClearFlash", "PerformFirmwareUpdate", "Nack", "Reference", "Generator", "SpectrumAnalyzerSettings",
-                                               "SpectrumAnalyzerResult", "RequestDeviceInfo", "RequestSourceCal", "RequestReceiverCal", "SourceCalPoint",
-                                               "ReceiverCalPoint", "SetIdle", "RequestFrequencyCorrection", "FrequencyCorrection", "RequestDeviceConfiguration",
-                                               "DeviceConfiguration", "DeviceStatus", "RequestDeviceStatus", "VNADatapoint", "SetTrigger", "ClearTrigger"};
-
-        item->setData(3, Qt::DisplayRole, "Type "+QString::number((int)e.p->type)+"("+packetNames[(int)e.p->type]+")");
+        e.decode();
+    }
+    if(e.type == DevicePacketLog::LogEntry::Type::Packet && e.p) {
         auto addDouble = [=](QTreeWidgetItem *parent, QString name, double value, QString unit = "", int precision = 8) {
             auto subitem = new QTreeWidgetItem;
             subitem->setData(2, Qt::DisplayRole, name);
@@ -145,6 +332,41 @@ void DevicePacketLogView::addEntry(const DevicePacketLog::LogEntry &e)
             parent->addChild(subitem);
         };
 
+        auto addDatapoint = [=](QTreeWidgetItem *parent, Protocol::VNADatapoint<32> &s) {
+            addInteger(parent, "Point number", s.pointNum);
+            addDouble(parent, "Frequency/time", s.frequency, "Hz");
+            addDouble(parent, "Power", (double) s.cdBm / 100.0, "dBm");
+            for(unsigned int i=0;i<s.getNumValues();i++) {
+                auto v = s.getValue(i);
+                vector<int> ports;
+                if(v.flags & 0x01) {
+                    ports.push_back(1);
+                }
+                if(v.flags & 0x02) {
+                    ports.push_back(2);
+                }
+                if(v.flags & 0x04) {
+                    ports.push_back(3);
+                }
+                if(v.flags & 0x08) {
+                    ports.push_back(4);
+                }
+                bool reference = v.flags & 0x10;
+                int stage = v.flags >> 5;
+                auto vitem = new QTreeWidgetItem;
+                vitem->setData(2, Qt::DisplayRole, "Measurement "+QString::number(i+1));
+                vitem->setData(3, Qt::DisplayRole, "Real: "+QString::number(v.value.real())+" Imag: "+QString::number(v.value.imag()));
+                addInteger(vitem, "Stage", stage);
+                addBool(vitem, "Reference", reference);
+                QString sports = QString::number(ports.front());
+                for(unsigned int j=1;j<ports.size();j++) {
+                    sports += ","+QString::number(ports[j]);
+                }
+                addString(vitem, "Ports", sports);
+                parent->addChild(vitem);
+            }
+        };
+
         switch(e.p->type) {
         case Protocol::PacketType::SweepSettings: {
             Protocol::SweepSettings s = e.p->settings;
@@ -159,6 +381,7 @@ void DevicePacketLogView::addEntry(const DevicePacketLog::LogEntry &e)
             addBool(item, "Suppress peaks", s.suppressPeaks);
             addBool(item, "Fixed power setting", s.fixedPowerSetting);
             addBool(item, "Logarithmic sweep", s.logSweep);
+            addBool(item, "Datapoint CRC", s.datapointCRC);
             addInteger(item, "Stages", s.stages);
             addInteger(item, "Port 1 stage", s.port1Stage);
             addInteger(item, "Port 2 stage", s.port2Stage);
@@ -383,42 +606,33 @@ void DevicePacketLogView::addEntry(const DevicePacketLog::LogEntry &e)
             addDouble(item, "Tracking generator power", (double) s.trackingPower / 100.0, "dBm");
         }
             break;
-        case Protocol::PacketType::VNADatapoint: {
-            Protocol::VNADatapoint<32>* s = e.datapoint;
-            addInteger(item, "Point number", s->pointNum);
-            addDouble(item, "Frequency/time", s->frequency, "Hz");
-            addDouble(item, "Power", (double) s->cdBm / 100.0, "dBm");
-            for(unsigned int i=0;i<s->getNumValues();i++) {
-                auto v = s->getValue(i);
-                vector<int> ports;
-                if(v.flags & 0x01) {
-                    ports.push_back(1);
-                }
-                if(v.flags & 0x02) {
-                    ports.push_back(2);
-                }
-                if(v.flags & 0x04) {
-                    ports.push_back(3);
-                }
-                if(v.flags & 0x08) {
-                    ports.push_back(4);
-                }
-                bool reference = v.flags & 0x10;
-                int stage = v.flags >> 5;
-                auto vitem = new QTreeWidgetItem;
-                vitem->setData(2, Qt::DisplayRole, "Measurement "+QString::number(i+1));
-                vitem->setData(3, Qt::DisplayRole, "Real: "+QString::number(v.value.real())+" Imag: "+QString::number(v.value.imag()));
-                addInteger(vitem, "Stage", stage);
-                addBool(vitem, "Reference", reference);
-                QString sports = QString::number(ports.front());
-                for(unsigned int j=1;j<ports.size();j++) {
-                    sports += ","+QString::number(ports[j]);
+        case Protocol::PacketType::VNADatapoint:
+            addDatapoint(item, *e.datapoint);
+            break;
+        case Protocol::PacketType::VNADatapointBlock: {
+            auto b = e.datapointBlock;
+            addBool(item, "Half precision", b->getFlags() & Protocol::VNADatapointBlock::HalfPrecision);
+            addBool(item, "Frequency omitted", b->getFlags() & Protocol::VNADatapointBlock::FrequencyOmitted);
+            addInteger(item, "Number of points", b->getNumPoints());
+            Protocol::VNADatapoint<32> point;
+            for(unsigned int i=0;i<b->getNumPoints();i++) {
+                if(!b->getPoint(i, point)) {
+                    break;
                 }
-                addString(vitem, "Ports", sports);
-                item->addChild(vitem);
+                auto pitem = new QTreeWidgetItem;
+                pitem->setData(2, Qt::DisplayRole, "Point "+QString::number(point.pointNum));
+                addDatapoint(pitem, point);
+                item->addChild(pitem);
             }
         }
             break;
+        case Protocol::PacketType::DatapointFormat: {
+            Protocol::DatapointFormat s = e.p->datapointFormat;
+            addInteger(item, "Points per block", s.pointsPerBlock);
+            addBool(item, "Half precision", s.halfPrecision);
+            addBool(item, "Omit frequency", s.omitFrequency);
+        }
+            break;
         case Protocol::PacketType::SpectrumAnalyzerResult: {
             Protocol::SpectrumAnalyzerResult s = e.p->spectrumResult;
             addDouble(item, "Port 1 level", s.port1);
@@ -476,13 +690,90 @@ void DevicePacketLogView::addEntry(const DevicePacketLog::LogEntry &e)
             break;
         }
     } else {
-        item->setData(2, Qt::DisplayRole, "Invalid bytes");
-        item->setData(3, Qt::DisplayRole, QString::number(e.bytes.size())+ " bytes");
         for(auto b : e.bytes) {
             auto subitem = new QTreeWidgetItem;
             subitem->setData(3, Qt::DisplayRole, "0x"+QString::number(b, 16));
             item->addChild(subitem);
         }
     }
-    ui->tree->addTopLevelItem(item);
+    return item;
+}
+
+DevicePacketLogView::DevicePacketLogView(QWidget *parent) :
+    QDialog(parent),
+    ui(new Ui::DevicePacketLogView)
+{
+    setAttribute(Qt::WA_DeleteOnClose);
+    ui->setupUi(this);
+    ui->tree->setModel(&model);
+    // all rows have the same height, no need to measure every row
+    ui->tree->setUniformRowHeights(true);
+    connect(&model, &DevicePacketLogModel::entriesChanged, this, &DevicePacketLogView::updateStatus);
+    connect(ui->filter, &QLineEdit::textChanged, &model, &DevicePacketLogModel::setFilter);
+
+    connect(ui->buttonBox->button(QDialogButtonBox::Reset), &QPushButton::clicked, [=](){
+        DevicePacketLog::getInstance().reset();
+        model.clear();
+    });
+    connect(ui->buttonBox->button(QDialogButtonBox::Save), &QPushButton::clicked, [=](){
+        QString filename = QFileDialog::getSaveFileName(nullptr, "Load LibreVNA log data", "", "LibreVNA log files (*.vnalog)", nullptr, QFileDialog::DontUseNativeDialog);
+        if(filename.isEmpty()) {
+            // aborted selection
+            return;
+        }
+        if(!filename.endsWith(".vnalog")) {
+            filename.append(".vnalog");
+        }
+        ofstream file;
+        file.open(filename.toStdString());
+        file << setw(1) << DevicePacketLog::getInstance().toJSON() << endl;
+        file.close();
+    });
+    connect(ui->buttonBox->button(QDialogButtonBox::Open), &QPushButton::clicked, [=](){
+        QString filename = QFileDialog::getOpenFileName(nullptr, "Load LibreVNA log data", "", "LibreVNA log files (*.vnalog)", nullptr, QFileDialog::DontUseNativeDialog);
+        if(filename.isEmpty()) {
+            // aborted selection
+            return;
+        }
+        ifstream file;
+        file.open(filename.toStdString());
+        if(!file.is_open()) {
+            qWarning() << "Unable to open file:" << filename;
+            return;
+        }
+        nlohmann::json j;
+        try {
+            // TODO this can take a long time, move to thread
+            file >> j;
+        } catch (exception &e) {
+            InformationBox::ShowError("Error", "Failed to parse the USB log file (" + QString(e.what()) + ")");
+            qWarning() << "Parsing of USB log file failed: " << e.what();
+            file.close();
+            return;
+        }
+        file.close();
+        DevicePacketLog::getInstance().fromJSON(j);
+        model.reload();
+    });
+
+    updateStatus();
+}
+
+DevicePacketLogView::~DevicePacketLogView()
+{
+    delete ui;
+}
+
+void DevicePacketLogView::updateStatus()
+{
+    auto &log = DevicePacketLog::getInstance();
+    QString status = "Log contains "+QString::number(model.getEntryCount()) + " entries";
+    if(model.getEntryCount() != (unsigned long) model.rowCount()) {
+        status += " ("+QString::number(model.rowCount())+" shown)";
+    }
+    status += ", using " + Unit::ToString(log.getUsedStorageSize(), "B", " kMG") + " (maximum: "+Unit::ToString(log.getMaxStorageSize(), "B", " kMG")+")";
+    if(!log.isEnabled()) {
+        status += ", logging is disabled";
+    }
+    ui->status->setText(status);
 }
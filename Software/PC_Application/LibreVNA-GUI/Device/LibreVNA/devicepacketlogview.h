@@ -2,13 +2,83 @@
 #define DEVICEUSBLOGVIEW_H
 
 #include "devicepacketlog.h"
+#include "Util/backgroundfilter.h"
 
 #include <QDialog>
+#include <QAbstractItemModel>
+#include <QTreeWidgetItem>
+#include <QTimer>
+
+#include <deque>
+#include <map>
+#include <memory>
 
 namespace Ui {
 class DevicePacketLogView;
 }
 
+/*
+ * Entries of the DevicePacketLog as a tree (one top level item per entry, the decoded content as children).
+ *
+ * The log is polled every updateInterval and new entries are inserted in one batch. Packets are only decoded when
+ * their content is shown. Filtering the entries runs in a worker thread.
+ */
+class DevicePacketLogModel : public QAbstractItemModel
+{
+    Q_OBJECT
+public:
+    DevicePacketLogModel(QObject *parent = nullptr);
+    ~DevicePacketLogModel();
+
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex &child) const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    bool hasChildren(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    // Removes all entries from the model (but not from the log), only entries added to the log afterwards are shown
+    void clear();
+    // Clears the model and reads all entries from the log again
+    void reload();
+    // Only entries whose source, type or packet type contain the text are shown (case insensitive)
+    void setFilter(QString text);
+    // All entries, including entries hidden by the filter
+    unsigned long getEntryCount() const {return entries.size();}
+
+    static constexpr int updateInterval = 200;
+    static constexpr unsigned int maxEntries = 1000000;
+
+signals:
+    void entriesChanged();
+
+private:
+    void update();
+    void trim();
+    bool matches(const DevicePacketLog::LogEntry &e) const;
+    const DevicePacketLog::LogEntry &entry(int row) const;
+    // Returns the tree item of a child index or the (lazily created) root item of the content of a log entry
+    QTreeWidgetItem *item(const QModelIndex &index) const;
+
+    // thread safe, also called by the filter thread
+    static bool matchesText(const QString &serial, DevicePacketLog::LogEntry::Type type, Protocol::PacketType packetType, const QString &text);
+    static QString packetName(Protocol::PacketType type);
+    static QTreeWidgetItem *createDetails(const DevicePacketLog::LogEntry &entry);
+
+    // all entries, entries.front() is the entry number firstEntry (counted since the creation of the model)
+    std::deque<DevicePacketLog::LogEntry> entries;
+    unsigned long long firstEntry;
+    // entry numbers of the entries that pass the filter
+    std::deque<unsigned long long> visible;
+    // decoded content of the entries that have been expanded, indexed by entry number
+    mutable std::map<unsigned long long, std::unique_ptr<QTreeWidgetItem>> details;
+    unsigned long long logPosition;
+    QString filterText;
+    BackgroundFilter filter;
+    QTimer updateTimer;
+};
+
 class DevicePacketLogView : public QDialog
 {
     Q_OBJECT
@@ -18,10 +88,10 @@ public:
     ~DevicePacketLogView();
 
 private slots:
-    void updateTree();
-    void addEntry(const DevicePacketLog::LogEntry &e);
+    void updateStatus();
 private:
     Ui::DevicePacketLogView *ui;
+    DevicePacketLogModel model;
 };
 
 #endif // DEVICEUSBLOGVIEW_H
@@ -12,12 +12,18 @@
 #include "receivercaldialog.h"
 #include "unit.h"
 #include "CustomWidgets/informationbox.h"
+#include "Util/latencytracer.h"
+#include "Util/metrics.h"
 #include "devicepacketlogview.h"
 
 #include "ui_librevnadriversettingswidget.h"
 
+#include <algorithm>
+
 using namespace std;
 
+std::set<QString> LibreVNADriver::datapointFormatRejected;
+
 class Reference
 {
 public:
@@ -115,6 +121,11 @@ LibreVNADriver::LibreVNADriver()
     SApoints = 0;
     hardwareVersion = 0;
     protocolVersion = 0;
+    VNADatapointCRC = true;
+    VNADatapointBlocks = true;
+    VNAHalfPrecision = false;
+    datapointFormatSupported = true;
+    VNAsweep = {};
     setSynchronization(Synchronization::Disabled, false);
 
     auto manual = new QAction("Manual Control");
@@ -288,6 +299,9 @@ QWidget *LibreVNADriver::createSettingsWidget()
     ui->UseSignalID->setChecked(SASignalID);
     ui->SuppressPeaks->setChecked(VNASuppressInvalidPeaks);
     ui->AdjustPowerLevel->setChecked(VNAAdjustPowerLevel);
+    ui->DatapointCRC->setChecked(VNADatapointCRC);
+    ui->DatapointBlocks->setChecked(VNADatapointBlocks);
+    ui->HalfPrecision->setChecked(VNAHalfPrecision);
     ui->DFTlimitRBW->setEnabled(false);
     connect(ui->UseDFT, &QCheckBox::toggled, ui->DFTlimitRBW, &SIUnitEdit::setEnabled);
     ui->UseDFT->setChecked(SAUseDFT);
@@ -322,6 +336,15 @@ QWidget *LibreVNADriver::createSettingsWidget()
     connect(ui->AdjustPowerLevel, &QCheckBox::toggled, this, [=](){
         VNAAdjustPowerLevel = ui->AdjustPowerLevel->isChecked();
     });
+    connect(ui->DatapointCRC, &QCheckBox::toggled, this, [=](){
+        VNADatapointCRC = ui->DatapointCRC->isChecked();
+    });
+    connect(ui->DatapointBlocks, &QCheckBox::toggled, this, [=](){
+        VNADatapointBlocks = ui->DatapointBlocks->isChecked();
+    });
+    connect(ui->HalfPrecision, &QCheckBox::toggled, this, [=](){
+        VNAHalfPrecision = ui->HalfPrecision->isChecked();
+    });
     connect(ui->UseDFT, &QCheckBox::toggled, this, [=](){
         SAUseDFT = ui->UseDFT->isChecked();
     });
@@ -379,6 +402,7 @@ bool LibreVNADriver::setVNA(const DeviceDriver::VNASettings &s, std::function<vo
     p.settings.suppressPeaks = VNASuppressInvalidPeaks ? 1 : 0;
     p.settings.fixedPowerSetting = VNAAdjustPowerLevel || s.dBmStart != s.dBmStop ? 0 : 1;
     p.settings.logSweep = s.logSweep ? 1 : 0;
+    p.settings.datapointCRC = VNADatapointCRC ? 1 : 0;
 
     zerospan = (s.freqStart == s.freqStop) && (s.dBmStart == s.dBmStop);
     p.settings.port1Stage = find(s.excitedPorts.begin(), s.excitedPorts.end(), 1) - s.excitedPorts.begin();
@@ -388,7 +412,29 @@ bool LibreVNADriver::setVNA(const DeviceDriver::VNASettings &s, std::function<vo
     p.settings.syncMode = (int) sync;
     p.settings.syncMaster = syncMaster ? 1 : 0;
 
+    if(datapointFormatSupported) {
+        // combine consecutive points into blocks, limited to the points measured within maxBlockLatency
+        Protocol::PacketInfo f = {};
+        f.type = Protocol::PacketType::DatapointFormat;
+        if(VNADatapointBlocks && !s.excitedPorts.empty()) {
+            f.datapointFormat.pointsPerBlock = std::clamp(s.IFBW * maxBlockLatency / s.excitedPorts.size(), 0.0, 255.0);
+        }
+        f.datapointFormat.halfPrecision = VNAHalfPrecision ? 1 : 0;
+        f.datapointFormat.omitFrequency = 1;
+        SendPacket(f, [=](TransmissionResult r){
+            if(r == TransmissionResult::Nack) {
+                // not supported by the firmware, every point is sent as a VNADatapoint
+                datapointFormatSupported = false;
+                datapointFormatRejected.insert(serial+" "+info.firmware_version);
+            }
+        });
+    }
+
     return SendPacket(p, [=](TransmissionResult r){
+        if(r == TransmissionResult::Ack) {
+            // all following points belong to this sweep
+            VNAsweep = p.settings;
+        }
         if(cb) {
             cb(r == TransmissionResult::Ack);
         }
@@ -585,8 +631,58 @@ void LibreVNADriver::setSynchronization(LibreVNADriver::Synchronization s, bool
     syncMaster = master;
 }
 
+void LibreVNADriver::updateTransmissionQueueMetric(unsigned int depth)
+{
+    static auto &queueDepth = Metrics::getInstance().gauge("librevna_transmission_queue_depth", "Packets waiting to be sent to the device (including the one waiting for an answer)");
+    queueDepth.set(depth);
+}
+
+void LibreVNADriver::updateTransmissionResultMetrics(TransmissionResult result, double seconds)
+{
+    static auto &ackLatency = Metrics::getInstance().histogram("librevna_ack_latency_seconds", "Time from sending a packet until the device answered with Ack or Nack",
+                                                               Metrics::Histogram::exponentialBounds(0.0001, 2, 14));
+    static auto &nacks = Metrics::getInstance().counter("librevna_transmission_nacks_total", "Packets answered with Nack");
+    static auto &timeouts = Metrics::getInstance().counter("librevna_transmission_timeouts_total", "Packets without an answer from the device");
+    switch(result) {
+    case TransmissionResult::Nack:
+        nacks.increment();
+        [[fallthrough]];
+    case TransmissionResult::Ack:
+        ackLatency.observe(seconds);
+        break;
+    case TransmissionResult::Timeout:
+        timeouts.increment();
+        break;
+    default:
+        break;
+    }
+}
+
+void LibreVNADriver::updateReceiveBufferMetric(unsigned int bytes)
+{
+    static auto &bufferFill = Metrics::getInstance().gauge("librevna_receive_buffer_bytes", "Received bytes not yet decoded (incomplete packet at the end of the buffer)");
+    bufferFill.set(bytes);
+}
+
 void LibreVNADriver::handleReceivedPacket(const Protocol::PacketInfo &packet)
 {
+    LATENCY_SPAN("LibreVNADriver::handleReceivedPacket", "Device", (long long) packet.type);
+    if(packet.type == Protocol::PacketType::VNADatapointBlock) {
+        // the points of a block are handled (and passed on) like individual VNADatapoint packets
+        auto block = packet.VNAdatapointBlock;
+        for(uint8_t i=0;i<block->getNumPoints();i++) {
+            Protocol::PacketInfo p;
+            p.type = Protocol::PacketType::VNADatapoint;
+            p.VNAdatapoint = new Protocol::VNADatapoint<32>;
+            block->getPoint(i, *p.VNAdatapoint);
+            if(block->getFlags() & Protocol::VNADatapointBlock::FrequencyOmitted) {
+                p.VNAdatapoint->frequency = Protocol::VNADatapointBlock::getPointFrequency(VNAsweep.f_start, VNAsweep.f_stop, VNAsweep.points, p.VNAdatapoint->pointNum);
+            }
+            handleReceivedPacket(p);
+        }
+        delete block;
+        return;
+    }
     emit passOnReceivedPacket(packet);
 
     if(skipOwnPacketHandling) {
@@ -610,6 +706,8 @@ void LibreVNADriver::handleReceivedPacket(const Protocol::PacketInfo &packet)
 
         hardwareVersion = packet.info.hardware_version;
         info.firmware_version = QString::number(packet.info.FW_major)+"."+QString::number(packet.info.FW_minor)+"."+QString::number(packet.info.FW_patch);
+        // possibly a different device or an updated firmware
+        datapointFormatSupported = !datapointFormatRejected.count(serial+" "+info.firmware_version);
         info.hardware_version = hardwareVersionToString(packet.info.hardware_version)+" Rev."+QString(packet.info.HW_Revision);
         info.supportedFeatures = {
             Feature::VNA, Feature::VNAFrequencySweep, Feature::VNALogSweep, Feature::VNAPowerSweep, Feature::VNAZeroSpan,
@@ -6,6 +6,7 @@
 #include "../../VNA_embedded/Application/Communication/Protocol.hpp"
 
 #include <functional>
+#include <set>
 
 class LibreVNADriver : public DeviceDriver
 {
@@ -196,6 +197,11 @@ protected slots:
 protected:
     QString hardwareVersionToString(uint8_t version);
 
+    // Acquisition health metrics, updated by the USB and TCP implementations
+    static void updateTransmissionQueueMetric(unsigned int depth);
+    static void updateTransmissionResultMetrics(TransmissionResult result, double seconds);
+    static void updateReceiveBufferMetric(unsigned int bytes);
+
     bool connected;
     unsigned int protocolVersion;
     QString serial;
@@ -207,6 +213,14 @@ protected:
 
     bool skipOwnPacketHandling;
     bool zerospan;
+    // cleared when the device rejects the DatapointFormat packet (older firmware)
+    bool datapointFormatSupported;
+    // serials and firmware versions of the devices that rejected the DatapointFormat packet, they are not asked again
+    static std::set<QString> datapointFormatRejected;
+    // sweep settings acknowledged by the device, required for points without frequency
+    Protocol::SweepSettings VNAsweep;
+    // a block of points should be complete after this time (in seconds)
+    static constexpr double maxBlockLatency = 0.02;
     unsigned int SApoints;
 
     Synchronization sync;
@@ -222,6 +236,9 @@ protected:
     double SARBWLimitForDFT;
     bool VNASuppressInvalidPeaks;
     bool VNAAdjustPowerLevel;
+    bool VNADatapointCRC;
+    bool VNADatapointBlocks;
+    bool VNAHalfPrecision;
 };
 
 Q_DECLARE_METATYPE(Protocol::PacketInfo)
@@ -0,0 +1,427 @@
+#include "librevnasimulator.h"
+
+#include "librevnatcpdriver.h"
+
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <set>
+
+using namespace std;
+
+static set<LibreVNASimulator*> runningSimulators;
+
+LibreVNASimulator::LibreVNASimulator(QString serial, unsigned int ports)
+    : serial(serial),
+      ports(std::clamp(ports, 1U, 4U)),
+      dataSocket(nullptr),
+      logSocket(nullptr),
+      mode(Mode::Idle),
+      VNAsettings(),
+      SAsettings(),
+      format(),
+      nextFormat(),
+      nextPoint(0),
+      pointsSinceStart(0),
+      pointsPerSecond(10000),
+      lossRate(0.0),
+      corruptionRate(0.0),
+      rng(0),
+      statistics()
+{
+    connect(&dataServer, &QTcpServer::newConnection, this, &LibreVNASimulator::newDataConnection);
+    connect(&logServer, &QTcpServer::newConnection, this, &LibreVNASimulator::newLogConnection);
+    connect(&timer, &QTimer::timeout, this, &LibreVNASimulator::generate);
+}
+
+LibreVNASimulator::~LibreVNASimulator()
+{
+    stop();
+}
+
+bool LibreVNASimulator::start(QHostAddress address)
+{
+    stop();
+    if(!dataServer.listen(address, LibreVNATCPDriver::DataPort)) {
+        qWarning() << "Simulator failed to listen on data port:" << dataServer.errorString();
+        return false;
+    }
+    if(!logServer.listen(address, LibreVNATCPDriver::LogPort)) {
+        qWarning() << "Simulator failed to listen on log port:" << logServer.errorString();
+        dataServer.close();
+        return false;
+    }
+    runningSimulators.insert(this);
+    return true;
+}
+
+void LibreVNASimulator::stop()
+{
+    timer.stop();
+    mode = Mode::Idle;
+    for(auto socket : {&dataSocket, &logSocket}) {
+        if(*socket) {
+            (*socket)->abort();
+            (*socket)->deleteLater();
+            *socket = nullptr;
+        }
+    }
+    dataServer.close();
+    logServer.close();
+    runningSimulators.erase(this);
+}
+
+void LibreVNASimulator::setFaultInjection(double lossRate, double corruptionRate)
+{
+    this->lossRate = lossRate;
+    this->corruptionRate = corruptionRate;
+}
+
+std::map<QString, QHostAddress> LibreVNASimulator::getRunningSimulators()
+{
+    std::map<QString, QHostAddress> ret;
+    for(auto s : runningSimulators) {
+        auto address = s->getAddress();
+        if(address == QHostAddress::Any || address == QHostAddress::AnyIPv4) {
+            // listening on all interfaces, connect through the loopback interface
+            address = QHostAddress(QHostAddress::LocalHost);
+        }
+        ret[s->serial] = address;
+    }
+    return ret;
+}
+
+void LibreVNASimulator::newDataConnection()
+{
+    auto socket = dataServer.nextPendingConnection();
+    if(dataSocket) {
+        // only one connection at a time, the new one replaces the old one
+        dataSocket->abort();
+        dataSocket->deleteLater();
+    }
+    dataSocket = socket;
+    receiveBuffer.clear();
+    timer.stop();
+    mode = Mode::Idle;
+    connect(dataSocket, &QTcpSocket::readyRead, this, &LibreVNASimulator::receivedData);
+    connect(dataSocket, &QTcpSocket::disconnected, this, [=](){
+        if(dataSocket == socket) {
+            timer.stop();
+            mode = Mode::Idle;
+        }
+    });
+}
+
+void LibreVNASimulator::newLogConnection()
+{
+    auto socket = logServer.nextPendingConnection();
+    if(logSocket) {
+        logSocket->abort();
+        logSocket->deleteLater();
+    }
+    logSocket = socket;
+    logSocket->write(QString("LibreVNA simulator "+serial+" started\r\n").toLatin1());
+}
+
+void LibreVNASimulator::receivedData()
+{
+    receiveBuffer.append(dataSocket->readAll());
+    uint16_t handled;
+    do {
+        Protocol::PacketInfo packet;
+        handled = Protocol::DecodeBuffer((uint8_t*) receiveBuffer.data(), std::min(receiveBuffer.size(), (qsizetype) UINT16_MAX), &packet);
+        receiveBuffer.remove(0, handled);
+        if(packet.type == Protocol::PacketType::VNADatapoint) {
+            // not expected from the application, drop it
+            delete packet.VNAdatapoint;
+        } else if(packet.type == Protocol::PacketType::VNADatapointBlock) {
+            delete packet.VNAdatapointBlock;
+        } else if(packet.type != Protocol::PacketType::None) {
+            handlePacket(packet);
+        }
+    } while(handled > 0);
+}
+
+void LibreVNASimulator::handlePacket(const Protocol::PacketInfo &packet)
+{
+    // answers as the firmware does (see App.cpp of the embedded application)
+    switch(packet.type) {
+    case Protocol::PacketType::SweepSettings: {
+        VNAsettings = packet.settings;
+        sendWithoutPayload(Protocol::PacketType::Ack);
+        format = nextFormat;
+        uint8_t blockFlags = 0;
+        if(format.halfPrecision) {
+            blockFlags |= Protocol::VNADatapointBlock::HalfPrecision;
+        }
+        bool zerospan = VNAsettings.f_start == VNAsettings.f_stop && VNAsettings.cdbm_excitation_start == VNAsettings.cdbm_excitation_stop;
+        if(format.omitFrequency && !VNAsettings.logSweep && !zerospan) {
+            blockFlags |= Protocol::VNADatapointBlock::FrequencyOmitted;
+        }
+        block.clear(blockFlags);
+        if(VNAsettings.points > 0 && !VNAsettings.standby) {
+            mode = Mode::VNA;
+        } else {
+            mode = Mode::Idle;
+        }
+    }
+        break;
+    case Protocol::PacketType::DatapointFormat:
+        // takes effect with the next sweep settings
+        nextFormat = packet.datapointFormat;
+        sendWithoutPayload(Protocol::PacketType::Ack);
+        break;
+    case Protocol::PacketType::SpectrumAnalyzerSettings:
+        SAsettings = packet.spectrumSettings;
+        sendWithoutPayload(Protocol::PacketType::Ack);
+        mode = SAsettings.pointNum > 0 ? Mode::SA : Mode::Idle;
+        break;
+    case Protocol::PacketType::SetIdle:
+        nextFormat = {};
+        mode = Mode::Idle;
+        sendWithoutPayload(Protocol::PacketType::Ack);
+        break;
+    case Protocol::PacketType::Generator:
+    case Protocol::PacketType::ManualControl:
+        // generator and manual control are accepted but do not produce any data
+        mode = Mode::Idle;
+        sendWithoutPayload(Protocol::PacketType::Ack);
+        break;
+    case Protocol::PacketType::RequestDeviceInfo: {
+        // first request of a (possibly different) driver, forget the datapoint format of the previous one
+        nextFormat = {};
+        sendWithoutPayload(Protocol::PacketType::Ack);
+        Protocol::PacketInfo p = {};
+        p.type = Protocol::PacketType::DeviceInfo;
+        p.info.ProtocolVersion = Protocol::Version;
+        p.info.FW_major = 0;
+        p.info.FW_minor = 0;
+        p.info.FW_patch = 0;
+        p.info.hardware_version = 0x01;
+        p.info.HW_Revision = 'S';
+        p.info.limits_minFreq = 100000;
+        p.info.limits_maxFreq = 6000000000;
+        p.info.limits_minIFBW = 10;
+        p.info.limits_maxIFBW = 50000;
+        p.info.limits_maxPoints = UINT16_MAX;
+        p.info.limits_cdbm_min = -4000;
+        p.info.limits_cdbm_max = 0;
+        p.info.limits_minRBW = 1;
+        p.info.limits_maxRBW = 1000000;
+        p.info.limits_maxAmplitudePoints = 255;
+        p.info.limits_maxFreqHarmonic = 18000000000;
+        p.info.num_ports = ports;
+        send(p);
+    }
+        break;
+    case Protocol::PacketType::RequestDeviceStatus: {
+        sendWithoutPayload(Protocol::PacketType::Ack);
+        Protocol::PacketInfo p = {};
+        p.type = Protocol::PacketType::DeviceStatus;
+        p.status.V1.FPGA_configured = 1;
+        p.status.V1.source_locked = 1;
+        p.status.V1.LO1_locked = 1;
+        p.status.V1.temp_source = 40;
+        p.status.V1.temp_LO1 = 40;
+        p.status.V1.temp_MCU = 40;
+        send(p);
+    }
+        break;
+    case Protocol::PacketType::None:
+        break;
+    default:
+        // everything else (reference, triggers, status updates, ...) is simply acknowledged
+        sendWithoutPayload(Protocol::PacketType::Ack);
+        break;
+    }
+    if(mode == Mode::Idle) {
+        timer.stop();
+    } else if(packet.type == Protocol::PacketType::SweepSettings || packet.type == Protocol::PacketType::SpectrumAnalyzerSettings) {
+        // new settings always restart the sweep
+        nextPoint = 0;
+        pointsSinceStart = 0;
+        elapsed.start();
+        timer.start(pointsPerSecond ? 5 : 0);
+    }
+    if(dataSocket) {
+        dataSocket->write(sendBuffer);
+        statistics.bytesSent += sendBuffer.size();
+        sendBuffer.clear();
+    }
+}
+
+void LibreVNASimulator::send(const Protocol::PacketInfo &packet, bool measurement)
+{
+    uint8_t buffer[1024];
+    auto len = Protocol::EncodePacket(packet, buffer, sizeof(buffer), VNAsettings.datapointCRC);
+    if(!len) {
+        qCritical() << "Simulator failed to encode packet";
+        return;
+    }
+    if(measurement) {
+        uniform_real_distribution<double> dist(0.0, 1.0);
+        if(lossRate > 0 && dist(rng) < lossRate) {
+            statistics.packetsDropped++;
+            return;
+        }
+        if(corruptionRate > 0 && dist(rng) < corruptionRate) {
+            uniform_int_distribution<unsigned int> byte(0, len - 1);
+            buffer[byte(rng)] ^= 1 << uniform_int_distribution<unsigned int>(0, 7)(rng);
+            statistics.packetsCorrupted++;
+        }
+    }
+    sendBuffer.append((const char*) buffer, len);
+}
+
+void LibreVNASimulator::sendWithoutPayload(Protocol::PacketType type)
+{
+    Protocol::PacketInfo p;
+    p.type = type;
+    send(p);
+}
+
+void LibreVNASimulator::generate()
+{
+    if(!dataSocket || mode == Mode::Idle) {
+        timer.stop();
+        return;
+    }
+    if(dataSocket->bytesToWrite() > 4 * 1024 * 1024) {
+        // the receiver is not keeping up, wait instead of buffering endlessly (like a real device would be limited by the connection)
+        return;
+    }
+    quint64 due = 1000;
+    if(pointsPerSecond) {
+        due = elapsed.elapsed() * pointsPerSecond / 1000 - pointsSinceStart;
+    }
+    // limit the burst size to stay responsive to incoming packets
+    due = std::min(due, (quint64) 20000);
+    for(quint64 i=0;i<due;i++) {
+        Protocol::PacketInfo p;
+        if(mode == Mode::VNA) {
+            Protocol::VNADatapoint<32> point;
+            createVNAPoint(point, nextPoint);
+            if(format.pointsPerBlock > 1) {
+                // same as the firmware: blocks are sent when full, at the end of the sweep and after maxBlockAge
+                if(!block.addPoint(point)) {
+                    sendBlock();
+                    block.addPoint(point);
+                }
+                if(block.getNumPoints() == 1) {
+                    blockAge.start();
+                }
+                if(block.getNumPoints() >= format.pointsPerBlock || nextPoint == VNAsettings.points - 1u
+                        || blockAge.elapsed() >= maxBlockAge) {
+                    sendBlock();
+                }
+            } else {
+                p.type = Protocol::PacketType::VNADatapoint;
+                p.VNAdatapoint = &point;
+                send(p, true);
+            }
+            nextPoint = (nextPoint + 1) % VNAsettings.points;
+        } else {
+            p.type = Protocol::PacketType::SpectrumAnalyzerResult;
+            p.spectrumResult = createSAPoint(nextPoint);
+            send(p, true);
+            nextPoint = (nextPoint + 1) % SAsettings.pointNum;
+        }
+    }
+    if(block.getNumPoints() && blockAge.elapsed() >= maxBlockAge) {
+        // no more points for a while (low point rate)
+        sendBlock();
+    }
+    pointsSinceStart += due;
+    statistics.pointsGenerated += due;
+    dataSocket->write(sendBuffer);
+    statistics.bytesSent += sendBuffer.size();
+    sendBuffer.clear();
+}
+
+void LibreVNASimulator::sendBlock()
+{
+    if(!block.getNumPoints()) {
+        return;
+    }
+    Protocol::PacketInfo p;
+    p.type = Protocol::PacketType::VNADatapointBlock;
+    p.VNAdatapointBlock = &block;
+    send(p, true);
+    block.clear(block.getFlags());
+}
+
+void LibreVNASimulator::createVNAPoint(Protocol::VNADatapoint<32> &p, unsigned int pointNum)
+{
+    auto &s = VNAsettings;
+    double a = s.points > 1 ? (double) pointNum / (s.points - 1) : 0.0;
+    double f;
+    if(s.logSweep && s.f_start > 0) {
+        f = s.f_start * pow((double) s.f_stop / s.f_start, a);
+    } else {
+        // exactly the frequency the driver calculates for points without frequency
+        f = Protocol::VNADatapointBlock::getPointFrequency(s.f_start, s.f_stop, s.points, pointNum);
+    }
+    p.pointNum = pointNum;
+    p.cdBm = s.cdbm_excitation_start + (s.cdbm_excitation_stop - s.cdbm_excitation_start) * a;
+    if(s.f_start == s.f_stop && s.cdbm_excitation_start == s.cdbm_excitation_stop) {
+        // zero span
+        p.us = pointsPerSecond ? (quint64) pointNum * 1000000 / pointsPerSecond : pointNum;
+    } else {
+        p.frequency = llround(f);
+    }
+
+    normal_distribution<float> noise(0.0, 1e-4);
+    const unsigned int portStages[4] = {s.port1Stage, s.port2Stage, s.port3Stage, s.port4Stage};
+    for(unsigned int stage=0;stage<=s.stages;stage++) {
+        // find the port which is excited in this stage
+        unsigned int excited = 0;
+        while(excited < ports && portStages[excited] != stage) {
+            excited++;
+        }
+        if(excited >= ports) {
+            continue;
+        }
+        for(unsigned int port=0;port<ports;port++) {
+            complex<double> S;
+            if(port == excited) {
+                // mismatched load, a little bit further away at every port
+                S = 0.2 * exp(complex<double>(0, -2 * M_PI * f * 1e-9 * (port + 1)));
+            } else {
+                // lossy line between the ports
+                S = 0.9 / (1.0 + f / 6e9) * exp(complex<double>(0, -2 * M_PI * f * 2e-9));
+            }
+            p.addValue(S.real() + noise(rng), S.imag() + noise(rng), stage, 1 << port);
+        }
+        // the reference receiver is shared by all ports
+        p.addValue(1.0f, 0.0f, stage, ((1 << ports) - 1) | (int) Protocol::Source::Reference);
+    }
+}
+
+Protocol::SpectrumAnalyzerResult LibreVNASimulator::createSAPoint(unsigned int pointNum)
+{
+    auto &s = SAsettings;
+    Protocol::SpectrumAnalyzerResult r = {};
+    r.pointNum = pointNum;
+    double a = s.pointNum > 1 ? (double) pointNum / (s.pointNum - 1) : 0.0;
+    double f = s.f_start + ((double) s.f_stop - s.f_start) * a;
+    if(s.f_start == s.f_stop) {
+        r.us = pointsPerSecond ? (quint64) pointNum * 1000000 / pointsPerSecond : pointNum;
+    } else {
+        r.frequency = llround(f);
+    }
+    // noise floor and a tone (-20dBm) in the center of the span
+    normal_distribution<float> noise(0.0, 1e-6);
+    double center = ((double) s.f_start + s.f_stop) / 2;
+    double rbw = s.RBW > 0 ? s.RBW : 1;
+    double tone = 0.1 * exp(-pow((f - center) / rbw, 2));
+    float values[4];
+    for(unsigned int i=0;i<4;i++) {
+        values[i] = i < ports ? abs(1e-5 + tone + noise(rng)) : 0.0;
+    }
+    r.port1 = values[0];
+    r.port2 = values[1];
+    r.port3 = values[2];
+    r.port4 = values[3];
+    return r;
+}
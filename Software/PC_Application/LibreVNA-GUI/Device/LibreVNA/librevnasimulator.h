@@ -0,0 +1,109 @@
+#ifndef LIBREVNASIMULATOR_H
+#define LIBREVNASIMULATOR_H
+
+#include "../../VNA_embedded/Application/Communication/Protocol.hpp"
+
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QHostAddress>
+
+#include <random>
+#include <map>
+
+/**
+ * @brief LibreVNASimulator
+ *
+ * Simulates a LibreVNA without any hardware. It listens on the same TCP ports as a real device and
+ * speaks the same protocol (device info/status, sweep and spectrum analyzer settings, Ack/Nack and
+ * the measurement results), so the LibreVNA/TCP driver connects to it like to any other device.
+ * Running simulators are reported to the LibreVNA/TCP driver directly, they do not take part in
+ * the SSDP discovery.
+ *
+ * The measurements are those of a synthetic DUT (a mismatched line between every pair of ports for
+ * the VNA, a single tone in the center of the span for the spectrum analyzer) and are generated at a
+ * configurable rate. Lost and corrupted packets can be injected into the measurement data. VNA points are combined
+ * into VNADatapointBlock packets if requested by the driver (see Protocol::DatapointFormat).
+ */
+class LibreVNASimulator : public QObject
+{
+    Q_OBJECT
+public:
+    LibreVNASimulator(QString serial = "SIMULATION", unsigned int ports = 2);
+    ~LibreVNASimulator();
+
+    bool start(QHostAddress address = QHostAddress::LocalHost);
+    void stop();
+    bool isRunning() {return dataServer.isListening();}
+
+    QString getSerial() {return serial;}
+    QHostAddress getAddress() {return dataServer.serverAddress();}
+
+    // Generated measurement points per second (0 for as fast as possible)
+    void setPointsPerSecond(unsigned int pps) {pointsPerSecond = pps;}
+    // Probabilities (0.0 to 1.0) that a measurement packet is dropped or that one of its bytes is corrupted.
+    // Only measurement packets are affected, Acks and device info/status are always sent correctly
+    void setFaultInjection(double lossRate, double corruptionRate);
+
+    class Statistics {
+    public:
+        quint64 pointsGenerated;
+        quint64 packetsDropped;
+        quint64 packetsCorrupted;
+        quint64 bytesSent;
+    };
+    Statistics getStatistics() {return statistics;}
+
+    // All running simulators (serial -> address)
+    static std::map<QString, QHostAddress> getRunningSimulators();
+
+private:
+    enum class Mode {
+        Idle,
+        VNA,
+        SA,
+    };
+
+    void newDataConnection();
+    void newLogConnection();
+    void receivedData();
+    void handlePacket(const Protocol::PacketInfo &packet);
+    void send(const Protocol::PacketInfo &packet, bool measurement = false);
+    void sendWithoutPayload(Protocol::PacketType type);
+    void generate();
+    void sendBlock();
+    void createVNAPoint(Protocol::VNADatapoint<32> &p, unsigned int pointNum);
+    Protocol::SpectrumAnalyzerResult createSAPoint(unsigned int pointNum);
+
+    QString serial;
+    unsigned int ports;
+
+    QTcpServer dataServer, logServer;
+    QTcpSocket *dataSocket;
+    QTcpSocket *logSocket;
+    QByteArray receiveBuffer;
+    QByteArray sendBuffer;
+
+    Mode mode;
+    Protocol::SweepSettings VNAsettings;
+    Protocol::SpectrumAnalyzerSettings SAsettings;
+    // format of the running sweep and the format requested by the driver for the next one
+    Protocol::DatapointFormat format, nextFormat;
+    Protocol::VNADatapointBlock block;
+    // started with the first point of a block, points are not held back for longer than maxBlockAge (in ms)
+    QElapsedTimer blockAge;
+    static constexpr qint64 maxBlockAge = 20;
+    unsigned int nextPoint;
+    quint64 pointsSinceStart;
+    QElapsedTimer elapsed;
+    QTimer timer;
+
+    unsigned int pointsPerSecond;
+    double lossRate, corruptionRate;
+    std::mt19937 rng;
+    Statistics statistics;
+};
+
+#endif // LIBREVNASIMULATOR_H
@@ -1,8 +1,10 @@
 #include "librevnatcpdriver.h"
 
+#include "librevnasimulator.h"
 #include "CustomWidgets/informationbox.h"
 #include "devicepacketlog.h"
 #include "Util/util.h"
+#include "Util/latencytracer.h"
 
 #include <QTimer>
 #include <QNetworkInterface>
@@ -10,8 +12,6 @@
 using namespace std;
 
 static const QString service_name = "urn:schemas-upnp-org:device:LibreVNA:1";
-static constexpr int DataPort = 19544;
-static constexpr int LogPort = 19545;
 static auto SSDPaddress = QHostAddress("239.255.255.250");
 static constexpr int SSDPport = 1900;
 
@@ -49,6 +49,9 @@ LibreVNATCPDriver::LibreVNATCPDriver()
     specificSettings.push_back(Savable::SettingDescription(&SASignalID, "LibreVNATCPDriver.signalID", true));
     specificSettings.push_back(Savable::SettingDescription(&VNASuppressInvalidPeaks, "LibreVNATCPDriver.suppressInvalidPeaks", true));
     specificSettings.push_back(Savable::SettingDescription(&VNAAdjustPowerLevel, "LibreVNATCPDriver.adjustPowerLevel", false));
+    specificSettings.push_back(Savable::SettingDescription(&VNADatapointCRC, "LibreVNATCPDriver.datapointCRC", true));
+    specificSettings.push_back(Savable::SettingDescription(&VNADatapointBlocks, "LibreVNATCPDriver.datapointBlocks", true));
+    specificSettings.push_back(Savable::SettingDescription(&VNAHalfPrecision, "LibreVNATCPDriver.halfPrecision", false));
     specificSettings.push_back(Savable::SettingDescription(&SAUseDFT, "LibreVNATCPDriver.useDFT", true));
     specificSettings.push_back(Savable::SettingDescription(&SARBWLimitForDFT, "LibreVNATCPDriver.RBWlimitDFT", 3000));
 }
@@ -80,6 +83,16 @@ std::set<QString> LibreVNATCPDriver::GetAvailableDevices()
     // need delay here while still processing events
     SynSleep::sleep(100);
 
+    // simulated devices do not answer the SSDP requests, add them directly
+    for(auto &s : LibreVNASimulator::getRunningSimulators()) {
+        DetectedDevice d;
+        d.serial = s.first;
+        d.address = s.second;
+        d.responseTime = QDateTime::currentDateTime();
+        d.maxAgeSeconds = 0;
+        addDetectedDevice(d);
+    }
+
     std::set<QString> serials;
     for(auto d : detectedDevices) {
         serials.insert(d.serial);
@@ -222,12 +235,15 @@ void LibreVNATCPDriver::ReceivedData()
 //    qDebug() << "Received data";
     do {
 //        qDebug() << "Decoding" << dataBuffer->getReceived() << "Bytes";
-        handled_len = Protocol::DecodeBuffer((uint8_t*) dataBuffer.data(), dataBuffer.size(), &packet);
+        {
+            LATENCY_SPAN("Protocol::DecodeBuffer", "TCP");
+            handled_len = Protocol::DecodeBuffer((uint8_t*) dataBuffer.data(), dataBuffer.size(), &packet);
+        }
 //        qDebug() << "Handled" << handled_len << "Bytes, type:" << (int) packet.type;
         if(handled_len > 0) {
             auto &log = DevicePacketLog::getInstance();
             if(packet.type != Protocol::PacketType::None) {
-                log.addPacket(packet, serial);
+                log.addPacket(packet.type, (uint8_t*) dataBuffer.data(), handled_len, serial);
             } else {
                 log.addInvalidBytes((uint8_t*) dataBuffer.data(), handled_len, serial);
             }
@@ -246,6 +262,7 @@ void LibreVNATCPDriver::ReceivedData()
             break;
         }
     } while (handled_len > 0);
+    updateReceiveBufferMetric(dataBuffer.size());
 }
 
 void LibreVNATCPDriver::ReceivedLog()
@@ -274,6 +291,7 @@ void LibreVNATCPDriver::transmissionFinished(LibreVNADriver::TransmissionResult
         return;
     }
     auto t = transmissionQueue.dequeue();
+    updateTransmissionResultMetrics(result, transmissionStarted.nsecsElapsed() * 1e-9);
     if(result == TransmissionResult::Timeout) {
         qWarning() << "transmissionFinished with timeout, packettype:" << (int) t.packet.type << "Device:" << serial;
     }
@@ -298,6 +316,7 @@ void LibreVNATCPDriver::transmissionFinished(LibreVNADriver::TransmissionResult
     if(transmissionQueue.isEmpty()) {
         transmissionActive = false;
     }
+    updateTransmissionQueueMetric(transmissionQueue.size());
 }
 
 bool LibreVNATCPDriver::SendPacket(const Protocol::PacketInfo &packet, std::function<void (LibreVNADriver::TransmissionResult)> cb, unsigned int timeout)
@@ -308,6 +327,7 @@ bool LibreVNATCPDriver::SendPacket(const Protocol::PacketInfo &packet, std::func
     t.callback = cb;
     lock_guard<mutex> lock(transmissionMutex);
     transmissionQueue.enqueue(t);
+    updateTransmissionQueueMetric(transmissionQueue.size());
 //    qDebug() << "Enqueued packet, queue at " << transmissionQueue.size();
     if(!transmissionActive) {
         startNextTransmission();
@@ -356,13 +376,14 @@ bool LibreVNATCPDriver::startNextTransmission()
         return false;
     }
     auto &log = DevicePacketLog::getInstance();
-    log.addPacket(t.packet);
+    log.addPacket(t.packet.type, buffer, length);
     auto ret = dataSocket.write((char*) buffer, length);
     if(ret < 0) {
         qCritical() << "Error sending TCP data";
         return false;
     }
     transmissionTimer.start(t.timeout);
+    transmissionStarted.start();
 //    qDebug() << "Transmission started, queue at " << transmissionQueue.size();
     return true;
 }
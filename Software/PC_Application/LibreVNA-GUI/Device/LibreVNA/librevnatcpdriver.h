@@ -9,6 +9,7 @@
 
 #include <QQueue>
 #include <QTimer>
+#include <QElapsedTimer>
 #include <QUdpSocket>
 #include <QTcpSocket>
 #include <QDateTime>
@@ -52,6 +53,9 @@ public:
         detectedDevices = other.detectedDevices;
     }
 
+    static constexpr int DataPort = 19544;
+    static constexpr int LogPort = 19545;
+
 private slots:
     void SSDPreceived(QUdpSocket *sock);
     void ReceivedData();
@@ -101,6 +105,7 @@ private:
     QQueue<Transmission> transmissionQueue;
     bool startNextTransmission();
     QTimer transmissionTimer;
+    QElapsedTimer transmissionStarted;
     bool transmissionActive;
 
     std::thread *m_receiveThread;
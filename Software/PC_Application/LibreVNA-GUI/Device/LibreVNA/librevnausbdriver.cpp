@@ -2,6 +2,7 @@
 
 #include "CustomWidgets/informationbox.h"
 #include "devicepacketlog.h"
+#include "Util/latencytracer.h"
 
 #include <QTimer>
 
@@ -32,6 +33,9 @@ LibreVNAUSBDriver::LibreVNAUSBDriver()
     specificSettings.push_back(Savable::SettingDescription(&SASignalID, "LibreVNAUSBDriver.signalID", true));
     specificSettings.push_back(Savable::SettingDescription(&VNASuppressInvalidPeaks, "LibreVNAUSBDriver.suppressInvalidPeaks", true));
     specificSettings.push_back(Savable::SettingDescription(&VNAAdjustPowerLevel, "LibreVNAUSBDriver.adjustPowerLevel", false));
+    specificSettings.push_back(Savable::SettingDescription(&VNADatapointCRC, "LibreVNAUSBDriver.datapointCRC", true));
+    specificSettings.push_back(Savable::SettingDescription(&VNADatapointBlocks, "LibreVNAUSBDriver.datapointBlocks", true));
+    specificSettings.push_back(Savable::SettingDescription(&VNAHalfPrecision, "LibreVNAUSBDriver.halfPrecision", false));
     specificSettings.push_back(Savable::SettingDescription(&SAUseDFT, "LibreVNAUSBDriver.useDFT", true));
     specificSettings.push_back(Savable::SettingDescription(&SARBWLimitForDFT, "LibreVNAUSBDriver.RBWlimitDFT", 3000));
 }
@@ -165,12 +169,15 @@ void LibreVNAUSBDriver::ReceivedData()
 //    qDebug() << "Received data";
     do {
 //        qDebug() << "Decoding" << dataBuffer->getReceived() << "Bytes";
-        handled_len = Protocol::DecodeBuffer(dataBuffer->getBuffer(), dataBuffer->getReceived(), &packet);
+        {
+            LATENCY_SPAN("Protocol::DecodeBuffer", "USB");
+            handled_len = Protocol::DecodeBuffer(dataBuffer->getBuffer(), dataBuffer->getReceived(), &packet);
+        }
 //        qDebug() << "Handled" << handled_len << "Bytes, type:" << (int) packet.type;
         if(handled_len > 0) {
             auto &log = DevicePacketLog::getInstance();
             if(packet.type != Protocol::PacketType::None) {
-                log.addPacket(packet, serial);
+                log.addPacket(packet.type, dataBuffer->getBuffer(), handled_len, serial);
             } else {
                 log.addInvalidBytes(dataBuffer->getBuffer(), handled_len, serial);
             }
@@ -189,6 +196,7 @@ void LibreVNAUSBDriver::ReceivedData()
             break;
         }
     } while (handled_len > 0);
+    updateReceiveBufferMetric(dataBuffer->getReceived());
 }
 
 void LibreVNAUSBDriver::ReceivedLog()
@@ -216,6 +224,7 @@ void LibreVNAUSBDriver::transmissionFinished(LibreVNADriver::TransmissionResult
         return;
     }
     auto t = transmissionQueue.dequeue();
+    updateTransmissionResultMetrics(result, transmissionStarted.nsecsElapsed() * 1e-9);
     if(result == TransmissionResult::Timeout) {
         qWarning() << "transmissionFinished with timeout, packettype:" << (int) t.packet.type << "Device:" << serial;
     }
@@ -240,6 +249,7 @@ void LibreVNAUSBDriver::transmissionFinished(LibreVNADriver::TransmissionResult
     if(transmissionQueue.isEmpty()) {
         transmissionActive = false;
     }
+    updateTransmissionQueueMetric(transmissionQueue.size());
 }
 
 bool LibreVNAUSBDriver::SendPacket(const Protocol::PacketInfo &packet, std::function<void (LibreVNADriver::TransmissionResult)> cb, unsigned int timeout)
@@ -250,6 +260,7 @@ bool LibreVNAUSBDriver::SendPacket(const Protocol::PacketInfo &packet, std::func
     t.callback = cb;
     lock_guard<mutex> lock(transmissionMutex);
     transmissionQueue.enqueue(t);
+    updateTransmissionQueueMetric(transmissionQueue.size());
 //    qDebug() << "Enqueued packet, queue at " << transmissionQueue.size();
     if(!transmissionActive) {
         startNextTransmission();
@@ -260,6 +271,7 @@ bool LibreVNAUSBDriver::SendPacket(const Protocol::PacketInfo &packet, std::func
 void LibreVNAUSBDriver::USBHandleThread()
 {
     qDebug() << "Receive thread started";
+    LATENCY_THREAD_NAME("USB");
     while (connected) {
         libusb_handle_events(m_context);
     }
@@ -356,7 +368,7 @@ bool LibreVNAUSBDriver::startNextTransmission()
     }
     int actual_length;
     auto &log = DevicePacketLog::getInstance();
-    log.addPacket(t.packet);
+    log.addPacket(t.packet.type, buffer, length);
     auto ret = libusb_bulk_transfer(m_handle, EP_Data_Out_Addr, buffer, length, &actual_length, 0);
     if(ret < 0) {
         qCritical() << "Error sending data: "
@@ -364,6 +376,7 @@ bool LibreVNAUSBDriver::startNextTransmission()
         return false;
     }
     transmissionTimer.start(t.timeout);
+    transmissionStarted.start();
 //    qDebug() << "Transmission started, queue at " << transmissionQueue.size();
     return true;
 }
@@ -9,6 +9,7 @@
 
 #include <QQueue>
 #include <QTimer>
+#include <QElapsedTimer>
 
 class LibreVNAUSBDriver : public LibreVNADriver
 {
@@ -72,6 +73,7 @@ private:
     QQueue<Transmission> transmissionQueue;
     bool startNextTransmission();
     QTimer transmissionTimer;
+    QElapsedTimer transmissionStarted;
     bool transmissionActive;
 
     std::thread *m_receiveThread;
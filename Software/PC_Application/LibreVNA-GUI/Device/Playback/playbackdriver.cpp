@@ -0,0 +1,495 @@
+#include "playbackdriver.h"
+
+#include "ui_playbackdriversettingswidget.h"
+#include "CustomWidgets/informationbox.h"
+
+#include <QDir>
+#include <QFileDialog>
+#include <QRegularExpression>
+#include <QtEndian>
+#include <algorithm>
+#include <cmath>
+
+using Stage = SweepRecorder::Stage;
+
+PlaybackDriver::PlaybackDriver()
+{
+    connected = false;
+    VNAStage = SAStage = activeStage = Stage::Last;
+    pendingValid = false;
+    SApoints = 0;
+    sweepsPlayed = 0;
+    finished = false;
+    generation = 0;
+
+    directory = "";
+    pacing = (int) Pacing::RealTime;
+    speed = 10.0;
+    loop = true;
+    specificSettings.push_back(Savable::SettingDescription(&directory, "PlaybackDriver.directory", ""));
+    specificSettings.push_back(Savable::SettingDescription(&pacing, "PlaybackDriver.pacing", (int) Pacing::RealTime));
+    specificSettings.push_back(Savable::SettingDescription(&speed, "PlaybackDriver.speed", 10.0));
+    specificSettings.push_back(Savable::SettingDescription(&loop, "PlaybackDriver.loop", true));
+
+    timer.setSingleShot(true);
+    connect(&timer, &QTimer::timeout, this, &PlaybackDriver::playNext);
+}
+
+PlaybackDriver::~PlaybackDriver()
+{
+    disconnect();
+}
+
+std::set<QString> PlaybackDriver::GetAvailableDevices()
+{
+    std::set<QString> ret;
+    detectedRecordings.clear();
+    if(directory.isEmpty()) {
+        return ret;
+    }
+    // recordings consist of numbered files: <name>_0000.<extension>, <name>_0001.<extension>, ...
+    static const QRegularExpression re("^(.*)_\\d{4}(\\.[^.]*)?$");
+    for(auto &fi : QDir(directory).entryInfoList(QDir::Files, QDir::Name)) {
+        auto match = re.match(fi.fileName());
+        if(!match.hasMatch()) {
+            continue;
+        }
+        QFile f(fi.absoluteFilePath());
+        if(!f.open(QIODevice::ReadOnly)) {
+            continue;
+        }
+        auto magic = f.read(sizeof(quint32));
+        if(magic.size() != sizeof(quint32) || qFromLittleEndian<quint32>(magic.constData()) != SweepRecorder::fileMagic) {
+            continue;
+        }
+        auto name = match.captured(1) + match.captured(2);
+        detectedRecordings[name].append(fi.absoluteFilePath());
+        ret.insert(name);
+    }
+    return ret;
+}
+
+bool PlaybackDriver::connectTo(QString serial)
+{
+    if(connected) {
+        disconnect();
+    }
+    if(!detectedRecordings.count(serial)) {
+        return false;
+    }
+
+    for(auto &name : detectedRecordings[serial]) {
+        File f;
+        f.file = std::make_unique<QFile>(name);
+        if(!f.file->open(QIODevice::ReadOnly)) {
+            InformationBox::ShowError("Error", "Unable to open "+name+": "+f.file->errorString());
+            files.clear();
+            return false;
+        }
+        f.size = f.file->size();
+        // the data is only read from disk when it is accessed, even huge recordings are available immediately
+        f.data = f.file->map(0, f.size);
+        if(!f.data || f.size < SweepRecorder::fileHeaderSize || qFromLittleEndian<quint32>(f.data) != SweepRecorder::fileMagic) {
+            InformationBox::ShowError("Error", "Unable to map "+name+" or not a valid recording");
+            files.clear();
+            return false;
+        }
+        files.push_back(std::move(f));
+    }
+    if(files.empty()) {
+        return false;
+    }
+
+    // the settings of all recorded stages are at the beginning of the first file
+    std::set<Stage> stages;
+    Position pos = {0, SweepRecorder::fileHeaderSize};
+    SweepRecorder::ChunkType type;
+    Stage stage;
+    const uchar *payload;
+    quint64 size;
+    for(unsigned int i=0;i<1000 && readChunk(pos, type, stage, payload, size);i++) {
+        if(type == SweepRecorder::ChunkType::Settings) {
+            stages.insert(stage);
+        }
+    }
+    auto firstOf = [&](std::vector<Stage> candidates) -> Stage {
+        for(auto s : candidates) {
+            if(stages.count(s)) {
+                return s;
+            }
+        }
+        return Stage::Last;
+    };
+    VNAStage = firstOf({Stage::VNARaw, Stage::VNACalibrated, Stage::VNADeembedded});
+    SAStage = firstOf({Stage::SARaw, Stage::SANormalized});
+
+    info = Info();
+    info.firmware_version = "File version "+QString::number(qFromLittleEndian<quint16>(files[0].data + 4));
+    info.hardware_version = "Playback";
+    VNAchannels.clear();
+    SAchannels.clear();
+    SweepRecorder::Sweep first;
+    position = {0, SweepRecorder::fileHeaderSize};
+    settings.clear();
+    if(VNAStage != Stage::Last && nextSweep(VNAStage, first) && first.x.size() > 0) {
+        info.supportedFeatures.insert(Feature::VNA);
+        info.supportedFeatures.insert(Feature::VNAFrequencySweep);
+        info.Limits.VNA.minFreq = first.x.front();
+        info.Limits.VNA.maxFreq = first.x.back();
+        unsigned int ports = 1;
+        static const QRegularExpression sparam("^S(\\d)(\\d)$");
+        for(auto &c : first.channels) {
+            VNAchannels.append(c);
+            auto match = sparam.match(c);
+            if(match.hasMatch()) {
+                ports = std::max(ports, (unsigned int) std::max(match.captured(1).toUInt(), match.captured(2).toUInt()));
+            }
+        }
+        info.Limits.VNA.ports = std::min(ports, maximumSupportedPorts);
+    } else {
+        VNAStage = Stage::Last;
+    }
+    position = {0, SweepRecorder::fileHeaderSize};
+    settings.clear();
+    if(SAStage != Stage::Last && nextSweep(SAStage, first) && first.x.size() > 0) {
+        info.supportedFeatures.insert(Feature::SA);
+        info.Limits.SA.minFreq = first.x.front();
+        info.Limits.SA.maxFreq = first.x.back();
+        info.Limits.SA.ports = std::min((unsigned int) first.channels.size(), maximumSupportedPorts);
+        for(auto &c : first.channels) {
+            SAchannels.append(c);
+        }
+        SApoints = first.x.size();
+    } else {
+        SAStage = Stage::Last;
+    }
+    if(VNAStage == Stage::Last && SAStage == Stage::Last) {
+        InformationBox::ShowError("Error", "The recording does not contain any complete sweeps");
+        files.clear();
+        return false;
+    }
+
+    position = {0, SweepRecorder::fileHeaderSize};
+    settings.clear();
+    this->serial = serial;
+    sweepsPlayed = 0;
+    finished = false;
+    connected = true;
+    emit InfoUpdated();
+    return true;
+}
+
+void PlaybackDriver::disconnect()
+{
+    generation++;
+    timer.stop();
+    activeStage = Stage::Last;
+    pendingValid = false;
+    for(auto &f : files) {
+        f.file->unmap((uchar*) f.data);
+    }
+    files.clear();
+    settings.clear();
+    connected = false;
+}
+
+QString PlaybackDriver::getStatus()
+{
+    if(!connected) {
+        return "";
+    }
+    if(finished) {
+        return "Playback of "+serial+" finished after "+QString::number(sweepsPlayed)+" sweeps";
+    }
+    return "Playing "+serial+", sweep "+QString::number(sweepsPlayed);
+}
+
+QWidget *PlaybackDriver::createSettingsWidget()
+{
+    auto w = new QWidget;
+    auto ui = new Ui::PlaybackDriverSettingsWidget;
+    ui->setupUi(w);
+
+    // Set initial values
+    ui->directory->setText(directory);
+    ui->pacing->setCurrentIndex(pacing);
+    ui->speed->setValue(speed);
+    ui->speed->setEnabled(pacing == (int) Pacing::Accelerated);
+    ui->loop->setChecked(loop);
+
+    // make connections to change the values
+    connect(ui->directory, &QLineEdit::textChanged, this, [=](){
+        directory = ui->directory->text();
+    });
+    connect(ui->browse, &QPushButton::clicked, this, [=](){
+        auto dir = QFileDialog::getExistingDirectory(w, "Select directory containing recordings", directory);
+        if(!dir.isEmpty()) {
+            ui->directory->setText(dir);
+        }
+    });
+    connect(ui->pacing, qOverload<int>(&QComboBox::currentIndexChanged), this, [=](int index){
+        pacing = index;
+        ui->speed->setEnabled(pacing == (int) Pacing::Accelerated);
+    });
+    connect(ui->speed, qOverload<double>(&QDoubleSpinBox::valueChanged), this, [=](double value){
+        speed = value;
+    });
+    connect(ui->loop, &QCheckBox::toggled, this, [=](bool checked){
+        loop = checked;
+    });
+    return w;
+}
+
+QStringList PlaybackDriver::availableVNAMeasurements()
+{
+    return VNAchannels;
+}
+
+bool PlaybackDriver::setVNA(const VNASettings &s, std::function<void (bool)> cb)
+{
+    if(!connected || VNAStage == Stage::Last) {
+        return false;
+    }
+    VNAsettings = s;
+    startPlayback(VNAStage);
+    if(cb) {
+        cb(true);
+    }
+    return true;
+}
+
+QStringList PlaybackDriver::availableSAMeasurements()
+{
+    return SAchannels;
+}
+
+bool PlaybackDriver::setSA(const SASettings &s, std::function<void (bool)> cb)
+{
+    Q_UNUSED(s)
+    if(!connected || SAStage == Stage::Last) {
+        return false;
+    }
+    startPlayback(SAStage);
+    if(cb) {
+        cb(true);
+    }
+    return true;
+}
+
+unsigned int PlaybackDriver::getSApoints()
+{
+    return SApoints;
+}
+
+bool PlaybackDriver::setIdle(std::function<void (bool)> cb)
+{
+    generation++;
+    timer.stop();
+    activeStage = Stage::Last;
+    if(cb) {
+        cb(true);
+    }
+    return true;
+}
+
+void PlaybackDriver::setPacing(Pacing pacing, double speed)
+{
+    this->pacing = (int) pacing;
+    this->speed = speed;
+}
+
+bool PlaybackDriver::readChunk(Position &pos, SweepRecorder::ChunkType &type, Stage &stage, const uchar *&payload, quint64 &size)
+{
+    auto &f = files[pos.file];
+    if(pos.offset + SweepRecorder::chunkHeaderSize > f.size) {
+        // end of file (or truncated chunk header)
+        return false;
+    }
+    auto src = f.data + pos.offset;
+    if(f.size - pos.offset == SweepRecorder::trailerSize && qFromLittleEndian<quint32>(src + 8) == SweepRecorder::indexMagic) {
+        // reached the trailer
+        return false;
+    }
+    type = (SweepRecorder::ChunkType) qFromLittleEndian<quint32>(src);
+    stage = (Stage) qFromLittleEndian<quint32>(src + 4);
+    size = qFromLittleEndian<quint64>(src + 8);
+    if(size > f.size - pos.offset - SweepRecorder::chunkHeaderSize) {
+        // incomplete chunk, the file was not closed properly
+        return false;
+    }
+    payload = src + SweepRecorder::chunkHeaderSize;
+    pos.offset += SweepRecorder::chunkHeaderSize + size;
+    return true;
+}
+
+bool PlaybackDriver::nextSweep(Stage stage, SweepRecorder::Sweep &sweep)
+{
+    bool wrapped = false;
+    while(true) {
+        SweepRecorder::ChunkType type;
+        Stage chunkStage;
+        const uchar *payload;
+        quint64 size;
+        if(!readChunk(position, type, chunkStage, payload, size)) {
+            // every file starts with its own settings
+            settings.clear();
+            if(position.file + 1 < files.size()) {
+                position = {position.file + 1, SweepRecorder::fileHeaderSize};
+                continue;
+            } else if(loop && !wrapped) {
+                wrapped = true;
+                position = {0, SweepRecorder::fileHeaderSize};
+                continue;
+            }
+            return false;
+        }
+        if(type == SweepRecorder::ChunkType::Settings) {
+            auto &s = settings[chunkStage];
+            s.stage = chunkStage;
+            if(!SweepRecorder::decodeSettings(payload, size, s)) {
+                settings.erase(chunkStage);
+            }
+        } else if(type == SweepRecorder::ChunkType::Sweep && chunkStage == stage && settings.count(stage)) {
+            auto &s = settings[stage];
+            sweep.stage = stage;
+            sweep.channels = s.channels;
+            sweep.Z0 = s.Z0;
+            sweep.settings = s.settings;
+            if(SweepRecorder::decodeSweep(payload, size, sweep)) {
+                return true;
+            }
+        }
+    }
+}
+
+void PlaybackDriver::startPlayback(Stage stage)
+{
+    generation++;
+    timer.stop();
+    activeStage = stage;
+    finished = false;
+    // continue at the current position, only sweeps of the new stage are considered
+    pendingValid = nextSweep(stage, pending);
+    if(pendingValid) {
+        timer.start(0);
+    } else {
+        finished = true;
+    }
+    emit StatusUpdated();
+}
+
+void PlaybackDriver::playNext()
+{
+    if(!pendingValid || activeStage == Stage::Last) {
+        return;
+    }
+    SweepRecorder::Sweep current;
+    std::swap(current, pending);
+    auto gen = generation;
+    if(current.isVNA()) {
+        emitVNASweep(current);
+    } else {
+        emitSASweep(current);
+    }
+    if(gen != generation) {
+        // the playback has been stopped or restarted while the sweep was processed
+        return;
+    }
+    sweepsPlayed++;
+    pendingValid = nextSweep(activeStage, pending);
+    if(!pendingValid) {
+        finished = true;
+        emit StatusUpdated();
+        return;
+    }
+    int delay = 0;
+    if(pacing != (int) Pacing::Fastest) {
+        double diff = pending.timestamp - current.timestamp;
+        if(pacing == (int) Pacing::Accelerated && speed > 0) {
+            diff /= speed;
+        }
+        // timestamps jump backwards when looping, long pauses in the recording are shortened
+        delay = std::clamp(diff, 0.0, 10000.0);
+    }
+    timer.start(delay);
+    emit StatusUpdated();
+}
+
+void PlaybackDriver::emitVNASweep(const SweepRecorder::Sweep &sweep)
+{
+    auto &x = sweep.x;
+    if(x.empty() || VNAsettings.points <= 0) {
+        return;
+    }
+    if(sweep.settings.zerospan || sweep.settings.type == "POWER") {
+        // x holds the time (zero span) or a constant frequency (power sweep), there is nothing to
+        // interpolate over. Replay the points as recorded
+        unsigned int points = std::min(x.size(), (size_t) VNAsettings.points);
+        for(unsigned int i=0;i<points;i++) {
+            VNAMeasurement m;
+            m.pointNum = i;
+            m.Z0 = sweep.Z0;
+            if(sweep.settings.zerospan) {
+                m.frequency = sweep.settings.start;
+                m.us = x[i];
+            } else {
+                m.frequency = x[i];
+            }
+            m.dBm = sweep.dBm[i];
+            for(unsigned int c=0;c<sweep.channels.size();c++) {
+                m.measurements[sweep.channels[c]] = std::complex<double>(sweep.data[c][2*i], sweep.data[c][2*i+1]);
+            }
+            emit VNAmeasurementReceived(m);
+        }
+        return;
+    }
+    // interpolate the recorded sweep onto the requested points
+    for(int i=0;i<VNAsettings.points;i++) {
+        double f = VNAsettings.freqStart;
+        if(VNAsettings.points > 1) {
+            double a = (double) i / (VNAsettings.points - 1);
+            if(VNAsettings.logSweep && VNAsettings.freqStart > 0) {
+                f = VNAsettings.freqStart * pow(VNAsettings.freqStop / VNAsettings.freqStart, a);
+            } else {
+                f = VNAsettings.freqStart + (VNAsettings.freqStop - VNAsettings.freqStart) * a;
+            }
+        }
+        unsigned int upper = std::lower_bound(x.begin(), x.end(), f) - x.begin();
+        unsigned int lower = upper;
+        double a = 0.0;
+        if(upper == 0) {
+            lower = upper = 0;
+        } else if(upper >= x.size()) {
+            lower = upper = x.size() - 1;
+        } else {
+            lower = upper - 1;
+            a = (f - x[lower]) / (x[upper] - x[lower]);
+        }
+        VNAMeasurement m;
+        m.pointNum = i;
+        m.Z0 = sweep.Z0;
+        m.frequency = f;
+        m.dBm = sweep.dBm[lower] * (1.0 - a) + sweep.dBm[upper] * a;
+        for(unsigned int c=0;c<sweep.channels.size();c++) {
+            auto &column = sweep.data[c];
+            std::complex<double> low(column[2*lower], column[2*lower+1]);
+            std::complex<double> high(column[2*upper], column[2*upper+1]);
+            m.measurements[sweep.channels[c]] = low * (1.0 - a) + high * a;
+        }
+        emit VNAmeasurementReceived(m);
+    }
+}
+
+void PlaybackDriver::emitSASweep(const SweepRecorder::Sweep &sweep)
+{
+    SApoints = sweep.x.size();
+    for(unsigned int i=0;i<sweep.x.size();i++) {
+        SAMeasurement m;
+        m.pointNum = i;
+        m.frequency = sweep.x[i];
+        for(unsigned int c=0;c<sweep.channels.size();c++) {
+            m.measurements[sweep.channels[c]] = sweep.data[c][i];
+        }
+        emit SAmeasurementReceived(m);
+    }
+}
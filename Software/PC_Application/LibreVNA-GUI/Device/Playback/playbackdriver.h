@@ -0,0 +1,216 @@
+#ifndef PLAYBACKDRIVER_H
+#define PLAYBACKDRIVER_H
+
+#include "../devicedriver.h"
+#include "sweeprecorder.h"
+
+#include <QFile>
+#include <QTimer>
+
+#include <memory>
+
+/**
+ * @brief PlaybackDriver
+ *
+ * Virtual device which replays sweeps that have been recorded by the SweepRecorder. Every recording
+ * (consisting of all numbered files with the same base name) in the configured directory shows up
+ * as a separate device. The files are memory mapped and decoded one sweep at a time, so even very
+ * large recordings are available immediately.
+ *
+ * VNA frequency sweeps are interpolated onto the requested sweep settings. The points of zero span
+ * and power sweeps as well as SA sweeps are passed on as recorded. If a recording contains several
+ * stages, the raw data is preferred.
+ */
+class PlaybackDriver : public DeviceDriver
+{
+public:
+    PlaybackDriver();
+    virtual ~PlaybackDriver();
+
+    /**
+     * @brief Returns the driver name. It must be unique across all implemented drivers and is used to identify the driver
+     * @return driver name
+     */
+    virtual QString getDriverName() override {return "Playback";}
+    /**
+     * @brief Lists all available devices by their serial numbers
+     * @return Serial numbers of detected devices
+     */
+    virtual std::set<QString> GetAvailableDevices() override;
+
+protected:
+    /**
+     * @brief Connects to a device, given by its serial number
+     *
+     * @param serial Serial number of device that should be connected to
+     * @return true if connection successful, otherwise false
+     */
+    virtual bool connectTo(QString serial) override;
+    /**
+     * @brief Disconnects from device. Has no effect if no device was connected
+     */
+    virtual void disconnect() override;
+
+public:
+    /**
+     * @brief Returns the serial number of the connected device
+     * @return Serial number of connected device (empty string if no device is connected)
+     */
+    virtual QString getSerial() override {return serial;}
+
+    /**
+     * @brief Returns the device information. This function will be called when a device has been connected. Its return value must be valid
+     * directly after returning from DeviceDriver::connectTo()
+     *
+     * Emit the InfoUpdate() signal whenever the return value of this function changes.
+     *
+     * @return Device information
+     */
+    virtual Info getInfo() override {return info;}
+
+    /**
+     * @brief Returns a set of all active flags
+     *
+     * There is also a convenience function to check a specific flag, see DeviceDriver::asserted()
+     *
+     * @return Set of active flags
+     */
+    virtual std::set<Flag> getFlags() override {return std::set<Flag>();}
+
+    /**
+     * @brief Returns the device status string. It will be displayed in the status bar of the application
+     *
+     * Emit the StatusUpdated() signal whenever the return value of this function changes
+     *
+     * @return Status string
+     */
+    virtual QString getStatus() override;
+
+    /**
+     * @brief Returns a widget to edit the driver specific settings.
+     *
+     * The widget is displayed in the global settings dialog and allows the user to edit the settings
+     * specific to this driver. The application takes ownership of the widget after returning,
+     * create a new widget for every call to this function. If the driver has no specific settings
+     * or the settings do not need to be editable by the user, return a nullptr. In this case, no
+     * page for this driver is created in the settings dialog
+     * @return newly constructed settings widget or nullptr
+     */
+    virtual QWidget *createSettingsWidget() override;
+
+    /**
+     * @brief Names of available measurements.
+     *
+     * The names must be identical to the names used in the returned VNAMeasurement.
+     * Typically the S parameters, e.g. this function may return {"S11","S12","S21","S22"} but any other names are also allowed.
+     *
+     * @return List of available VNA measurement parameters
+     */
+    virtual QStringList availableVNAMeasurements() override;
+
+    /**
+     * @brief Configures the VNA and starts a sweep
+     * @param s VNA settings
+     * @param cb Callback, must be called after the VNA has been configured
+     * @return true if configuration successful, false otherwise
+     */
+    virtual bool setVNA(const VNASettings &s, std::function<void(bool)> cb = nullptr) override;
+
+    /**
+     * @brief Names of available measurements.
+     *
+     * The names must be identical to the names used in the returned SAMeasurement.
+     * Typically the port names, e.g. this function may return {"PORT1","PORT2"} but any other names are also allowed.
+     *
+     * @return List of available SA measurement parameters
+     */
+    virtual QStringList availableSAMeasurements() override;
+    /**
+     * @brief Configures the SA and starts a sweep
+     * @param s SA settings
+     * @param cb Callback, must be called after the SA has been configured
+     * @return true if configuration successful, false otherwise
+     */
+    virtual bool setSA(const SASettings &s, std::function<void(bool)> cb = nullptr) override;
+
+    /**
+     * @brief Returns the number of points in one spectrum analyzer sweep (as configured by the last setSA() call)
+     * @return Number of points in the sweep
+     */
+    virtual unsigned int getSApoints() override;
+
+    /**
+     * @brief Sets the device to idle
+     *
+     * Stops all sweeps and signal generation
+     *
+     * @param cb Callback, must be called after the device has stopped all operations
+     * @return true if configuration successful, false otherwise
+     */
+    virtual bool setIdle(std::function<void(bool)> cb = nullptr) override;
+
+    enum class Pacing {
+        // sweeps are replayed with the same timing as they were recorded
+        RealTime = 0,
+        // recorded timing, sped up by the configured factor
+        Accelerated = 1,
+        // as fast as the application is able to process the sweeps
+        Fastest = 2,
+    };
+    void setPacing(Pacing pacing, double speed = 1.0);
+    void setRecordingDirectory(QString directory) {this->directory = directory;}
+    void setLoop(bool loop) {this->loop = loop;}
+
+private:
+    class File {
+    public:
+        std::unique_ptr<QFile> file;
+        const uchar *data;
+        quint64 size;
+    };
+    class Position {
+    public:
+        unsigned int file;
+        quint64 offset;
+    };
+
+    // Reads the chunk at the position and advances to the next chunk. Returns false at the end of the file
+    bool readChunk(Position &pos, SweepRecorder::ChunkType &type, SweepRecorder::Stage &stage, const uchar *&payload, quint64 &size);
+    // Decodes the next sweep of the stage, continuing in the next file (or from the beginning if looping is enabled)
+    bool nextSweep(SweepRecorder::Stage stage, SweepRecorder::Sweep &sweep);
+    void startPlayback(SweepRecorder::Stage stage);
+    void playNext();
+    void emitVNASweep(const SweepRecorder::Sweep &sweep);
+    void emitSASweep(const SweepRecorder::Sweep &sweep);
+
+    QString serial;
+    bool connected;
+    Info info;
+    std::vector<File> files;
+    Position position;
+    // channels and Z0 at the current position of each stage
+    std::map<SweepRecorder::Stage, SweepRecorder::Sweep> settings;
+    SweepRecorder::Stage VNAStage, SAStage, activeStage;
+    QStringList VNAchannels, SAchannels;
+    SweepRecorder::Sweep pending;
+    bool pendingValid;
+    unsigned int SApoints;
+    quint64 sweepsPlayed;
+    bool finished;
+    // incremented whenever the playback is stopped or restarted
+    unsigned int generation;
+
+    VNASettings VNAsettings;
+    QTimer timer;
+
+    // recordings in the directory (serial -> files)
+    std::map<QString, QStringList> detectedRecordings;
+
+    // driver specific settings
+    QString directory;
+    int pacing;
+    double speed;
+    bool loop;
+};
+
+#endif // PLAYBACKDRIVER_H
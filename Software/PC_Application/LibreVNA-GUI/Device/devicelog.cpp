@@ -2,30 +2,209 @@
 
 #include "ui_devicelog.h"
 
-#include <QScrollBar>
 #include <QFileDialog>
+#include <QColor>
 #include <fstream>
+#include <memory>
 
 using namespace std;
 
+DeviceLogModel::DeviceLogModel(QObject *parent)
+    : QAbstractListModel(parent),
+      firstLine(0),
+      limit(0),
+      filter(this)
+{
+    updateTimer.setSingleShot(true);
+    updateTimer.setInterval(updateInterval);
+    connect(&updateTimer, &QTimer::timeout, this, &DeviceLogModel::flush);
+}
+
+int DeviceLogModel::rowCount(const QModelIndex &parent) const
+{
+    if(parent.isValid()) {
+        return 0;
+    }
+    return visible.size();
+}
+
+QVariant DeviceLogModel::data(const QModelIndex &index, int role) const
+{
+    if(!index.isValid() || index.row() >= (int) visible.size()) {
+        return QVariant();
+    }
+    auto &line = lines[visible[index.row()] - firstLine];
+    switch(role) {
+    case Qt::DisplayRole:
+        return line;
+    case Qt::ForegroundRole:
+        // Set color depending on log level
+        if(line.contains(",CRT]")) {
+            return QColor(Qt::red);
+        } else if(line.contains(",ERR]")) {
+            return QColor(255, 94, 0);
+        } else if(line.contains(",WRN]")) {
+            return QColor(255, 174, 26);
+        } else if(line.contains(",DBG")) {
+            return QColor(Qt::gray);
+        }
+        return QVariant();
+    default:
+        return QVariant();
+    }
+}
+
+void DeviceLogModel::addLine(QString line)
+{
+    pending.append(line);
+    if(!updateTimer.isActive()) {
+        updateTimer.start();
+    }
+}
+
+void DeviceLogModel::clear()
+{
+    filter.cancel();
+    beginResetModel();
+    firstLine += lines.size();
+    lines.clear();
+    visible.clear();
+    pending.clear();
+    endResetModel();
+}
+
+void DeviceLogModel::setLineLimit(unsigned int limit)
+{
+    this->limit = limit;
+    trim();
+}
+
+void DeviceLogModel::setFilter(QString text)
+{
+    filterText = text;
+    if(text.isEmpty()) {
+        filter.cancel();
+        beginResetModel();
+        visible.resize(lines.size());
+        for(unsigned int i=0;i<lines.size();i++) {
+            visible[i] = firstLine + i;
+        }
+        endResetModel();
+        return;
+    }
+    // QString is implicitly shared, copying the lines is cheap
+    auto snapshot = make_shared<vector<QString>>(lines.begin(), lines.end());
+    auto snapshotFirst = firstLine;
+    auto snapshotEnd = firstLine + lines.size();
+    filter.start(snapshot->size(), [=](unsigned int row) {
+        return (*snapshot)[row].contains(text, Qt::CaseInsensitive);
+    }, [=](vector<unsigned int> matching) {
+        // lines may have been added or removed while filtering
+        beginResetModel();
+        visible.clear();
+        for(auto m : matching) {
+            if(snapshotFirst + m >= firstLine) {
+                visible.push_back(snapshotFirst + m);
+            }
+        }
+        for(auto n = max(snapshotEnd, firstLine);n < firstLine + lines.size();n++) {
+            if(matches(lines[n - firstLine])) {
+                visible.push_back(n);
+            }
+        }
+        endResetModel();
+    });
+}
+
+QStringList DeviceLogModel::getLines() const
+{
+    QStringList ret;
+    for(auto &l : lines) {
+        ret.append(l);
+    }
+    return ret + pending;
+}
+
+void DeviceLogModel::flush()
+{
+    if(pending.isEmpty()) {
+        return;
+    }
+    auto first = firstLine + lines.size();
+    unsigned int added = 0;
+    for(auto &l : pending) {
+        lines.push_back(l);
+        if(matches(l)) {
+            added++;
+        }
+    }
+    pending.clear();
+    if(added) {
+        beginInsertRows(QModelIndex(), visible.size(), visible.size() + added - 1);
+        for(auto n = first;n < firstLine + lines.size();n++) {
+            if(matches(lines[n - firstLine])) {
+                visible.push_back(n);
+            }
+        }
+        endInsertRows();
+    }
+    trim();
+    emit linesAdded();
+}
+
+void DeviceLogModel::trim()
+{
+    if(!limit || lines.size() <= limit) {
+        return;
+    }
+    auto remove = lines.size() - limit;
+    unsigned int removedRows = 0;
+    while(removedRows < visible.size() && visible[removedRows] < firstLine + remove) {
+        removedRows++;
+    }
+    if(removedRows) {
+        beginRemoveRows(QModelIndex(), 0, removedRows - 1);
+        visible.erase(visible.begin(), visible.begin() + removedRows);
+    }
+    lines.erase(lines.begin(), lines.begin() + remove);
+    firstLine += remove;
+    if(removedRows) {
+        endRemoveRows();
+    }
+}
+
+bool DeviceLogModel::matches(const QString &line) const
+{
+    return filterText.isEmpty() || line.contains(filterText, Qt::CaseInsensitive);
+}
+
 DeviceLog::DeviceLog(QWidget *parent) :
     QWidget(parent),
     ui(new Ui::DeviceLog)
 {
     ui->setupUi(this);
+    ui->list->setModel(&model);
+    // all lines have the same height, no need to measure every line
+    ui->list->setUniformItemSizes(true);
     connect(ui->bClear, &QPushButton::clicked, this, &DeviceLog::clear);
     connect(ui->limitLines, &QCheckBox::toggled, [=](bool enabled){
         if(enabled) {
-            ui->text->setMaximumBlockCount(ui->numLines->value());
+            model.setLineLimit(ui->numLines->value());
             ui->numLines->setEnabled(true);
         } else {
-            ui->text->setMaximumBlockCount(0);
+            model.setLineLimit(0);
             ui->numLines->setEnabled(false);
         }
     });
-    ui->text->setMaximumBlockCount(ui->numLines->value());
+    model.setLineLimit(ui->numLines->value());
     connect(ui->numLines, qOverload<int>(&QSpinBox::valueChanged), [=](int lines) {
-        ui->text->setMaximumBlockCount(lines);
+        model.setLineLimit(lines);
+    });
+    connect(ui->filter, &QLineEdit::textChanged, &model, &DeviceLogModel::setFilter);
+    connect(&model, &DeviceLogModel::linesAdded, [=](){
+        if(ui->cbAutoscroll->isChecked()) {
+            ui->list->scrollToBottom();
+        }
     });
 }
 
@@ -36,31 +215,12 @@ DeviceLog::~DeviceLog()
 
 void DeviceLog::addLine(QString line)
 {
-    // Set color depending on log level
-    QColor color = Qt::black;
-    if(line.contains(",CRT]")) {
-        color = Qt::red;
-    } else if(line.contains(",ERR]")) {
-        color = QColor(255, 94, 0);
-    } else if(line.contains(",WRN]")) {
-        color = QColor(255, 174, 26);
-    } else if(line.contains(",DBG")) {
-        color = Qt::gray;
-    }
-    QTextCharFormat tf;
-    tf = ui->text->currentCharFormat();
-    tf.setForeground(QBrush(color));
-    ui->text->setCurrentCharFormat(tf);
-    ui->text->appendPlainText(line);
-    if(ui->cbAutoscroll->isChecked()) {
-        QScrollBar *sb = ui->text->verticalScrollBar();
-        sb->setValue(sb->maximum());
-    }
+    model.addLine(line);
 }
 
 void DeviceLog::clear()
 {
-    ui->text->clear();
+    model.clear();
 }
 
 void DeviceLog::on_bToFile_clicked()
@@ -70,7 +230,9 @@ void DeviceLog::on_bToFile_clicked()
         // create file
         ofstream file;
         file.open(filename.toStdString());
-        file << ui->text->toPlainText().toStdString();
+        for(auto &l : model.getLines()) {
+            file << l.toStdString() << endl;
+        }
         file.close();
     }
 }
@@ -1,12 +1,63 @@
 #ifndef DEVICELOG_H
 #define DEVICELOG_H
 
+#include "Util/backgroundfilter.h"
+
 #include <QWidget>
+#include <QAbstractListModel>
+#include <QTimer>
+
+#include <deque>
 
 namespace Ui {
 class DeviceLog;
 }
 
+/*
+ * Lines of the device log. New lines are collected and inserted in batches (at most every updateInterval), only the
+ * visible lines are formatted. Filtering the lines runs in a worker thread.
+ */
+class DeviceLogModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    DeviceLogModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    void addLine(QString line);
+    void clear();
+    // 0 keeps all lines
+    void setLineLimit(unsigned int limit);
+    // Only lines containing the text are shown (case insensitive), an empty filter shows all lines
+    void setFilter(QString text);
+    bool isFiltering() const {return filter.isRunning();}
+    // All lines, including lines hidden by the filter
+    QStringList getLines() const;
+
+    static constexpr int updateInterval = 100;
+
+signals:
+    void linesAdded();
+
+private:
+    void flush();
+    void trim();
+    bool matches(const QString &line) const;
+
+    // all lines, lines.front() is the line number firstLine (counted since the creation of the model)
+    std::deque<QString> lines;
+    unsigned long long firstLine;
+    // line numbers of the lines that pass the filter
+    std::deque<unsigned long long> visible;
+    QStringList pending;
+    unsigned int limit;
+    QString filterText;
+    BackgroundFilter filter;
+    QTimer updateTimer;
+};
+
 class DeviceLog : public QWidget
 {
     Q_OBJECT
@@ -24,6 +75,7 @@ private slots:
 
 private:
     Ui::DeviceLog *ui;
+    DeviceLogModel model;
 };
 
 #endif // DEVICELOG_H
@@ -0,0 +1,421 @@
+# Sources shared by the GUI, the tests (LibreVNA-Test) and the benchmarks (LibreVNA-Bench). The including project
+# only adds its own main.cpp and settings
+
+HEADERS += \
+    $$PWD/../../VNA_embedded/Application/Communication/Protocol.hpp \
+    $$PWD/../../VNA_embedded/Application/Communication/PacketConstants.h \
+    $$PWD/Calibration/LibreCAL/caldevice.h \
+    $$PWD/Calibration/LibreCAL/librecaldialog.h \
+    $$PWD/Calibration/LibreCAL/usbdevice.h \
+    $$PWD/Calibration/calibration.h \
+    $$PWD/Calibration/calibrationmeasurement.h \
+    $$PWD/Calibration/calkit.h \
+    $$PWD/Calibration/calkitdialog.h \
+    $$PWD/Calibration/calstandard.h \
+    $$PWD/Calibration/manualcalibrationdialog.h \
+    $$PWD/CustomWidgets/colorpickerbutton.h \
+    $$PWD/CustomWidgets/csvimport.h \
+    $$PWD/CustomWidgets/informationbox.h \
+    $$PWD/CustomWidgets/jsonpickerdialog.h \
+    $$PWD/CustomWidgets/siunitedit.h \
+    $$PWD/CustomWidgets/tilewidget.h \
+    $$PWD/CustomWidgets/toggleswitch.h \
+    $$PWD/CustomWidgets/touchstoneimport.h \
+    $$PWD/CustomWidgets/tracesetselector.h \
+    $$PWD/Device/LibreVNA/Compound/compounddevice.h \
+    $$PWD/Device/LibreVNA/Compound/compounddeviceeditdialog.h \
+    $$PWD/Device/LibreVNA/Compound/compounddriver.h \
+    $$PWD/Device/LibreVNA/amplitudecaldialog.h \
+    $$PWD/Device/LibreVNA/deviceconfigurationdialogv1.h \
+    $$PWD/Device/LibreVNA/deviceconfigurationdialogvfe.h \
+    $$PWD/Device/LibreVNA/deviceconfigurationdialogvff.h \
+    $$PWD/Device/LibreVNA/devicepacketlog.h \
+    $$PWD/Device/LibreVNA/devicepacketlogview.h \
+    $$PWD/Device/LibreVNA/firmwareupdatedialog.h \
+    $$PWD/Device/LibreVNA/frequencycaldialog.h \
+    $$PWD/Device/LibreVNA/librevnadriver.h \
+    $$PWD/Device/LibreVNA/librevnasimulator.h \
+    $$PWD/Device/LibreVNA/librevnatcpdriver.h \
+    $$PWD/Device/LibreVNA/librevnausbdriver.h \
+    $$PWD/Device/LibreVNA/manualcontroldialogV1.h \
+    $$PWD/Device/LibreVNA/manualcontroldialogvfe.h \
+    $$PWD/Device/LibreVNA/manualcontroldialogvff.h \
+    $$PWD/Device/LibreVNA/receivercaldialog.h \
+    $$PWD/Device/LibreVNA/sourcecaldialog.h \
+    $$PWD/Device/Playback/playbackdriver.h \
+    $$PWD/Device/SNA5000A/sna5000adriver.h \
+    $$PWD/Device/SSA3000X/ssa3000xdriver.h \
+    $$PWD/Device/devicedriver.h \
+    $$PWD/Device/devicelog.h \
+    $$PWD/Device/devicetcpdriver.h \
+    $$PWD/Device/tracedifferencegenerator.h \
+    $$PWD/Generator/generator.h \
+    $$PWD/Generator/signalgenwidget.h \
+    $$PWD/SpectrumAnalyzer/spectrumanalyzer.h \
+    $$PWD/SpectrumAnalyzer/tracewidgetsa.h \
+    $$PWD/Tools/eseries.h \
+    $$PWD/Tools/impedancematchdialog.h \
+    $$PWD/Tools/mixedmodeconversion.h \
+    $$PWD/Tools/parameters.h \
+    $$PWD/Traces/Marker/marker.h \
+    $$PWD/Traces/Marker/markergroup.h \
+    $$PWD/Traces/Marker/markermodel.h \
+    $$PWD/Traces/Marker/markerwidget.h \
+    $$PWD/Traces/Math/dft.h \
+    $$PWD/Traces/Math/expression.h \
+    $$PWD/Traces/Math/medianfilter.h \
+    $$PWD/Traces/Math/parser/mpCompat.h \
+    $$PWD/Traces/Math/parser/mpDefines.h \
+    $$PWD/Traces/Math/parser/mpError.h \
+    $$PWD/Traces/Math/parser/mpFuncCmplx.h \
+    $$PWD/Traces/Math/parser/mpFuncCommon.h \
+    $$PWD/Traces/Math/parser/mpFuncMatrix.h \
+    $$PWD/Traces/Math/parser/mpFuncNonCmplx.h \
+    $$PWD/Traces/Math/parser/mpFuncStr.h \
+    $$PWD/Traces/Math/parser/mpFwdDecl.h \
+    $$PWD/Traces/Math/parser/mpICallback.h \
+    $$PWD/Traces/Math/parser/mpIOprt.h \
+    $$PWD/Traces/Math/parser/mpIPackage.h \
+    $$PWD/Traces/Math/parser/mpIPrecedence.h \
+    $$PWD/Traces/Math/parser/mpIToken.h \
+    $$PWD/Traces/Math/parser/mpIValReader.h \
+    $$PWD/Traces/Math/parser/mpIValue.h \
+    $$PWD/Traces/Math/parser/mpIfThenElse.h \
+    $$PWD/Traces/Math/parser/mpMatrix.h \
+    $$PWD/Traces/Math/parser/mpMatrixError.h \
+    $$PWD/Traces/Math/parser/mpOprtBinAssign.h \
+    $$PWD/Traces/Math/parser/mpOprtBinCommon.h \
+    $$PWD/Traces/Math/parser/mpOprtCmplx.h \
+    $$PWD/Traces/Math/parser/mpOprtIndex.h \
+    $$PWD/Traces/Math/parser/mpOprtMatrix.h \
+    $$PWD/Traces/Math/parser/mpOprtNonCmplx.h \
+    $$PWD/Traces/Math/parser/mpOprtPostfixCommon.h \
+    $$PWD/Traces/Math/parser/mpPackageCmplx.h \
+    $$PWD/Traces/Math/parser/mpPackageCommon.h \
+    $$PWD/Traces/Math/parser/mpPackageMatrix.h \
+    $$PWD/Traces/Math/parser/mpPackageNonCmplx.h \
+    $$PWD/Traces/Math/parser/mpPackageStr.h \
+    $$PWD/Traces/Math/parser/mpPackageUnit.h \
+    $$PWD/Traces/Math/parser/mpParser.h \
+    $$PWD/Traces/Math/parser/mpParserBase.h \
+    $$PWD/Traces/Math/parser/mpParserMessageProvider.h \
+    $$PWD/Traces/Math/parser/mpRPN.h \
+    $$PWD/Traces/Math/parser/mpScriptTokens.h \
+    $$PWD/Traces/Math/parser/mpStack.h \
+    $$PWD/Traces/Math/parser/mpTest.h \
+    $$PWD/Traces/Math/parser/mpTokenReader.h \
+    $$PWD/Traces/Math/parser/mpTypes.h \
+    $$PWD/Traces/Math/parser/mpValReader.h \
+    $$PWD/Traces/Math/parser/mpValue.h \
+    $$PWD/Traces/Math/parser/mpValueCache.h \
+    $$PWD/Traces/Math/parser/mpVariable.h \
+    $$PWD/Traces/Math/parser/suSortPred.h \
+    $$PWD/Traces/Math/parser/suStringTokens.h \
+    $$PWD/Traces/Math/parser/utGeneric.h \
+    $$PWD/Traces/Math/tdr.h \
+    $$PWD/Traces/Math/timegate.h \
+    $$PWD/Traces/Math/tracemath.h \
+    $$PWD/Traces/Math/windowfunction.h \
+    $$PWD/Traces/eyediagramplot.h \
+    $$PWD/Traces/fftcomplex.h \
+    $$PWD/Traces/renderscheduler.h \
+    $$PWD/Traces/sparamtraceselector.h \
+    $$PWD/Traces/trace.h \
+    $$PWD/Traces/traceaxis.h \
+    $$PWD/Traces/tracecsvexport.h \
+    $$PWD/Traces/traceeditdialog.h \
+    $$PWD/Traces/traceimportdialog.h \
+    $$PWD/Traces/tracemodel.h \
+    $$PWD/Traces/traceplot.h \
+    $$PWD/Traces/tracesmithchart.h \
+    $$PWD/Traces/tracetouchstoneexport.h \
+    $$PWD/Traces/tracewaterfall.h \
+    $$PWD/Traces/tracewidget.h \
+    $$PWD/Traces/tracexyplot.h \
+    $$PWD/Traces/tracepolar.h \
+    $$PWD/Traces/waterfallaxisdialog.h \
+    $$PWD/Traces/xyplotaxisdialog.h \
+    $$PWD/Traces/tracepolarchart.h \
+    $$PWD/Util/backgroundfilter.h \
+    $$PWD/Util/latencytracer.h \
+    $$PWD/Util/metrics.h \
+    $$PWD/Util/numberformatter.h \
+    $$PWD/Util/prbs.h \
+    $$PWD/Util/qpointervariant.h \
+    $$PWD/Util/usbinbuffer.h \
+    $$PWD/Util/util.h \
+    $$PWD/Util/app_common.h \
+    $$PWD/VNA/Deembedding/deembedding.h \
+    $$PWD/VNA/Deembedding/deembeddingdialog.h \
+    $$PWD/VNA/Deembedding/deembeddingoption.h \
+    $$PWD/VNA/Deembedding/impedancerenormalization.h \
+    $$PWD/VNA/Deembedding/manualdeembeddingdialog.h \
+    $$PWD/VNA/Deembedding/matchingnetwork.h \
+    $$PWD/VNA/Deembedding/portextension.h \
+    $$PWD/VNA/Deembedding/twothru.h \
+    $$PWD/VNA/tracewidgetvna.h \
+    $$PWD/VNA/vna.h \
+    $$PWD/VNA/vnapipeline.h \
+    $$PWD/about.h \
+    $$PWD/appwindow.h \
+    $$PWD/averaging.h \
+    $$PWD/csv.h \
+    $$PWD/json.hpp \
+    $$PWD/metricsserver.h \
+    $$PWD/modehandler.h \
+    $$PWD/mode.h \
+    $$PWD/modewindow.h \
+    $$PWD/preferences.h \
+    $$PWD/savable.h \
+    $$PWD/scpi.h \
+    $$PWD/streamingserver.h \
+    $$PWD/sweeprecorder.h \
+    $$PWD/tcpserver.h \
+    $$PWD/touchstone.h \
+    $$PWD/unit.h
+
+SOURCES += \
+    $$PWD/../../VNA_embedded/Application/Communication/Protocol.cpp \
+    $$PWD/Calibration/LibreCAL/caldevice.cpp \
+    $$PWD/Calibration/LibreCAL/librecaldialog.cpp \
+    $$PWD/Calibration/LibreCAL/usbdevice.cpp \
+    $$PWD/Calibration/calibration.cpp \
+    $$PWD/Calibration/calibrationmeasurement.cpp \
+    $$PWD/Calibration/calkit.cpp \
+    $$PWD/Calibration/calkitdialog.cpp \
+    $$PWD/Calibration/calstandard.cpp \
+    $$PWD/Calibration/manualcalibrationdialog.cpp \
+    $$PWD/CustomWidgets/colorpickerbutton.cpp \
+    $$PWD/CustomWidgets/csvimport.cpp \
+    $$PWD/CustomWidgets/informationbox.cpp \
+    $$PWD/CustomWidgets/jsonpickerdialog.cpp \
+    $$PWD/CustomWidgets/siunitedit.cpp \
+    $$PWD/CustomWidgets/tilewidget.cpp \
+    $$PWD/CustomWidgets/toggleswitch.cpp \
+    $$PWD/CustomWidgets/touchstoneimport.cpp \
+    $$PWD/CustomWidgets/tracesetselector.cpp \
+    $$PWD/Device/LibreVNA/Compound/compounddevice.cpp \
+    $$PWD/Device/LibreVNA/Compound/compounddeviceeditdialog.cpp \
+    $$PWD/Device/LibreVNA/Compound/compounddriver.cpp \
+    $$PWD/Device/LibreVNA/amplitudecaldialog.cpp \
+    $$PWD/Device/LibreVNA/deviceconfigurationdialogv1.cpp \
+    $$PWD/Device/LibreVNA/deviceconfigurationdialogvfe.cpp \
+    $$PWD/Device/LibreVNA/deviceconfigurationdialogvff.cpp \
+    $$PWD/Device/LibreVNA/devicepacketlog.cpp \
+    $$PWD/Device/LibreVNA/devicepacketlogview.cpp \
+    $$PWD/Device/LibreVNA/firmwareupdatedialog.cpp \
+    $$PWD/Device/LibreVNA/frequencycaldialog.cpp \
+    $$PWD/Device/LibreVNA/librevnadriver.cpp \
+    $$PWD/Device/LibreVNA/librevnasimulator.cpp \
+    $$PWD/Device/LibreVNA/librevnatcpdriver.cpp \
+    $$PWD/Device/LibreVNA/librevnausbdriver.cpp \
+    $$PWD/Device/LibreVNA/manualcontroldialogV1.cpp \
+    $$PWD/Device/LibreVNA/manualcontroldialogvfe.cpp \
+    $$PWD/Device/LibreVNA/manualcontroldialogvff.cpp \
+    $$PWD/Device/LibreVNA/receivercaldialog.cpp \
+    $$PWD/Device/LibreVNA/sourcecaldialog.cpp \
+    $$PWD/Device/Playback/playbackdriver.cpp \
+    $$PWD/Device/SNA5000A/sna5000adriver.cpp \
+    $$PWD/Device/SSA3000X/ssa3000xdriver.cpp \
+    $$PWD/Device/devicedriver.cpp \
+    $$PWD/Device/devicelog.cpp \
+    $$PWD/Device/devicetcpdriver.cpp \
+    $$PWD/Generator/generator.cpp \
+    $$PWD/Generator/signalgenwidget.cpp \
+    $$PWD/SpectrumAnalyzer/spectrumanalyzer.cpp \
+    $$PWD/SpectrumAnalyzer/tracewidgetsa.cpp \
+    $$PWD/Tools/eseries.cpp \
+    $$PWD/Tools/impedancematchdialog.cpp \
+    $$PWD/Tools/mixedmodeconversion.cpp \
+    $$PWD/Tools/parameters.cpp \
+    $$PWD/Traces/Marker/marker.cpp \
+    $$PWD/Traces/Marker/markergroup.cpp \
+    $$PWD/Traces/Marker/markermodel.cpp \
+    $$PWD/Traces/Marker/markerwidget.cpp \
+    $$PWD/Traces/Math/dft.cpp \
+    $$PWD/Traces/Math/expression.cpp \
+    $$PWD/Traces/Math/medianfilter.cpp \
+    $$PWD/Traces/Math/parser/mpError.cpp \
+    $$PWD/Traces/Math/parser/mpFuncCmplx.cpp \
+    $$PWD/Traces/Math/parser/mpFuncCommon.cpp \
+    $$PWD/Traces/Math/parser/mpFuncMatrix.cpp \
+    $$PWD/Traces/Math/parser/mpFuncNonCmplx.cpp \
+    $$PWD/Traces/Math/parser/mpFuncStr.cpp \
+    $$PWD/Traces/Math/parser/mpICallback.cpp \
+    $$PWD/Traces/Math/parser/mpIOprt.cpp \
+    $$PWD/Traces/Math/parser/mpIPackage.cpp \
+    $$PWD/Traces/Math/parser/mpIToken.cpp \
+    $$PWD/Traces/Math/parser/mpIValReader.cpp \
+    $$PWD/Traces/Math/parser/mpIValue.cpp \
+    $$PWD/Traces/Math/parser/mpIfThenElse.cpp \
+    $$PWD/Traces/Math/parser/mpOprtBinAssign.cpp \
+    $$PWD/Traces/Math/parser/mpOprtBinCommon.cpp \
+    $$PWD/Traces/Math/parser/mpOprtCmplx.cpp \
+    $$PWD/Traces/Math/parser/mpOprtIndex.cpp \
+    $$PWD/Traces/Math/parser/mpOprtMatrix.cpp \
+    $$PWD/Traces/Math/parser/mpOprtNonCmplx.cpp \
+    $$PWD/Traces/Math/parser/mpOprtPostfixCommon.cpp \
+    $$PWD/Traces/Math/parser/mpPackageCmplx.cpp \
+    $$PWD/Traces/Math/parser/mpPackageCommon.cpp \
+    $$PWD/Traces/Math/parser/mpPackageMatrix.cpp \
+    $$PWD/Traces/Math/parser/mpPackageNonCmplx.cpp \
+    $$PWD/Traces/Math/parser/mpPackageStr.cpp \
+    $$PWD/Traces/Math/parser/mpPackageUnit.cpp \
+    $$PWD/Traces/Math/parser/mpParser.cpp \
+    $$PWD/Traces/Math/parser/mpParserBase.cpp \
+    $$PWD/Traces/Math/parser/mpParserMessageProvider.cpp \
+    $$PWD/Traces/Math/parser/mpRPN.cpp \
+    $$PWD/Traces/Math/parser/mpScriptTokens.cpp \
+    $$PWD/Traces/Math/parser/mpTest.cpp \
+    $$PWD/Traces/Math/parser/mpTokenReader.cpp \
+    $$PWD/Traces/Math/parser/mpValReader.cpp \
+    $$PWD/Traces/Math/parser/mpValue.cpp \
+    $$PWD/Traces/Math/parser/mpValueCache.cpp \
+    $$PWD/Traces/Math/parser/mpVariable.cpp \
+    $$PWD/Traces/Math/tdr.cpp \
+    $$PWD/Traces/Math/timegate.cpp \
+    $$PWD/Traces/Math/tracemath.cpp \
+    $$PWD/Traces/Math/windowfunction.cpp \
+    $$PWD/Traces/eyediagramplot.cpp \
+    $$PWD/Traces/fftcomplex.cpp \
+    $$PWD/Traces/renderscheduler.cpp \
+    $$PWD/Traces/sparamtraceselector.cpp \
+    $$PWD/Traces/trace.cpp \
+    $$PWD/Traces/traceaxis.cpp \
+    $$PWD/Traces/tracecsvexport.cpp \
+    $$PWD/Traces/traceeditdialog.cpp \
+    $$PWD/Traces/traceimportdialog.cpp \
+    $$PWD/Traces/tracemodel.cpp \
+    $$PWD/Traces/traceplot.cpp \
+    $$PWD/Traces/tracesmithchart.cpp \
+    $$PWD/Traces/tracepolarchart.cpp \
+    $$PWD/Traces/tracetouchstoneexport.cpp \
+    $$PWD/Traces/tracewaterfall.cpp \
+    $$PWD/Traces/tracewidget.cpp \
+    $$PWD/Traces/tracexyplot.cpp \
+    $$PWD/Traces/tracepolar.cpp \
+    $$PWD/Traces/waterfallaxisdialog.cpp \
+    $$PWD/Traces/xyplotaxisdialog.cpp \
+    $$PWD/Util/backgroundfilter.cpp \
+    $$PWD/Util/latencytracer.cpp \
+    $$PWD/Util/metrics.cpp \
+    $$PWD/Util/numberformatter.cpp \
+    $$PWD/Util/prbs.cpp \
+    $$PWD/Util/usbinbuffer.cpp \
+    $$PWD/Util/util.cpp \
+    $$PWD/VNA/Deembedding/deembedding.cpp \
+    $$PWD/VNA/Deembedding/deembeddingdialog.cpp \
+    $$PWD/VNA/Deembedding/deembeddingoption.cpp \
+    $$PWD/VNA/Deembedding/impedancerenormalization.cpp \
+    $$PWD/VNA/Deembedding/manualdeembeddingdialog.cpp \
+    $$PWD/VNA/Deembedding/matchingnetwork.cpp \
+    $$PWD/VNA/Deembedding/portextension.cpp \
+    $$PWD/VNA/Deembedding/twothru.cpp \
+    $$PWD/VNA/tracewidgetvna.cpp \
+    $$PWD/VNA/vna.cpp \
+    $$PWD/VNA/vnapipeline.cpp \
+    $$PWD/about.cpp \
+    $$PWD/appwindow.cpp \
+    $$PWD/averaging.cpp \
+    $$PWD/csv.cpp \
+    $$PWD/metricsserver.cpp \
+    $$PWD/modehandler.cpp \
+    $$PWD/mode.cpp \
+    $$PWD/modewindow.cpp \
+    $$PWD/preferences.cpp \
+    $$PWD/savable.cpp \
+    $$PWD/scpi.cpp \
+    $$PWD/streamingserver.cpp \
+    $$PWD/sweeprecorder.cpp \
+    $$PWD/tcpserver.cpp \
+    $$PWD/touchstone.cpp \
+    $$PWD/unit.cpp
+
+FORMS += \
+    $$PWD/Calibration/CalStandardLineEditDialog.ui \
+    $$PWD/Calibration/CalStandardLoadEditDialog.ui \
+    $$PWD/Calibration/CalStandardOpenEditDialog.ui \
+    $$PWD/Calibration/CalStandardReflectEditDialog.ui \
+    $$PWD/Calibration/CalStandardShortEditDialog.ui \
+    $$PWD/Calibration/CalStandardThroughEditDialog.ui \
+    $$PWD/Calibration/LibreCAL/librecaldialog.ui \
+    $$PWD/Calibration/calibrationdialogui.ui \
+    $$PWD/Calibration/calkitdialog.ui \
+    $$PWD/Calibration/manualcalibrationdialog.ui \
+    $$PWD/CustomWidgets/csvimport.ui \
+    $$PWD/CustomWidgets/jsonpickerdialog.ui \
+    $$PWD/CustomWidgets/tilewidget.ui \
+    $$PWD/CustomWidgets/touchstoneimport.ui \
+    $$PWD/Device/LibreVNA/Compound/compounddeviceeditdialog.ui \
+    $$PWD/Device/LibreVNA/Compound/compounddriversettingswidget.ui \
+    $$PWD/Device/LibreVNA/addamplitudepointsdialog.ui \
+    $$PWD/Device/LibreVNA/amplitudecaldialog.ui \
+    $$PWD/Device/LibreVNA/automaticamplitudedialog.ui \
+    $$PWD/Device/LibreVNA/deviceconfigurationdialogv1.ui \
+    $$PWD/Device/LibreVNA/deviceconfigurationdialogvfe.ui \
+    $$PWD/Device/LibreVNA/deviceconfigurationdialogvff.ui \
+    $$PWD/Device/LibreVNA/devicepacketlogview.ui \
+    $$PWD/Device/LibreVNA/firmwareupdatedialog.ui \
+    $$PWD/Device/LibreVNA/frequencycaldialog.ui \
+    $$PWD/Device/LibreVNA/librevnadriversettingswidget.ui \
+    $$PWD/Device/LibreVNA/manualcontroldialogV1.ui \
+    $$PWD/Device/LibreVNA/manualcontroldialogvfe.ui \
+    $$PWD/Device/LibreVNA/manualcontroldialogvff.ui \
+    $$PWD/Device/Playback/playbackdriversettingswidget.ui \
+    $$PWD/Device/devicelog.ui \
+    $$PWD/Device/devicetcpdriversettings.ui \
+    $$PWD/Generator/signalgenwidget.ui \
+    $$PWD/Tools/impedancematchdialog.ui \
+    $$PWD/Tools/mixedmodeconversion.ui \
+    $$PWD/Traces/Marker/markerwidget.ui \
+    $$PWD/Traces/Math/dftdialog.ui \
+    $$PWD/Traces/Math/dftexplanationwidget.ui \
+    $$PWD/Traces/Math/expressiondialog.ui \
+    $$PWD/Traces/Math/expressionexplanationwidget.ui \
+    $$PWD/Traces/Math/medianexplanationwidget.ui \
+    $$PWD/Traces/Math/medianfilterdialog.ui \
+    $$PWD/Traces/Math/newtracemathdialog.ui \
+    $$PWD/Traces/Math/tdrdialog.ui \
+    $$PWD/Traces/Math/tdrexplanationwidget.ui \
+    $$PWD/Traces/Math/timedomaingatingexplanationwidget.ui \
+    $$PWD/Traces/Math/timegatedialog.ui \
+    $$PWD/Traces/Math/timegateexplanationwidget.ui \
+    $$PWD/Traces/XYPlotConstantLineEditDialog.ui \
+    $$PWD/Traces/eyediagrameditdialog.ui \
+    $$PWD/Traces/smithchartdialog.ui \
+    $$PWD/Traces/polarchartdialog.ui \
+    $$PWD/Traces/tracecsvexport.ui \
+    $$PWD/Traces/traceeditdialog.ui \
+    $$PWD/Traces/traceimportdialog.ui \
+    $$PWD/Traces/tracetouchstoneexport.ui \
+    $$PWD/Traces/tracewidget.ui \
+    $$PWD/Traces/waterfallaxisdialog.ui \
+    $$PWD/Traces/xyplotaxisdialog.ui \
+    $$PWD/VNA/Deembedding/deembeddingdialog.ui \
+    $$PWD/VNA/Deembedding/impedancenormalizationdialog.ui \
+    $$PWD/VNA/Deembedding/manualdeembeddingdialog.ui \
+    $$PWD/VNA/Deembedding/matchingnetworkdialog.ui \
+    $$PWD/VNA/Deembedding/measurementdialog.ui \
+    $$PWD/VNA/Deembedding/portextensioneditdialog.ui \
+    $$PWD/VNA/Deembedding/twothrudialog.ui \
+    $$PWD/VNA/s2pImportOptions.ui \
+    $$PWD/aboutdialog.ui \
+    $$PWD/main.ui \
+    $$PWD/preferencesdialog.ui
+
+INCLUDEPATH += \
+    $$PWD \
+    $$PWD/Util \
+    $$PWD/VNA/Deembedding \
+    $$PWD/Calibration
+
+LIBS += -lusb-1.0
+unix:LIBS += -L/usr/lib/
+
+CONFIG += c++17
+REVISION = $$system(git rev-parse HEAD)
+DEFINES += GITHASH=\\"\"$$REVISION\\"\"
+DEFINES += FW_MAJOR=1 FW_MINOR=6 FW_PATCH=0 FW_SUFFIX=""
+DEFINES -= _UNICODE UNICODE
+# Latency instrumentation of the measurement pipeline, remove to compile it out
+DEFINES += LIBREVNA_LATENCY_TRACING
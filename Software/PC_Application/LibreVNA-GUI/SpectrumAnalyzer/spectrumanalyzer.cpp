@@ -524,6 +524,10 @@ void SpectrumAnalyzer::NewDatapoint(DeviceDriver::SAMeasurement m)
 
     auto m_avg = average.process(m);
     if(average.settled()) {
+        if(isOperationPending() && getRoot()) {
+            // averaging just settled after a settings change
+            getRoot()->notify("SETTLED", "SA");
+        }
         setOperationPending(false);
     }
 
@@ -537,7 +541,7 @@ void SpectrumAnalyzer::NewDatapoint(DeviceDriver::SAMeasurement m)
         }
     }
 
-    window->addStreamingData(m_avg, AppWindow::SADataType::Raw);
+    window->addStreamingData(m_avg, AppWindow::SADataType::Raw, m_avg.pointNum == DeviceDriver::SApoints() - 1);
 
     if(normalize.measuring) {
         if(average.currentSweep() == averages) {
@@ -568,15 +572,22 @@ void SpectrumAnalyzer::NewDatapoint(DeviceDriver::SAMeasurement m)
             m.second /= normalize.portCorrection[m.first][m_avg.pointNum];
             m.second *= corr;
         }
-        window->addStreamingData(m_avg, AppWindow::SADataType::Normalized);
+        window->addStreamingData(m_avg, AppWindow::SADataType::Normalized, m_avg.pointNum == DeviceDriver::SApoints() - 1);
     }
 
 
-    traceModel.addSAData(m_avg, settings);
-    emit dataChanged();
+    if(traceProcessingEnabled()) {
+        traceModel.addSAData(m_avg, settings);
+        emit dataChanged();
+    }
     if(m_avg.pointNum == DeviceDriver::SApoints() - 1) {
         UpdateAverageCount();
-        markerModel->updateMarkers();
+        if(traceProcessingEnabled()) {
+            markerModel->updateMarkers();
+        }
+        if(getRoot()) {
+            getRoot()->notify("SWEEP", "SA");
+        }
     }
     static unsigned int lastPoint = 0;
     if(m_avg.pointNum > 0 && m_avg.pointNum != lastPoint + 1) {
@@ -585,6 +596,17 @@ void SpectrumAnalyzer::NewDatapoint(DeviceDriver::SAMeasurement m)
     lastPoint = m_avg.pointNum;
 }
 
+void SpectrumAnalyzer::UpdateRecorderSettings()
+{
+    SweepRecorder::SweepSettings s;
+    s.zerospan = settings.freqStart == settings.freqStop;
+    s.start = settings.freqStart;
+    s.stop = settings.freqStop;
+    s.bandwidth = settings.RBW;
+    s.averages = averages;
+    window->getRecorder()->setSASweepSettings(s);
+}
+
 void SpectrumAnalyzer::SettingsChanged()
 {
     if(window->getDevice()) {
@@ -733,6 +755,7 @@ void SpectrumAnalyzer::SetAveraging(unsigned int averages)
     average.setAverages(averages);
     emit averagingChanged(averages);
     UpdateAverageCount();
+    UpdateRecorderSettings();
     setOperationPending(!average.settled());
 }
 
@@ -876,6 +899,7 @@ void SpectrumAnalyzer::ConfigureDevice()
 {
     if(running) {
         changingSettings = true;
+        UpdateRecorderSettings();
 
         if(window->getDevice() && isActive) {
             window->getDevice()->setSA(settings, [=](bool){
@@ -1078,6 +1102,7 @@ void SpectrumAnalyzer::SetupSCPI()
         return average.getLevel() == averages ? "TRUE" : "FALSE";
     }));
     scpi_acq->add(new SCPICommand("LIMit", nullptr, [=](QStringList) -> QString {
+        enableTraceProcessing();
         return tiles->allLimitsPassing() ? "PASS" : "FAIL";
     }));
     scpi_acq->add(new SCPICommand("SINGLE", [=](QStringList params) -> QString {
@@ -1182,6 +1207,10 @@ void SpectrumAnalyzer::SetupSCPI()
         return QString::number(normalize.Level->value());
     }));
     SCPINode::add(traceWidget);
+    // traces are only updated without GUI after they have been requested
+    traceWidget->setAccessCallback([=](){
+        enableTraceProcessing();
+    });
 }
 
 void SpectrumAnalyzer::UpdateAverageCount()
@@ -85,6 +85,8 @@ private slots:
 private:
     void SetupSCPI();
     void UpdateAverageCount();
+    // passes the sweep settings to the recorder, which stores them along with the recorded sweeps
+    void UpdateRecorderSettings();
     void SettingsChanged();
     void ConstrainAndUpdateFrequencies();
     void LoadSweepSettings();
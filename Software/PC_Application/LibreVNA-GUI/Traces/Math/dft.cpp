@@ -6,6 +6,7 @@
 #include "ui_dftdialog.h"
 #include "ui_dftexplanationwidget.h"
 #include "appwindow.h"
+#include "Util/latencytracer.h"
 
 #include <chrono>
 #include <thread>
@@ -128,6 +129,7 @@ void Math::DFT::fromJSON(nlohmann::json j)
 
 void Math::DFT::inputSamplesChanged(unsigned int begin, unsigned int end)
 {
+    LATENCY_SPAN("DFT::inputSamplesChanged", "Math");
     Q_UNUSED(begin);
     Q_UNUSED(end);
     if(input->rData().size() < 2) {
@@ -158,6 +160,7 @@ Math::DFTThread::DFTThread(Math::DFT &dft)
 void Math::DFTThread::run()
 {
     qDebug() << "DFT thread starting";
+    LATENCY_THREAD_NAME("DFT");
     using namespace std::chrono;
     auto lastCalc = system_clock::now();
     while(1) {
@@ -176,6 +179,7 @@ void Math::DFTThread::run()
             lastCalc = system_clock::now();
         }
 //        qDebug() << "DFT thread calculating";
+        LATENCY_SPAN("DFTThread::calculate", "Math", dft.input->rData().size());
         double DC = dft.DCfreq;
         TDR *tdr = nullptr;
         if(dft.automaticDC) {
@@ -4,6 +4,7 @@
 #include "Traces/trace.h"
 #include "ui_expressionexplanationwidget.h"
 #include "appwindow.h"
+#include "Util/latencytracer.h"
 
 #include <QWidget>
 #include <QDebug>
@@ -85,6 +86,7 @@ void Math::Expression::fromJSON(nlohmann::json j)
 
 void Math::Expression::inputSamplesChanged(unsigned int begin, unsigned int end)
 {
+    LATENCY_SPAN("Expression::inputSamplesChanged", "Math", end - begin);
     auto in = input->rData();
     data.resize(in.size());
     try {
@@ -4,6 +4,7 @@
 #include "ui_medianexplanationwidget.h"
 #include "CustomWidgets/informationbox.h"
 #include "appwindow.h"
+#include "Util/latencytracer.h"
 
 using namespace Math;
 using namespace std;
@@ -79,6 +80,7 @@ void MedianFilter::fromJSON(nlohmann::json j)
 }
 
 void MedianFilter::inputSamplesChanged(unsigned int begin, unsigned int end) {
+    LATENCY_SPAN("MedianFilter::inputSamplesChanged", "Math", end - begin);
     if(data.size() != input->rData().size()) {
         data.resize(input->rData().size());
     }
@@ -5,6 +5,7 @@
 #include "ui_tdrexplanationwidget.h"
 #include "Util/util.h"
 #include "appwindow.h"
+#include "Util/latencytracer.h"
 
 #include <chrono>
 #include <thread>
@@ -202,6 +203,7 @@ void TDR::setMode(Mode m)
 
 void TDR::inputSamplesChanged(unsigned int begin, unsigned int end)
 {
+    LATENCY_SPAN("TDR::inputSamplesChanged", "Math");
     Q_UNUSED(begin);
     Q_UNUSED(end);
     if(input->rData().size() >= 2) {
@@ -243,6 +245,7 @@ TDRThread::TDRThread(TDR &tdr)
 void TDRThread::run()
 {
     qDebug() << "TDR thread starting";
+    LATENCY_THREAD_NAME("TDR");
     using namespace std::chrono;
     auto lastCalc = system_clock::now();
     while(1) {
@@ -261,6 +264,7 @@ void TDRThread::run()
             lastCalc = system_clock::now();
         }
 //        qDebug() << "TDR thread calculating";
+        LATENCY_SPAN("TDRThread::calculate", "Math", tdr.input->rData().size());
         // perform calculation
         vector<complex<double>> frequencyDomain;
         auto stepSize = (tdr.input->rData().back().x - tdr.input->rData().front().x) / (tdr.input->rData().size() - 1);
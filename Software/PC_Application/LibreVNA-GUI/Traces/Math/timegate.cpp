@@ -8,6 +8,7 @@
 #include "Util/util.h"
 #include "unit.h"
 #include "appwindow.h"
+#include "Util/latencytracer.h"
 
 #include <QWidget>
 #include <QDialog>
@@ -210,6 +211,7 @@ double Math::TimeGate::getStop()
 
 void Math::TimeGate::inputSamplesChanged(unsigned int begin, unsigned int end)
 {
+    LATENCY_SPAN("TimeGate::inputSamplesChanged", "Math", end - begin);
     if(data.size() != input->rData().size()) {
         data.resize(input->rData().size());
         updateFilter();
@@ -11,6 +11,8 @@
 #include <random>
 #include <thread>
 #include <chrono>
+#include <functional>
+#include <algorithm>
 
 #include <QFileDialog>
 #include <QPainter>
@@ -42,18 +44,22 @@ EyeDiagramPlot::EyeDiagramPlot(TraceModel &model, QWidget *parent)
 
     tdr = new Math::TDR;
 
-    calcData = &data[0];
-    displayData = &data[1];
+    densityTimestep = 0.0;
+    densityMinVoltage = 0.0;
+    densityMaxVoltage = 0.0;
 
     xAxis.set(XAxis::Type::Time, false, true, 0, 0.000001, 10, true);
     yAxis.set(YAxis::Type::Real, false, true, -1, 1, 10, true);
     initializeTraceInfo();
 
     destructing = false;
+    calcGeneration = 0;
     thread = new EyeThread(*this);
     thread->start(EyeThread::Priority::LowestPriority);
 
     connect(tdr, &Math::TDR::outputSamplesChanged, this, &EyeDiagramPlot::triggerUpdate);
+    // emitted from the calculation thread, the plot has to be updated from the GUI thread
+    connect(this, &EyeDiagramPlot::calculationComplete, this, &EyeDiagramPlot::replot, Qt::QueuedConnection);
 
     replot();
 }
@@ -62,6 +68,7 @@ EyeDiagramPlot::~EyeDiagramPlot()
 {
     // tell thread to exit
     destructing = true;
+    abortCalculation();
     semphr.release();
     thread->wait();
     delete thread;
@@ -90,9 +97,10 @@ void EyeDiagramPlot::enableTrace(Trace *t, bool enabled)
         if(trace) {
             disconnect(trace, &Trace::lastMathChanged, this, nullptr);
             tdr->removeInput();
+            abortCalculation();
             std::lock_guard<std::mutex> calc(calcMutex);
-            displayData->clear();
-            calcData->clear();
+            std::lock_guard<std::mutex> guard(bufferSwitchMutex);
+            density = QImage();
         }
         trace = nullptr;
     }
@@ -184,19 +192,24 @@ void EyeDiagramPlot::fromJSON(nlohmann::json j)
     auto yautodivs = jY.value("autoDivs", false);
     yAxis.set(yAxis.getType(), false, yAuto, yMin, yMax, yDivs, yautodivs);
 
-    datarate = j.value("datarate", datarate);
-    risetime = j.value("risetime", risetime);
-    falltime = j.value("falltime", falltime);
-    linearEdge = j.value("linearEdge", linearEdge);
-    highlevel = j.value("highlevel", highlevel);
-    lowlevel = j.value("lowlevel", lowlevel);
-    bitsPerSymbol = j.value("bitPerSymbol", bitsPerSymbol);
-    noise = j.value("noise", noise);
-    jitter = j.value("jitter", jitter);
-    patternbits = j.value("patternBits", patternbits);
-    cycles = j.value("cycles", cycles);
-    xSamples = j.value("xSamples", xSamples);
-    traceBlurring = j.value("traceBlurring", traceBlurring);
+    {
+        abortCalculation();
+        std::lock_guard<std::mutex> calc(calcMutex);
+        datarate = j.value("datarate", datarate);
+        risetime = j.value("risetime", risetime);
+        falltime = j.value("falltime", falltime);
+        linearEdge = j.value("linearEdge", linearEdge);
+        highlevel = j.value("highlevel", highlevel);
+        lowlevel = j.value("lowlevel", lowlevel);
+        bitsPerSymbol = j.value("bitPerSymbol", bitsPerSymbol);
+        noise = j.value("noise", noise);
+        jitter = j.value("jitter", jitter);
+        patternbits = j.value("patternBits", patternbits);
+        cycles = j.value("cycles", cycles);
+        xSamples = j.value("xSamples", xSamples);
+        traceBlurring = j.value("traceBlurring", traceBlurring);
+    }
+    triggerUpdate();
 
     for(unsigned int hash : j["traces"]) {
         // attempt to find the traces with this hash
@@ -352,7 +365,8 @@ void EyeDiagramPlot::axisSetupDialog()
     ui->Ydivs->setValue(yAxis.getDivs());
 
     auto updateValues = [=](){
-        std::lock_guard<std::mutex> guard(calcMutex);
+        abortCalculation();
+        std::unique_lock<std::mutex> guard(calcMutex);
         datarate = ui->datarate->value();
         risetime = ui->risetime->value();
         falltime = ui->falltime->value();
@@ -371,6 +385,9 @@ void EyeDiagramPlot::axisSetupDialog()
 
         xAxis.set(xAxis.getType(), false, ui->Xauto->isChecked(), ui->Xmin->value(), ui->Xmax->value(), ui->Xdivs->value(), ui->XautoDivs->isChecked());
         yAxis.set(yAxis.getType(), false, ui->Yauto->isChecked(), ui->Ymin->value(), ui->Ymax->value(), ui->Ydivs->value(), ui->YautoDivs->isChecked());
+        guard.unlock();
+        // restart the calculation with the new settings
+        triggerUpdate();
     };
 
     connect(ui->buttonBox->button(QDialogButtonBox::Ok), &QPushButton::clicked, [=](){
@@ -568,112 +585,20 @@ void EyeDiagramPlot::draw(QPainter &p)
         }
     }
 
-    if(displayData->size() >= 2) {
+    {
         std::lock_guard<std::mutex> guard(bufferSwitchMutex);
-        if((*displayData)[0].y[0] == 0.0 && (*displayData)[0].y[1] == 0.0) {
-            qDebug() << "detected null data, displaydata:" << displayData;
-        }
-        unsigned int pxWidth = plotAreaWidth;
-        unsigned int pxHeight = plotAreaBottom - plotAreaTop;
-        std::vector<std::vector<unsigned int>> bitmap;
-        bitmap.resize(pxWidth);
-        for(auto &y : bitmap) {
-            y.resize(pxHeight, 0);
-        }
-        unsigned int highestIntensity = 0;
-        unsigned int numTraces = (*displayData)[displayData->size()-1].y.size();
-
-        auto addLine = [&](int x0, int y0, int x1, int y1, bool skipFirst = true) {
-            bool first = true;
-            auto putpixel = [&](int x, int y) {
-                if(skipFirst && first) {
-                    first = false;
-                    return;
-                }
-                for(int i=-traceBlurring;i<=traceBlurring;i++) {
-                    for(int j=-traceBlurring;j<=traceBlurring;j++) {
-                        if(i*i+j*j <= traceBlurring*traceBlurring) {
-                            if(x+i < 0 || x+i >= (int) pxWidth || y+j < 0 || y+j >= (int) pxHeight) {
-                                return;
-                            }
-                            auto &bin = bitmap[x+i][y+j];
-                            bin++;
-                            if(bin > highestIntensity) {
-                                highestIntensity = bin;
-                            }
-                        }
-                    }
-                }
-            };
-
-            int dx =  abs (x1 - x0), sx = x0 < x1 ? 1 : -1;
-            int dy = -abs (y1 - y0), sy = y0 < y1 ? 1 : -1;
-            int err = dx + dy, e2; /* error value e_xy */
-
-            for (;;){  /* loop */
-                putpixel (x0,y0);
-                if (x0 == x1 && y0 == y1) break;
-                e2 = 2 * err;
-                if (e2 >= dy) { err += dy; x0 += sx; } /* e_xy+e_x > 0 */
-                if (e2 <= dx) { err += dx; y0 += sy; } /* e_xy+e_y < 0 */
-            }
-        };
-
-        // Assemble the bitmap
-        for(unsigned int i=1;i<displayData->size();i++) {
-            int x0 = xAxis.transform((*displayData)[i-1].x, 0, pxWidth);
-            int x1 = xAxis.transform((*displayData)[i].x, 0, pxWidth);
-            if((x0 < 0 && x1 < 0) || (x0 >= (int) pxWidth && x1 >= (int) pxWidth)) {
-                // completely out of the frame
-                continue;
-            }
-            for(unsigned int j=0;j<numTraces;j++) {
-                int y0 = yAxis.transform((*displayData)[i-1].y[j], pxHeight, 0);
-                int y1 = yAxis.transform((*displayData)[i].y[j], pxHeight, 0);
-                addLine(x0, y0, x1, y1, i > 1);
-            }
-        }
-
-        /*
-         * Only a small amount of pixels will have a lot of traces of top of each other.
-         * This would result in using mostly the colder colors in the intensity grading.
-         *
-         * Generate a histogram of pixel usage and create an adjustment curve to evenly
-         * distribute all intensity colors
-         */
-        unsigned int hist[highestIntensity+1];
-        memset(hist, 0, sizeof(hist));
-        unsigned long total = 0;
-        for(unsigned int i=1;i<pxWidth;i++) {
-            for(unsigned int j=0;j<pxHeight;j++) {
-                hist[bitmap[i][j]]++;
-                total++;
-            }
+        if(!density.isNull()) {
+            // every column is centered on its sample time, the rows span the voltage range of the calculation
+            auto left = xAxis.transform(-0.5 * densityTimestep, plotAreaLeft, plotAreaLeft + plotAreaWidth);
+            auto right = xAxis.transform((density.width() - 0.5) * densityTimestep, plotAreaLeft, plotAreaLeft + plotAreaWidth);
+            auto top = yAxis.transform(densityMaxVoltage, plotAreaBottom, plotAreaTop);
+            auto bottom = yAxis.transform(densityMinVoltage, plotAreaBottom, plotAreaTop);
+            p.save();
+            p.setClipRect(QRect(plotAreaLeft + 1, plotAreaTop + 1, plotAreaWidth - 1, plotAreaBottom - plotAreaTop - 1));
+            p.setRenderHint(QPainter::SmoothPixmapTransform);
+            p.drawImage(QRectF(QPointF(left, top), QPointF(right, bottom)), density);
+            p.restore();
         }
-        unsigned int sum = 0;
-        double correctedCurve[highestIntensity+1];
-        correctedCurve[0] = 0.0;
-        total -= hist[0];
-        for(unsigned int i=1;i<=highestIntensity;i++) {
-            sum += hist[i];
-            correctedCurve[i] = pow((double) sum / total, 2); // not totally even distribution, x^2 seems to look better
-        }
-
-        // draw the bitmap
-        pen = QPen();
-        pen.setCosmetic(true);
-        for(unsigned int i=1;i<pxWidth;i++) {
-            for(unsigned int j=0;j<pxHeight;j++) {
-                if(bitmap[i][j] > 0) {
-                    double value = correctedCurve[bitmap[i][j]];
-                    pen.setColor(Util::getIntensityGradeColor(value));
-                    p.setPen(pen);
-                    p.drawPoint(plotAreaLeft + i + 1, plotAreaTop + j + 1);
-                }
-            }
-        }
-    } else {
-        qDebug() << "Empty eye data, displaydata:" << displayData;
     }
     if(dropPending && supported(dropTrace)) {
         p.setOpacity(dropOpacity);
@@ -748,6 +673,11 @@ void EyeDiagramPlot::setStatus(QString s)
     emit statusChanged(s);
 }
 
+void EyeDiagramPlot::abortCalculation()
+{
+    calcGeneration++;
+}
+
 double EyeDiagramPlot::calculatedTime()
 {
     return 2.0 / datarate;
@@ -765,6 +695,36 @@ double EyeDiagramPlot::maxDisplayVoltage()
     return highlevel + eyeRange * yOverrange;
 }
 
+/*
+ * Calls work(index, worker) for every index in [0, count), distributed over all workers.
+ * The worker number can be used to access per-worker state. Returns early (leaving some
+ * indices unprocessed) as soon as abort() returns true
+ */
+static void parallelFor(unsigned long count, unsigned int workers, const std::function<bool()> &abort,
+                        const std::function<void(unsigned long, unsigned int)> &work)
+{
+    std::atomic<unsigned long> nextIndex(0);
+    auto worker = [&](unsigned int id) {
+        unsigned long i;
+        while((i = nextIndex++) < count && !abort()) {
+            work(i, id);
+        }
+    };
+    std::vector<std::thread> threads;
+    for(unsigned int i=1;i<workers;i++) {
+        threads.emplace_back(worker, i);
+    }
+    worker(0);
+    for(auto &t : threads) {
+        t.join();
+    }
+}
+
+bool EyeThread::aborted()
+{
+    return eye.destructing || eye.calcGeneration != generation;
+}
+
 void EyeThread::run()
 {
     while(1) {
@@ -777,6 +737,8 @@ void EyeThread::run()
             qDebug() << "Eye thread exiting";
             return;
         }
+        // settings can only change while we are not holding the calcMutex, any change from now on aborts this calculation
+        generation = eye.calcGeneration;
         eye.setStatus("Starting calculation...");
         if(!eye.trace) {
             eye.setStatus("No trace assigned");
@@ -803,22 +765,15 @@ void EyeThread::run()
 
         // calculate timestep
         double timestep = eye.calculatedTime() / eye.xSamples;
-        // reserve vector for input data
-        std::vector<std::complex<double>> inVec(eye.xSamples * (eye.cycles + 1), 0.0); // needs to calculate one more cycle than required for the display (settling)
-
-        // resize working buffer
-        qDebug() << "Clearing old eye data, calcData:" << eye.calcData;
-        eye.calcData->clear();
-        eye.calcData->resize(eye.xSamples);
-        for(auto& s : *eye.calcData) {
-            s.y.resize(eye.cycles, 0.0);
-        }
+        unsigned int xSamples = eye.xSamples;
+        // needs to calculate one more cycle than required for the display (settling)
+        unsigned long totalSamples = (unsigned long) xSamples * (eye.cycles + 1);
 
         eye.setStatus("Extracting impulse response...");
 
         // calculate impulse response of trace
         double eyeTimeShift = 0;
-        std::vector<std::complex<double>> impulseVec;
+        std::vector<double> impulseVec;
         // determine how long the impulse response is
         auto samples = eye.tdr->numSamples();
         if(samples == 0) {
@@ -840,9 +795,12 @@ void EyeThread::run()
         }
 
         unsigned long convolutedSize = length / timestep;
-        if(convolutedSize > inVec.size()) {
+        if(convolutedSize > totalSamples) {
             // impulse response is longer than what we display, truncate
-            convolutedSize = inVec.size();
+            convolutedSize = totalSamples;
+        }
+        if(convolutedSize == 0) {
+            convolutedSize = 1;
         }
         impulseVec.resize(convolutedSize);
         /*
@@ -868,17 +826,66 @@ void EyeThread::run()
 
         qDebug() << "Eye calculation: TDR calculation done";
 
+        if(aborted()) {
+            continue;
+        }
+
+        /*
+         * The convolution is done with the overlap-save method: each block of fftSize input samples
+         * overlaps the previous block by the length of the impulse response and yields blockStep+1
+         * valid output samples (one more than the step, so every block can connect its first sample
+         * to the last sample of the preceding block). The impulse response is real, so two blocks
+         * are convolved at once in the real and imaginary part of a single FFT.
+         */
+        unsigned long fftSize = 1024;
+        while(fftSize < 4 * convolutedSize) {
+            fftSize <<= 1;
+        }
+        unsigned long blockStep = fftSize - convolutedSize;
+        unsigned long blocks = (totalSamples + blockStep - 1) / blockStep;
+
+        std::vector<std::complex<double>> impulseSpectrum(fftSize, 0.0);
+        for(unsigned long i=0;i<convolutedSize;i++) {
+            // includes the scaling of the inverse FFT
+            impulseSpectrum[i] = impulseVec[i] / fftSize;
+        }
+        Fft::transform(impulseSpectrum, false);
+
+        // input signal is generated in batches of blocks, the input buffer additionally holds the overlap with the previous batch
+        unsigned int workers = std::max(1U, std::thread::hardware_concurrency());
+        unsigned long batchBlocks = std::max((unsigned long) workers * 4, (1UL << 21) / blockStep);
+        std::vector<double> input(batchBlocks * blockStep + convolutedSize);
+
+        class WorkerState {
+        public:
+            std::vector<std::complex<double>> fft;
+            std::mt19937 rng;
+            std::vector<unsigned int> hist;
+        };
+        std::vector<WorkerState> workerStates(workers);
+        std::random_device rd;
+        for(auto &w : workerStates) {
+            w.fft.resize(fftSize);
+            w.rng.seed(rd());
+            w.hist.resize((unsigned long) xSamples * eye.yBins, 0);
+        }
+
         eye.setStatus("Generating PRBS sequence...");
 
         auto prbs = PRBS(eye.patternbits);
+        unsigned int prbsWord = 0;
+        unsigned int prbsAvailable = 0;
 
         auto getNextLevel = [&]() -> unsigned int {
             unsigned int level = 0;
             for(unsigned int i=0;i<eye.bitsPerSymbol;i++) {
-                level <<= 1;
-                if(prbs.next()) {
-                    level |= 0x01;
+                if(!prbsAvailable) {
+                    // fetch the PRBS a word at a time
+                    prbsWord = prbs.next(32);
+                    prbsAvailable = 32;
                 }
+                prbsAvailable--;
+                level = (level << 1) | ((prbsWord >> prbsAvailable) & 0x01);
             }
             return level;
         };
@@ -892,112 +899,269 @@ void EyeThread::run()
         unsigned int nextSignal = getNextLevel();
 
         // initialize random generator
-        std::random_device rd1;
-        std::mt19937 mt_noise(rd1());
-        std::normal_distribution<> dist_noise(0, eye.noise);
-
-        std::random_device rd2;
-        std::mt19937 mt_jitter(rd2());
+        std::mt19937 mt_jitter(rd());
         std::normal_distribution<> dist_jitter(0, eye.jitter);
 
         unsigned int bitcnt = 1;
         double transitionTime = -10; // assume that we start with a settled input, last transition was "long" ago
-        for(unsigned int i=0;i<inVec.size();i++) {
-            double time = (i+eyeXshift)*timestep;
-            double voltage;
-            if(time >= transitionTime) {
-                // last transition is over,
-                // schedule the next transition
-                voltage = levelToVoltage(nextSignal);
-                // move on to the next bit
-                currentSignal = nextSignal;
-                nextSignal = getNextLevel();
-                transitionTime = bitcnt * 1.0 / eye.datarate + dist_jitter(mt_jitter);
-                bitcnt++;
-            } else {
-                // still before the next edge
-                voltage = levelToVoltage(currentSignal);
+        unsigned long sampleIndex = 0;
+        double lastVoltage = 0.0;
+
+        // generates the next count samples of the input signal (without noise)
+        auto generateInput = [&](double *dst, unsigned long count) {
+            for(unsigned long n=0;n<count;n++, sampleIndex++) {
+                double time = (sampleIndex+eyeXshift)*timestep;
+                double voltage;
+                if(time >= transitionTime) {
+                    // last transition is over,
+                    // schedule the next transition
+                    voltage = levelToVoltage(nextSignal);
+                    // move on to the next bit
+                    currentSignal = nextSignal;
+                    nextSignal = getNextLevel();
+                    transitionTime = bitcnt * 1.0 / eye.datarate + dist_jitter(mt_jitter);
+                    bitcnt++;
+                } else {
+                    // still before the next edge
+                    voltage = levelToVoltage(currentSignal);
+                }
+                // add fall/rise time
+                if(sampleIndex > 0 && voltage != lastVoltage) {
+                    double last = lastVoltage;
+                    if(eye.linearEdge) {
+                        if(voltage > last) {
+                            // rising edge
+                            double max_rise = timestep / (eye.risetime * 1.25);
+                            if(voltage - last > max_rise) {
+                                voltage = last + max_rise;
+                            }
+                        } else {
+                            // falling edge
+                            double max_fall = timestep / (eye.falltime * 1.25);
+                            if(voltage - last < -max_fall) {
+                                voltage = last - max_fall;
+                            }
+                        }
+                    } else {
+                        // exponential edge
+                        // edge is modeled as exponential rise/fall. Adjust time constant to match
+                        // selected rise/fall time (with 10-90% signal rise/fall within specified time)
+                        auto expTimeConstant = (voltage > last ? eye.risetime : eye.falltime) / 2.197224577;
+                        if(expTimeConstant > 0) {
+                            voltage = last + (1.0 - exp(-timestep/expTimeConstant)) * (voltage - last);
+                        }
+                    }
+                }
+                dst[n] = voltage;
+                lastVoltage = voltage;
             }
-            inVec[i] = voltage;
-        }
+        };
 
-        // add fall/rise time
-        for(unsigned int i=1;i<inVec.size();i++) {
-            double last = inVec[i-1].real();
-            double next = inVec[i].real();
-            if(last == next) {
-                // no change, nothing to do
-                continue;
+        // histogram of the output voltage, one column per sample
+        double minVoltage = eye.minDisplayVoltage();
+        double maxVoltage = eye.maxDisplayVoltage();
+        auto voltageToBin = [=](double voltage) -> int {
+            return floor((voltage - minVoltage) / (maxVoltage - minVoltage) * eye.yBins);
+        };
+        auto fillColumn = [=](std::vector<unsigned int> &hist, unsigned int column, int from, int to) {
+            if(from > to) {
+                std::swap(from, to);
             }
-            if(eye.linearEdge) {
-                if(next > last) {
-                    // rising edge
-                    double max_rise = timestep / (eye.risetime * 1.25);
-                    if(next - last > max_rise) {
-                        next = last + max_rise;
-                    }
-                } else {
-                    // falling edge
-                    double max_fall = timestep / (eye.falltime * 1.25);
-                    if(next - last < -max_fall) {
-                        next = last - max_fall;
+            from = std::max(from, 0);
+            to = std::min(to, (int) eye.yBins - 1);
+            auto col = &hist[(unsigned long) column * eye.yBins];
+            for(int i=from;i<=to;i++) {
+                col[i]++;
+            }
+        };
+        // adds the connection from the previous sample (at column x-1) to the sample at column x
+        auto addSegment = [=](std::vector<unsigned int> &hist, unsigned int x, double from, double to) {
+            int binFrom = voltageToBin(from);
+            int binTo = voltageToBin(to);
+            int mid = (binFrom + binTo) / 2;
+            // the first half of the connection belongs to the previous column. Its starting point was
+            // already added by the preceding connection (except for the first column)
+            if(x == 1) {
+                fillColumn(hist, 0, binFrom, mid);
+            } else if(mid > binFrom) {
+                fillColumn(hist, x - 1, binFrom + 1, mid);
+            } else if(mid < binFrom) {
+                fillColumn(hist, x - 1, binFrom - 1, mid);
+            }
+            fillColumn(hist, x, mid, binTo);
+        };
+
+        auto isAborted = [this]() -> bool {
+            return aborted();
+        };
+
+        eye.setStatus("Performing convolution...");
+
+        for(unsigned long batchStart=0;batchStart<blocks && !aborted();batchStart+=batchBlocks) {
+            unsigned long batchSize = std::min(batchBlocks, blocks - batchStart);
+            unsigned long newSamples = batchSize * blockStep;
+            if(batchStart == 0) {
+                generateInput(&input[convolutedSize], newSamples);
+                // the input was settled at the first value before the start
+                std::fill(input.begin(), input.begin() + convolutedSize, input[convolutedSize]);
+            } else {
+                // keep the overlap from the end of the previous batch
+                std::copy(input.end() - convolutedSize, input.end(), input.begin());
+                generateInput(&input[convolutedSize], newSamples);
+            }
+
+            // add noise
+            if(eye.noise > 0) {
+                static constexpr unsigned long noiseChunk = 65536;
+                parallelFor((newSamples + noiseChunk - 1) / noiseChunk, workers, isAborted, [&](unsigned long chunk, unsigned int worker) {
+                    std::normal_distribution<> dist_noise(0, eye.noise);
+                    auto &rng = workerStates[worker].rng;
+                    auto start = convolutedSize + chunk * noiseChunk;
+                    auto stop = std::min(start + noiseChunk, convolutedSize + newSamples);
+                    for(auto i=start;i<stop;i++) {
+                        input[i] += dist_noise(rng);
                     }
+                });
+            }
+
+            // convolve pairs of blocks and accumulate the output
+            parallelFor((batchSize + 1) / 2, workers, isAborted, [&](unsigned long pair, unsigned int worker) {
+                auto &w = workerStates[worker];
+                unsigned long blockA = pair * 2;
+                unsigned long blockB = blockA + 1;
+                bool hasB = blockB < batchSize;
+                auto inA = &input[blockA * blockStep];
+                auto inB = hasB ? &input[blockB * blockStep] : nullptr;
+                for(unsigned long i=0;i<fftSize;i++) {
+                    w.fft[i] = std::complex<double>(inA[i], hasB ? inB[i] : 0.0);
                 }
-            } else {
-                // exponential edge
-                // edge is modeled as exponential rise/fall. Adjust time constant to match
-                // selected rise/fall time (with 10-90% signal rise/fall within specified time)
-                auto expTimeConstant = (next > last ? eye.risetime : eye.falltime) / 2.197224577;
-                if(expTimeConstant > 0) {
-                    next = last + (1.0 - exp(-timestep/expTimeConstant)) * (next - last);
+                Fft::transform(w.fft, false);
+                for(unsigned long i=0;i<fftSize;i++) {
+                    w.fft[i] *= impulseSpectrum[i];
                 }
-            }
-            inVec[i] = next;
+                Fft::transform(w.fft, true);
+
+                auto accumulate = [&](unsigned long block, bool imag) {
+                    // the first valid output of the block is the sample preceding the block start
+                    unsigned long blockStart = (batchStart + block) * blockStep;
+                    auto outputAt = [&](unsigned long i) -> double {
+                        auto &v = w.fft[convolutedSize - 1 + i];
+                        return imag ? v.imag() : v.real();
+                    };
+                    for(unsigned long i=1;i<=blockStep;i++) {
+                        unsigned long sample = blockStart + i - 1;
+                        if(sample >= totalSamples) {
+                            break;
+                        }
+                        unsigned int x = sample % xSamples;
+                        if(sample < xSamples || x == 0) {
+                            // skip settling cycle, don't connect across the start of the eye
+                            continue;
+                        }
+                        addSegment(w.hist, x, outputAt(i - 1), outputAt(i));
+                    }
+                };
+                accumulate(blockA, false);
+                if(hasB) {
+                    accumulate(blockB, true);
+                }
+            });
+
+            eye.setStatus("Performing convolution... "+QString::number(100 * (batchStart + batchSize) / blocks)+"%");
         }
 
-        // add noise
-        for(auto &v : inVec) {
-            v += dist_noise(mt_noise);
+        if(aborted()) {
+            qDebug() << "Eye calculation aborted";
+            continue;
         }
 
-        // input voltage vector fully assembled
-        qDebug() << "Eye calculation: input data generated";
+        qDebug() << "Eye calculation: Convolution done";
 
-        eye.setStatus("Performing convolution...");
+        eye.setStatus("Rendering eye...");
 
-        qDebug() << "Convolve via FFT start";
-        std::vector<std::complex<double>> outVec;
-        impulseVec.resize(inVec.size(), 0.0);
-        outVec.resize(inVec.size());
-        Fft::convolve(inVec, impulseVec, outVec);
-        qDebug() << "Convolve via FFT stop";
+        // merge histograms of all workers
+        std::vector<unsigned long long> hist(workerStates[0].hist.begin(), workerStates[0].hist.end());
+        for(unsigned int i=1;i<workers;i++) {
+            auto &h = workerStates[i].hist;
+            for(unsigned long j=0;j<hist.size();j++) {
+                hist[j] += h[j];
+            }
+        }
+        workerStates.clear();
 
-        // fill data from outVec
-        for(unsigned int i=0;i<eye.xSamples;i++) {
-            (*eye.calcData).at(i).x = i * timestep;
+        // blur the traces with a separable box filter. The blurring setting is in voltage bins, scale the
+        // horizontal radius so the blur is roughly round on a plot with similar pixel counts in both directions
+        auto blur = [&](unsigned long count, unsigned long stride, unsigned long lines, unsigned long lineStride, int radius) {
+            if(radius <= 0) {
+                return;
+            }
+            std::vector<unsigned long long> line(count);
+            for(unsigned long l=0;l<lines;l++) {
+                auto data = &hist[l * lineStride];
+                for(unsigned long i=0;i<count;i++) {
+                    line[i] = data[i * stride];
+                }
+                // sliding window sum
+                unsigned long long sum = 0;
+                for(long i=0;i<radius && i < (long) count;i++) {
+                    sum += line[i];
+                }
+                for(long i=0;i<(long) count;i++) {
+                    if(i + radius < (long) count) {
+                        sum += line[i + radius];
+                    }
+                    if(i - radius - 1 >= 0) {
+                        sum -= line[i - radius - 1];
+                    }
+                    data[i * stride] = sum;
+                }
+            }
+        };
+        blur(eye.yBins, 1, xSamples, eye.yBins, eye.traceBlurring);
+        blur(xSamples, eye.yBins, eye.yBins, 1, round((double) eye.traceBlurring * xSamples / eye.yBins));
+
+        /*
+         * Only a small amount of pixels will have a lot of traces of top of each other.
+         * This would result in using mostly the colder colors in the intensity grading.
+         *
+         * Create an adjustment curve from the distribution of the bin values to evenly
+         * distribute all intensity colors
+         */
+        std::vector<unsigned long long> sorted;
+        for(auto v : hist) {
+            if(v > 0) {
+                sorted.push_back(v);
+            }
         }
-        for(unsigned int i=eye.xSamples;i<inVec.size();i++) {
-            unsigned int x = i % eye.xSamples;
-            unsigned int y = i / eye.xSamples - 1;
-            (*eye.calcData).at(x).y.at(y) = outVec[i].real();
+        std::sort(sorted.begin(), sorted.end());
+
+        QImage image(xSamples, eye.yBins, QImage::Format_ARGB32_Premultiplied);
+        image.fill(Qt::transparent);
+        for(unsigned int x=0;x<xSamples;x++) {
+            for(unsigned int y=0;y<eye.yBins;y++) {
+                auto v = hist[(unsigned long) x * eye.yBins + y];
+                if(v == 0) {
+                    continue;
+                }
+                auto rank = std::upper_bound(sorted.begin(), sorted.end(), v) - sorted.begin();
+                double value = pow((double) rank / sorted.size(), 2); // not totally even distribution, x^2 seems to look better
+                image.setPixel(x, eye.yBins - 1 - y, Util::getIntensityGradeColor(value).rgba());
+            }
         }
 
-        qDebug() << "Eye calculation: Convolution done";
+        if(aborted()) {
+            continue;
+        }
 
         {
             std::lock_guard<std::mutex> guard(eye.bufferSwitchMutex);
-            // switch buffers
-            qDebug() << "Switching diplay buffers, calcData:" << eye.calcData;
-            auto buf = eye.displayData;
-            eye.displayData = eye.calcData;
-            eye.calcData = buf;
-            if((*eye.displayData)[0].y[0] == 0.0 && (*eye.displayData)[0].y[1] == 0.0) {
-                qDebug() << "detected null after eye calculation";
-            }
-            qDebug() << "Buffer switch complete, displayData:" << eye.displayData;
+            eye.density = image;
+            eye.densityTimestep = timestep;
+            eye.densityMinVoltage = minVoltage;
+            eye.densityMaxVoltage = maxVoltage;
         }
 
         eye.setStatus("Eye calculation complete");
-        eye.replot();
+        emit eye.calculationComplete();
     }
 }
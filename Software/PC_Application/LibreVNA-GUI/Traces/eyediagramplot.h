@@ -6,8 +6,10 @@
 #include "Traces/Math/tdr.h"
 
 #include <mutex>
+#include <atomic>
 #include <QThread>
 #include <QSemaphore>
+#include <QImage>
 
 #include <QObject>
 
@@ -17,11 +19,14 @@ class EyeThread : public QThread
 {
     Q_OBJECT
 public:
-    EyeThread(EyeDiagramPlot &eye) : eye(eye) {}
+    EyeThread(EyeDiagramPlot &eye) : eye(eye), generation(0) {}
     ~EyeThread(){}
 private:
     void run() override;
+    // true if the running calculation is outdated (settings changed or plot about to be deleted)
+    bool aborted();
     EyeDiagramPlot &eye;
+    unsigned int generation;
 };
 
 class EyeDiagramPlot : public TracePlot
@@ -48,6 +53,7 @@ public slots:
     void axisSetupDialog();
 signals:
     void statusChanged(QString);
+    void calculationComplete();
 
 protected:
     virtual void updateContextMenu() override;
@@ -67,9 +73,13 @@ private slots:
     void triggerUpdate();
 private:
     static constexpr double yOverrange = 0.2;
+    // vertical resolution of the calculated eye (number of voltage bins per sample)
+    static constexpr unsigned int yBins = 512;
     QPoint plotValueToPixel(QPointF plotValue);
     QPointF pixelToPlotValue(QPoint pixel);
     void setStatus(QString s);
+    // aborts a running calculation, call before locking calcMutex to change the settings
+    void abortCalculation();
     double calculatedTime();
     double minDisplayVoltage();
     double maxDisplayVoltage();
@@ -81,15 +91,11 @@ private:
     XAxis xAxis;
     YAxis yAxis;
 
-    class Xdata {
-    public:
-        double x;
-        std::vector<double> y;
-    };
-
-    std::vector<Xdata> data[2];
-    std::vector<Xdata> *displayData;
-    std::vector<Xdata> *calcData;
+    // Result of the last calculation: hit density with one column per sample and one row per voltage bin
+    // (highest voltage in the first row). Already color graded, only needs to be scaled onto the plot
+    QImage density;
+    double densityTimestep;
+    double densityMinVoltage, densityMaxVoltage;
 
     unsigned int xSamples;
     double datarate;
@@ -113,7 +119,9 @@ private:
     std::mutex calcMutex;
 
     EyeThread *thread;
-    bool destructing;
+    std::atomic<bool> destructing;
+    // incremented whenever a running calculation becomes obsolete
+    std::atomic<unsigned int> calcGeneration;
     QSemaphore semphr;
 };
 
@@ -0,0 +1,98 @@
+#include "renderscheduler.h"
+
+#include "traceplot.h"
+#include "preferences.h"
+
+#include <algorithm>
+
+RenderScheduler::RenderScheduler()
+    : targetInterval(100.0),
+      adaptive(true),
+      currentFrameTime(0.0),
+      averageFrameTime(0.0)
+{
+    frameTimer.setSingleShot(true);
+    connect(&frameTimer, &QTimer::timeout, this, &RenderScheduler::frameTick);
+    sinceLastFrame.start();
+    updateFromPreferences();
+}
+
+void RenderScheduler::requestReplot(TracePlot *plot)
+{
+    pending.insert(plot);
+    if(frameTimer.isActive()) {
+        // already waiting for the next frame, this replot will be included
+        return;
+    }
+    auto remaining = getFrameInterval() - sinceLastFrame.elapsed();
+    if(remaining <= 0) {
+        // last frame was a sufficiently long time ago, render as soon as control returns to the event loop
+        frameTimer.start(0);
+    } else {
+        frameTimer.start(remaining);
+    }
+}
+
+void RenderScheduler::removePlot(TracePlot *plot)
+{
+    pending.erase(plot);
+    stats.erase(plot);
+}
+
+void RenderScheduler::reportRenderTime(TracePlot *plot, double milliseconds)
+{
+    currentFrameTime += milliseconds;
+    auto &s = stats[plot];
+    if(s.frames == 0) {
+        s.average = milliseconds;
+    } else {
+        s.average = (1.0 - averagingWeight) * s.average + averagingWeight * milliseconds;
+    }
+    s.last = milliseconds;
+    s.max = std::max(s.max, milliseconds);
+    s.frames++;
+}
+
+RenderScheduler::RenderStats RenderScheduler::getStats(TracePlot *plot) const
+{
+    if(stats.count(plot)) {
+        return stats.at(plot);
+    } else {
+        return RenderStats();
+    }
+}
+
+double RenderScheduler::getFrameInterval() const
+{
+    auto interval = targetInterval;
+    if(adaptive) {
+        // keep enough time between frames for the acquisition and the user interface
+        interval = std::max(interval, averageFrameTime / maxRenderLoad);
+    }
+    return std::min(interval, maxFrameInterval);
+}
+
+void RenderScheduler::updateFromPreferences()
+{
+    auto &pref = Preferences::getInstance();
+    targetInterval = 1000.0 / std::max(pref.Graphs.targetFPS, 1);
+    adaptive = pref.Graphs.adaptiveFrameRate;
+}
+
+void RenderScheduler::frameTick()
+{
+    // the paint events of the previous frame have all been handled by now
+    averageFrameTime = (1.0 - averagingWeight) * averageFrameTime + averagingWeight * currentFrameTime;
+    currentFrameTime = 0.0;
+    sinceLastFrame.restart();
+
+    auto plots = TracePlot::getPlots();
+    auto requests = std::move(pending);
+    pending.clear();
+    for(auto p : requests) {
+        if(plots.count(p)) {
+            // Qt merges the resulting paint events of all graphs into one update of the window
+            p->replot();
+        }
+    }
+}
@@ -0,0 +1,74 @@
+#ifndef RENDERSCHEDULER_H
+#define RENDERSCHEDULER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+
+#include <set>
+#include <map>
+
+class TracePlot;
+
+// Coalesces the replot requests of all graphs into a single frame tick. The frame rate is limited to a
+// configurable target and reduced automatically if rendering the graphs takes up too much time.
+class RenderScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    static RenderScheduler& getInstance() {
+        static RenderScheduler instance;
+        return instance;
+    }
+    RenderScheduler(const RenderScheduler&) = delete;
+
+    // schedules a replot of the graph in the next frame. Multiple requests before the next frame are merged
+    void requestReplot(TracePlot *plot);
+    // removes any pending requests and the statistics of the graph (must be called when the graph is deleted)
+    void removePlot(TracePlot *plot);
+    // called by the graphs after each paint event
+    void reportRenderTime(TracePlot *plot, double milliseconds);
+
+    class RenderStats {
+    public:
+        RenderStats() : frames(0), last(0.0), average(0.0), max(0.0) {}
+        unsigned long frames;
+        double last;
+        double average; // exponential moving average
+        double max;
+    };
+
+    RenderStats getStats(TracePlot *plot) const;
+    // time between two frames in ms, including adaptive back-off
+    double getFrameInterval() const;
+    double getFrameRate() const { return 1000.0 / getFrameInterval(); }
+
+public slots:
+    void updateFromPreferences();
+
+private slots:
+    void frameTick();
+
+private:
+    RenderScheduler();
+
+    // fraction of the event loop time that rendering is allowed to use before the frame rate gets reduced
+    static constexpr double maxRenderLoad = 0.5;
+    // the frame rate is never reduced below 0.5fps, the interval is capped at this value
+    static constexpr double maxFrameInterval = 2000.0;
+    // weight of the newest frame in the moving average of the frame time
+    static constexpr double averagingWeight = 0.2;
+
+    std::set<TracePlot*> pending;
+    std::map<TracePlot*, RenderStats> stats;
+    QTimer frameTimer;
+    QElapsedTimer sinceLastFrame;
+
+    double targetInterval;
+    bool adaptive;
+    // accumulated render time of all graphs since the last frame tick
+    double currentFrameTime;
+    double averageFrameTime;
+};
+
+#endif // RENDERSCHEDULER_H
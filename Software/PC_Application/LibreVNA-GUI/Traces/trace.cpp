@@ -286,7 +286,7 @@ QString Trace::fillFromCSV(CSV &csv, unsigned int parameter)
     clear();
     fileParameter = parameter;
     filename = csv.getFilename();
-    auto xColumn = csv.getColumn(0);
+    auto &xColumn = csv.getColumn(0);
     if(csv.getHeader(0).compare("time", Qt::CaseInsensitive) == 0) {
         domain = DataType::Time;
     } else if(csv.getHeader(0).compare("power", Qt::CaseInsensitive) == 0) {
@@ -86,10 +86,11 @@ void TraceCSVExport::on_buttonBox_accepted()
     vector<double> X;
     QString Xname = Trace::dataTypeToString(traces[0]->outputType());
     auto samples = traces[0]->numSamples();
+    X.reserve(samples);
     for(unsigned int i=0;i<samples;i++) {
         X.push_back(traces[0]->sample(i).x);
     }
-    csv.addColumn(Xname, X);
+    csv.addColumn(Xname, std::move(X));
     // add the trace data
     for(auto trace : traces) {
         for(auto ytype : getSelectedYAxisTypes()) {
@@ -97,10 +98,11 @@ void TraceCSVExport::on_buttonBox_accepted()
             axis.set(ytype, false, false, 0, 1, 10, false);
             auto samples = trace->numSamples();
             vector<double> values;
+            values.reserve(samples);
             for(unsigned int i=0;i<samples;i++) {
                 values.push_back(axis.sampleToCoordinate(trace->sample(i), trace, i));
             }
-            csv.addColumn(trace->name()+"_"+axis.TypeToName(), values);
+            csv.addColumn(trace->name()+"_"+axis.TypeToName(), std::move(values));
         }
     }
 
@@ -1,5 +1,7 @@
 ﻿#include "tracemodel.h"
 
+#include "Util/latencytracer.h"
+
 #include <QIcon>
 #include <QDebug>
 #include <QDateTime>
@@ -283,6 +285,7 @@ void TraceModel::clearLiveData()
 
 void TraceModel::addVNAData(const DeviceDriver::VNAMeasurement& d, TraceMath::DataType datatype, bool deembedded)
 {
+    LATENCY_SPAN("TraceModel::addVNAData", "Traces", d.pointNum);
     source = DataSource::VNA;
     lastReceivedData = QDateTime::currentDateTimeUtc();
     for(auto t : traces) {
@@ -5,18 +5,22 @@
 #include "Marker/markermodel.h"
 #include "preferences.h"
 #include "Util/util.h"
+#include "Util/latencytracer.h"
+#include "Util/metrics.h"
 #include "CustomWidgets/tilewidget.h"
 #include "tracexyplot.h"
 #include "tracesmithchart.h"
 #include "eyediagramplot.h"
 #include "tracewaterfall.h"
 #include "tracepolarchart.h"
+#include "renderscheduler.h"
 
 #include <QPainter>
 #include <QPainterPath>
 #include <QMimeData>
 #include <QDebug>
 #include <QApplication>
+#include <QElapsedTimer>
 
 std::set<TracePlot*> TracePlot::plots;
 
@@ -38,7 +42,6 @@ TracePlot::TracePlot(TraceModel &model, QWidget *parent)
     contextmenu = new QMenu();
     markedForDeletion = false;
     setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
-    lastUpdate = QTime::currentTime();
     replotTimer.setSingleShot(true);
     connect(&replotTimer, &QTimer::timeout, this, qOverload<>(&TracePlot::update));
     sweep_fmin = std::numeric_limits<double>::lowest();
@@ -57,6 +60,7 @@ TracePlot::TracePlot(TraceModel &model, QWidget *parent)
 TracePlot::~TracePlot()
 {
     plots.erase(this);
+    RenderScheduler::getInstance().removePlot(this);
     delete contextmenu;
     delete cursorLabel;
 }
@@ -201,6 +205,10 @@ void TracePlot::contextMenuEvent(QContextMenuEvent *event)
 
 void TracePlot::paintEvent(QPaintEvent *event)
 {
+    LATENCY_SPAN("TracePlot::paintEvent", "Plot");
+    QElapsedTimer renderTime;
+    renderTime.start();
+
     if(traceRemovalPending) {
         for(auto t : traces) {
             if(!t.second) {
@@ -378,6 +386,23 @@ void TracePlot::paintEvent(QPaintEvent *event)
         p.drawText(QRect(dropRect.right(), 0, dropRect.left(), h), Qt::AlignCenter, "Insert to\nthe right");
     }
 
+    auto &scheduler = RenderScheduler::getInstance();
+    if(pref.Graphs.showRenderTimes) {
+        // timing of the previous paint event, the current one is still in progress
+        auto stats = scheduler.getStats(this);
+        auto font = p.font();
+        font.setPixelSize(pref.Graphs.fontSizeAxis);
+        p.setFont(font);
+        p.setPen(Util::getFontColorFromBackground(pref.Graphs.Color.background));
+        auto text = QString::number(stats.last, 'f', 1) + "ms (avg " + QString::number(stats.average, 'f', 1)
+                + "ms, max " + QString::number(stats.max, 'f', 1) + "ms) @ " + QString::number(scheduler.getFrameRate(), 'f', 1) + "fps";
+        p.drawText(QRect(0, 0, w, h), Qt::AlignLeft | Qt::AlignBottom, text);
+    }
+
+    scheduler.reportRenderTime(this, renderTime.nsecsElapsed() * 1.0e-6);
+    static auto &frameTime = Metrics::getInstance().histogram("librevna_render_frame_seconds", "Time needed to paint a plot",
+                                                              Metrics::Histogram::exponentialBounds(0.0005, 2, 12));
+    frameTime.observe(renderTime.nsecsElapsed() * 1.0e-9);
     replotTimer.start(MaxUpdateInterval);
 }
 
@@ -757,14 +782,8 @@ void TracePlot::traceDeleted(Trace *t)
 
 void TracePlot::triggerReplot()
 {
-    auto now = QTime::currentTime();
-    if (lastUpdate.msecsTo(now) >= MinUpdateInterval // last update was a sufficiently long time ago
-            || lastUpdate.msecsTo(now) < 0) { // or the time rolled over at midnight
-        lastUpdate = now;
-        replot();
-    } else {
-        replotTimer.start(MinUpdateInterval);
-    }
+    // replots of all graphs are rate limited and merged into a single frame
+    RenderScheduler::getInstance().requestReplot(this);
 }
 
 void TracePlot::checkIfStillSupported(Trace *t)
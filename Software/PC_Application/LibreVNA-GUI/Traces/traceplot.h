@@ -6,14 +6,15 @@
 
 #include <QMenu>
 #include <QContextMenuEvent>
-#include <QTime>
 #include <QLabel>
 #include <QWidget>
 
 class TileWidget;
+class RenderScheduler;
 
 class TracePlot : public QWidget, public Savable
 {
+    friend class RenderScheduler;
     Q_OBJECT
 public:
     enum class Type {
@@ -52,7 +53,7 @@ signals:
     void deleted(TracePlot*);
 
 protected:
-    static constexpr int MinUpdateInterval = 100;
+    // graphs are repainted at least this often, even without any replot requests
     static constexpr int MaxUpdateInterval = 2000;
     // need to be called in derived class constructor
     void initializeTraceInfo();
@@ -75,7 +76,6 @@ protected:
     std::map<Trace*, bool> traces;
     QMenu *contextmenu;
     QPoint contextmenuClickpoint; // mouse coordinates when the contextmenu was invoked
-    QTime lastUpdate;
     QTimer replotTimer;
     bool markedForDeletion;
     static std::set<TracePlot*> plots;
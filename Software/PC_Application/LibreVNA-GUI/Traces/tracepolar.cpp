@@ -2,8 +2,10 @@
 
 #include "Marker/marker.h"
 #include "Util/util.h"
+#include "preferences.h"
 
 #include <QFileDialog>
+#include <QPainter>
 
 using namespace std;
 
@@ -17,9 +19,43 @@ TracePolar::TracePolar(TraceModel &model, QWidget *parent)
     fmax = 6000000000;
     edgeReflection = 1.0;
     offset = QPointF(0.0, 0.0);
+    cacheEdgeReflection = 0.0;
     initializeTraceInfo();
 }
 
+void TracePolar::enableTrace(Trace *t, bool enabled)
+{
+    bool changed = traces[t] != enabled;
+    TracePlot::enableTrace(t, enabled);
+    if(!changed) {
+        return;
+    }
+    if(enabled) {
+        // keep track of changed points, only those need to be transformed again
+        connect(t, &Trace::dataChanged, this, [=](unsigned int begin, unsigned int end){
+            auto &cache = traceCache[t];
+            if(cache.dirtyBegin >= cache.dirtyEnd) {
+                cache.dirtyBegin = begin;
+                cache.dirtyEnd = end;
+            } else {
+                cache.dirtyBegin = std::min(cache.dirtyBegin, begin);
+                cache.dirtyEnd = std::max(cache.dirtyEnd, end);
+            }
+        });
+        connect(t, &Trace::typeChanged, this, [=](){
+            traceCache.erase(t);
+        });
+        connect(t, &Trace::lastMathChanged, this, [=](){
+            traceCache.erase(t);
+        });
+    } else {
+        disconnect(t, &Trace::dataChanged, this, nullptr);
+        disconnect(t, &Trace::typeChanged, this, nullptr);
+        disconnect(t, &Trace::lastMathChanged, this, nullptr);
+    }
+    traceCache.erase(t);
+}
+
 nlohmann::json TracePolar::toJSON()
 {
     nlohmann::json j;
@@ -320,6 +356,165 @@ double TracePolar::maximumVisibleFrequency()
     }
 }
 
+void TracePolar::drawCachedBackground(QPainter &p)
+{
+    auto &pref = Preferences::getInstance();
+
+    BackgroundKey key;
+    key.size = p.window().size();
+    key.pixelRatio = devicePixelRatioF();
+    key.transform = transform;
+    key.edgeReflection = edgeReflection;
+    key.offset = offset;
+    key.axisColor = pref.Graphs.Color.axis.rgba();
+    key.divisionColor = pref.Graphs.Color.Ticks.divisions.rgba();
+    key.lineWidth = pref.Graphs.lineWidth;
+    key.settings = backgroundSettings();
+
+    if(background.isNull() || !(key == backgroundKey)) {
+        // cached background is outdated, render again
+        background = QPixmap(key.size * key.pixelRatio);
+        background.setDevicePixelRatio(key.pixelRatio);
+        background.fill(Qt::transparent);
+        QPainter bp(&background);
+        bp.setRenderHints(p.renderHints());
+        bp.setFont(p.font());
+        drawBackground(bp);
+        backgroundKey = key;
+    }
+    p.drawPixmap(0, 0, background);
+}
+
+void TracePolar::drawTrace(QPainter &p, Trace *t)
+{
+    auto &pref = Preferences::getInstance();
+    auto &points = pixelCoordinates(t);
+    auto nPoints = points.size();
+
+    bool checkFrequency = t->getDataType() == Trace::DataType::Frequency;
+    auto minFreq = minimumVisibleFrequency();
+    auto maxFreq = maximumVisibleFrequency();
+    bool hideAfterSweep = pref.Graphs.SweepIndicator.hide && !isnan(xSweep) && t->getSource() == Trace::Source::Live && t->isVisible() && !t->isPaused();
+    auto center = transform.map(QPointF(0,0));
+    auto radius = polarCoordMax * transform.m11();
+    auto outside = [&](const QPointF &point) -> bool {
+        auto diff = point - center;
+        return QPointF::dotProduct(diff, diff) > radius * radius;
+    };
+
+    // the trace is drawn as polylines with as few interruptions as possible. Points too close to their
+    // predecessor are skipped (unless they end a polyline), they would not be visible anyway
+    QPolygonF line;
+    QPointF skipped;
+    bool hasSkipped = false;
+    auto finishLine = [&]() {
+        if(hasSkipped) {
+            line.append(skipped);
+            hasSkipped = false;
+        }
+        if(line.size() >= 2) {
+            p.drawPolyline(line);
+        }
+        line.clear();
+    };
+    auto addPoint = [&](const QPointF &point) {
+        if(!line.isEmpty()) {
+            auto diff = point - line.back();
+            if(QPointF::dotProduct(diff, diff) < minPointDistance * minPointDistance) {
+                skipped = point;
+                hasSkipped = true;
+                return;
+            }
+        }
+        line.append(point);
+        hasSkipped = false;
+    };
+
+    double lastX = nPoints > 0 ? t->sample(0).x : 0.0;
+    for(unsigned int i=1;i<nPoints;i++) {
+        auto nowX = t->sample(i).x;
+        auto x = lastX;
+        lastX = nowX;
+        if (checkFrequency && (x < minFreq || nowX > maxFreq)) {
+            finishLine();
+            continue;
+        }
+        if(isnan(points[i].x())) {
+            break;
+        }
+
+        if(hideAfterSweep) {
+            // check if this part of the trace is visible
+            double range = maxFreq - minFreq;
+            double afterSweep = nowX - xSweep;
+            if(afterSweep > 0 && afterSweep * 100 / range <= pref.Graphs.SweepIndicator.hidePercent) {
+                // do not display this part of the trace
+                finishLine();
+                continue;
+            }
+        }
+
+        QPointF p1 = points[i-1];
+        QPointF p2 = points[i];
+        if(limitToEdge && (outside(p1) || outside(p2))) {
+            // partially outside of visible area, constrain
+            if(!TracePolar::constrainLineToCircle(p1, p2, center, radius)) {
+                // completely out of visible area
+                finishLine();
+                continue;
+            }
+            if(line.isEmpty() || p1 != points[i-1]) {
+                // starts at the edge of the visible area
+                finishLine();
+                line.append(p1);
+            }
+            addPoint(p2);
+            if(p2 != points[i]) {
+                // leaves the visible area
+                finishLine();
+            }
+            continue;
+        }
+        if(line.isEmpty()) {
+            line.append(p1);
+        }
+        addPoint(p2);
+    }
+    finishLine();
+}
+
+const std::vector<QPointF> &TracePolar::pixelCoordinates(Trace *t)
+{
+    if(transform != cacheTransform || edgeReflection != cacheEdgeReflection || offset != cacheOffset) {
+        // zoom, offset or size changed, all coordinates are outdated
+        traceCache.clear();
+        cacheTransform = transform;
+        cacheEdgeReflection = edgeReflection;
+        cacheOffset = offset;
+    }
+    auto &cache = traceCache[t];
+    unsigned int samples = t->size();
+    if(cache.points.size() != samples) {
+        cache.points.resize(samples);
+        cache.dirtyBegin = 0;
+        cache.dirtyEnd = samples;
+    }
+    for(unsigned int i=cache.dirtyBegin;i<cache.dirtyEnd && i<samples;i++) {
+        auto d = dataAddOffset(t->sample(i).y);
+        cache.points[i] = transform.map(QPointF(d.real() * polarCoordMax / edgeReflection, -d.imag() * polarCoordMax / edgeReflection));
+    }
+    cache.dirtyBegin = cache.dirtyEnd = 0;
+    return cache.points;
+}
+
+bool TracePolar::BackgroundKey::operator==(const TracePolar::BackgroundKey &rhs) const
+{
+    return size == rhs.size && pixelRatio == rhs.pixelRatio && transform == rhs.transform
+            && edgeReflection == rhs.edgeReflection && offset == rhs.offset
+            && axisColor == rhs.axisColor && divisionColor == rhs.divisionColor
+            && lineWidth == rhs.lineWidth && settings == rhs.settings;
+}
+
 bool TracePolar::constrainLineToCircle(QPointF &a, QPointF &b, QPointF center, double radius)
 {
     auto distance = [](const QPointF &a, const QPointF &b) {
@@ -3,6 +3,8 @@
 
 #include "traceplot.h"
 
+#include <QPixmap>
+
 class PolarArc {
 public:
     PolarArc(QPointF center, double radius, double startAngle = 0.0, double spanAngle = 2*M_PI);
@@ -21,6 +23,8 @@ public:
     virtual nlohmann::json toJSON() override; // derived classes must call TracePolar::joJSON before doing anything
     virtual void fromJSON(nlohmann::json j) override; // derived classes must call TracePolar::joJSON before doing anything
 
+    virtual void enableTrace(Trace *t, bool enabled) override;
+
     virtual void move(const QPoint &vect) override;
     virtual void zoom(const QPoint &center, double factor, bool horizontally, bool vertically) override;
     virtual void setAuto(bool horizontally, bool vertically) override;
@@ -32,6 +36,8 @@ public slots:
 
 protected:
     static constexpr double polarCoordMax = 4096;
+    // consecutive trace points closer than this (in pixels) are merged when drawing
+    static constexpr double minPointDistance = 1.0;
 
     virtual bool positionWithinGraphArea(const QPoint &p) override;
     virtual std::complex<double> dataAddOffset(std::complex<double> d);
@@ -52,6 +58,15 @@ protected:
     double minimumVisibleFrequency();
     double maximumVisibleFrequency();
 
+    // Draws the static part of the chart (circles, grid lines). Only called when the cached background is outdated
+    virtual void drawBackground(QPainter &p) {Q_UNUSED(p)}
+    // All settings that influence drawBackground (apart from size, zoom, offset and graph colors)
+    virtual nlohmann::json backgroundSettings() { return nlohmann::json(); }
+    // Draws the background from the cache, renders it again first if necessary. transform must already be set
+    void drawCachedBackground(QPainter &p);
+    // Draws a trace as polylines, using cached pixel coordinates for all points
+    void drawTrace(QPainter &p, Trace *t);
+
     // given two points and a circle, the two points are adjusted in such a way that the line they describe
     // is constrained within the circle. Returns true if there is a remaining line segment in the circle, false
     // if the line lies completely outside of the circle (or is tangent to the circle)
@@ -65,6 +80,36 @@ protected:
     double edgeReflection; // magnitude of reflection coefficient at the edge of the polar chart (zoom factor)
     QPointF offset;
     QTransform transform;
+
+private:
+    const std::vector<QPointF> &pixelCoordinates(Trace *t);
+
+    class BackgroundKey {
+    public:
+        bool operator==(const BackgroundKey &rhs) const;
+        QSize size;
+        qreal pixelRatio;
+        QTransform transform;
+        double edgeReflection;
+        QPointF offset;
+        QRgb axisColor, divisionColor;
+        double lineWidth;
+        nlohmann::json settings;
+    };
+    BackgroundKey backgroundKey;
+    QPixmap background;
+
+    class TraceCache {
+    public:
+        std::vector<QPointF> points;
+        // range of points that changed since they were last transformed
+        unsigned int dirtyBegin, dirtyEnd;
+    };
+    std::map<Trace*, TraceCache> traceCache;
+    // transformation parameters the cached coordinates are based on
+    QTransform cacheTransform;
+    double cacheEdgeReflection;
+    QPointF cacheOffset;
 };
 
 #endif // TRACEPOLAR_H
@@ -17,6 +17,7 @@ public slots:
 private:
     bool supported(Trace *t) override;
     virtual void draw(QPainter& painter) override;
+    virtual void drawBackground(QPainter& p) override;
     virtual bool dropSupported(Trace *t) override;
     QString mouseText(QPoint pos) override;
 };
@@ -235,19 +235,10 @@ bool TraceSmithChart::configureForTrace(Trace *t)
     return false;
 }
 
-void TraceSmithChart::draw(QPainter &p) {
+void TraceSmithChart::drawBackground(QPainter &p)
+{
     auto& pref = Preferences::getInstance();
 
-    // translate coordinate system so that the smith chart sits in the origin and has a size of 1
-    auto w = p.window();
-    p.save();
-    p.translate(w.width()/2, w.height()/2);
-    auto scale = qMin(w.height(), w.width()) / (2.0 * polarCoordMax);
-    p.scale(scale, scale);
-
-    transform = p.transform();
-    p.restore();
-
     auto drawArc = [&](SmithChartArc a) {
         a.constrainToCircle(QPointF(0,0), edgeReflection);
         auto topleft = dataToPixel(complex<double>(a.center.x() - a.radius, a.center.y() - a.radius));
@@ -297,6 +288,32 @@ void TraceSmithChart::draw(QPainter &p) {
             drawArc(arc);
         }
     }
+}
+
+nlohmann::json TraceSmithChart::backgroundSettings()
+{
+    nlohmann::json j;
+    j["Z0"] = Z0;
+    for(auto line : constantLines) {
+        j["constantLines"].push_back(line.toJSON());
+    }
+    return j;
+}
+
+void TraceSmithChart::draw(QPainter &p) {
+    auto& pref = Preferences::getInstance();
+
+    // translate coordinate system so that the smith chart sits in the origin and has a size of 1
+    auto w = p.window();
+    p.save();
+    p.translate(w.width()/2, w.height()/2);
+    auto scale = qMin(w.height(), w.width()) / (2.0 * polarCoordMax);
+    p.scale(scale, scale);
+
+    transform = p.transform();
+    p.restore();
+
+    drawCachedBackground(p);
 
     for(auto t : traces) {
         if(!t.second) {
@@ -308,48 +325,10 @@ void TraceSmithChart::draw(QPainter &p) {
             // trace marked invisible
             continue;
         }
-        pen = QPen(trace->color(), pref.Graphs.lineWidth);
+        auto pen = QPen(trace->color(), pref.Graphs.lineWidth);
         pen.setCosmetic(true);
         p.setPen(pen);
-        int nPoints = trace->size();
-        for(int i=1;i<nPoints;i++) {
-            auto last = trace->sample(i-1);
-            auto now = trace->sample(i);
-            if ((trace->getDataType() == Trace::DataType::Frequency) && (last.x < minimumVisibleFrequency() || now.x > maximumVisibleFrequency())) {
-                continue;
-            }
-            if(isnan(now.y.real())) {
-                break;
-            }
-
-            if(pref.Graphs.SweepIndicator.hide && !isnan(xSweep) && trace->getSource() == Trace::Source::Live && trace->isVisible() && !trace->isPaused()) {
-                // check if this part of the trace is visible
-                double range = maximumVisibleFrequency() - minimumVisibleFrequency();
-                double afterSweep = now.x - xSweep;
-                if(afterSweep > 0 && afterSweep * 100 / range <= pref.Graphs.SweepIndicator.hidePercent) {
-                    // do not display this part of the trace
-                    continue;
-                }
-            }
-
-            last = dataAddOffset(last);
-            now = dataAddOffset(now);
-
-            // scale to size of smith diagram
-            QPointF p1 = dataToPixel(last);
-            QPointF p2 = dataToPixel(now);
-
-            if(limitToEdge && (abs(last.y) > edgeReflection || abs(now.y) > edgeReflection)) {
-                // partially outside of visible area, constrain
-                if(!TracePolar::constrainLineToCircle(p1, p2, transform.map(QPointF(0,0)), polarCoordMax * scale)) {
-                    // completely out of visible area
-                    continue;
-                }
-            }
-
-            // draw line
-            p.drawLine(p1, p2);
-        }
+        drawTrace(p, trace);
         if(trace->size() > 0) {
             // only draw markers if the trace has at least one point
             auto markers = t.first->getMarkers();
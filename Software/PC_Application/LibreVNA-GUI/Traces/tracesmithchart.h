@@ -119,6 +119,8 @@ protected:
     virtual bool configureForTrace(Trace *t) override;
     bool supported(Trace *t) override;
     virtual void draw(QPainter& painter) override;
+    virtual void drawBackground(QPainter& p) override;
+    virtual nlohmann::json backgroundSettings() override;
     virtual void traceDropped(Trace *t, QPoint position) override;
     virtual bool dropSupported(Trace *t) override;
     QString mouseText(QPoint pos) override;
@@ -10,6 +10,9 @@
 #include <QFileDialog>
 #include <QPainter>
 
+#include <array>
+#include <cstring>
+
 using namespace std;
 
 TraceWaterfall::TraceWaterfall(TraceModel &model, QWidget *parent)
@@ -17,6 +20,15 @@ TraceWaterfall::TraceWaterfall(TraceModel &model, QWidget *parent)
       dir(Direction::TopToBottom),
       align(Alignment::PrimaryOnly),
       trace(nullptr),
+      historyPoints(0),
+      historyStride(0),
+      historyNewest(0),
+      historyRows(0),
+      imageValid(false),
+      imageSlots(0),
+      imageNewest(0),
+      pendingBegin(0),
+      pendingEnd(0),
       pixelsPerLine(1),
       keepDataBeyondPlotSize(false),
       maxDataSweeps(500)
@@ -25,6 +37,7 @@ TraceWaterfall::TraceWaterfall(TraceModel &model, QWidget *parent)
     plotAreaLeft = 0;
     plotAreaWidth = 0;
     plotAreaBottom = 0;
+    historyNewest = maxDataSweeps - 1;
 
     xAxis.set(XAxis::Type::Frequency, false, true, 0, 6000000000, 10, false);
     yAxis.set(YAxis::Type::Magnitude, false, true, -1, 1, 10, false);
@@ -97,7 +110,7 @@ void TraceWaterfall::fromJSON(nlohmann::json j)
 {
     resetWaterfall();
     pixelsPerLine = j.value("pixelsPerLine", pixelsPerLine);
-    maxDataSweeps = j.value("maxLines", maxDataSweeps);
+    setMaxSweeps(j.value("maxLines", maxDataSweeps));
     keepDataBeyondPlotSize = j.value("keepDataBeyondPlot", keepDataBeyondPlotSize);
     if(QString::fromStdString(j.value("direction", "TopToBottom")) == "TopToBottom") {
         dir = Direction::TopToBottom;
@@ -153,7 +166,46 @@ void TraceWaterfall::axisSetupDialog()
 
 void TraceWaterfall::resetWaterfall()
 {
-    data.clear();
+    history.clear();
+    rowMin.clear();
+    rowMax.clear();
+    xValues.clear();
+    historyPoints = 0;
+    historyStride = 0;
+    historyRows = 0;
+    // the next row will be stored at index 0
+    historyNewest = maxDataSweeps - 1;
+    pendingBegin = pendingEnd = 0;
+    imageValid = false;
+    updateYAxis();
+}
+
+void TraceWaterfall::setMaxSweeps(unsigned int sweeps)
+{
+    if(sweeps < 1) {
+        sweeps = 1;
+    }
+    if(sweeps == maxDataSweeps) {
+        return;
+    }
+    // copy the newest rows into a new buffer, starting with the oldest row at index 0
+    auto rows = historyStride > 0 ? std::min(historyRows, sweeps) : 0;
+    std::vector<float> newHistory(rows * historyStride);
+    std::vector<float> newMin(rows), newMax(rows);
+    for(unsigned int i=0;i<rows;i++) {
+        auto age = rows - i - 1;
+        auto index = (historyNewest + maxDataSweeps - age) % maxDataSweeps;
+        memcpy(&newHistory[i * historyStride], historyRow(age), historyStride * sizeof(float));
+        newMin[i] = rowMin[index];
+        newMax[i] = rowMax[index];
+    }
+    history = std::move(newHistory);
+    rowMin = std::move(newMin);
+    rowMax = std::move(newMax);
+    maxDataSweeps = sweeps;
+    historyRows = rows;
+    historyNewest = rows > 0 ? rows - 1 : maxDataSweeps - 1;
+    imageValid = false;
     updateYAxis();
 }
 
@@ -385,71 +437,32 @@ void TraceWaterfall::draw(QPainter &p)
         }
     }
 
-    p.setClipRect(QRect(plotRect.x()+1, plotRect.y()+1, plotRect.width()-1, plotRect.height()-1));
-    if(data.size()) {
-        // plot waterfall data
-        int ytop, ybottom;
-        bool lastLine = false;
-        if(dir == Direction::TopToBottom) {
-            ytop = plotAreaTop;
-            ybottom = ytop + pixelsPerLine - 1;
+    auto waterfallRect = QRect(plotRect.x()+1, plotRect.y()+1, plotRect.width()-1, plotRect.height()-1);
+    p.setClipRect(waterfallRect);
+    if(historyRows > 0 && waterfallRect.width() > 0 && waterfallRect.height() > 0) {
+        auto layout = currentImageLayout(waterfallRect.size());
+        if(!imageValid || layout != imageLayout) {
+            // axis, size or settings changed, render all visible sweeps again
+            rebuildImage(layout);
         } else {
-            ybottom = plotAreaBottom - 1;
-            ytop = ybottom - pixelsPerLine + 1;
-        }
-        int i;
-        for(i=data.size() - 1;i>=0;i--) {
-            auto sweep = data[i];
-            for(unsigned int s=0;s<sweep.size();s++) {
-                auto x = xAxis.sampleToCoordinate(sweep[s], trace);
-                double x_start;
-                double x_stop;
-                if(x < xAxis.getRangeMin() || x > xAxis.getRangeMax()) {
-                    // out of range, skip
-                    continue;
-                }
-                if(s == 0) {
-                    x_start = x;
-                } else {
-                    auto prev_x = xAxis.sampleToCoordinate(sweep[s-1], trace);
-                    x_start = (prev_x + x) / 2.0;
-                }
-                x_start = xAxis.transform(x_start, plotAreaLeft, plotAreaLeft + plotAreaWidth);
-                if(s == sweep.size() - 1) {
-                    x_stop = x;
-                } else {
-                    auto next_x = xAxis.sampleToCoordinate(sweep[s+1], trace);
-                    x_stop = (next_x + x) / 2.0;
-                }
-                x_stop = xAxis.transform(x_stop, plotAreaLeft, plotAreaLeft + plotAreaWidth);
-                auto y = yAxis.sampleToCoordinate(sweep[s]);
-                auto color = Util::getIntensityGradeColor(yAxis.transform(y, 0.0, 1.0));
-                auto rect = QRect(round(x_start), ytop, round(x_stop - x_start) + 1, ybottom - ytop + 1);
-                p.fillRect(rect, QBrush(color));
-            }
-            if(lastLine) {
-                break;
-            }
-            // update ycoords for next line
-            if(dir == Direction::TopToBottom) {
-                ytop = ybottom + 1;
-                ybottom = ytop + pixelsPerLine - 1;
-                if(ybottom >= plotAreaBottom) {
-                    ybottom = plotAreaBottom;
-                    lastLine = true;
-                }
-            } else {
-                ybottom = ytop - 1;
-                ytop = ybottom - pixelsPerLine + 1;
-                if(ytop <= plotAreaTop) {
-                    ytop = plotAreaTop;
-                    lastLine = true;
-                }
-            }
+            renderPending();
+        }
+        // draw the image in two parts, starting with the slot that is displayed at the top
+        unsigned int topSlot = dir == Direction::TopToBottom ? imageNewest : (imageNewest + 1) % imageSlots;
+        int split = topSlot * pixelsPerLine;
+        int imageHeight = image.height();
+        int y = waterfallRect.y();
+        if(dir == Direction::BottomToTop) {
+            // newest sweep has to be aligned with the bottom of the plot
+            y = waterfallRect.y() + waterfallRect.height() - imageHeight;
         }
-        if(!keepDataBeyondPlotSize && i >= 0) {
+        p.drawImage(QPoint(waterfallRect.x(), y), image, QRect(0, split, image.width(), imageHeight - split));
+        if(split > 0) {
+            p.drawImage(QPoint(waterfallRect.x(), y + imageHeight - split), image, QRect(0, 0, image.width(), split));
+        }
+        if(!keepDataBeyondPlotSize && historyRows > imageSlots) {
             // not all data could be plotted, drop
-            data.erase(data.begin(), data.begin() + i);
+            historyRows = imageSlots;
             updateYAxis();
         }
     }
@@ -559,30 +572,63 @@ void TraceWaterfall::traceDataChanged(unsigned int begin, unsigned int end)
             xAxis.set(xAxis.getType(), xAxis.getLog(), true, min_x, max_x, xAxis.getDivs(), xAxis.getAutoDivs());
         }
     }
+    auto points = trace->size();
+    if(points != historyPoints) {
+        if(historyRows > 1 || points < historyPoints) {
+            // number of points changed, the stored sweeps can not be displayed together with the new one
+            resetWaterfall();
+        }
+        if(points > historyStride) {
+            // still in the first sweep, grow the row size (only the newest row has to be preserved)
+            auto newStride = std::max(points, historyStride * 2);
+            std::vector<float> newHistory(newStride, std::numeric_limits<float>::quiet_NaN());
+            if(historyRows > 0 && historyPoints > 0) {
+                memcpy(newHistory.data(), historyRow(0), historyPoints * sizeof(float));
+                rowMin = {rowMin[historyNewest]};
+                rowMax = {rowMax[historyNewest]};
+                historyNewest = 0;
+            }
+            history = std::move(newHistory);
+            historyStride = newStride;
+        }
+        historyPoints = points;
+        xValues.resize(points, std::numeric_limits<double>::quiet_NaN());
+        imageValid = false;
+    }
     bool YAxisUpdateRequired = false;
-    if (begin == 0 || data.size() == 0) {
-        if(data.size() == 1) {
+    if (begin == 0 || historyRows == 0) {
+        if(historyRows == 1) {
             YAxisUpdateRequired = true;
         }
-        // start new row
-        data.push_back(std::vector<Trace::Data>());
-        while (data.size() > maxDataSweeps) {
-            data.pop_front();
-            // min/max might have changed due to removed data
+        if(historyRows == maxDataSweeps) {
+            // oldest row will be overwritten, min/max might change
             YAxisUpdateRequired = true;
         }
+        // start new row
+        addHistoryRow();
     }
     // grab trace data
-    data.back().resize(trace->size());
+    auto row = historyRow(0);
+    auto &minRow = rowMin[historyNewest];
+    auto &maxRow = rowMax[historyNewest];
     double min = yAxis.getRangeMin();
     double max = yAxis.getRangeMax();
     for(unsigned int i=begin;i<end;i++) {
-        data.back()[i] = trace->sample(i);
+        auto sample = trace->sample(i);
+        double x = xAxis.sampleToCoordinate(sample, trace, i);
+        if(x != xValues[i]) {
+            // position of the point changed, column mapping needs update
+            xValues[i] = x;
+            imageValid = false;
+        }
+        double val = yAxis.sampleToCoordinate(sample, trace, i);
+        row[i] = val;
+        if(isnan(val) || isinf(val)) {
+            continue;
+        }
+        minRow = std::min(minRow, (float) val);
+        maxRow = std::max(maxRow, (float) val);
         if(yAxis.getAutorange() && !YAxisUpdateRequired) {
-            double val = yAxis.sampleToCoordinate(trace->sample(i));
-            if(isnan(val) || isinf(val)) {
-                continue;
-            }
             if(val < min) {
                 min = val;
             }
@@ -591,6 +637,13 @@ void TraceWaterfall::traceDataChanged(unsigned int begin, unsigned int end)
             }
         }
     }
+    if(pendingBegin == pendingEnd) {
+        pendingBegin = begin;
+        pendingEnd = end;
+    } else {
+        pendingBegin = std::min(pendingBegin, begin);
+        pendingEnd = std::max(pendingEnd, end);
+    }
     if(yAxis.getAutorange() && !YAxisUpdateRequired && (min != yAxis.getRangeMin() || max != yAxis.getRangeMax())) {
         // axis scaling needs update due to new trace data
         yAxis.set(yAxis.getType(), yAxis.getLog(), true, min, max, yAxis.getDivs(), yAxis.getAutoDivs());
@@ -604,18 +657,14 @@ void TraceWaterfall::updateYAxis()
     if(yAxis.getAutorange()) {
         double min = std::numeric_limits<double>::max();
         double max = std::numeric_limits<double>::lowest();
-        for(auto sweep : data) {
-            for(unsigned int i=0;i<sweep.size();i++) {
-                double val = yAxis.sampleToCoordinate(sweep[i]);
-                if(isnan(val) || isinf(val)) {
-                    continue;
-                }
-                if(val < min) {
-                    min = val;
-                }
-                if(val > max) {
-                    max = val;
-                }
+        // only the per-sweep extrema need to be checked
+        for(unsigned int age=0;age<historyRows;age++) {
+            auto index = (historyNewest + maxDataSweeps - age) % maxDataSweeps;
+            if(rowMin[index] < min) {
+                min = rowMin[index];
+            }
+            if(rowMax[index] > max) {
+                max = rowMax[index];
             }
         }
         if(max > min) {
@@ -624,6 +673,196 @@ void TraceWaterfall::updateYAxis()
     }
 }
 
+float *TraceWaterfall::historyRow(unsigned int age)
+{
+    if(historyStride == 0 || history.empty()) {
+        // trace without points, there is no row to point to
+        return nullptr;
+    }
+    auto index = (historyNewest + maxDataSweeps - age) % maxDataSweeps;
+    return &history[index * historyStride];
+}
+
+void TraceWaterfall::addHistoryRow()
+{
+    if(imageValid) {
+        // finish the previous sweep before its slot moves
+        renderPending();
+        advanceImageSlot();
+    }
+    historyNewest = (historyNewest + 1) % maxDataSweeps;
+    if(history.size() < (historyNewest + 1) * historyStride) {
+        // buffer is not full yet
+        history.resize((historyNewest + 1) * historyStride);
+    }
+    if(rowMin.size() < historyNewest + 1) {
+        rowMin.resize(historyNewest + 1);
+        rowMax.resize(historyNewest + 1);
+    }
+    if(historyRows < maxDataSweeps) {
+        historyRows++;
+    }
+    auto row = historyRow(0);
+    std::fill(row, row + historyStride, std::numeric_limits<float>::quiet_NaN());
+    rowMin[historyNewest] = std::numeric_limits<float>::max();
+    rowMax[historyNewest] = std::numeric_limits<float>::lowest();
+    pendingBegin = pendingEnd = 0;
+}
+
+bool TraceWaterfall::ImageLayout::operator==(const ImageLayout &o) const
+{
+    return size == o.size && pixelsPerLine == o.pixelsPerLine && dir == o.dir
+            && xMin == o.xMin && xMax == o.xMax && yMin == o.yMin && yMax == o.yMax
+            && xLog == o.xLog && yLog == o.yLog && points == o.points;
+}
+
+TraceWaterfall::ImageLayout TraceWaterfall::currentImageLayout(QSize size)
+{
+    ImageLayout l;
+    l.size = size;
+    l.pixelsPerLine = pixelsPerLine;
+    l.dir = dir;
+    l.xMin = xAxis.getRangeMin();
+    l.xMax = xAxis.getRangeMax();
+    l.xLog = xAxis.getLog();
+    l.yMin = yAxis.getRangeMin();
+    l.yMax = yAxis.getRangeMax();
+    l.yLog = yAxis.getLog();
+    l.points = historyPoints;
+    return l;
+}
+
+void TraceWaterfall::rebuildImage(const ImageLayout &layout)
+{
+    imageLayout = layout;
+    imageSlots = (layout.size.height() + pixelsPerLine - 1) / pixelsPerLine;
+    if(image.width() != layout.size.width() || image.height() != (int) (imageSlots * pixelsPerLine)) {
+        image = QImage(layout.size.width(), imageSlots * pixelsPerLine, QImage::Format_ARGB32_Premultiplied);
+    }
+    image.fill(Qt::transparent);
+    imageNewest = 0;
+
+    // calculate which pixel columns belong to each point (boundaries are halfway between two neighboring points)
+    columnStart.resize(historyPoints);
+    columnStop.resize(historyPoints);
+    // the image starts one pixel to the right of the plot area border
+    int offset = plotAreaLeft + 1;
+    for(unsigned int s=0;s<historyPoints;s++) {
+        auto x = xValues[s];
+        if(isnan(x) || x < xAxis.getRangeMin() || x > xAxis.getRangeMax()) {
+            // out of range, skip
+            columnStart[s] = columnStop[s] = 0;
+            continue;
+        }
+        double x_start = x;
+        if(s > 0 && !isnan(xValues[s-1])) {
+            x_start = (xValues[s-1] + x) / 2.0;
+        }
+        double x_stop = x;
+        if(s < historyPoints - 1 && !isnan(xValues[s+1])) {
+            x_stop = (xValues[s+1] + x) / 2.0;
+        }
+        x_start = xAxis.transform(x_start, plotAreaLeft, plotAreaLeft + plotAreaWidth);
+        x_stop = xAxis.transform(x_stop, plotAreaLeft, plotAreaLeft + plotAreaWidth);
+        int start = round(x_start);
+        int stop = start + round(x_stop - x_start) + 1;
+        columnStart[s] = qBound(0, start - offset, image.width());
+        columnStop[s] = qBound(0, stop - offset, image.width());
+    }
+
+    imageValid = true;
+    auto rows = std::min(historyRows, imageSlots);
+    for(unsigned int age=0;age<rows;age++) {
+        renderRow(age, 0, historyPoints);
+    }
+    pendingBegin = pendingEnd = 0;
+}
+
+unsigned int TraceWaterfall::slotForAge(unsigned int age)
+{
+    age %= imageSlots;
+    if(imageLayout.dir == Direction::TopToBottom) {
+        return (imageNewest + age) % imageSlots;
+    } else {
+        return (imageNewest + imageSlots - age) % imageSlots;
+    }
+}
+
+void TraceWaterfall::advanceImageSlot()
+{
+    // use the settings the image was rendered with, the current settings may already have changed
+    auto lines = imageLayout.pixelsPerLine;
+    if(imageLayout.dir == Direction::TopToBottom) {
+        imageNewest = (imageNewest + imageSlots - 1) % imageSlots;
+    } else {
+        imageNewest = (imageNewest + 1) % imageSlots;
+    }
+    // the slot still contains the oldest visible sweep which is now scrolled out of the plot
+    for(unsigned int i=0;i<lines;i++) {
+        memset(image.scanLine(imageNewest * lines + i), 0, image.bytesPerLine());
+    }
+}
+
+void TraceWaterfall::renderRow(unsigned int age, unsigned int begin, unsigned int end)
+{
+    end = std::min(end, historyPoints);
+    if(begin >= end) {
+        return;
+    }
+    auto row = historyRow(age);
+    auto lines = imageLayout.pixelsPerLine;
+    auto firstLine = slotForAge(age) * lines;
+    auto line = reinterpret_cast<QRgb*>(image.scanLine(firstLine));
+    int minColumn = image.width();
+    int maxColumn = 0;
+    for(unsigned int s=begin;s<end;s++) {
+        if(columnStart[s] >= columnStop[s]) {
+            continue;
+        }
+        QRgb color = 0;
+        if(!isnan(row[s])) {
+            color = valueToColor(yAxis.transform(row[s], 0.0, 1.0));
+        }
+        std::fill(line + columnStart[s], line + columnStop[s], color);
+        minColumn = std::min(minColumn, columnStart[s]);
+        maxColumn = std::max(maxColumn, columnStop[s]);
+    }
+    if(maxColumn > minColumn) {
+        // all lines of this sweep are identical
+        for(unsigned int i=1;i<lines;i++) {
+            auto dest = reinterpret_cast<QRgb*>(image.scanLine(firstLine + i));
+            memcpy(dest + minColumn, line + minColumn, (maxColumn - minColumn) * sizeof(QRgb));
+        }
+    }
+}
+
+void TraceWaterfall::renderPending()
+{
+    if(imageValid && historyRows > 0 && imageLayout.points == historyPoints) {
+        renderRow(0, pendingBegin, pendingEnd);
+    }
+    pendingBegin = pendingEnd = 0;
+}
+
+QRgb TraceWaterfall::valueToColor(double intensity)
+{
+    static const auto lut = [](){
+        std::array<QRgb, colorLUTsize> lut;
+        for(unsigned int i=0;i<colorLUTsize;i++) {
+            lut[i] = Util::getIntensityGradeColor((double) i / (colorLUTsize - 1)).rgba();
+        }
+        return lut;
+    }();
+    if(intensity >= 0.0 && intensity <= 1.0) {
+        return lut[(unsigned int) (intensity * (colorLUTsize - 1) + 0.5)];
+    } else if(intensity > 1.0) {
+        return QColor(Qt::white).rgba();
+    } else {
+        // below range or NaN
+        return QColor(Qt::black).rgba();
+    }
+}
+
 QString TraceWaterfall::AlignmentToString(Alignment a)
 {
     switch(a) {
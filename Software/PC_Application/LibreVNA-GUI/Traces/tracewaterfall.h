@@ -5,7 +5,9 @@
 
 #include "traceaxis.h"
 
-#include <deque>
+#include <QImage>
+
+#include <vector>
 
 class TraceWaterfall : public TracePlot
 {
@@ -30,6 +32,7 @@ public:
 public slots:
     void axisSetupDialog();
     void resetWaterfall();
+    void setMaxSweeps(unsigned int sweeps);
 
 protected:
     virtual bool configureForTrace(Trace *t) override;
@@ -73,7 +76,48 @@ private:
     XAxis xAxis;
     YAxis yAxis;
 
-    std::deque<std::vector<Trace::Data>> data;
+    // History of the Y axis values (already converted to the Y axis type), one row per sweep. Rows are stored in a
+    // ring buffer with maxDataSweeps entries and a stride of historyStride values
+    float *historyRow(unsigned int age); // age 0 is the newest sweep, nullptr if the rows are empty
+    void addHistoryRow();
+    std::vector<float> history;
+    std::vector<float> rowMin, rowMax;
+    std::vector<double> xValues; // X coordinate of every point, identical for all sweeps
+    unsigned int historyPoints;
+    unsigned int historyStride;
+    unsigned int historyNewest;
+    unsigned int historyRows;
+
+    // The rendered waterfall. Every sweep occupies one slot of pixelsPerLine image lines. The image is used as a
+    // ring buffer as well: a new sweep only moves imageNewest and the image is drawn in two parts
+    class ImageLayout {
+    public:
+        bool operator==(const ImageLayout &o) const;
+        bool operator!=(const ImageLayout &o) const { return !(*this == o); }
+        QSize size;
+        unsigned int pixelsPerLine;
+        Direction dir;
+        double xMin, xMax, yMin, yMax;
+        bool xLog, yLog;
+        unsigned int points;
+    };
+    ImageLayout currentImageLayout(QSize size);
+    void rebuildImage(const ImageLayout &layout);
+    unsigned int slotForAge(unsigned int age);
+    void advanceImageSlot();
+    void renderRow(unsigned int age, unsigned int begin, unsigned int end);
+    void renderPending();
+    QImage image;
+    ImageLayout imageLayout;
+    bool imageValid;
+    unsigned int imageSlots;
+    unsigned int imageNewest;
+    std::vector<int> columnStart, columnStop; // pixel columns covered by each point
+    unsigned int pendingBegin, pendingEnd; // points of the newest sweep that still have to be rendered
+
+    static constexpr unsigned int colorLUTsize = 1024;
+    static QRgb valueToColor(double intensity);
+
     unsigned int pixelsPerLine;
     int plotAreaLeft, plotAreaWidth, plotAreaBottom, plotAreaTop;
     bool keepDataBeyondPlotSize;
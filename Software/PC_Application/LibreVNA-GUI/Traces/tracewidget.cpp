@@ -7,6 +7,7 @@
 #include "trace.h"
 #include "unit.h"
 #include "Util/util.h"
+#include "Util/numberformatter.h"
 #include "appwindow.h"
 
 #include <QKeyEvent>
@@ -191,17 +192,19 @@ void TraceWidget::SetupSCPI()
         return findTraceFromName(params[0]);
     };
 
-    auto createStringFromData = [](Trace *t, const Trace::Data &d) -> QString {
+    auto addData = [](NumberFormatter &f, Trace *t, const Trace::Data &d) {
         if(Trace::isSAParameter(t->liveParameter())) {
             if(std::isnan(d.x)) {
-                return "NaN";
+                f.add("NaN");
+            } else {
+                f.add(Util::SparamTodB(d.y.real()));
             }
-            return QString::number(Util::SparamTodB(d.y.real()));
         } else {
             if(std::isnan(d.x)) {
-                return "NaN,NaN";
+                f.add("NaN,NaN");
+            } else {
+                f.add(d.y.real()).add(',').add(d.y.imag());
             }
-            return QString::number(d.y.real())+","+QString::number(d.y.imag());
         }
     };
 
@@ -218,25 +221,44 @@ void TraceWidget::SetupSCPI()
         if(!t) {
            return SCPI::getResultName(SCPI::Result::Error);
         }
-        QString ret;
-        if(t->size() > 0) {
+        auto scpi = getRoot();
+        if(scpi && scpi->getDataFormat() != SCPI::DataFormat::ASCII) {
+            // binary block, each point consists of the x coordinate followed by either the real and imaginary part or the value in dB (SA traces)
+            bool dB = Trace::isSAParameter(t->liveParameter());
+            std::vector<double> values;
+            values.reserve(t->size() * (dB ? 2 : 3));
             for(unsigned int i=0;i<t->size();i++) {
                 auto d = t->sample(i);
-                int precision = 0;
-                switch(t->outputType()) {
-                case Trace::DataType::Invalid:
-                case Trace::DataType::Frequency: precision = 0; break;
-                case Trace::DataType::Time: precision = 12; break;
-                case Trace::DataType::Power: precision = 3; break;
-                case Trace::DataType::TimeZeroSpan: precision = 4; break;
+                values.push_back(d.x);
+                if(dB) {
+                    values.push_back(Util::SparamTodB(d.y.real()));
+                } else {
+                    values.push_back(d.y.real());
+                    values.push_back(d.y.imag());
                 }
-                ret += "[" + QString::number(d.x, 'f', precision) + ","+createStringFromData(t, d)+"],";
             }
-            ret.chop(1);
-        } else {
-            ret = "EMPTY";
-        }
-        return ret;
+            return scpi->createBlock(values);
+        }
+        if(t->size() == 0) {
+            return "EMPTY";
+        }
+        int precision = 0;
+        switch(t->outputType()) {
+        case Trace::DataType::Invalid:
+        case Trace::DataType::Frequency: precision = 0; break;
+        case Trace::DataType::Time: precision = 12; break;
+        case Trace::DataType::Power: precision = 3; break;
+        case Trace::DataType::TimeZeroSpan: precision = 4; break;
+        }
+        NumberFormatter ret(t->size() * 48);
+        for(unsigned int i=0;i<t->size();i++) {
+            auto d = t->sample(i);
+            ret.add('[').addFixed(d.x, precision).add(',');
+            addData(ret, t, d);
+            ret.add("],");
+        }
+        ret.chop();
+        return ret.toString();
     }));
     add(new SCPICommand("AT", nullptr, [=](QStringList params) -> QString {
         auto t = findTrace(params);
@@ -251,7 +273,9 @@ void TraceWidget::SetupSCPI()
             if(std::isnan(d.x)) {
                 return "NaN,NaN";
             } else {
-                return createStringFromData(t, d);
+                NumberFormatter ret;
+                addData(ret, t, d);
+                return ret.toString();
             }
         }
     }));
@@ -310,6 +334,11 @@ void TraceWidget::SetupSCPI()
         }
         // touchstone assembled, save to dummyfile
         auto s = t.toString(Touchstone::Scale::GHz, Touchstone::Format::RealImaginary);
+        auto scpi = getRoot();
+        if(scpi && scpi->getDataFormat() != SCPI::DataFormat::ASCII) {
+            // the file contains multiple lines, as a block the client knows where it ends
+            return scpi->createBlock(QByteArray::fromStdString(s.str()));
+        }
         return QString::fromStdString(s.str());
     }));
     add(new SCPICommand("MAXFrequency", nullptr, [=](QStringList params) -> QString {
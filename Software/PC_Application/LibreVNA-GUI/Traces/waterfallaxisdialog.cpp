@@ -116,14 +116,19 @@ void WaterfallAxisDialog::on_buttonBox_accepted()
 {
     // set plot values to the ones selected in the dialog
     plot->xAxis.set(plot->xAxis.getType(), ui->Xlog->isChecked(), true, plot->xAxis.getRangeMin(), plot->xAxis.getRangeMax(), 10, false);
+    auto oldYType = plot->yAxis.getType();
     plot->yAxis.set((YAxis::Type) ui->Wtype->currentIndex(), ui->Wlog->isChecked(), ui->Wauto->isChecked(), ui->Wmin->value(), ui->Wmax->value(), 2, false);
+    if(plot->yAxis.getType() != oldYType) {
+        // the history only contains values for the previous Y axis type
+        plot->resetWaterfall();
+    }
     if(ui->Wdir->currentIndex() == 0) {
         plot->dir = TraceWaterfall::Direction::TopToBottom;
     } else {
         plot->dir = TraceWaterfall::Direction::BottomToTop;
     }
     plot->pixelsPerLine = ui->Wpixels->value();
-    plot->maxDataSweeps = ui->WmaxSweeps->value();
+    plot->setMaxSweeps(ui->WmaxSweeps->value());
     if(ui->Wmode->currentIndex() == 0) {
         plot->keepDataBeyondPlotSize = false;
     } else {
@@ -0,0 +1,51 @@
+#include "backgroundfilter.h"
+
+using namespace std;
+
+BackgroundFilter::BackgroundFilter(QObject *context)
+    : context(context),
+      generation(0),
+      running(false)
+{
+
+}
+
+BackgroundFilter::~BackgroundFilter()
+{
+    cancel();
+}
+
+void BackgroundFilter::start(unsigned int rows, std::function<bool (unsigned int)> matches, std::function<void (std::vector<unsigned int>)> result)
+{
+    cancel();
+    running = true;
+    auto current = ++generation;
+    thread = std::thread([=](){
+        vector<unsigned int> matching;
+        for(unsigned int i=0;i<rows;i++) {
+            if(i % 4096 == 0 && generation != current) {
+                // cancelled
+                return;
+            }
+            if(matches(i)) {
+                matching.push_back(i);
+            }
+        }
+        // pending calls are discarded if the context object is deleted
+        QMetaObject::invokeMethod(context, [=](){
+            if(generation == current) {
+                running = false;
+                result(matching);
+            }
+        }, Qt::QueuedConnection);
+    });
+}
+
+void BackgroundFilter::cancel()
+{
+    generation++;
+    running = false;
+    if(thread.joinable()) {
+        thread.join();
+    }
+}
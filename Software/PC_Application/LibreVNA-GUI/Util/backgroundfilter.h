@@ -0,0 +1,36 @@
+#ifndef BACKGROUNDFILTER_H
+#define BACKGROUNDFILTER_H
+
+#include <QObject>
+
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+/*
+ * Filters the rows of a (large) log in a worker thread to keep the GUI responsive.
+ *
+ * The filter function is called for every row in the worker thread, so it must only access data that has been copied
+ * for the worker (e.g. captured by value). The indices of the matching rows are passed to the result function in the
+ * thread of the context object. Starting a new filter cancels the one that is still running, its result is discarded.
+ */
+class BackgroundFilter
+{
+public:
+    BackgroundFilter(QObject *context);
+    ~BackgroundFilter();
+
+    void start(unsigned int rows, std::function<bool(unsigned int row)> matches, std::function<void(std::vector<unsigned int> matching)> result);
+    void cancel();
+    bool isRunning() const {return running;}
+
+private:
+    QObject *context;
+    std::thread thread;
+    // incremented whenever a filter is started or cancelled, a worker stops once it is no longer the current one
+    std::atomic<unsigned int> generation;
+    bool running;
+};
+
+#endif // BACKGROUNDFILTER_H
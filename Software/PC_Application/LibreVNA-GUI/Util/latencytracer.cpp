@@ -0,0 +1,153 @@
+#include "latencytracer.h"
+
+#include <QThread>
+#include <QCoreApplication>
+#include <QFile>
+
+#include <chrono>
+#include <algorithm>
+
+using namespace std;
+
+std::atomic<bool> LatencyTracer::active(false);
+std::atomic<long long> LatencyTracer::startTime(0);
+std::vector<std::shared_ptr<LatencyTracer::ThreadBuffer>> LatencyTracer::buffers;
+std::mutex LatencyTracer::buffersMutex;
+unsigned int LatencyTracer::nextThreadID = 1;
+thread_local std::shared_ptr<LatencyTracer::ThreadBuffer> LatencyTracer::ownBuffer;
+thread_local QString LatencyTracer::ownName;
+
+LatencyTracer::ThreadBuffer::ThreadBuffer(unsigned int id, QString name)
+    : events(bufferSize),
+      written(0),
+      begun(0),
+      id(id),
+      name(name)
+{
+
+}
+
+void LatencyTracer::start()
+{
+    lock_guard<mutex> lock(buffersMutex);
+    // only the thread itself still references the buffers of running threads
+    buffers.erase(remove_if(buffers.begin(), buffers.end(), [](const shared_ptr<ThreadBuffer> &b) {
+        return b.use_count() == 1;
+    }), buffers.end());
+    startTime = now();
+    active = true;
+}
+
+void LatencyTracer::stop()
+{
+    active = false;
+}
+
+void LatencyTracer::setThreadName(QString name)
+{
+    ownName = name;
+    if(ownBuffer) {
+        lock_guard<mutex> lock(buffersMutex);
+        ownBuffer->name = name;
+    }
+}
+
+nlohmann::json LatencyTracer::toJSON()
+{
+    constexpr int pid = 1;
+    auto events = nlohmann::json::array();
+    events.push_back({{"name", "process_name"}, {"ph", "M"}, {"pid", pid}, {"args", {{"name", "LibreVNA-GUI"}}}});
+
+    lock_guard<mutex> lock(buffersMutex);
+    auto start = startTime.load();
+    for(auto &b : buffers) {
+        events.push_back({{"name", "thread_name"}, {"ph", "M"}, {"pid", pid}, {"tid", b->id}, {"args", {{"name", b->name.toStdString()}}}});
+
+        // the thread keeps on writing while the events are copied
+        auto end = b->written.load(memory_order_acquire);
+        auto first = end > bufferSize ? end - bufferSize : 0;
+        vector<Event> copy;
+        copy.reserve(end - first);
+        for(auto n=first;n<end;n++) {
+            copy.push_back(b->events[n % bufferSize]);
+        }
+        // Events that were started while copying overwrote the slots one buffer length before them. If any of
+        // their data has been copied, the fence makes the started count visible
+        atomic_thread_fence(memory_order_acquire);
+        auto begun = b->begun.load(memory_order_relaxed);
+        auto valid = begun > bufferSize ? begun - bufferSize : 0;
+        for(auto n=max(first, valid);n<end;n++) {
+            auto &e = copy[n - first];
+            if(e.begin < start) {
+                continue;
+            }
+            nlohmann::json j;
+            j["name"] = e.name;
+            j["cat"] = e.category;
+            j["ph"] = "X";
+            j["pid"] = pid;
+            j["tid"] = b->id;
+            j["ts"] = (e.begin - start) / 1000.0;
+            j["dur"] = e.duration / 1000.0;
+            if(e.value >= 0) {
+                j["args"] = {{"value", e.value}};
+            }
+            events.push_back(j);
+        }
+    }
+    nlohmann::json j;
+    j["traceEvents"] = events;
+    j["displayTimeUnit"] = "ns";
+    return j;
+}
+
+bool LatencyTracer::save(QString filename)
+{
+    QFile file(filename);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    auto data = toJSON().dump();
+    return file.write(data.c_str(), data.size()) == (qint64) data.size();
+}
+
+long long LatencyTracer::now()
+{
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void LatencyTracer::record(const char *name, const char *category, long long begin, long long duration, long long value)
+{
+    auto &b = threadBuffer();
+    // only this thread writes into the buffer
+    auto n = b.written.load(memory_order_relaxed);
+    // announce the write first, toJSON() drops the event that is overwritten while copying
+    b.begun.store(n + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    b.events[n % bufferSize] = Event{name, category, begin, duration, value};
+    b.written.store(n + 1, memory_order_release);
+}
+
+LatencyTracer::ThreadBuffer &LatencyTracer::threadBuffer()
+{
+    if(!ownBuffer) {
+        QString name = ownName;
+        if(name.isEmpty()) {
+            auto thread = QThread::currentThread();
+            auto app = QCoreApplication::instance();
+            if(!thread->objectName().isEmpty()) {
+                name = thread->objectName();
+            } else if(app && thread == app->thread()) {
+                name = "Main";
+            }
+        }
+        lock_guard<mutex> lock(buffersMutex);
+        auto id = nextThreadID++;
+        if(name.isEmpty()) {
+            name = "Thread "+QString::number(id);
+        }
+        ownBuffer = make_shared<ThreadBuffer>(id, name);
+        buffers.push_back(ownBuffer);
+    }
+    return *ownBuffer;
+}
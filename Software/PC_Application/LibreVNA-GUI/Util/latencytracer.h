@@ -0,0 +1,119 @@
+#ifndef LATENCYTRACER_H
+#define LATENCYTRACER_H
+
+#include "json.hpp"
+
+#include <QString>
+
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <mutex>
+
+/*
+ * Records the time spent in the stages of the measurement pipeline (from the arrival of the USB data to the plots).
+ *
+ * The stages are marked with LATENCY_SPAN(name, category[, value]) which measures the time until the end of the
+ * enclosing scope. Every thread records into its own ring buffer without locking, only the newest bufferSize spans of
+ * each thread are kept. Recording has to be started explicitly, an inactive tracer costs one atomic load per span.
+ *
+ * The spans can be exported in the Chrome trace event format (open with chrome://tracing or https://ui.perfetto.dev).
+ *
+ * All instrumentation is removed at compile time unless LIBREVNA_LATENCY_TRACING is defined.
+ */
+class LatencyTracer
+{
+public:
+    // true if the instrumentation has been compiled in
+    static constexpr bool isAvailable() {
+#ifdef LIBREVNA_LATENCY_TRACING
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // Starts recording, spans recorded before are discarded
+    static void start();
+    static void stop();
+    static bool isActive() { return active.load(std::memory_order_relaxed); }
+
+    // Names the calling thread in the exported trace (default: the QThread object name or a number). Cheap, the buffer
+    // of the thread is only allocated once it records a span
+    static void setThreadName(QString name);
+
+    // Returns all spans recorded since the last start() in the Chrome trace event format
+    static nlohmann::json toJSON();
+    static bool save(QString filename);
+
+    static constexpr unsigned int bufferSize = 65536;
+
+    class Span {
+    public:
+        Span(const char *name, const char *category, long long value = -1)
+            : name(name), category(category), value(value), begin(isActive() ? now() : -1) {}
+        ~Span() {
+            if(begin >= 0) {
+                record(name, category, begin, now() - begin, value);
+            }
+        }
+        Span(const Span&) = delete;
+        Span &operator=(const Span&) = delete;
+    private:
+        const char *name;
+        const char *category;
+        long long value;
+        long long begin;
+    };
+
+private:
+    class Event {
+    public:
+        // names and categories must be string literals, only the pointers are stored
+        const char *name;
+        const char *category;
+        long long begin;
+        long long duration;
+        long long value;
+    };
+    class ThreadBuffer {
+    public:
+        ThreadBuffer(unsigned int id, QString name);
+        std::vector<Event> events;
+        // number of events written so far, the event n is stored at n % bufferSize
+        std::atomic<unsigned long long> written;
+        // number of events whose write has started (written + 1 while an event is being written)
+        std::atomic<unsigned long long> begun;
+        unsigned int id;
+        QString name;
+    };
+
+    // nanoseconds on a monotonic clock
+    static long long now();
+    static void record(const char *name, const char *category, long long begin, long long duration, long long value);
+    static ThreadBuffer &threadBuffer();
+
+    static std::atomic<bool> active;
+    // spans that began before this time have been discarded
+    static std::atomic<long long> startTime;
+    // buffers of all threads that recorded spans, buffers of finished threads are removed on the next start()
+    static std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    static std::mutex buffersMutex;
+    static unsigned int nextThreadID;
+    // buffer of the calling thread, only allocated when the thread records its first span. Naming a thread that
+    // never records anything costs no more than the name
+    static thread_local std::shared_ptr<ThreadBuffer> ownBuffer;
+    static thread_local QString ownName;
+};
+
+#ifdef LIBREVNA_LATENCY_TRACING
+#define LATENCY_CONCAT_IMPL(a, b) a##b
+#define LATENCY_CONCAT(a, b) LATENCY_CONCAT_IMPL(a, b)
+#define LATENCY_SPAN(...) LatencyTracer::Span LATENCY_CONCAT(latencySpan, __LINE__)(__VA_ARGS__)
+#define LATENCY_THREAD_NAME(name) LatencyTracer::setThreadName(name)
+#else
+#define LATENCY_SPAN(...)
+#define LATENCY_THREAD_NAME(name)
+#endif
+
+#endif // LATENCYTRACER_H
@@ -0,0 +1,223 @@
+#include "metrics.h"
+
+#include <QDebug>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+QString Metrics::Metric::toText() const
+{
+    QString text;
+    text += "# HELP " + name + " " + help + "\n";
+    text += "# TYPE " + name + " " + getType() + "\n";
+    text += samplesToText();
+    return text;
+}
+
+QString Metrics::Metric::format(double value)
+{
+    if(std::isinf(value)) {
+        return value > 0 ? "+Inf" : "-Inf";
+    } else if(std::isnan(value)) {
+        return "NaN";
+    }
+    return QString::number(value, 'g', 10);
+}
+
+QString Metrics::Counter::toString() const
+{
+    return QString::number(get());
+}
+
+QString Metrics::Counter::samplesToText() const
+{
+    return getName() + " " + toString() + "\n";
+}
+
+QString Metrics::Gauge::toString() const
+{
+    return format(get());
+}
+
+QString Metrics::Gauge::samplesToText() const
+{
+    return getName() + " " + toString() + "\n";
+}
+
+Metrics::Histogram::Histogram(QString name, QString help, std::vector<double> bounds)
+    : Metric(name, help),
+      bounds(bounds)
+{
+    std::sort(this->bounds.begin(), this->bounds.end());
+    reset();
+}
+
+void Metrics::Histogram::observe(double v)
+{
+    // a value equal to a bound belongs to the bucket of that bound (the bounds are inclusive)
+    auto bucket = lower_bound(bounds.begin(), bounds.end(), v) - bounds.begin();
+    lock_guard<mutex> lock(mtx);
+    buckets[bucket]++;
+    if(count == 0 || v < min) {
+        min = v;
+    }
+    if(count == 0 || v > max) {
+        max = v;
+    }
+    count++;
+    sum += v;
+    last = v;
+}
+
+void Metrics::Histogram::reset()
+{
+    lock_guard<mutex> lock(mtx);
+    buckets = vector<unsigned long long>(bounds.size() + 1, 0);
+    count = 0;
+    sum = min = max = last = 0.0;
+}
+
+QString Metrics::Histogram::toString() const
+{
+    lock_guard<mutex> lock(mtx);
+    return QString::number(count)+","+format(count ? sum / count : 0.0)+","+format(min)+","+format(max)+","
+            +format(quantile(0.5))+","+format(quantile(0.99))+","+format(last);
+}
+
+unsigned long long Metrics::Histogram::getCount() const
+{
+    lock_guard<mutex> lock(mtx);
+    return count;
+}
+
+double Metrics::Histogram::getMean() const
+{
+    lock_guard<mutex> lock(mtx);
+    return count ? sum / count : 0.0;
+}
+
+double Metrics::Histogram::getLast() const
+{
+    lock_guard<mutex> lock(mtx);
+    return last;
+}
+
+double Metrics::Histogram::getQuantile(double q) const
+{
+    lock_guard<mutex> lock(mtx);
+    return quantile(q);
+}
+
+std::vector<double> Metrics::Histogram::exponentialBounds(double start, double factor, unsigned int count)
+{
+    vector<double> ret;
+    for(unsigned int i=0;i<count;i++) {
+        ret.push_back(start);
+        start *= factor;
+    }
+    return ret;
+}
+
+QString Metrics::Histogram::samplesToText() const
+{
+    lock_guard<mutex> lock(mtx);
+    QString text;
+    unsigned long long cumulative = 0;
+    for(unsigned int i=0;i<buckets.size();i++) {
+        cumulative += buckets[i];
+        auto le = i < bounds.size() ? format(bounds[i]) : "+Inf";
+        text += getName() + "_bucket{le=\"" + le + "\"} " + QString::number(cumulative) + "\n";
+    }
+    text += getName() + "_sum " + format(sum) + "\n";
+    text += getName() + "_count " + QString::number(count) + "\n";
+    return text;
+}
+
+double Metrics::Histogram::quantile(double q) const
+{
+    if(count == 0) {
+        return 0.0;
+    }
+    double rank = q * count;
+    unsigned long long cumulative = 0;
+    for(unsigned int i=0;i<buckets.size();i++) {
+        if(buckets[i] > 0 && cumulative + buckets[i] >= rank) {
+            // the observed extremes limit the outermost buckets
+            double lower = i > 0 ? std::max(bounds[i-1], min) : min;
+            double upper = i < bounds.size() ? std::min(bounds[i], max) : max;
+            return lower + (upper - lower) * (rank - cumulative) / buckets[i];
+        }
+        cumulative += buckets[i];
+    }
+    return max;
+}
+
+template<class T, typename... Args>
+T &Metrics::get(QString name, Args... args)
+{
+    lock_guard<mutex> lock(mtx);
+    auto it = metrics.find(name);
+    if(it == metrics.end()) {
+        it = metrics.emplace(name, make_unique<T>(name, args...)).first;
+    }
+    auto metric = dynamic_cast<T*>(it->second.get());
+    if(!metric) {
+        qFatal("Metric %s registered with different types", qPrintable(name));
+    }
+    return *metric;
+}
+
+Metrics::Counter &Metrics::counter(QString name, QString help)
+{
+    return get<Counter>(name, help);
+}
+
+Metrics::Gauge &Metrics::gauge(QString name, QString help)
+{
+    return get<Gauge>(name, help);
+}
+
+Metrics::Histogram &Metrics::histogram(QString name, QString help, std::vector<double> bounds)
+{
+    return get<Histogram>(name, help, bounds);
+}
+
+Metrics::Metric *Metrics::find(QString name)
+{
+    lock_guard<mutex> lock(mtx);
+    auto it = metrics.find(name);
+    if(it == metrics.end()) {
+        return nullptr;
+    }
+    return it->second.get();
+}
+
+QStringList Metrics::getNames()
+{
+    lock_guard<mutex> lock(mtx);
+    QStringList names;
+    for(auto &m : metrics) {
+        names.append(m.first);
+    }
+    return names;
+}
+
+void Metrics::reset()
+{
+    lock_guard<mutex> lock(mtx);
+    for(auto &m : metrics) {
+        m.second->reset();
+    }
+}
+
+QString Metrics::toText()
+{
+    lock_guard<mutex> lock(mtx);
+    QString text;
+    for(auto &m : metrics) {
+        text += m.second->toText();
+    }
+    return text;
+}
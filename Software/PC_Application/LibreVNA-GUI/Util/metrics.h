@@ -0,0 +1,139 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QString>
+#include <QStringList>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <vector>
+
+/*
+ * Registry of counters, gauges and histograms describing the health of the acquisition (sweep times, missed points,
+ * queue depths, ...).
+ *
+ * Metrics are created on first use and live until the application exits, so the returned references can be kept
+ * in a static variable at the place where the metric is updated:
+ *
+ *   static auto &dropped = Metrics::getInstance().counter("librevna_example_dropped_total", "Dropped examples");
+ *   dropped.increment();
+ *
+ * Updating counters and gauges is lock-free and can be done from any thread. Names and the text export follow the
+ * Prometheus text exposition format.
+ */
+class Metrics
+{
+public:
+    static Metrics& getInstance() {
+        static Metrics instance;
+        return instance;
+    }
+    Metrics(const Metrics&) = delete;
+
+    class Metric {
+    public:
+        Metric(QString name, QString help) : name(name), help(help) {}
+        virtual ~Metric() {}
+
+        QString getName() const {return name;}
+        QString getHelp() const {return help;}
+        virtual QString getType() const = 0;
+        virtual void reset() = 0;
+        // Short representation of the current value, as returned by the SCPI query
+        virtual QString toString() const = 0;
+        // All lines of this metric in the text exposition format (including HELP and TYPE)
+        QString toText() const;
+    protected:
+        virtual QString samplesToText() const = 0;
+        static QString format(double value);
+    private:
+        QString name;
+        QString help;
+    };
+
+    // Monotonically increasing count of events
+    class Counter : public Metric {
+    public:
+        using Metric::Metric;
+        void increment(unsigned long long n = 1) {
+            value.fetch_add(n, std::memory_order_relaxed);
+        }
+        unsigned long long get() const {return value.load(std::memory_order_relaxed);}
+        QString getType() const override {return "counter";}
+        void reset() override {value = 0;}
+        QString toString() const override;
+    protected:
+        QString samplesToText() const override;
+    private:
+        std::atomic<unsigned long long> value{0};
+    };
+
+    // Current value of a quantity that can go up and down
+    class Gauge : public Metric {
+    public:
+        using Metric::Metric;
+        void set(double v) {value.store(v, std::memory_order_relaxed);}
+        double get() const {return value.load(std::memory_order_relaxed);}
+        QString getType() const override {return "gauge";}
+        void reset() override {value = 0.0;}
+        QString toString() const override;
+    protected:
+        QString samplesToText() const override;
+    private:
+        std::atomic<double> value{0.0};
+    };
+
+    // Distribution of observed values, counted in buckets with the given (ascending) upper bounds
+    class Histogram : public Metric {
+    public:
+        Histogram(QString name, QString help, std::vector<double> bounds);
+        void observe(double v);
+        QString getType() const override {return "histogram";}
+        void reset() override;
+        // count,mean,min,max,median,99th percentile,last observed value
+        QString toString() const override;
+
+        unsigned long long getCount() const;
+        double getMean() const;
+        double getLast() const;
+        // Estimated from the buckets (linear interpolation within the bucket)
+        double getQuantile(double q) const;
+
+        // count bounds, starting at start and multiplied by factor for every further bound
+        static std::vector<double> exponentialBounds(double start, double factor, unsigned int count);
+    protected:
+        QString samplesToText() const override;
+    private:
+        double quantile(double q) const;
+        std::vector<double> bounds;
+        mutable std::mutex mtx;
+        // one more bucket than bounds for values above the last bound
+        std::vector<unsigned long long> buckets;
+        unsigned long long count;
+        double sum, min, max, last;
+    };
+
+    // Returns the metric with this name, creating it if it does not exist yet
+    Counter &counter(QString name, QString help);
+    Gauge &gauge(QString name, QString help);
+    Histogram &histogram(QString name, QString help, std::vector<double> bounds);
+
+    // Returns nullptr if no metric with this name exists
+    Metric *find(QString name);
+    QStringList getNames();
+    // Resets all metrics to their initial values
+    void reset();
+    // All metrics in the text exposition format
+    QString toText();
+
+private:
+    Metrics() {}
+    template<class T, typename... Args> T &get(QString name, Args... args);
+
+    std::mutex mtx;
+    std::map<QString, std::unique_ptr<Metric>> metrics;
+};
+
+#endif // METRICS_H
@@ -0,0 +1,107 @@
+#include "numberformatter.h"
+
+#include <cmath>
+#include <cstdio>
+#include <charconv>
+#include <algorithm>
+
+NumberFormatter::NumberFormatter(size_t reserve)
+{
+    buffer.reserve(reserve);
+}
+
+NumberFormatter &NumberFormatter::add(double value, int precision)
+{
+    format(value, Format::General, precision);
+    return *this;
+}
+
+NumberFormatter &NumberFormatter::addFixed(double value, int decimals)
+{
+    format(value, Format::Fixed, decimals);
+    return *this;
+}
+
+NumberFormatter &NumberFormatter::addShortest(double value)
+{
+    format(value, Format::Shortest, 0);
+    return *this;
+}
+
+NumberFormatter &NumberFormatter::add(char c)
+{
+    buffer.push_back(c);
+    return *this;
+}
+
+NumberFormatter &NumberFormatter::add(const char *s)
+{
+    buffer.append(s);
+    return *this;
+}
+
+NumberFormatter &NumberFormatter::add(const QString &s)
+{
+    buffer.append(s.toStdString());
+    return *this;
+}
+
+void NumberFormatter::chop(size_t n)
+{
+    buffer.resize(n < buffer.size() ? buffer.size() - n : 0);
+}
+
+void NumberFormatter::clear()
+{
+    buffer.clear();
+}
+
+QString NumberFormatter::toString() const
+{
+    return QString::fromLatin1(buffer.data(), buffer.size());
+}
+
+void NumberFormatter::format(double value, Format f, int precision)
+{
+    if(std::isnan(value)) {
+        // the sign of NaN is not shown by QString::number
+        buffer.append("nan");
+        return;
+    }
+    // enough for every value except large numbers in fixed format, the space is increased if necessary
+    size_t space = 32;
+    while(true) {
+        auto pos = buffer.size();
+        buffer.resize(pos + space);
+        auto begin = &buffer[pos];
+        auto end = begin + space;
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+        std::to_chars_result res;
+        switch(f) {
+        case Format::General: res = std::to_chars(begin, end, value, std::chars_format::general, precision); break;
+        case Format::Fixed: res = std::to_chars(begin, end, value, std::chars_format::fixed, precision); break;
+        case Format::Shortest: res = std::to_chars(begin, end, value); break;
+        }
+        if(res.ec == std::errc()) {
+            buffer.resize(res.ptr - buffer.data());
+            return;
+        }
+#else
+        // the standard library does not support std::to_chars for floating point values, fall back to snprintf
+        int len = 0;
+        switch(f) {
+        case Format::General: len = snprintf(begin, space, "%.*g", precision, value); break;
+        case Format::Fixed: len = snprintf(begin, space, "%.*f", precision, value); break;
+        case Format::Shortest: len = snprintf(begin, space, "%.17g", value); break;
+        }
+        if(len >= 0 && (size_t) len < space) {
+            buffer.resize(pos + len);
+            // snprintf uses the decimal point of the current locale
+            std::replace(buffer.begin() + pos, buffer.end(), ',', '.');
+            return;
+        }
+#endif
+        buffer.resize(pos);
+        space *= 4;
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef NUMBERFORMATTER_H
+#define NUMBERFORMATTER_H
+
+#include <QString>
+#include <string>
+
+/*
+ * Creates text containing lots of numbers (e.g. ASCII SCPI responses with trace data or CSV files).
+ *
+ * All numbers are formatted (with std::to_chars, if available) directly into a single buffer. This is considerably
+ * faster than concatenating the temporary strings created by QString::number(). The output of add() and addFixed()
+ * is identical to the corresponding QString::number() calls.
+ */
+class NumberFormatter
+{
+public:
+    NumberFormatter(size_t reserve = 0);
+
+    // general format with the given number of significant digits, same as QString::number(value, 'g', precision)
+    NumberFormatter &add(double value, int precision = 6);
+    // fixed format with the given number of decimals, same as QString::number(value, 'f', decimals)
+    NumberFormatter &addFixed(double value, int decimals);
+    // shortest representation that converts back to the identical value
+    NumberFormatter &addShortest(double value);
+    NumberFormatter &add(char c);
+    NumberFormatter &add(const char *s);
+    NumberFormatter &add(const QString &s);
+
+    // removes the last n characters (e.g. a trailing separator)
+    void chop(size_t n = 1);
+    void clear();
+    size_t size() const { return buffer.size(); }
+    bool isEmpty() const { return buffer.empty(); }
+
+    QString toString() const;
+    const std::string &data() const { return buffer; }
+
+private:
+    enum class Format {
+        General,
+        Fixed,
+        Shortest,
+    };
+    void format(double value, Format f, int precision);
+
+    std::string buffer;
+};
+
+#endif // NUMBERFORMATTER_H
@@ -26,7 +26,22 @@ PRBS::PRBS(unsigned int bits)
         throw std::runtime_error("Bit size not supported");
     }
     polynom = polynoms[bits];
-    shiftReg = 0xFFFFFFFF;
+    // only the lowest bits of the shift register take part in the feedback
+    stateMask = (1UL << bits) - 1;
+    shiftReg = stateMask;
+
+    // precompute eight steps for every possible register state
+    byteSteps.resize(stateMask + 1);
+    for(unsigned int state=0;state<=stateMask;state++) {
+        shiftReg = state;
+        unsigned char output = 0;
+        for(unsigned int i=0;i<8;i++) {
+            output = (output << 1) | (next() ? 0x01 : 0x00);
+        }
+        byteSteps[state].output = output;
+        byteSteps[state].state = shiftReg;
+    }
+    shiftReg = stateMask;
 }
 
 bool PRBS::next()
@@ -39,6 +54,25 @@ bool PRBS::next()
         }
         mask <<= 1;
     }
-    shiftReg = (shiftReg << 1) | (newbit ? 0x01 : 0x00);
+    shiftReg = ((shiftReg << 1) | (newbit ? 0x01 : 0x00)) & stateMask;
     return newbit;
 }
+
+unsigned int PRBS::next(unsigned int n)
+{
+    if(n > 32) {
+        throw std::runtime_error("Too many bits requested");
+    }
+    unsigned int ret = 0;
+    while(n >= 8) {
+        auto &step = byteSteps[shiftReg];
+        ret = (ret << 8) | step.output;
+        shiftReg = step.state;
+        n -= 8;
+    }
+    while(n > 0) {
+        ret = (ret << 1) | (next() ? 0x01 : 0x00);
+        n--;
+    }
+    return ret;
+}
@@ -1,6 +1,7 @@
 #ifndef PRBS_H
 #define PRBS_H
 
+#include <vector>
 
 class PRBS
 {
@@ -8,11 +9,23 @@ public:
     PRBS(unsigned int bits);
 
     bool next();
+    // returns the next n bits (n <= 32), the first generated bit ends up in the MSB
+    unsigned int next(unsigned int n);
 
 private:
     unsigned int bits;
     unsigned int shiftReg;
     unsigned int polynom;
+    unsigned int stateMask;
+
+    // Advancing the shift register by a whole byte only depends on the (masked) register state.
+    // The table is indexed by the state and holds the 8 output bits and the resulting state
+    class ByteStep {
+    public:
+        unsigned char output;
+        unsigned short state;
+    };
+    std::vector<ByteStep> byteSteps;
 };
 
 #endif // PRBS_H
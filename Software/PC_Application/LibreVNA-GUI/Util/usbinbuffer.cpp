@@ -1,5 +1,7 @@
 #include "usbinbuffer.h"
 
+#include "latencytracer.h"
+
 #include <mutex>
 
 #include <QDebug>
@@ -67,6 +69,7 @@ void USBInBuffer::Callback(libusb_transfer *transfer)
     case LIBUSB_TRANSFER_COMPLETED:
     case LIBUSB_TRANSFER_TIMED_OUT:
         if(transfer->actual_length > 0) {
+            LATENCY_SPAN("USBInBuffer::Callback", "USB", transfer->actual_length);
             received_size += transfer->actual_length;
             inCallback = true;
             emit DataReceived();
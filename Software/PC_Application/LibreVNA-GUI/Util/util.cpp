@@ -1,7 +1,9 @@
 #include "util.h"
 
 #include <random>
+#include <charconv>
 #include <QVector2D>
+#include <QByteArray>
 
 void Util::unwrapPhase(std::vector<double> &phase, unsigned int start_index)
 {
@@ -225,3 +227,34 @@ bool Util::firmwareEqualOrHigher(QString firmware, QString compare)
         return true;
     }
 }
+
+bool Util::parseDouble(const char *&pos, const char *end, double &value)
+{
+    while(pos < end && isWhitespace(*pos)) {
+        pos++;
+    }
+    if(pos < end && *pos == '+') {
+        // not accepted by std::from_chars
+        pos++;
+    }
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    auto res = std::from_chars(pos, end, value);
+    if(res.ec != std::errc()) {
+        return false;
+    }
+    pos = res.ptr;
+#else
+    // the standard library does not support std::from_chars for floating point values, use the (locale independent) Qt conversion
+    auto tokenEnd = pos;
+    while(tokenEnd < end && ((*tokenEnd >= '0' && *tokenEnd <= '9') || *tokenEnd == '.' || *tokenEnd == 'e' || *tokenEnd == 'E' || *tokenEnd == '-' || *tokenEnd == '+')) {
+        tokenEnd++;
+    }
+    bool ok;
+    value = QByteArray::fromRawData(pos, tokenEnd - pos).toDouble(&ok);
+    if(!ok) {
+        return false;
+    }
+    pos = tokenEnd;
+#endif
+    return true;
+}
@@ -168,6 +168,13 @@ namespace Util {
     QColor getIntensityGradeColor(double intensity);
 
     bool firmwareEqualOrHigher(QString firmware, QString compare);
+
+    static inline bool isWhitespace(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+    // Parses a floating point number from a character buffer (locale independent, leading whitespace and a leading
+    // plus sign are skipped). On success, pos points behind the number
+    bool parseDouble(const char *&pos, const char *end, double &value);
 }
 
 #endif // UTILH_H
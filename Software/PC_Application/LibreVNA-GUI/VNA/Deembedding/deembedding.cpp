@@ -4,6 +4,7 @@
 #include "ui_measurementdialog.h"
 #include "Traces/sparamtraceselector.h"
 #include "appwindow.h"
+#include "Util/latencytracer.h"
 
 #include <QDebug>
 
@@ -135,6 +136,7 @@ Deembedding::Deembedding(TraceModel &tm)
 
 void Deembedding::Deembed(DeviceDriver::VNAMeasurement &d)
 {
+    LATENCY_SPAN("Deembedding::Deembed", "Processing", d.pointNum);
     for(auto it = options.begin();it != options.end();it++) {
         if (measuring && measuringOption == *it) {
             // this option needs a measurement
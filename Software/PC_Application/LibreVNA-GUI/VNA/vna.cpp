@@ -20,6 +20,9 @@
 #include "Calibration/manualcalibrationdialog.h"
 #include "Calibration/LibreCAL/librecaldialog.h"
 #include "Util/util.h"
+#include "Util/numberformatter.h"
+#include "Util/latencytracer.h"
+#include "Util/metrics.h"
 #include "Tools/parameters.h"
 
 #include <QGridLayout>
@@ -57,6 +60,7 @@ VNA::VNA(AppWindow *window, QString name)
     : Mode(window, name, "VNA"),
       deembedding(traceModel),
       deembedding_active(false),
+      pipeline(window, cal, deembedding),
       tiles(new TileWidget(traceModel)),
     central(new QScrollArea)
 {
@@ -69,6 +73,9 @@ VNA::VNA(AppWindow *window, QString name)
     calDialog = nullptr;
 
     changingSettings = false;
+    sweepPoints = 0;
+    sweepPointsReceived = 0;
+    lastPointNum = -1;
     settings.sweepType = SweepType::Frequency;
     settings.zerospan = false;
 
@@ -78,6 +85,11 @@ VNA::VNA(AppWindow *window, QString name)
     connect(&configurationTimer, &QTimer::timeout, this, [=](){
         ConfigureDevice(configurationTimerResetTraces);
     });
+    sweepDataQueryTimer.setSingleShot(true);
+    connect(&sweepDataQueryTimer, &QTimer::timeout, this, [=](){
+        qWarning() << "No VNA data received for" << sweepDataQueryTimeout << "ms, aborting pending sweep data queries";
+        FailSweepDataQueries();
+    });
 
     // Create default traces
     createDefaultTracesAndGraphs(2);
@@ -492,6 +504,16 @@ VNA::VNA(AppWindow *window, QString name)
     // Calibration connections
     connect(&cal, &Calibration::activated, this, &VNA::UpdateStatusbar);
     connect(&cal, &Calibration::deactivated, this, &VNA::UpdateStatusbar);
+    connect(&cal, &Calibration::activated, this, [=](Calibration::CalType applied){
+        if(getRoot()) {
+            getRoot()->notify("CALIBRATION", applied.getShortString());
+        }
+    });
+    connect(&cal, &Calibration::deactivated, this, [=](){
+        if(getRoot()) {
+            getRoot()->notify("CALIBRATION", "NONE");
+        }
+    });
     connect(cbEnableCal, &QCheckBox::stateChanged, calToolbarLambda);
     connect(cbType, qOverload<int>(&QComboBox::currentIndexChanged), calToolbarLambda);
     connect(&cal, &Calibration::deactivated, [=](){
@@ -716,6 +738,8 @@ QString VNA::getCalToolTip()
 
 void VNA::deactivate()
 {
+    pipeline.flush();
+    FailSweepDataQueries();
     setOperationPending(false);
     StoreSweepSettings();
     Mode::deactivate();
@@ -782,12 +806,20 @@ void VNA::initializeDevice()
 
 void VNA::deviceDisconnected()
 {
+    pipeline.flush();
+    FailSweepDataQueries();
     defaultCalMenu->setEnabled(false);
     emit sweepStopped();
 }
 
+void VNA::flushStreamingData()
+{
+    pipeline.flush();
+}
+
 void VNA::shutdown()
 {
+    pipeline.flush();
     if(cal.hasUnsavedChanges() && cal.getCaltype().type != Calibration::Type::None) {
         auto save = InformationBox::AskQuestion("Save calibration?", "The calibration contains data that has not been saved yet. Do you want to save it before exiting?", false);
         if(save) {
@@ -848,6 +880,7 @@ void VNA::fromJSON(nlohmann::json j)
     if(j.is_null()) {
         return;
     }
+    pipeline.flush();
     if(j.contains("traces")) {
         traceModel.fromJSON(j["traces"]);
     }
@@ -897,24 +930,58 @@ using namespace std;
 
 void VNA::NewDatapoint(DeviceDriver::VNAMeasurement m)
 {
+    LATENCY_SPAN("VNA::NewDatapoint", "VNA", m.pointNum);
     if(isActive != true) {
         // ignore
         return;
     }
 
+    if(!sweepDataQueries.empty()) {
+        // the device is still sending data
+        sweepDataQueryTimer.start(sweepDataQueryTimeout);
+    }
+
     if(changingSettings) {
         // already setting new sweep settings, ignore incoming points from old settings
         return;
     }
 
-    // Calculate sweep time
-    if(m.pointNum == 0) {
-        // new sweep started
-        static auto lastStart = QDateTime::currentDateTimeUtc();
-        auto now = QDateTime::currentDateTimeUtc();
-        auto sweepTime = lastStart.msecsTo(now);
-        lastStart = now;
-        qDebug() << "Sweep took"<<sweepTime<<"milliseconds";
+    static auto &sweepDuration = Metrics::getInstance().histogram("librevna_vna_sweep_duration_seconds", "Time between the first and the last point of a VNA sweep",
+                                                                  Metrics::Histogram::exponentialBounds(0.001, 2, 18));
+    static auto &pointRate = Metrics::getInstance().gauge("librevna_vna_points_per_second", "Received VNA points per second during the last sweep");
+    static auto &receivedPoints = Metrics::getInstance().counter("librevna_vna_points_total", "Received VNA points");
+    static auto &missedPoints = Metrics::getInstance().counter("librevna_vna_points_missed_total", "VNA points skipped in the sequence of point numbers");
+    static auto &unexpectedPoints = Metrics::getInstance().counter("librevna_vna_points_out_of_order_total", "VNA points with a repeated, decreasing or too large point number");
+    receivedPoints.increment();
+
+    // Calculate sweep time and check the sequence of point numbers
+    if(m.pointNum >= sweepPoints) {
+        // too large, the point is ignored below and not part of the sequence
+        unexpectedPoints.increment();
+    } else {
+        if(m.pointNum == 0) {
+            // new sweep started
+            if(lastPointNum >= 0 && (unsigned int) lastPointNum + 1 < sweepPoints) {
+                // the end of the previous sweep is missing
+                missedPoints.increment(sweepPoints - lastPointNum - 1);
+            }
+            sweepTimer.start();
+            sweepPointsReceived = 0;
+        } else if(lastPointNum >= 0 && m.pointNum > (unsigned int) lastPointNum + 1) {
+            missedPoints.increment(m.pointNum - lastPointNum - 1);
+        } else if(lastPointNum >= 0 && m.pointNum <= (unsigned int) lastPointNum) {
+            unexpectedPoints.increment();
+        }
+        lastPointNum = m.pointNum;
+        sweepPointsReceived++;
+        if(m.pointNum == sweepPoints - 1 && sweepTimer.isValid()) {
+            auto sweepTime = sweepTimer.nsecsElapsed() * 1e-9;
+            sweepTimer.invalidate();
+            sweepDuration.observe(sweepTime);
+            if(sweepTime > 0) {
+                pointRate.set(sweepPointsReceived / sweepTime);
+            }
+        }
     }
 
     emit newRawDatapoint(m);
@@ -946,9 +1013,13 @@ void VNA::NewDatapoint(DeviceDriver::VNAMeasurement m)
 
     m_avg = average.process(m_avg);
 
-    window->addStreamingData(m_avg, AppWindow::VNADataType::Raw);
+    window->addStreamingData(m_avg, AppWindow::VNADataType::Raw, m_avg.pointNum == settings.npoints - 1);
 
     if(average.settled()) {
+        if(isOperationPending() && getRoot()) {
+            // averaging just settled after a settings change
+            getRoot()->notify("SETTLED", "VNA");
+        }
         setOperationPending(false);
     }
 
@@ -970,47 +1041,64 @@ void VNA::NewDatapoint(DeviceDriver::VNAMeasurement m)
         emit calibrationMeasurementPercentage(percentage);
     }
 
-    cal.correctMeasurement(m_avg);
-
-    if(cal.getCaltype().type != Calibration::Type::None) {
-        window->addStreamingData(m_avg, AppWindow::VNADataType::Calibrated);
+    bool lastPointOfSweep = m_avg.pointNum == settings.npoints - 1;
+    if(settings.zerospan && m_avg.pointNum == 0) {
+        // keep track of first point time
+        settings.firstPointTime = m_avg.us;
     }
 
-    TraceMath::DataType type;
-    if(settings.zerospan) {
-        type = TraceMath::DataType::TimeZeroSpan;
+    if(!traceProcessingEnabled() && !deembedding.isMeasuring()) {
+        // no traces to update, calibration and de-embedding are only needed for streaming/recording
+        pipeline.addPoint(m_avg, lastPointOfSweep, settings.zerospan, settings.firstPointTime, deembedding_active);
+    } else {
+        // points handed to the pipeline earlier must be streamed before this one
+        pipeline.flush();
 
-        // keep track of first point time
-        if(m_avg.pointNum == 0) {
-            settings.firstPointTime = m_avg.us;
-            m_avg.us = 0;
-        } else {
+        cal.correctMeasurement(m_avg);
+
+        if(cal.getCaltype().type != Calibration::Type::None) {
+            window->addStreamingData(m_avg, AppWindow::VNADataType::Calibrated, lastPointOfSweep);
+        }
+
+        TraceMath::DataType type;
+        if(settings.zerospan) {
+            type = TraceMath::DataType::TimeZeroSpan;
             m_avg.us -= settings.firstPointTime;
+        } else {
+            switch(settings.sweepType) {
+            case SweepType::Last:
+            case SweepType::Frequency:
+                type = TraceMath::DataType::Frequency;
+                break;
+            case SweepType::Power:
+                type = TraceMath::DataType::Power;
+                break;
+            }
         }
-    } else {
-        switch(settings.sweepType) {
-        case SweepType::Last:
-        case SweepType::Frequency:
-            type = TraceMath::DataType::Frequency;
-            break;
-        case SweepType::Power:
-            type = TraceMath::DataType::Power;
-            break;
+
+        traceModel.addVNAData(m_avg, type, false);
+        if(deembedding_active) {
+            deembedding.Deembed(m_avg);
+            window->addStreamingData(m_avg, AppWindow::VNADataType::Deembedded, lastPointOfSweep);
+            traceModel.addVNAData(m_avg, type, true);
         }
-    }
 
-    traceModel.addVNAData(m_avg, type, false);
-    if(deembedding_active) {
-        deembedding.Deembed(m_avg);
-        window->addStreamingData(m_avg, AppWindow::VNADataType::Deembedded);
-        traceModel.addVNAData(m_avg, type, true);
+        emit dataChanged();
+        if(lastPointOfSweep) {
+            markerModel->updateMarkers();
+        }
     }
 
-
-    emit dataChanged();
-    if(m_avg.pointNum == settings.npoints - 1) {
+    if(lastPointOfSweep) {
         UpdateAverageCount();
-        markerModel->updateMarkers();
+        if(getRoot()) {
+            getRoot()->notify("SWEEP", "VNA");
+        }
+        AnswerSweepDataQueries();
+    } else if(m_avg.pointNum == 0) {
+        for(auto &q : sweepDataQueries) {
+            q.sweepStarted = true;
+        }
     }
 
     static unsigned int lastPoint = 0;
@@ -1029,11 +1117,139 @@ void VNA::NewDatapoint(DeviceDriver::VNAMeasurement m)
     }
 }
 
+QString VNA::CreateSweepDataResponse(QStringList traceNames)
+{
+    auto available = traceModel.getTraces();
+    std::vector<Trace*> traces;
+    for(auto name : traceNames) {
+        auto it = std::find_if(available.begin(), available.end(), [=](Trace *t) {
+            return t->name().compare(name, Qt::CaseInsensitive) == 0;
+        });
+        if(it == available.end()) {
+            // trace has been removed in the meantime
+            return SCPI::getResultName(SCPI::Result::ExecError);
+        }
+        traces.push_back(*it);
+    }
+    if(traces.size() == 0) {
+        return SCPI::getResultName(SCPI::Result::ExecError);
+    }
+    // all traces must share the same x axis
+    auto npoints = traces[0]->size();
+    for(auto t : traces) {
+        if(t->size() != npoints || t->outputType() != traces[0]->outputType() || Trace::isSAParameter(t->liveParameter())) {
+            return SCPI::getResultName(SCPI::Result::ExecError);
+        }
+    }
+    auto scpi = getRoot();
+    if(scpi && scpi->getDataFormat() != SCPI::DataFormat::ASCII) {
+        // binary block, each point consists of the x coordinate followed by the real and imaginary part of every trace
+        std::vector<double> values;
+        values.reserve(npoints * (1 + 2 * traces.size()));
+        for(unsigned int i=0;i<npoints;i++) {
+            values.push_back(traces[0]->sample(i).x);
+            for(auto t : traces) {
+                auto y = t->sample(i).y;
+                values.push_back(y.real());
+                values.push_back(y.imag());
+            }
+        }
+        return scpi->createBlock(values);
+    }
+    if(npoints == 0) {
+        return "EMPTY";
+    }
+    int precision = 0;
+    switch(traces[0]->outputType()) {
+    case Trace::DataType::Invalid:
+    case Trace::DataType::Frequency: precision = 0; break;
+    case Trace::DataType::Time: precision = 12; break;
+    case Trace::DataType::Power: precision = 3; break;
+    case Trace::DataType::TimeZeroSpan: precision = 4; break;
+    }
+    NumberFormatter ret(npoints * (16 + 32 * traces.size()));
+    for(unsigned int i=0;i<npoints;i++) {
+        ret.add('[').addFixed(traces[0]->sample(i).x, precision);
+        for(auto t : traces) {
+            auto y = t->sample(i).y;
+            ret.add(',').add(y.real()).add(',').add(y.imag());
+        }
+        ret.add("],");
+    }
+    ret.chop();
+    return ret.toString();
+}
+
+void VNA::AnswerSweepDataQueries()
+{
+    auto scpi = getRoot();
+    if(!scpi) {
+        return;
+    }
+    // Settled queries take the first sweep with the final averaging level (averaging is reset on every settings
+    // change, so that sweep always reflects the current settings). All other queries need a sweep that started
+    // after the query was received
+    auto ready = [=](const SweepDataQuery &q) {
+        return q.settled ? average.settled() : q.sweepStarted;
+    };
+    // the response may trigger further queries, work on a copy
+    auto queries = sweepDataQueries;
+    sweepDataQueries.erase(std::remove_if(sweepDataQueries.begin(), sweepDataQueries.end(), ready), sweepDataQueries.end());
+    if(sweepDataQueries.empty()) {
+        sweepDataQueryTimer.stop();
+    }
+    for(auto &q : queries) {
+        if(ready(q)) {
+            scpi->deferredResponse(q.connection, [=]() {
+                return CreateSweepDataResponse(q.traces);
+            });
+        }
+    }
+}
+
+void VNA::FailSweepDataQueries()
+{
+    sweepDataQueryTimer.stop();
+    auto scpi = getRoot();
+    // the response may trigger further queries, work on a copy
+    auto queries = sweepDataQueries;
+    sweepDataQueries.clear();
+    if(!scpi) {
+        return;
+    }
+    for(auto &q : queries) {
+        scpi->deferredResponse(q.connection, []() {
+            return SCPI::getResultName(SCPI::Result::ExecError);
+        });
+    }
+}
+
 void VNA::UpdateAverageCount()
 {
     lAverages->setText(QString::number(average.getLevel()) + "/");
 }
 
+void VNA::UpdateRecorderSettings()
+{
+    SweepRecorder::SweepSettings s;
+    s.type = SweepTypeToString(settings.sweepType).toUpper();
+    s.zerospan = settings.zerospan;
+    if(settings.sweepType == SweepType::Frequency) {
+        s.start = settings.Freq.start;
+        s.stop = settings.Freq.stop;
+        s.powerStart = settings.Freq.excitation_power;
+        s.powerStop = settings.Freq.excitation_power;
+    } else {
+        s.start = settings.Power.frequency;
+        s.stop = settings.Power.frequency;
+        s.powerStart = settings.Power.start;
+        s.powerStop = settings.Power.stop;
+    }
+    s.bandwidth = settings.bandwidth;
+    s.averages = averages;
+    window->getRecorder()->setVNASweepSettings(s);
+}
+
 void VNA::SettingsChanged(bool resetTraces, int delay)
 {
     if(window->getDevice()) {
@@ -1042,6 +1258,9 @@ void VNA::SettingsChanged(bool resetTraces, int delay)
     configurationTimer.start(delay);
     changingSettings = true;
     configurationTimerResetTraces = resetTraces;
+    // points of the new settings start a new sequence
+    lastPointNum = -1;
+    sweepTimer.invalidate();
     if(resetTraces) {
         ResetLiveTraces();
     }
@@ -1279,6 +1498,7 @@ void VNA::SetAveraging(unsigned int averages)
     average.setAverages(averages);
     emit averagingChanged(averages);
     UpdateAverageCount();
+    UpdateRecorderSettings();
     setOperationPending(!average.settled());
 }
 
@@ -1536,7 +1756,53 @@ void VNA::SetupSCPI()
     scpi_acq->add(new SCPICommand("FINished", nullptr, [=](QStringList) -> QString {
         return average.settled() ? SCPI::getResultName(SCPI::Result::True) : SCPI::getResultName(SCPI::Result::False);
     }));
+    scpi_acq->add(new SCPICommand("SWEEPDATA", nullptr, [=](QStringList params) -> QString {
+        enableTraceProcessing();
+        bool settled = false;
+        if(params.size() > 0 && params[0] == "SETTLED") {
+            settled = true;
+            params.pop_front();
+        }
+        QStringList traceNames;
+        if(params.isEmpty()) {
+            // no traces specified, use all
+            for(auto t : traceModel.getTraces()) {
+                traceNames.append(t->name());
+            }
+        }
+        for(auto p : params) {
+            auto traces = traceModel.getTraces();
+            auto it = std::find_if(traces.begin(), traces.end(), [=](Trace *t) {
+                return t->name().compare(p, Qt::CaseInsensitive) == 0;
+            });
+            if(it == traces.end()) {
+                return SCPI::getResultName(SCPI::Result::Error);
+            }
+            traceNames.append((*it)->name());
+        }
+        auto scpi = getRoot();
+        if(!scpi || traceNames.isEmpty()) {
+            return SCPI::getResultName(SCPI::Result::Error);
+        }
+        if(settled && singleSweep && average.getLevel() == averages) {
+            // single sweep has already finished, no further data will arrive
+            return CreateSweepDataResponse(traceNames);
+        }
+        if(!running || !window->getDevice()) {
+            // the query would never be answered
+            return SCPI::getResultName(SCPI::Result::ExecError);
+        }
+        SweepDataQuery q;
+        q.connection = scpi->deferResponse();
+        q.traces = traceNames;
+        q.settled = settled;
+        q.sweepStarted = false;
+        sweepDataQueries.push_back(q);
+        sweepDataQueryTimer.start(sweepDataQueryTimeout);
+        return SCPI::getResultName(SCPI::Result::Empty);
+    }));
     scpi_acq->add(new SCPICommand("LIMit", nullptr, [=](QStringList) -> QString {
+        enableTraceProcessing();
         return tiles->allLimitsPassing() ? "PASS" : "FAIL";
     }));
     scpi_acq->add(new SCPICommand("SINGLE", [=](QStringList params) -> QString {
@@ -1581,6 +1847,15 @@ void VNA::SetupSCPI()
     }));
 
     SCPINode::add(&deembedding);
+
+    // commands may change the calibration or de-embedding, finish processing the pending points first
+    setAccessCallback([=](){
+        pipeline.flush();
+    });
+    // traces are only updated without GUI after they have been requested
+    traceWidget->setAccessCallback([=](){
+        enableTraceProcessing();
+    });
 }
 
 void VNA::ConstrainAndUpdateFrequencies()
@@ -1866,6 +2141,7 @@ void VNA::ConfigureDevice(bool resetTraces, std::function<void(bool)> cb)
             }
         }
         settings.excitedPorts = s.excitedPorts;
+        UpdateRecorderSettings();
 
         double start = settings.sweepType == SweepType::Frequency ? settings.Freq.start : settings.Power.start;
         double stop = settings.sweepType == SweepType::Frequency ? settings.Freq.stop : settings.Power.stop;
@@ -1885,6 +2161,7 @@ void VNA::ConfigureDevice(bool resetTraces, std::function<void(bool)> cb)
             start = seg_start;
             stop = seg_stop;
         }
+        sweepPoints = npoints;
 
         if(settings.sweepType == SweepType::Frequency) {
             s.freqStart = start;
@@ -1919,6 +2196,8 @@ void VNA::ConfigureDevice(bool resetTraces, std::function<void(bool)> cb)
             changingSettings = false;
         }
     } else {
+        // stopped, pending queries will not receive another sweep
+        FailSweepDataQueries();
         if(window->getDevice()) {
             changingSettings = true;
             window->getDevice()->setIdle([=](bool){
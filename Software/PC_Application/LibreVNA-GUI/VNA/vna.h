@@ -8,10 +8,12 @@
 #include "scpi.h"
 #include "tracewidgetvna.h"
 #include "Calibration/calibration.h"
+#include "vnapipeline.h"
 
 #include <QObject>
 #include <QWidget>
 #include <QScrollArea>
+#include <QElapsedTimer>
 #include <functional>
 
 class VNA : public Mode
@@ -23,6 +25,7 @@ public:
     void deactivate() override;
     void initializeDevice() override;
     void deviceDisconnected() override;
+    void flushStreamingData() override;
     void shutdown() override;
 
     virtual Type getType() override { return Type::VNA;}
@@ -130,6 +133,8 @@ private:
     bool CalibrationMeasurementActive() { return calWaitFirst || calMeasuring; }
     void SetupSCPI();
     void UpdateAverageCount();
+    // passes the sweep settings to the recorder, which stores them along with the recorded sweeps
+    void UpdateRecorderSettings();
     void SettingsChanged(bool resetTraces = true, int delay = 100);
     void ConstrainAndUpdateFrequencies();
     void LoadSweepSettings();
@@ -152,9 +157,33 @@ private:
     Averaging average;
     bool singleSweep;
     bool running;
+
+    // Pending :VNA:ACQ:SWEEPDATA? queries, answered at the end of the next complete (and settled, if requested) sweep
+    class SweepDataQuery {
+    public:
+        unsigned int connection;
+        QStringList traces;
+        bool settled;
+        // only sweeps that started after the query was received are considered
+        bool sweepStarted;
+    };
+    std::vector<SweepDataQuery> sweepDataQueries;
+    QString CreateSweepDataResponse(QStringList traceNames);
+    void AnswerSweepDataQueries();
+    // answers all pending queries with an execution error (no more data will arrive for them)
+    void FailSweepDataQueries();
+    // restarted with every received point while queries are pending, the queries fail when it expires
+    QTimer sweepDataQueryTimer;
+    static constexpr int sweepDataQueryTimeout = 10000;
     QTimer configurationTimer;
     bool configurationTimerResetTraces;
 
+    // Sweep health metrics, the sequence of point numbers starts over whenever the settings change
+    unsigned int sweepPoints; // number of points the device sends per sweep (per segment)
+    unsigned int sweepPointsReceived;
+    int lastPointNum; // -1 if no point has been received since the settings changed
+    QElapsedTimer sweepTimer; // started at the first point of a sweep
+
     // Calibration
     Calibration cal;
     bool changingSettings;
@@ -179,6 +208,9 @@ private:
     bool deembedding_active;
     bool wasRunningBeforeDeembeddingMeasurement;
 
+    // calibration and de-embedding for streaming/recording when no traces are updated
+    VNAPipeline pipeline;
+
     // Status Labels
     QLabel *lAverages;
     QLabel *calLabel;
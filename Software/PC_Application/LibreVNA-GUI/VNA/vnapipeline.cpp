@@ -0,0 +1,118 @@
+#include "vnapipeline.h"
+
+#include "appwindow.h"
+#include "Calibration/calibration.h"
+#include "Deembedding/deembedding.h"
+#include "Util/latencytracer.h"
+
+using namespace std;
+
+VNAPipeline::VNAPipeline(AppWindow *window, Calibration &cal, Deembedding &deembedding)
+    : window(window),
+      cal(cal),
+      deembedding(deembedding),
+      busy(false),
+      stopRequested(false),
+      processedPoints(0)
+{
+    latencyTimer.setSingleShot(true);
+    QObject::connect(&latencyTimer, &QTimer::timeout, [=](){
+        handOver();
+    });
+}
+
+VNAPipeline::~VNAPipeline()
+{
+    if(thread.joinable()) {
+        {
+            lock_guard<mutex> lock(mtx);
+            stopRequested = true;
+        }
+        workAvailable.notify_one();
+        thread.join();
+    }
+}
+
+void VNAPipeline::addPoint(const DeviceDriver::VNAMeasurement &m, bool lastPointOfSweep, bool zerospan, quint64 firstPointTime, bool deembed)
+{
+    if(!thread.joinable()) {
+        // only start the worker when it is actually needed
+        thread = std::thread(&VNAPipeline::process, this);
+    }
+    if(block.empty()) {
+        block.reserve(blockSize);
+        latencyTimer.start(maxLatency);
+    }
+    block.push_back(Point{m, lastPointOfSweep, zerospan, firstPointTime, deembed});
+    if(block.size() >= blockSize || lastPointOfSweep) {
+        handOver();
+    }
+}
+
+void VNAPipeline::flush()
+{
+    if(!thread.joinable()) {
+        return;
+    }
+    handOver();
+    unique_lock<mutex> lock(mtx);
+    workDone.wait(lock, [=](){
+        return queue.empty() && !busy;
+    });
+}
+
+void VNAPipeline::handOver()
+{
+    latencyTimer.stop();
+    if(block.empty()) {
+        return;
+    }
+    {
+        unique_lock<mutex> lock(mtx);
+        // the worker is not keeping up, slow down the main thread instead of queuing endlessly
+        workDone.wait(lock, [=](){
+            return queue.size() < maxQueuedBlocks;
+        });
+        queue.push_back(std::move(block));
+    }
+    block.clear();
+    workAvailable.notify_one();
+}
+
+void VNAPipeline::process()
+{
+    LATENCY_THREAD_NAME("VNAPipeline");
+    unique_lock<mutex> lock(mtx);
+    while(true) {
+        workAvailable.wait(lock, [=](){
+            return stopRequested || !queue.empty();
+        });
+        if(stopRequested) {
+            break;
+        }
+        auto points = std::move(queue.front());
+        queue.pop_front();
+        busy = true;
+        lock.unlock();
+
+        bool calibrated = cal.getCaltype().type != Calibration::Type::None;
+        for(auto &p : points) {
+            if(calibrated) {
+                cal.correctMeasurement(p.m);
+                window->addStreamingData(p.m, AppWindow::VNADataType::Calibrated, p.lastPointOfSweep);
+            }
+            if(p.deembed) {
+                if(p.zerospan) {
+                    p.m.us -= p.firstPointTime;
+                }
+                deembedding.Deembed(p.m);
+                window->addStreamingData(p.m, AppWindow::VNADataType::Deembedded, p.lastPointOfSweep);
+            }
+        }
+        processedPoints += points.size();
+
+        lock.lock();
+        busy = false;
+        workDone.notify_all();
+    }
+}
@@ -0,0 +1,81 @@
+#ifndef VNAPIPELINE_H
+#define VNAPIPELINE_H
+
+#include "Device/devicedriver.h"
+
+#include <QTimer>
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <vector>
+
+class AppWindow;
+class Calibration;
+class Deembedding;
+
+/**
+ * @brief VNAPipeline
+ *
+ * Calibrates and de-embeds VNA measurements in a worker thread and hands the results to the streaming
+ * servers and the sweep recorder. It replaces the trace based processing when the application runs
+ * without GUI with --lazy-traces and no traces are needed, keeping the main thread free for receiving data
+ * from the device.
+ *
+ * Points are passed to the worker in blocks: when a block is full, at the end of a sweep or at the
+ * latest after maxLatency. The calibration protects itself against concurrent access, everything else
+ * (de-embedding options, streaming servers, recorder) must not be changed while points are being processed.
+ * Call flush() before changing them (AppWindow does so through Mode::flushStreamingData()).
+ */
+class VNAPipeline
+{
+public:
+    VNAPipeline(AppWindow *window, Calibration &cal, Deembedding &deembedding);
+    ~VNAPipeline();
+
+    // For zero span, firstPointTime is subtracted from the point time before de-embedding (as for the traces)
+    void addPoint(const DeviceDriver::VNAMeasurement &m, bool lastPointOfSweep, bool zerospan, quint64 firstPointTime, bool deembed);
+    // Blocks until all points handed over so far have been processed
+    void flush();
+
+    quint64 getProcessedPoints() {return processedPoints;}
+
+    static constexpr unsigned int blockSize = 256;
+    // maximum time a point waits for its block to be handed over (in ms)
+    static constexpr int maxLatency = 10;
+    // addPoint() blocks while this many blocks are waiting for the worker
+    static constexpr unsigned int maxQueuedBlocks = 64;
+
+private:
+    class Point {
+    public:
+        DeviceDriver::VNAMeasurement m;
+        bool lastPointOfSweep;
+        bool zerospan;
+        quint64 firstPointTime;
+        bool deembed;
+    };
+    void handOver();
+    void process();
+
+    AppWindow *window;
+    Calibration &cal;
+    Deembedding &deembedding;
+
+    // block currently being filled (only accessed by the main thread)
+    std::vector<Point> block;
+    QTimer latencyTimer;
+
+    std::deque<std::vector<Point>> queue;
+    bool busy;
+    bool stopRequested;
+    std::mutex mtx;
+    std::condition_variable workAvailable;
+    std::condition_variable workDone;
+    std::thread thread;
+    std::atomic<quint64> processedPoints;
+};
+
+#endif // VNAPIPELINE_H
@@ -7,6 +7,7 @@
 #include "Traces/tracesmithchart.h"
 #include "Traces/tracexyplot.h"
 #include "Traces/traceimportdialog.h"
+#include "Traces/renderscheduler.h"
 #include "CustomWidgets/tilewidget.h"
 #include "CustomWidgets/siunitedit.h"
 #include "Traces/Marker/markerwidget.h"
@@ -19,12 +20,15 @@
 #include "SpectrumAnalyzer/spectrumanalyzer.h"
 #include "CustomWidgets/informationbox.h"
 #include "Util/app_common.h"
+#include "Util/latencytracer.h"
+#include "Util/metrics.h"
 #include "about.h"
 #include "mode.h"
 #include "modehandler.h"
 #include "modewindow.h"
 #include "Device/LibreVNA/librevnausbdriver.h"
 #include "Device/LibreVNA/librevnatcpdriver.h"
+#include "Device/LibreVNA/devicepacketlog.h"
 
 #include <QDockWidget>
 #include <QApplication>
@@ -64,12 +68,14 @@ static const QString APP_VERSION = QString::number(FW_MAJOR) + "." +
 static const QString APP_GIT_HASH = QString(GITHASH);
 
 static bool noGUIset = false;
+static bool lazyTracesSet = false;
 
 AppWindow::AppWindow(QWidget *parent)
     : QMainWindow(parent)
     , deviceActionGroup(new QActionGroup(this))
     , ui(new Ui::MainWindow)
     , server(nullptr)
+    , metricsServer(nullptr)
     , streamVNARawData(nullptr)
     , streamVNACalibratedData(nullptr)
     , streamVNADeembeddedData(nullptr)
@@ -90,9 +96,12 @@ AppWindow::AppWindow(QWidget *parent)
     parser.addOption(QCommandLineOption({"p","port"}, "Specify port to listen for SCPI commands", "port"));
     parser.addOption(QCommandLineOption({"d","device"}, "Only allow connections to the specified device", "device"));
     parser.addOption(QCommandLineOption("no-gui", "Disables the graphical interface"));
+    parser.addOption(QCommandLineOption("lazy-traces", "Without graphical interface: only update the traces after a trace related SCPI command has been used. "
+                                        "Increases the throughput of the streaming servers and the recorder, the first trace query returns outdated data"));
     parser.addOption(QCommandLineOption("cal", "Calibration file to load on startup", "cal"));
     parser.addOption(QCommandLineOption("setup", "Setup file to load on startup", "setup"));
     parser.addOption(QCommandLineOption("reset-preferences", "Resets all preferences to their default values"));
+    parser.addOption(QCommandLineOption("simulate", "Starts a simulated device which generates the given number of points per second (0 for as fast as possible)", "points/s"));
 
     parser.process(QCoreApplication::arguments());
 
@@ -107,6 +116,15 @@ AppWindow::AppWindow(QWidget *parent)
     device = nullptr;
 //    vdevice = nullptr;
     modeHandler = nullptr;
+    simulator = nullptr;
+
+    if(parser.isSet("simulate")) {
+        simulator = new LibreVNASimulator();
+        simulator->setPointsPerSecond(parser.value("simulate").toUInt());
+        if(!simulator->start()) {
+            qWarning() << "Unable to start the simulated device";
+        }
+    }
 
     if(parser.isSet("port")) {
         bool OK;
@@ -121,6 +139,10 @@ AppWindow::AppWindow(QWidget *parent)
         StartTCPServer(p.SCPIServer.port);
     }
 
+    if(p.MetricsServer.enabled) {
+        metricsServer = new MetricsServer(p.MetricsServer.port);
+    }
+
     if(p.StreamingServers.VNARawData.enabled) {
         streamVNARawData = new StreamingServer(p.StreamingServers.VNARawData.port);
     }
@@ -136,6 +158,12 @@ AppWindow::AppWindow(QWidget *parent)
     if(p.StreamingServers.SANormalizedData.enabled) {
         streamSANormalizedData = new StreamingServer(p.StreamingServers.SANormalizedData.port);
     }
+    for(auto server : {streamVNARawData, streamVNACalibratedData, streamVNADeembeddedData, streamSARawData, streamSANormalizedData}) {
+        if(server) {
+            server->setQueueLimit(p.StreamingServers.queueSize);
+            server->setDropPolicy((StreamingServer::DropPolicy) p.StreamingServers.dropPolicy);
+        }
+    }
 
     ui->setupUi(this);
 
@@ -213,12 +241,21 @@ AppWindow::AppWindow(QWidget *parent)
     } else {
         InformationBox::setGUI(false);
         noGUIset = true;
+        lazyTracesSet = parser.isSet("lazy-traces");
     }
 }
 
 AppWindow::~AppWindow()
 {
     StopTCPServer();
+    flushStreamingData();
+    delete metricsServer;
+    delete streamVNARawData;
+    delete streamVNACalibratedData;
+    delete streamVNADeembeddedData;
+    delete streamSARawData;
+    delete streamSANormalizedData;
+    delete simulator;
     delete ui;
 }
 
@@ -259,6 +296,29 @@ void AppWindow::SetupMenu()
         preferencesChanged();
     });
 
+    ui->actionRecord_Latency_Trace->setVisible(LatencyTracer::isAvailable());
+    ui->actionSave_Latency_Trace->setVisible(LatencyTracer::isAvailable());
+    connect(ui->actionRecord_Latency_Trace, &QAction::toggled, [=](bool checked){
+        if(checked) {
+            LatencyTracer::start();
+        } else {
+            LatencyTracer::stop();
+        }
+    });
+    connect(ui->actionSave_Latency_Trace, &QAction::triggered, [=](){
+        auto filename = QFileDialog::getSaveFileName(nullptr, "Save latency trace", "", "Chrome trace files (*.json)", nullptr, QFileDialog::DontUseNativeDialog);
+        if(filename.isEmpty()) {
+            // aborted selection
+            return;
+        }
+        if(!filename.endsWith(".json")) {
+            filename.append(".json");
+        }
+        if(!LatencyTracer::save(filename)) {
+            InformationBox::ShowError("Error", "Failed to save the latency trace to "+filename);
+        }
+    });
+
     connect(ui->actionAbout, &QAction::triggered, [=](){
         auto &a = About::getInstance();
         a.about();
@@ -345,6 +405,8 @@ bool AppWindow::ConnectToDevice(QString serial, DeviceDriver *driver)
                 connect(d, &DeviceDriver::ConnectionLost, this, &AppWindow::DeviceConnectionLost);
                 connect(d, &DeviceDriver::StatusUpdated, this, &AppWindow::DeviceStatusUpdated);
                 connect(d, &DeviceDriver::FlagsUpdated, this, &AppWindow::DeviceFlagsUpdated);
+                // the first status of the new device is always sent
+                lastFlags.clear();
                 connect(d, &DeviceDriver::releaseControl, this, [=](){
                     if(lastActiveMode) {
                         modeHandler->activate(lastActiveMode);
@@ -370,6 +432,7 @@ bool AppWindow::ConnectToDevice(QString serial, DeviceDriver *driver)
             return false;
         }
         UpdateStatusBar(AppWindow::DeviceStatusBar::Connected);
+        scpi.notify("CONNECTED", device->getSerial());
 //        connect(vdevice, &VirtualDevice::NeedsFirmwareUpdate, this, &AppWindow::DeviceNeedsUpdate);
         ui->actionDisconnect->setEnabled(true);
         // find correct position to add device specific actions at
@@ -428,6 +491,7 @@ void AppWindow::DisconnectDevice()
         for(auto a : device->driverSpecificActions()) {
             ui->menuDevice->removeAction(a);
         }
+        scpi.notify("DISCONNECTED", device->getSerial());
         device->disconnectDevice();
         disconnect(device, nullptr, &deviceLog, nullptr);
         disconnect(device, nullptr, this, nullptr);
@@ -455,6 +519,9 @@ void AppWindow::DisconnectDevice()
 
 void AppWindow::DeviceConnectionLost()
 {
+    if(device) {
+        scpi.notify("CONNECTIONLOST", device->getSerial());
+    }
     DisconnectDevice();
     InformationBox::ShowError("Disconnected", "The connection to the device has been lost");
     UpdateDeviceList();
@@ -487,6 +554,15 @@ void AppWindow::SetupSCPI()
         ResetReference();
         return SCPI::getResultName(SCPI::Result::Empty);
     }, nullptr));
+    // events available for subscription with EVENt:SUBScribe
+    scpi.addEvent("SWEEP");
+    scpi.addEvent("SETTLED");
+    scpi.addEvent("CALIBRATION");
+    scpi.addEvent("FLAGS");
+    scpi.addEvent("CONNECTED");
+    scpi.addEvent("DISCONNECTED");
+    scpi.addEvent("CONNECTIONLOST");
+
     auto scpi_dev = new SCPINode("DEVice");
     scpi.add(scpi_dev);
     scpi_dev->add(new SCPICommand("DISConnect", [=](QStringList params) -> QString {
@@ -713,6 +789,152 @@ void AppWindow::SetupSCPI()
             return SCPI::getResultName(SCPI::Result::Error);
         }
     }));
+    auto scpi_streaming = new SCPINode("STReaming");
+    scpi_dev->add(scpi_streaming);
+    auto streamingServerFromName = [=](QString name) -> StreamingServer* {
+        name = name.toUpper();
+        if(name == "VNARAW") {
+            return streamVNARawData;
+        } else if(name == "VNACAL") {
+            return streamVNACalibratedData;
+        } else if(name == "VNADEEMB") {
+            return streamVNADeembeddedData;
+        } else if(name == "SARAW") {
+            return streamSARawData;
+        } else if(name == "SANORM") {
+            return streamSANormalizedData;
+        } else {
+            return nullptr;
+        }
+    };
+    scpi_streaming->add(new SCPICommand("CLIents", nullptr, [=](QStringList params) -> QString {
+        if(params.size() != 1) {
+            return SCPI::getResultName(SCPI::Result::Error);
+        }
+        auto server = streamingServerFromName(params[0]);
+        if(!server) {
+            return SCPI::getResultName(SCPI::Result::Error);
+        }
+        return QString::number(server->getStatistics().size());
+    }));
+    scpi_streaming->add(new SCPICommand("STATistics", nullptr, [=](QStringList params) -> QString {
+        unsigned long long index;
+        if(params.size() != 2 || !SCPI::paramToULongLong(params, 1, index)) {
+            return SCPI::getResultName(SCPI::Result::Error);
+        }
+        auto server = streamingServerFromName(params[0]);
+        if(!server) {
+            return SCPI::getResultName(SCPI::Result::Error);
+        }
+        auto stats = server->getStatistics();
+        if(index >= stats.size()) {
+            return SCPI::getResultName(SCPI::Result::Error);
+        }
+        auto s = stats[index];
+        QString format;
+        switch(s.format) {
+        case StreamingServer::Format::JSON: format = "JSON"; break;
+        case StreamingServer::Format::Binary32: format = "BIN32"; break;
+        case StreamingServer::Format::Binary64: format = "BIN64"; break;
+        }
+        return s.address+","+QString::number(s.port)+","+format+","+(s.sweepBatching ? "SWEEP" : "POINT")+","
+                +QString::number(s.framesSent)+","+QString::number(s.bytesSent)+","
+                +QString::number(s.framesDropped)+","+QString::number(s.bytesDropped)+","
+                +QString::number(s.queuedBytes)+","+QString::number(s.throughput, 'f', 0);
+    }));
+    auto scpi_record = new SCPINode("RECord");
+    scpi_dev->add(scpi_record);
+    scpi_record->add(new SCPICommand("STARt", [=](QStringList params) -> QString {
+        if(params.size() < 2) {
+            return SCPI::getResultName(SCPI::Result::Error);
+        }
+        std::set<SweepRecorder::Stage> stages;
+        for(int i=1;i<params.size();i++) {
+            auto stage = SweepRecorder::StageFromString(params[i]);
+            if(stage == SweepRecorder::Stage::Last) {
+                return SCPI::getResultName(SCPI::Result::Error);
+            }
+            stages.insert(stage);
+        }
+        flushStreamingData();
+        if(!recorder.start(params[0], stages)) {
+            return SCPI::getResultName(SCPI::Result::Error);
+        }
+        return SCPI::getResultName(SCPI::Result::Empty);
+    }, nullptr, false));
+    scpi_record->add(new SCPICommand("STOP", [=](QStringList) -> QString {
+        flushStreamingData();
+        recorder.stop();
+        return SCPI::getResultName(SCPI::Result::Empty);
+    }, nullptr));
+    scpi_record->add(new SCPICommand("ACTive", nullptr, [=](QStringList) -> QString {
+        return recorder.isRecording() ? SCPI::getResultName(SCPI::Result::True) : SCPI::getResultName(SCPI::Result::False);
+    }));
+    scpi_record->add(new SCPICommand("ROTation", [=](QStringList params) -> QString {
+        unsigned long long size, duration;
+        if(params.size() != 2 || !SCPI::paramToULongLong(params, 0, size) || !SCPI::paramToULongLong(params, 1, duration)) {
+            return SCPI::getResultName(SCPI::Result::Error);
+        }
+        recorder.setRotation(size, duration);
+        return SCPI::getResultName(SCPI::Result::Empty);
+    }, nullptr));
+    scpi_record->add(new SCPICommand("STATistics", nullptr, [=](QStringList) -> QString {
+        auto s = recorder.getStatistics();
+        return QString::number(s.sweepsRecorded)+","+QString::number(s.sweepsDropped)+","+QString::number(s.bytesWritten)+","
+                +QString::number(s.files)+","+(s.currentFile.isEmpty() ? "NONE" : s.currentFile);
+    }));
+    scpi_record->add(new SCPICommand("ERRor", nullptr, [=](QStringList) -> QString {
+        auto s = recorder.getStatistics();
+        return s.error.isEmpty() ? "NONE" : s.error;
+    }));
+    auto scpi_latency = new SCPINode("LATency");
+    scpi_dev->add(scpi_latency);
+    scpi_latency->add(new SCPICommand("STARt", [=](QStringList) -> QString {
+        if(!LatencyTracer::isAvailable()) {
+            return SCPI::getResultName(SCPI::Result::Error);
+        }
+        LatencyTracer::start();
+        QSignalBlocker blocker(ui->actionRecord_Latency_Trace);
+        ui->actionRecord_Latency_Trace->setChecked(true);
+        return SCPI::getResultName(SCPI::Result::Empty);
+    }, nullptr));
+    scpi_latency->add(new SCPICommand("STOP", [=](QStringList) -> QString {
+        LatencyTracer::stop();
+        QSignalBlocker blocker(ui->actionRecord_Latency_Trace);
+        ui->actionRecord_Latency_Trace->setChecked(false);
+        return SCPI::getResultName(SCPI::Result::Empty);
+    }, nullptr));
+    scpi_latency->add(new SCPICommand("ACTive", nullptr, [=](QStringList) -> QString {
+        return LatencyTracer::isActive() ? SCPI::getResultName(SCPI::Result::True) : SCPI::getResultName(SCPI::Result::False);
+    }));
+    scpi_latency->add(new SCPICommand("SAVE", [=](QStringList params) -> QString {
+        if(params.size() != 1 || !LatencyTracer::isAvailable()) {
+            return SCPI::getResultName(SCPI::Result::Error);
+        }
+        if(!LatencyTracer::save(params[0])) {
+            return SCPI::getResultName(SCPI::Result::Error);
+        }
+        return SCPI::getResultName(SCPI::Result::Empty);
+    }, nullptr, false));
+    auto scpi_metrics = new SCPINode("METrics");
+    scpi_dev->add(scpi_metrics);
+    scpi_metrics->add(new SCPICommand("LIST", nullptr, [=](QStringList) -> QString {
+        return Metrics::getInstance().getNames().join(",");
+    }));
+    scpi_metrics->add(new SCPICommand("VALue", nullptr, [=](QStringList params) -> QString {
+        if(params.size() != 1) {
+            return SCPI::getResultName(SCPI::Result::Error);
+        }
+        auto metric = Metrics::getInstance().find(params[0]);
+        if(!metric) {
+            return SCPI::getResultName(SCPI::Result::Error);
+        }
+        return metric->toString();
+    }, false));
+    scpi_metrics->add(new SCPICommand("RESet", [=](QStringList) -> QString {
+        Metrics::getInstance().reset();
+        return SCPI::getResultName(SCPI::Result::Empty);
+    }, nullptr));
     auto scpi_info = new SCPINode("INFo");
     scpi_dev->add(scpi_info);
     scpi_info->add(new SCPICommand("FWREVision", nullptr, [=](QStringList){
@@ -1022,6 +1244,8 @@ void AppWindow::StartTCPServer(int port)
     server = new TCPServer(port);
     connect(server, &TCPServer::received, &scpi, &SCPI::input);
     connect(&scpi, &SCPI::output, server, &TCPServer::send);
+    connect(&scpi, &SCPI::outputBlock, server, &TCPServer::sendBlock);
+    connect(server, &TCPServer::disconnected, &scpi, &SCPI::removeConnection);
 }
 
 void AppWindow::StopTCPServer()
@@ -1044,7 +1268,19 @@ void AppWindow::preferencesChanged()
         StartTCPServer(p.SCPIServer.port);
     }
 
-    auto updateStreamingServer = [](StreamingServer **server, bool enabled, int port) {
+    DevicePacketLog::getInstance().applyPreferences();
+
+    if(metricsServer && (!p.MetricsServer.enabled || metricsServer->getPort() != p.MetricsServer.port)) {
+        delete metricsServer;
+        metricsServer = nullptr;
+    }
+    if(!metricsServer && p.MetricsServer.enabled) {
+        metricsServer = new MetricsServer(p.MetricsServer.port);
+    }
+
+    // the servers may be deleted below
+    flushStreamingData();
+    auto updateStreamingServer = [&](StreamingServer **server, bool enabled, int port) {
         if(*server && !enabled) {
             delete *server;
             *server = nullptr;
@@ -1054,6 +1290,10 @@ void AppWindow::preferencesChanged()
             delete *server;
             *server = new StreamingServer(port);
         }
+        if(*server) {
+            (*server)->setQueueLimit(p.StreamingServers.queueSize);
+            (*server)->setDropPolicy((StreamingServer::DropPolicy) p.StreamingServers.dropPolicy);
+        }
     };
 
     updateStreamingServer(&streamVNARawData, p.StreamingServers.VNARawData.enabled, p.StreamingServers.VNARawData.port);
@@ -1083,6 +1323,8 @@ void AppWindow::preferencesChanged()
         }
     }
 
+    RenderScheduler::getInstance().updateFromPreferences();
+
     auto active = modeHandler->getActiveMode();
     if (active)
     {
@@ -1098,31 +1340,47 @@ SCPI* AppWindow::getSCPI()
     return &scpi;
 }
 
-void AppWindow::addStreamingData(const DeviceDriver::VNAMeasurement &m, VNADataType type)
+SweepRecorder* AppWindow::getRecorder()
+{
+    return &recorder;
+}
+
+void AppWindow::flushStreamingData()
+{
+    for(auto m : modeHandler->getModes()) {
+        m->flushStreamingData();
+    }
+}
+
+void AppWindow::addStreamingData(const DeviceDriver::VNAMeasurement &m, VNADataType type, bool lastPointOfSweep)
 {
     StreamingServer *server = nullptr;
+    SweepRecorder::Stage stage = SweepRecorder::Stage::VNARaw;
     switch(type) {
     case VNADataType::Raw: server = streamVNARawData; break;
-    case VNADataType::Calibrated: server = streamVNACalibratedData; break;
-    case VNADataType::Deembedded: server = streamVNADeembeddedData; break;
+    case VNADataType::Calibrated: server = streamVNACalibratedData; stage = SweepRecorder::Stage::VNACalibrated; break;
+    case VNADataType::Deembedded: server = streamVNADeembeddedData; stage = SweepRecorder::Stage::VNADeembedded; break;
     }
 
     if(server) {
-        server->addData(m);
+        server->addData(m, lastPointOfSweep);
     }
+    recorder.addData(m, stage, lastPointOfSweep);
 }
 
-void AppWindow::addStreamingData(const DeviceDriver::SAMeasurement &m, SADataType type)
+void AppWindow::addStreamingData(const DeviceDriver::SAMeasurement &m, SADataType type, bool lastPointOfSweep)
 {
     StreamingServer *server = nullptr;
+    SweepRecorder::Stage stage = SweepRecorder::Stage::SARaw;
     switch(type) {
     case SADataType::Raw: server = streamSARawData; break;
-    case SADataType::Normalized: server = streamSANormalizedData; break;
+    case SADataType::Normalized: server = streamSANormalizedData; stage = SweepRecorder::Stage::SANormalized; break;
     }
 
     if(server) {
-        server->addData(m);
+        server->addData(m, lastPointOfSweep);
     }
+    recorder.addData(m, stage, lastPointOfSweep);
 }
 
 void AppWindow::setModeStatus(QString msg)
@@ -1278,6 +1536,25 @@ void AppWindow::DeviceFlagsUpdated()
     lADCOverload.setVisible(device->asserted(DeviceDriver::Flag::Overload));
     lUnlevel.setVisible(device->asserted(DeviceDriver::Flag::Unlevel));
     lUnlock.setVisible(device->asserted(DeviceDriver::Flag::Unlocked));
+
+    QStringList flags;
+    if(device->asserted(DeviceDriver::Flag::Overload)) {
+        flags.append("OVERLOAD");
+    }
+    if(device->asserted(DeviceDriver::Flag::Unlocked)) {
+        flags.append("UNLOCKED");
+    }
+    if(device->asserted(DeviceDriver::Flag::Unlevel)) {
+        flags.append("UNLEVEL");
+    }
+    if(device->asserted(DeviceDriver::Flag::ExtRef)) {
+        flags.append("EXTREF");
+    }
+    auto info = flags.isEmpty() ? "NONE" : flags.join(",");
+    if(info != lastFlags) {
+        lastFlags = info;
+        scpi.notify("FLAGS", info);
+    }
 }
 
 void AppWindow::DeviceInfoUpdated()
@@ -1509,6 +1786,11 @@ bool AppWindow::showGUI()
     return !noGUIset;
 }
 
+bool AppWindow::lazyTraceProcessing()
+{
+    return noGUIset && lazyTracesSet;
+}
+
 void AppWindow::SetupStatusBar()
 {
     ui->statusbar->addWidget(&lConnectionStatus);
@@ -1527,6 +1809,13 @@ void AppWindow::SetupStatusBar()
     auto div3 = new QFrame;
     div3->setFrameShape(QFrame::VLine);
     ui->statusbar->addWidget(div3);
+    ui->statusbar->addWidget(&lMetrics);
+    auto div4 = new QFrame;
+    div4->setFrameShape(QFrame::VLine);
+    ui->statusbar->addWidget(div4);
+    connect(&metricsTimer, &QTimer::timeout, this, &AppWindow::UpdateMetricsStatus);
+    metricsTimer.start(1000);
+    UpdateMetricsStatus();
 
     lADCOverload.setStyleSheet("color : red");
     lADCOverload.setText("ADC overload");
@@ -1545,6 +1834,32 @@ void AppWindow::SetupStatusBar()
     //ui->statusbar->setStyleSheet("QStatusBar::item { border: 1px solid black; };");
 }
 
+void AppWindow::UpdateMetricsStatus()
+{
+    auto &m = Metrics::getInstance();
+    auto value = [&](QString name) -> QString {
+        auto metric = m.find(name);
+        return metric ? metric->toString() : "0";
+    };
+    auto sweepDuration = dynamic_cast<Metrics::Histogram*>(m.find("librevna_vna_sweep_duration_seconds"));
+    auto pointRate = dynamic_cast<Metrics::Gauge*>(m.find("librevna_vna_points_per_second"));
+    QString sweep = "-";
+    if(sweepDuration && pointRate && sweepDuration->getCount() > 0) {
+        sweep = Unit::ToString(sweepDuration->getLast(), "s", "um ", 3) + ", " + Unit::ToString(pointRate->get(), "pts/s", " kM", 3);
+    }
+    lMetrics.setText("Sweep: " + sweep + " | Missed: " + value("librevna_vna_points_missed_total")
+                     + " | Queue: " + value("librevna_transmission_queue_depth"));
+    QString tooltip;
+    for(auto name : m.getNames()) {
+        auto metric = m.find(name);
+        if(!tooltip.isEmpty()) {
+            tooltip += "\n";
+        }
+        tooltip += metric->getHelp() + ": " + metric->toString();
+    }
+    lMetrics.setToolTip(tooltip);
+}
+
 void AppWindow::UpdateStatusBar(DeviceStatusBar status)
 {
     switch(status) {
@@ -10,8 +10,11 @@
 #include "preferences.h"
 #include "scpi.h"
 #include "tcpserver.h"
+#include "metricsserver.h"
 #include "streamingserver.h"
+#include "sweeprecorder.h"
 #include "Device/devicedriver.h"
+#include "Device/LibreVNA/librevnasimulator.h"
 
 #include <QWidget>
 #include <QMainWindow>
@@ -23,6 +26,7 @@
 #include <QLabel>
 #include <QCommandLineParser>
 #include <QProgressDialog>
+#include <QTimer>
 
 namespace Ui {
 class MainWindow;
@@ -50,8 +54,11 @@ public:
     const QString& getAppGitHash() const;
 
     static bool showGUI();
+    // without GUI and with --lazy-traces, traces are only updated after a trace related SCPI command has been used
+    static bool lazyTraceProcessing();
 
     SCPI* getSCPI();
+    SweepRecorder* getRecorder();
 
     enum class VNADataType {
         Raw = 0,
@@ -59,14 +66,14 @@ public:
         Deembedded = 2,
     };
 
-    void addStreamingData(const DeviceDriver::VNAMeasurement &m, VNADataType type);
+    void addStreamingData(const DeviceDriver::VNAMeasurement &m, VNADataType type, bool lastPointOfSweep);
 
     enum class SADataType {
         Raw = 0,
         Normalized = 1,
     };
 
-    void addStreamingData(const DeviceDriver::SAMeasurement &m, SADataType type);
+    void addStreamingData(const DeviceDriver::SAMeasurement &m, SADataType type, bool lastPointOfSweep);
 
 public slots:
     void setModeStatus(QString msg);
@@ -103,6 +110,7 @@ private:
     void SetupMenu();
     void SetupStatusBar();
     void UpdateStatusBar(DeviceStatusBar status);
+    void UpdateMetricsStatus();
     void CreateToolbars();
     void SetupSCPI();
     void StartTCPServer(int port);
@@ -110,6 +118,8 @@ private:
 
     // Call whenever the preferences have changed. It stores the updated preferences and applies the changes which do not take effect immediately
     void preferencesChanged();
+    // waits until the modes are not passing data to the streaming servers and the recorder from other threads
+    void flushStreamingData();
 
     QStackedWidget *central;
 
@@ -150,21 +160,28 @@ private:
 
     QLabel lModeInfo;
     QLabel lSetupName;
+    QLabel lMetrics;
+    QTimer metricsTimer;
     // Error flag labels
     QLabel lADCOverload;
     QLabel lUnlevel;
     QLabel lUnlock;
+    // asserted flags of the last FLAGS event, the event is only sent when they change
+    QString lastFlags;
 
     Ui::MainWindow *ui;
     QCommandLineParser parser;
 
     SCPI scpi;
     TCPServer *server;
+    MetricsServer *metricsServer;
     StreamingServer *streamVNARawData;
     StreamingServer *streamVNACalibratedData;
     StreamingServer *streamVNADeembeddedData;
     StreamingServer *streamSARawData;
     StreamingServer *streamSANormalizedData;
+    SweepRecorder recorder;
+    LibreVNASimulator *simulator;
 
     QString appVersion;
     QString appGitHash;
@@ -1,5 +1,7 @@
 #include "averaging.h"
 
+#include "Util/latencytracer.h"
+
 using namespace std;
 
 Averaging::Averaging()
@@ -30,6 +32,7 @@ void Averaging::setAverages(unsigned int a)
 
 DeviceDriver::VNAMeasurement Averaging::process(DeviceDriver::VNAMeasurement d)
 {
+    LATENCY_SPAN("Averaging::process", "Processing", d.pointNum);
     if(d.measurements.size() != numMeasurements) {
         numMeasurements = d.measurements.size();
         reset(avg.size());
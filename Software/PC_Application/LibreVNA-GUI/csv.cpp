@@ -1,9 +1,13 @@
 #include "csv.h"
 
+#include "Util/numberformatter.h"
+#include "Util/util.h"
+
 #include <exception>
 #include <fstream>
+#include <cstring>
 #include <QStringList>
-#include <iomanip>
+#include <QFile>
 
 using namespace std;
 
@@ -15,38 +19,98 @@ CSV::CSV()
 CSV CSV::fromFile(QString filename, char sep)
 {
     CSV csv;
-    ifstream file;
-    file.open(filename.toStdString());
-    if(!file.is_open()) {
+    QFile file(filename);
+    if(!file.open(QIODevice::ReadOnly)) {
         throw runtime_error("Unable to open file:"+filename.toStdString());
     }
-    string line;
-    bool firstLine = true;
-    while(getline(file, line)) {
-        auto qline = QString::fromStdString(line);
-        auto stringList = qline.split(sep);
-        if(firstLine) {
-            // create columns and set headers
-            for(auto l : stringList) {
-                if(l.isEmpty()) {
-                    // header needs to be present, abort here
-                    break;
-                }
-                Column c;
-                c.header = l;
-                csv._columns.push_back(c);
+    // map the file into memory if possible, read it otherwise (e.g. empty file)
+    QByteArray contents;
+    const char *begin = nullptr;
+    qint64 size = file.size();
+    auto mapped = size > 0 ? file.map(0, size) : nullptr;
+    if(mapped) {
+        begin = (const char*) mapped;
+    } else {
+        contents = file.readAll();
+        begin = contents.constData();
+        size = contents.size();
+    }
+    const char *end = begin + size;
+    const char *pos = begin;
+
+    auto findLineEnd = [end](const char *pos) -> const char* {
+        auto lineEnd = (const char*) memchr(pos, '\n', end - pos);
+        return lineEnd ? lineEnd : end;
+    };
+
+    if(pos < end) {
+        // create columns and set headers
+        auto lineEnd = findLineEnd(pos);
+        auto headerEnd = lineEnd;
+        if(headerEnd > pos && headerEnd[-1] == '\r') {
+            headerEnd--;
+        }
+        while(true) {
+            auto cellEnd = (const char*) memchr(pos, sep, headerEnd - pos);
+            if(!cellEnd) {
+                cellEnd = headerEnd;
+            }
+            if(cellEnd == pos) {
+                // header needs to be present, abort here
+                break;
+            }
+            Column c;
+            c.header = QString::fromUtf8(pos, cellEnd - pos);
+            csv._columns.push_back(c);
+            if(cellEnd == headerEnd) {
+                break;
             }
-            firstLine = false;
-        } else {
-            // not the header, attempt to parse data
-            for(unsigned int i=0;i < csv._columns.size();i++) {
-                double value = 0.0;
-                if(i < (unsigned int) stringList.size()) {
-                    value = stringList[i].toDouble();
+            pos = cellEnd + 1;
+        }
+        pos = lineEnd < end ? lineEnd + 1 : end;
+    }
+
+    bool reserved = false;
+    while(pos < end) {
+        // not the header, attempt to parse data
+        auto lineEnd = findLineEnd(pos);
+        auto nextLine = lineEnd < end ? lineEnd + 1 : end;
+        if(!reserved) {
+            // estimate the number of rows from the length of the first one
+            auto rows = (end - pos) / (nextLine - pos) + 1;
+            for(auto &c : csv._columns) {
+                c.data.reserve(rows);
+            }
+            reserved = true;
+        }
+        bool lineComplete = false;
+        for(auto &c : csv._columns) {
+            double value = 0.0;
+            if(!lineComplete) {
+                auto cellEnd = (const char*) memchr(pos, sep, lineEnd - pos);
+                if(!cellEnd) {
+                    cellEnd = lineEnd;
+                    lineComplete = true;
+                }
+                // the cell must contain nothing but the number (and whitespace), otherwise it is treated as 0
+                auto p = pos;
+                if(Util::parseDouble(p, cellEnd, value)) {
+                    while(p < cellEnd && Util::isWhitespace(*p)) {
+                        p++;
+                    }
+                    if(p != cellEnd) {
+                        value = 0.0;
+                    }
+                } else {
+                    value = 0.0;
+                }
+                if(!lineComplete) {
+                    pos = cellEnd + 1;
                 }
-                csv._columns[i].data.push_back(value);
             }
+            c.data.push_back(value);
         }
+        pos = nextLine;
     }
     csv.filename = filename;
     return csv;
@@ -59,31 +123,39 @@ void CSV::toFile(QString filename, char sep)
         filename.append(".csv");
     }
     file.open(filename.toStdString());
-    file << setprecision(10);
     unsigned maxlen = 0;
-    for(auto c : _columns) {
-        file << c.header.toStdString();
-        file << sep;
+    NumberFormatter text;
+    for(auto &c : _columns) {
+        text.add(c.header).add(sep);
         if(c.data.size() > maxlen) {
             maxlen = c.data.size();
         }
     }
-    file << endl;
+    text.add('\n');
+    file.write(text.data().data(), text.size());
+    // write in chunks of rows to limit the buffer size for large files
+    constexpr unsigned int rowsPerChunk = 1000;
     for(unsigned int i=0;i<maxlen;i++) {
-        for(auto c : _columns) {
+        if(i % rowsPerChunk == 0) {
+            text.clear();
+        }
+        for(auto &c : _columns) {
             if(i < c.data.size()) {
-                file << c.data[i] << sep;
+                text.add(c.data[i], 10).add(sep);
             }
         }
-        file << endl;
+        text.add('\n');
+        if(i % rowsPerChunk == rowsPerChunk - 1 || i == maxlen - 1) {
+            file.write(text.data().data(), text.size());
+        }
     }
     file.close();
     this->filename = filename;
 }
 
-std::vector<double> CSV::getColumn(QString header)
+const std::vector<double> &CSV::getColumn(QString header)
 {
-    for(auto c : _columns) {
+    for(auto &c : _columns) {
         if(c.header == header) {
             return c.data;
         }
@@ -91,7 +163,7 @@ std::vector<double> CSV::getColumn(QString header)
     throw runtime_error("Header name not found");
 }
 
-std::vector<double> CSV::getColumn(unsigned int index)
+const std::vector<double> &CSV::getColumn(unsigned int index)
 {
     return _columns.at(index).data;
 }
@@ -101,12 +173,12 @@ QString CSV::getHeader(unsigned int index)
     return _columns.at(index).header;
 }
 
-void CSV::addColumn(QString name, const std::vector<double> &data)
+void CSV::addColumn(QString name, std::vector<double> data)
 {
     Column c;
     c.header = name;
-    c.data = data;
-    _columns.push_back(c);
+    c.data = std::move(data);
+    _columns.push_back(std::move(c));
 }
 
 QString CSV::getFilename() const
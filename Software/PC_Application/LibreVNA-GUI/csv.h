@@ -4,6 +4,8 @@
 #include <QString>
 #include <vector>
 
+// CSV file with a header line and numerical data. Reading maps the file into memory and parses it in a single pass,
+// writing formats the data in chunks of rows
 class CSV
 {
 public:
@@ -12,12 +14,12 @@ public:
     static CSV fromFile(QString filename, char sep = ',');
 
     void toFile(QString filename, char sep = ',');
-    std::vector<double> getColumn(QString header);
-    std::vector<double> getColumn(unsigned int index);
+    const std::vector<double> &getColumn(QString header);
+    const std::vector<double> &getColumn(unsigned int index);
     QString getHeader(unsigned int index);
     unsigned int columns() { return _columns.size();}
 
-    void addColumn(QString name, const std::vector<double> &data);
+    void addColumn(QString name, std::vector<double> data);
 
     QString getFilename() const;
     void setFilename(const QString &value);
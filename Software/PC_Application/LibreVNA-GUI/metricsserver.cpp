@@ -0,0 +1,47 @@
+#include "metricsserver.h"
+
+#include "Util/metrics.h"
+
+#include <QTimer>
+#include <QDebug>
+
+MetricsServer::MetricsServer(int port)
+{
+    this->port = port;
+    if(server.listen(QHostAddress::LocalHost, port)) {
+        qInfo() << "Metrics server listening on port" << port;
+    } else {
+        qWarning() << "Metrics server failed to listen on port" << port << ":" << server.errorString();
+    }
+    connect(&server, &QTcpServer::newConnection, [=](){
+        while(server.hasPendingConnections()) {
+            auto socket = server.nextPendingConnection();
+            connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+            connect(socket, &QTcpSocket::readyRead, socket, [=](){
+                if(socket->canReadLine()) {
+                    reply(socket, socket->readLine().startsWith("GET "));
+                }
+            });
+            QTimer::singleShot(requestTimeout, socket, [=](){
+                reply(socket, false);
+            });
+        }
+    });
+}
+
+void MetricsServer::reply(QTcpSocket *socket, bool http)
+{
+    if(socket->property("answered").toBool()) {
+        return;
+    }
+    socket->setProperty("answered", true);
+    auto text = Metrics::getInstance().toText().toUtf8();
+    if(http) {
+        socket->write("HTTP/1.0 200 OK\r\n"
+                      "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                      "Content-Length: " + QByteArray::number(text.size()) + "\r\n"
+                      "Connection: close\r\n\r\n");
+    }
+    socket->write(text);
+    socket->disconnectFromHost();
+}
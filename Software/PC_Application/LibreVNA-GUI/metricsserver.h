@@ -0,0 +1,28 @@
+#ifndef METRICSSERVER_H
+#define METRICSSERVER_H
+
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+
+// Answers every connection on the local interface with the current metrics (see Metrics::toText) and closes it.
+// HTTP GET requests get a HTTP response (e.g. for scraping by Prometheus), clients that do not send anything
+// receive the plain text after a short delay
+class MetricsServer : public QObject
+{
+    Q_OBJECT
+public:
+    MetricsServer(int port);
+
+    int getPort() {return port;}
+
+private:
+    void reply(QTcpSocket *socket, bool http);
+
+    static constexpr int requestTimeout = 200;
+
+    int port;
+    QTcpServer server;
+};
+
+#endif // METRICSSERVER_H
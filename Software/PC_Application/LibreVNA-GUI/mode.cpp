@@ -19,6 +19,7 @@ Mode::Mode(AppWindow *window, QString name, QString SCPIname)
     : QObject(window),
       SCPINode(SCPIname),
       isActive(false),
+      traceProcessing(false),
       window(window),
       name(name),
       central(nullptr)
@@ -176,6 +177,11 @@ void Mode::finalize(QWidget *centralWidget)
     }
 }
 
+bool Mode::traceProcessingEnabled()
+{
+    return traceProcessing || !AppWindow::lazyTraceProcessing();
+}
+
 void Mode::setStatusbarMessage(QString msg)
 {
     statusbarMsg = msg;
@@ -49,6 +49,10 @@ public:
     virtual QList<QAction*> getImportOptions() { return {};}
     virtual QList<QAction*> getExportOptions() { return {};}
 
+    // Called before the streaming servers or the recorder are changed. Modes which pass data to them from another
+    // thread must wait until all data handed to that thread has been passed on
+    virtual void flushStreamingData() {}
+
 signals:
     void statusbarMessage(QString msg);
 public slots:
@@ -60,6 +64,12 @@ protected:
     virtual void deactivate(); // derived classes must call Mode::deactivate before returning
     bool isActive;
 
+    // Traces, markers and plots only need to be updated if this returns true. Always the case unless started
+    // with --lazy-traces, then only after a trace related SCPI command has been used (see enableTraceProcessing())
+    bool traceProcessingEnabled();
+    void enableTraceProcessing() {traceProcessing = true;}
+    bool traceProcessing;
+
     void setStatusbarMessage(QString msg);
     // call once the derived class is fully initialized
     void finalize(QWidget *centralWidget);
@@ -136,6 +136,10 @@ PreferencesDialog::PreferencesDialog(Preferences *pref, QWidget *parent) :
          ui->MarkerShowP1dB->setEnabled(enabled);
     });
 
+    // Streaming servers page
+    ui->streamingServerQueueSize->setUnit("B");
+    ui->streamingServerQueueSize->setPrefixes(" kMG");
+
     // Debug page
     ui->DebugMaxUSBlogSize->setUnit("B");
     ui->DebugMaxUSBlogSize->setPrefixes(" kMG");
@@ -281,6 +285,9 @@ void PreferencesDialog::setInitialGUIState()
     ui->GraphsFontSizeTraceNames->setValue(p->Graphs.fontSizeTraceNames);
     ui->GraphsEnablePanZoom->setChecked(p->Graphs.enablePanAndZoom);
     ui->GraphsZoomFactor->setValue(p->Graphs.zoomFactor);
+    ui->GraphsTargetFPS->setValue(p->Graphs.targetFPS);
+    ui->GraphsAdaptiveFrameRate->setChecked(p->Graphs.adaptiveFrameRate);
+    ui->GraphsShowRenderTimes->setChecked(p->Graphs.showRenderTimes);
     ui->GraphsSweepTriangle->setChecked(p->Graphs.SweepIndicator.triangle);
     ui->GraphsSweepTriangleSize->setValue(p->Graphs.SweepIndicator.triangleSize);
     ui->GraphsSweepLine->setChecked(p->Graphs.SweepIndicator.line);
@@ -320,6 +327,8 @@ void PreferencesDialog::setInitialGUIState()
 
     ui->SCPIServerEnabled->setChecked(p->SCPIServer.enabled);
     ui->SCPIServerPort->setValue(p->SCPIServer.port);
+    ui->MetricsServerEnabled->setChecked(p->MetricsServer.enabled);
+    ui->MetricsServerPort->setValue(p->MetricsServer.port);
 
     ui->streamingServerVNArawEnabled->setChecked(p->StreamingServers.VNARawData.enabled);
     ui->streamingServerVNArawPort->setValue(p->StreamingServers.VNARawData.port);
@@ -331,7 +340,11 @@ void PreferencesDialog::setInitialGUIState()
     ui->streamingServerSArawPort->setValue(p->StreamingServers.SARawData.port);
     ui->streamingServerSAnormalizedEnabled->setChecked(p->StreamingServers.SANormalizedData.enabled);
     ui->streamingServerSAnormalizedPort->setValue(p->StreamingServers.SANormalizedData.port);
+    ui->streamingServerQueueSize->setValue(p->StreamingServers.queueSize);
+    ui->streamingServerDropPolicy->setCurrentIndex((int) p->StreamingServers.dropPolicy);
 
+    ui->DebugUSBlogEnabled->setChecked(p->Debug.USBlogEnabled);
+    ui->DebugUSBlogMeasurementData->setChecked(p->Debug.USBlogMeasurementData);
     ui->DebugMaxUSBlogSize->setValue(p->Debug.USBlogSizeLimit);
     ui->DebugSaveTraceData->setChecked(p->Debug.saveTraceData);
 
@@ -394,6 +407,9 @@ void PreferencesDialog::updateFromGUI()
     p->Graphs.fontSizeTraceNames = ui->GraphsFontSizeTraceNames->value();
     p->Graphs.enablePanAndZoom = ui->GraphsEnablePanZoom->isChecked();
     p->Graphs.zoomFactor = ui->GraphsZoomFactor->value();
+    p->Graphs.targetFPS = ui->GraphsTargetFPS->value();
+    p->Graphs.adaptiveFrameRate = ui->GraphsAdaptiveFrameRate->isChecked();
+    p->Graphs.showRenderTimes = ui->GraphsShowRenderTimes->isChecked();
     p->Graphs.SweepIndicator.triangle = ui->GraphsSweepTriangle->isChecked();
     p->Graphs.SweepIndicator.triangleSize = ui->GraphsSweepTriangleSize->value();
     p->Graphs.SweepIndicator.line = ui->GraphsSweepLine->isChecked();
@@ -432,6 +448,8 @@ void PreferencesDialog::updateFromGUI()
 
     p->SCPIServer.enabled = ui->SCPIServerEnabled->isChecked();
     p->SCPIServer.port = ui->SCPIServerPort->value();
+    p->MetricsServer.enabled = ui->MetricsServerEnabled->isChecked();
+    p->MetricsServer.port = ui->MetricsServerPort->value();
 
     p->StreamingServers.VNARawData.enabled = ui->streamingServerVNArawEnabled->isChecked();
     p->StreamingServers.VNARawData.port = ui->streamingServerVNArawPort->value();
@@ -443,7 +461,11 @@ void PreferencesDialog::updateFromGUI()
     p->StreamingServers.SARawData.port = ui->streamingServerSArawPort->value();
     p->StreamingServers.SANormalizedData.enabled = ui->streamingServerSAnormalizedEnabled->isChecked();
     p->StreamingServers.SANormalizedData.port = ui->streamingServerSAnormalizedPort->value();
+    p->StreamingServers.queueSize = ui->streamingServerQueueSize->value();
+    p->StreamingServers.dropPolicy = (StreamingDropPolicy) ui->streamingServerDropPolicy->currentIndex();
 
+    p->Debug.USBlogEnabled = ui->DebugUSBlogEnabled->isChecked();
+    p->Debug.USBlogMeasurementData = ui->DebugUSBlogMeasurementData->isChecked();
     p->Debug.USBlogSizeLimit = ui->DebugMaxUSBlogSize->value();
     p->Debug.saveTraceData = ui->DebugSaveTraceData->isChecked();
 
@@ -42,6 +42,14 @@ enum MarkerSymbolStyle {
 
 Q_DECLARE_METATYPE(MarkerSymbolStyle);
 
+enum StreamingDropPolicy {
+    StreamingDropOldest = 0,
+    StreamingDropSweeps = 1,
+    StreamingDisconnect = 2,
+};
+
+Q_DECLARE_METATYPE(StreamingDropPolicy);
+
 
 class Preferences : public Savable {
     friend class PreferencesDialog;
@@ -136,6 +144,10 @@ public:
         bool enablePanAndZoom;
         double zoomFactor;
 
+        int targetFPS;
+        bool adaptiveFrameRate;
+        bool showRenderTimes;
+
         bool enableMasterTicksForYAxis;
 
         struct {
@@ -165,6 +177,10 @@ public:
         bool enabled;
         int port;
     } SCPIServer;
+    struct {
+        bool enabled;
+        int port;
+    } MetricsServer;
     struct {
         struct {
             bool enabled;
@@ -186,8 +202,12 @@ public:
             bool enabled;
             int port;
         } SANormalizedData;
+        double queueSize;
+        StreamingDropPolicy dropPolicy;
     } StreamingServers;
     struct {
+        bool USBlogEnabled;
+        bool USBlogMeasurementData;
         double USBlogSizeLimit;
         bool saveTraceData;
     } Debug;
@@ -260,6 +280,9 @@ private:
         {&Graphs.fontSizeTraceNames, "Graphs.fontSizeTraceNames", 12},
         {&Graphs.enablePanAndZoom, "Graphs.enablePanAndZoom", true},
         {&Graphs.zoomFactor, "Graphs.zoomFactor", 0.9},
+        {&Graphs.targetFPS, "Graphs.targetFPS", 10},
+        {&Graphs.adaptiveFrameRate, "Graphs.adaptiveFrameRate", true},
+        {&Graphs.showRenderTimes, "Graphs.showRenderTimes", false},
         {&Graphs.enableMasterTicksForYAxis, "Graphs.enableMasterTicksForYAxis", false},
         {&Graphs.SweepIndicator.triangle, "Graphs.SweepIndicator.triangle", true},
         {&Graphs.SweepIndicator.triangleSize, "Graphs.SweepIndicator.triangleSize", 5},
@@ -298,6 +321,8 @@ private:
         {&Marker.symbolStyle, "Marker.symbolStyle", MarkerSymbolStyle::EmptyNumberAbove},
         {&SCPIServer.enabled, "SCPIServer.enabled", true},
         {&SCPIServer.port, "SCPIServer.port", 19542},
+        {&MetricsServer.enabled, "MetricsServer.enabled", false},
+        {&MetricsServer.port, "MetricsServer.port", 19543},
         {&StreamingServers.VNARawData.enabled, "StreamingServers.VNARawData.enabled", false},
         {&StreamingServers.VNARawData.port, "StreamingServers.VNARawData.port", 19000},
         {&StreamingServers.VNACalibratedData.enabled, "StreamingServers.VNACalibratedData.enabled", false},
@@ -308,6 +333,10 @@ private:
         {&StreamingServers.SARawData.port, "StreamingServers.sARawData.port", 19100},
         {&StreamingServers.SANormalizedData.enabled, "StreamingServers.SANormalizedData.enabled", false},
         {&StreamingServers.SANormalizedData.port, "StreamingServers.SANormalizedData.port", 19101},
+        {&StreamingServers.queueSize, "StreamingServers.queueSize", 4000000.0},
+        {&StreamingServers.dropPolicy, "StreamingServers.dropPolicy", StreamingDropPolicy::StreamingDropOldest},
+        {&Debug.USBlogEnabled, "Debug.USBlogEnabled", true},
+        {&Debug.USBlogMeasurementData, "Debug.USBlogMeasurementData", true},
         {&Debug.USBlogSizeLimit, "Debug.USBlogSizeLimit", 10000000.0},
         {&Debug.saveTraceData, "Debug.saveTraceData", false},
     }};
@@ -1,21 +1,35 @@
 #include "scpi.h"
 
 #include <QDebug>
+#include <QtEndian>
+#include <QDateTime>
+#include <cstring>
+#include <algorithm>
 
-SCPI::SCPI() :
-    SCPINode("")
+SCPI::Connection::Connection()
 {
     WAIexecuting = false;
+    responseDeferred = false;
+    blockPending = false;
     OPCsetBitScheduled = false;
     OPCQueryScheduled = false;
     OCAS = false;
     SESR = 0x00;
     ESE = 0xFF;
+    dataFormat = DataFormat::ASCII;
+    swappedByteOrder = false;
+}
+
+SCPI::SCPI() :
+    SCPINode("")
+{
+    current = 0;
+    eventSequence = 0;
 
     add(new SCPICommand("*CLS", [=](QStringList) {
-        SESR = 0x00;
-        OCAS = false;
-        OPCQueryScheduled = false;
+        state().SESR = 0x00;
+        state().OCAS = false;
+        state().OPCQueryScheduled = false;
         return SCPI::getResultName(SCPI::Result::Empty);
     }, nullptr));
 
@@ -24,24 +38,24 @@ SCPI::SCPI() :
         if(!SCPI::paramToULongLong(params, 0, newval) || newval >= 256) {
             return SCPI::getResultName(SCPI::Result::Error);
         } else {
-            ESE = newval;
+            state().ESE = newval;
             return SCPI::getResultName(SCPI::Result::Empty);
         }
     }, [=](QStringList){
-        return QString::number(ESE);
+        return QString::number(state().ESE);
     }));
 
     add(new SCPICommand("*ESR", nullptr, [=](QStringList){
-        auto ret = QString::number(SESR);
-        SESR = 0x00;
+        auto ret = QString::number(state().SESR);
+        state().SESR = 0x00;
         return ret;
     }));
 
     add(new SCPICommand("*OPC", [=](QStringList){
         // OPC command
         if(isOperationPending()) {
-            OPCsetBitScheduled = true;
-            OCAS = true;
+            state().OPCsetBitScheduled = true;
+            state().OCAS = true;
         } else {
             // operation already complete
             setFlag(Flag::OPC);
@@ -51,12 +65,12 @@ SCPI::SCPI() :
         // OPC query
         if(isOperationPending()) {
             // operation pending
-            OPCQueryScheduled = true;
-            OCAS = true;
+            state().OPCQueryScheduled = true;
+            state().OCAS = true;
             return SCPI::getResultName(SCPI::Result::Empty);
         } else {
             // no operation, can return immediately
-            OCAS = false;
+            state().OCAS = false;
             return "1";
         }
     }));
@@ -64,7 +78,7 @@ SCPI::SCPI() :
     add(new SCPICommand("*WAI", [=](QStringList){
         // WAI command
         if(isOperationPending()) {
-            WAIexecuting = true;
+            state().WAIexecuting = true;
         }
         return SCPI::getResultName(SCPI::Result::Empty);
     }, nullptr));
@@ -74,6 +88,90 @@ SCPI::SCPI() :
         createCommandList("", list);
         return list.trimmed();
     }));
+
+    auto format = new SCPINode("FORMat");
+    add(format);
+    format->add(new SCPICommand("DATA", [=](QStringList params) -> QString {
+        if(params.size() != 1) {
+            return SCPI::getResultName(SCPI::Result::Error);
+        }
+        auto p = params[0].split(",");
+        if(p.size() == 1 && match("ASCii", p[0])) {
+            state().dataFormat = DataFormat::ASCII;
+        } else if(p.size() == 1 && p[0] == "REAL") {
+            state().dataFormat = DataFormat::Real64;
+        } else if(p.size() == 2 && p[0] == "REAL" && p[1] == "32") {
+            state().dataFormat = DataFormat::Real32;
+        } else if(p.size() == 2 && p[0] == "REAL" && p[1] == "64") {
+            state().dataFormat = DataFormat::Real64;
+        } else {
+            return SCPI::getResultName(SCPI::Result::Error);
+        }
+        return SCPI::getResultName(SCPI::Result::Empty);
+    }, [=](QStringList) -> QString {
+        switch(state().dataFormat) {
+        case DataFormat::ASCII: return "ASCII";
+        case DataFormat::Real32: return "REAL,32";
+        case DataFormat::Real64: return "REAL,64";
+        }
+        return SCPI::getResultName(SCPI::Result::Error);
+    }));
+    format->add(new SCPICommand("BORDer", [=](QStringList params) -> QString {
+        if(params.size() != 1) {
+            return SCPI::getResultName(SCPI::Result::Error);
+        }
+        if(match("NORMal", params[0])) {
+            state().swappedByteOrder = false;
+        } else if(match("SWAPped", params[0])) {
+            state().swappedByteOrder = true;
+        } else {
+            return SCPI::getResultName(SCPI::Result::Error);
+        }
+        return SCPI::getResultName(SCPI::Result::Empty);
+    }, [=](QStringList) -> QString {
+        return state().swappedByteOrder ? "SWAPPED" : "NORMAL";
+    }));
+
+    auto event = new SCPINode("EVENt");
+    add(event);
+    event->add(new SCPICommand("SUBScribe", [=](QStringList params) -> QString {
+        if(params.isEmpty()) {
+            // subscribe to all events
+            params = QStringList(events.begin(), events.end());
+        }
+        for(auto p : params) {
+            if(std::find(events.begin(), events.end(), p) == events.end()) {
+                return SCPI::getResultName(SCPI::Result::Error);
+            }
+        }
+        for(auto p : params) {
+            state().subscriptions.insert(p);
+        }
+        return SCPI::getResultName(SCPI::Result::Empty);
+    }, [=](QStringList) -> QString {
+        if(state().subscriptions.empty()) {
+            return "NONE";
+        }
+        QStringList ret;
+        for(auto e : events) {
+            if(state().subscriptions.count(e)) {
+                ret.append(e);
+            }
+        }
+        return ret.join(",");
+    }));
+    event->add(new SCPICommand("UNSUBscribe", [=](QStringList params) -> QString {
+        if(params.isEmpty()) {
+            state().subscriptions.clear();
+        }
+        for(auto p : params) {
+            state().subscriptions.erase(p);
+        }
+        return SCPI::getResultName(SCPI::Result::Empty);
+    }, nullptr));
+    event->add(new SCPICommand("LIST", nullptr, [=](QStringList) -> QString {
+        return QStringList(events.begin(), events.end()).join(",");
+    }));
 }
 
 bool SCPI::match(QString s1, QString s2)
@@ -175,64 +273,215 @@ QString SCPI::getResultName(SCPI::Result r)
     }
 }
 
-void SCPI::input(QString line)
+QString SCPI::createBlock(const std::vector<double> &values)
+{
+    auto swappedByteOrder = state().swappedByteOrder;
+    QByteArray data;
+    if(state().dataFormat == DataFormat::Real32) {
+        data.resize(values.size() * sizeof(float));
+        auto dst = (uchar*) data.data();
+        for(auto v : values) {
+            float f = v;
+            quint32 u;
+            memcpy(&u, &f, sizeof(u));
+            if(swappedByteOrder) {
+                qToLittleEndian(u, dst);
+            } else {
+                qToBigEndian(u, dst);
+            }
+            dst += sizeof(u);
+        }
+    } else {
+        data.resize(values.size() * sizeof(double));
+        auto dst = (uchar*) data.data();
+        for(auto v : values) {
+            quint64 u;
+            memcpy(&u, &v, sizeof(u));
+            if(swappedByteOrder) {
+                qToLittleEndian(u, dst);
+            } else {
+                qToBigEndian(u, dst);
+            }
+            dst += sizeof(u);
+        }
+    }
+    return createBlock(data);
+}
+
+QString SCPI::createBlock(const QByteArray &data)
 {
-    cmdQueue.append(line);
+    auto length = QByteArray::number(data.size());
+    auto &c = state();
+    c.block = "#" + QByteArray::number(length.size()) + length + data + '\n';
+    c.blockPending = true;
+    return getResultName(Result::Empty);
+}
+
+SCPI::Connection &SCPI::state()
+{
+    auto it = connections.find(current);
+    if(it == connections.end()) {
+        closedConnection = Connection();
+        return closedConnection;
+    }
+    return it->second;
+}
+
+void SCPI::input(QString line, unsigned int connection)
+{
+    connections[connection].cmdQueue.append(line);
     process();
 }
 
+void SCPI::removeConnection(unsigned int connection)
+{
+    connections.erase(connection);
+}
+
 void SCPI::process()
 {
-    while(!WAIexecuting && !cmdQueue.isEmpty()) {
-        auto cmd = cmdQueue.front();
-        cmdQueue.pop_front();
-        auto cmds = cmd.split(";");
-        SCPINode *lastNode = this;
-        for(auto cmd : cmds) {
-            if(cmd.size() > 0) {
-                if(cmd[0] == ':' || cmd[0] == '*') {
-                    // reset to root node
-                    lastNode = this;
-                }
-                if(cmd[0] == ':') {
-                    cmd.remove(0, 1);
-                }
-                auto response = lastNode->parse(cmd, lastNode);
-                if(response == getResultName(Result::Error)) {
-                    setFlag(Flag::CME);
-                } else if(response == getResultName(Result::QueryError)) {
-                    setFlag(Flag::CME);
-                } else if(response == getResultName(Result::CmdError)) {
-                    setFlag(Flag::CME);
-                } else if(response == getResultName(Result::ExecError)) {
-                    setFlag(Flag::EXE);
-                } else if(response == getResultName(Result::Empty)) {
-                    // do nothing
-                } else {
-                    emit output(response);
-                }
+    bool executed = true;
+    while(executed) {
+        executed = false;
+        // Execute one line per connection and round. The connections may change while a command is executed,
+        // work on a copy of the IDs
+        std::vector<unsigned int> ids;
+        for(auto const &c : connections) {
+            ids.push_back(c.first);
+        }
+        for(auto id : ids) {
+            auto it = connections.find(id);
+            if(it == connections.end() || it->second.WAIexecuting || it->second.responseDeferred || it->second.cmdQueue.isEmpty()) {
+                continue;
             }
+            auto line = it->second.cmdQueue.front();
+            it->second.cmdQueue.pop_front();
+            execute(line, id);
+            executed = true;
         }
     }
 }
 
+void SCPI::execute(QString line, unsigned int connection)
+{
+    current = connection;
+    auto cmds = line.split(";");
+    SCPINode *lastNode = this;
+    for(auto cmd : cmds) {
+        if(cmd.size() > 0) {
+            if(cmd[0] == ':' || cmd[0] == '*') {
+                // reset to root node
+                lastNode = this;
+            }
+            if(cmd[0] == ':') {
+                cmd.remove(0, 1);
+            }
+            auto response = lastNode->parse(cmd, lastNode);
+            // the command may have processed events (and thus input from other connections), restore the context
+            current = connection;
+            if(!connections.count(connection)) {
+                // closed while the command was executed, nobody is left to receive the response
+                return;
+            }
+            respond(response);
+        }
+    }
+}
+
+void SCPI::respond(QString response)
+{
+    auto &c = state();
+    if(c.blockPending) {
+        c.blockPending = false;
+        auto block = c.block;
+        c.block.clear();
+        if(response == getResultName(Result::Empty)) {
+            emit outputBlock(block, current);
+            return;
+        }
+        // the query failed after creating the block, the block is dropped and the result handled as usual
+    }
+    if(response == getResultName(Result::Error)) {
+        setFlag(Flag::CME);
+    } else if(response == getResultName(Result::QueryError)) {
+        setFlag(Flag::CME);
+    } else if(response == getResultName(Result::CmdError)) {
+        setFlag(Flag::CME);
+    } else if(response == getResultName(Result::ExecError)) {
+        setFlag(Flag::EXE);
+    } else if(response == getResultName(Result::Empty)) {
+        // do nothing
+    } else {
+        emit output(response, current);
+    }
+}
+
+void SCPI::addEvent(QString name)
+{
+    if(std::find(events.begin(), events.end(), name) == events.end()) {
+        events.push_back(name);
+    }
+}
+
+void SCPI::notify(QString event, QString info)
+{
+    auto line = "EVENT " + QString::number(++eventSequence) + "," + QString::number(QDateTime::currentMSecsSinceEpoch()) + "," + event;
+    if(!info.isEmpty()) {
+        line += "," + info;
+    }
+    for(auto &c : connections) {
+        if(c.second.subscriptions.count(event)) {
+            emit output(line, c.first);
+        }
+    }
+}
+
+unsigned int SCPI::deferResponse()
+{
+    state().responseDeferred = true;
+    return current;
+}
+
+void SCPI::deferredResponse(unsigned int connection, std::function<QString ()> createResponse)
+{
+    auto it = connections.find(connection);
+    if(it == connections.end() || !it->second.responseDeferred) {
+        // connection has been closed in the meantime
+        return;
+    }
+    auto previous = current;
+    current = connection;
+    respond(createResponse());
+    state().responseDeferred = false;
+    current = previous;
+    // continue with the commands received while waiting for the response
+    process();
+}
+
 void SCPI::someOperationCompleted()
 {
     if(!isOperationPending()) {
         // all operations are complete
-        if(OCAS) {
-            OCAS = false;
-            if(OPCsetBitScheduled) {
-                setFlag(Flag::OPC);
-                OPCsetBitScheduled = false;
+        bool resume = false;
+        for(auto &c : connections) {
+            auto &s = c.second;
+            if(s.OCAS) {
+                s.OCAS = false;
+                if(s.OPCsetBitScheduled) {
+                    s.SESR |= (int) Flag::OPC;
+                    s.OPCsetBitScheduled = false;
+                }
+                if(s.OPCQueryScheduled) {
+                    emit output("1", c.first);
+                    s.OPCQueryScheduled = false;
+                }
             }
-            if(OPCQueryScheduled) {
-                output("1");
-                OPCQueryScheduled = false;
+            if(s.WAIexecuting) {
+                s.WAIexecuting = false;
+                resume = true;
             }
         }
-        if(WAIexecuting) {
-            WAIexecuting = false;
+        if(resume) {
             // process any queued commands
             process();
         }
@@ -241,17 +490,17 @@ void SCPI::someOperationCompleted()
 
 void SCPI::setFlag(Flag flag)
 {
-    SESR |= ((int) flag);
+    state().SESR |= ((int) flag);
 }
 
 void SCPI::clearFlag(Flag flag)
 {
-    SESR &= ~((int) flag);
+    state().SESR &= ~((int) flag);
 }
 
 bool SCPI::getFlag(Flag flag)
 {
-    return SESR & (int) flag;
+    return state().SESR & (int) flag;
 }
 
 SCPINode::~SCPINode()
@@ -270,6 +519,15 @@ SCPINode::~SCPINode()
     }
 }
 
+SCPI *SCPINode::getRoot()
+{
+    auto node = this;
+    while(node->parent) {
+        node = node->parent;
+    }
+    return dynamic_cast<SCPI*>(node);
+}
+
 bool SCPINode::add(SCPINode *node)
 {
     if(nameCollision(node->name)) {
@@ -278,6 +536,7 @@ bool SCPINode::add(SCPINode *node)
     }
     subnodes.push_back(node);
     node->parent = this;
+    addToIndex(node->name, node, nullptr);
     return true;
 }
 
@@ -286,6 +545,7 @@ bool SCPINode::remove(SCPINode *node)
     auto it = std::find(subnodes.begin(), subnodes.end(), node);
     if(it != subnodes.end()) {
         subnodes.erase(it);
+        removeFromIndex(node);
         node->parent = nullptr;
         return true;
     } else {
@@ -300,6 +560,7 @@ bool SCPINode::add(SCPICommand *cmd)
         return false;
     }
     commands.push_back(cmd);
+    addToIndex(cmd->name(), nullptr, cmd);
     return true;
 }
 
@@ -372,6 +633,8 @@ bool SCPINode::changeName(QString newname)
             // new name would result in a collision
             return false;
         }
+        parent->removeFromIndex(this);
+        parent->addToIndex(newname, this, nullptr);
     }
     name = newname;
     return true;
@@ -437,53 +700,97 @@ void SCPINode::createCommandList(QString prefix, QString &list)
     }
 }
 
-QString SCPINode::parse(QString cmd, SCPINode* &lastNode)
+QString SCPINode::parse(QStringView cmd, SCPINode* &lastNode)
 {
     if(cmd.isEmpty()) {
         return "";
     }
-    auto cmdName = cmd.split(" ").front();
-    auto splitPos = cmdName.indexOf(':');
-    if(splitPos > 0) {
-        // have not reached a leaf, find next subnode
-        auto subnode = cmd.left(splitPos);
-        for(auto n : subnodes) {
-            if(SCPI::match(n->name, subnode.toUpper())) {
-                // pass on to next level
-                return n->parse(cmd.right(cmd.size() - splitPos - 1), lastNode);
-            }
-        }
-        // unable to find subnode
-        return SCPI::getResultName(SCPI::Result::Error);
-    } else {
-        // no more levels, search for command
-        auto params = cmd.split(" ");
-        auto cmd = params.front();
-        params.pop_front();
-        bool isQuery = false;
-        if (cmd[cmd.size()-1]=='?') {
-            isQuery = true;
-            cmd.chop(1);
-        }
-        for(auto c : commands) {
-            if(SCPI::match(c->name(), cmd.toUpper())) {
-                // save current node in case of non-root for the next command
-                lastNode = this;
-                if(c->convertToUppercase()) {
-                    for(auto &p : params) {
-                        p = p.toUpper();
-                    }
-                }
-                if(isQuery) {
-                    return c->query(params);
-                } else {
-                    return c->execute(params);
-                }
-            }
+    auto paramStart = cmd.indexOf(' ');
+    auto header = paramStart >= 0 ? cmd.left(paramStart) : cmd;
+    // find the node, one level per colon
+    SCPINode *node = this;
+    qsizetype splitPos;
+    while((splitPos = header.indexOf(':')) > 0) {
+        auto entry = node->find(header.left(splitPos));
+        if(!entry || !entry->node) {
+            // unable to find subnode
+            return SCPI::getResultName(SCPI::Result::Error);
         }
+        node = entry->node;
+        header = header.mid(splitPos + 1);
+    }
+    // no more levels, search for command
+    bool isQuery = false;
+    if(header.endsWith('?')) {
+        isQuery = true;
+        header.chop(1);
+    }
+    auto entry = node->find(header);
+    if(!entry || !entry->command) {
         // couldn't find command
         return SCPI::getResultName(SCPI::Result::Error);
     }
+    auto c = entry->command;
+    // save current node in case of non-root for the next command
+    lastNode = node;
+    for(auto n = node;n;n = n->parent) {
+        if(n->accessCallback) {
+            n->accessCallback();
+        }
+    }
+    QStringList params;
+    if(paramStart >= 0) {
+        params = cmd.mid(paramStart + 1).toString().split(" ");
+    }
+    if(c->convertToUppercase()) {
+        for(auto &p : params) {
+            p = p.toUpper();
+        }
+    }
+    if(isQuery) {
+        return c->query(params);
+    } else {
+        return c->execute(params);
+    }
+}
+
+static bool indexKeyLess(QStringView a, QStringView b)
+{
+    return a.compare(b, Qt::CaseInsensitive) < 0;
+}
+
+void SCPINode::addToIndex(QString name, SCPINode *node, SCPICommand *command)
+{
+    auto insert = [=](QString key) {
+        auto it = std::lower_bound(index.begin(), index.end(), key, [](const IndexEntry &e, const QString &key) {
+            return indexKeyLess(e.key, key);
+        });
+        index.insert(it, IndexEntry{key, node, command});
+    };
+    auto full = name.toUpper();
+    auto abbreviated = SCPI::alternateName(name).toUpper();
+    insert(full);
+    if(abbreviated != full) {
+        insert(abbreviated);
+    }
+}
+
+void SCPINode::removeFromIndex(SCPINode *node)
+{
+    index.erase(std::remove_if(index.begin(), index.end(), [=](const IndexEntry &e) {
+        return e.node == node;
+    }), index.end());
+}
+
+const SCPINode::IndexEntry *SCPINode::find(QStringView name)
+{
+    auto it = std::lower_bound(index.begin(), index.end(), name, [](const IndexEntry &e, QStringView name) {
+        return indexKeyLess(e.key, name);
+    });
+    if(it == index.end() || it->key.compare(name, Qt::CaseInsensitive) != 0) {
+        return nullptr;
+    }
+    return &*it;
 }
 
 QString SCPICommand::execute(QStringList params)
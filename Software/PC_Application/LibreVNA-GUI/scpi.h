@@ -4,8 +4,12 @@
 #include <QString>
 #include <QObject>
 #include <vector>
+#include <map>
+#include <set>
 #include <functional>
 
+class SCPI;
+
 class SCPICommand {
 public:
     SCPICommand(QString name, std::function<QString(QStringList)> cmd, std::function<QString(QStringList)> query, bool convertToUppercase = true) :
@@ -31,7 +35,7 @@ class SCPINode {
     friend class SCPI;
 public:
     SCPINode(QString name) :
-        name(name), parent(nullptr), operationPending(false){}
+        name(name), parent(nullptr), operationPending(false), accessCallback(nullptr){}
     virtual ~SCPINode();
 
     bool add(SCPINode *node);
@@ -46,18 +50,39 @@ public:
 
     void setOperationPending(bool pending);
 
+    // Called before any command of this node (or of one of its subnodes) is executed
+    void setAccessCallback(std::function<void(void)> cb) {accessCallback = cb;}
+
+    // returns the root of the tree this node is part of (or nullptr if it is not part of a SCPI tree)
+    SCPI *getRoot();
+
 protected:
     bool isOperationPending();
 
 private:
-    QString parse(QString cmd, SCPINode* &lastNode);
+    QString parse(QStringView cmd, SCPINode* &lastNode);
     bool nameCollision(QString name);
     void createCommandList(QString prefix, QString &list);
+
+    // Lookup table for parsing: contains the short and long name of every subnode and command,
+    // sorted (case insensitive) by name. Updated whenever a subnode or command is added or renamed
+    class IndexEntry {
+    public:
+        QString key;
+        SCPINode *node;
+        SCPICommand *command;
+    };
+    void addToIndex(QString name, SCPINode *node, SCPICommand *command);
+    void removeFromIndex(SCPINode *node);
+    const IndexEntry *find(QStringView name);
+
     QString name;
     std::vector<SCPINode*> subnodes;
     std::vector<SCPICommand*> commands;
+    std::vector<IndexEntry> index;
     SCPINode *parent;
     bool operationPending;
+    std::function<void(void)> accessCallback;
 };
 
 class SCPI : public QObject, public SCPINode
@@ -86,14 +111,52 @@ public:
 
     static QString getResultName(SCPI::Result r);
 
+    // Selected with FORMat:DATA, determines how queries with large numerical responses return their data
+    enum class DataFormat {
+        ASCII,
+        Real32,
+        Real64,
+    };
+    // data format of the connection whose command is currently executed
+    DataFormat getDataFormat() {return state().dataFormat;}
+
+    // Creates an IEEE 488.2 definite length arbitrary block response (#<n><length><data>) containing the values
+    // as binary floating point numbers, using the selected data format and byte order (FORMat:BORDer).
+    // The block is stored for the current connection, the query has to return the result of this function
+    // (the empty result), the block is then sent instead
+    QString createBlock(const std::vector<double> &values);
+    // Creates a block response containing the raw data
+    QString createBlock(const QByteArray &data);
+
     // call whenever a subnode completes an operation
     void someOperationCompleted();
 
+    // Asynchronous events (e.g. sweep completed), pushed to every connection that subscribed to them with
+    // EVENt:SUBScribe. Events have to be registered before they can be subscribed to
+    void addEvent(QString name);
+    // Sends "EVENT <sequence number>,<timestamp>,<name>[,<info>]" to all subscribers of the event. The sequence number
+    // is incremented for every event (independent of the subscriptions), the timestamp is in milliseconds since epoch (UTC)
+    void notify(QString event, QString info = "");
+
+    // For queries that can not be answered immediately (e.g. because they wait for new data). Call from within the
+    // query and return an empty result. Returns the connection the query was received on, further commands of that
+    // connection are held back until deferredResponse() has been called for it.
+    unsigned int deferResponse();
+    // Sends the response of a deferred query. The response is created by the callback, which is executed in the
+    // context of the connection (e.g. createBlock() uses its data format). Ignored if the connection has been closed
+    void deferredResponse(unsigned int connection, std::function<QString()> createResponse);
+
 public slots:
-    void input(QString line);
+    // Commands of each connection are executed in order, commands of different connections are interleaved line by line.
+    // Every connection has its own status registers, data format and *WAI state: a connection waiting for an
+    // operation to complete does not block the others
+    void input(QString line, unsigned int connection = 0);
+    void removeConnection(unsigned int connection);
     void process();
 signals:
-    void output(QString line);
+    void output(QString line, unsigned int connection);
+    // emitted instead of output() for block responses, contains the block including the terminating newline
+    void outputBlock(QByteArray data, unsigned int connection);
 
 private:
 
@@ -112,15 +175,43 @@ private:
     void clearFlag(Flag flag);
     bool getFlag(Flag flag);
 
-    unsigned int SESR;
-    unsigned int ESE;
-
-    bool OCAS;
-    bool OPCsetBitScheduled;
-    bool OPCQueryScheduled;
-    bool WAIexecuting;
-
-    QList<QString> cmdQueue;
+    class Connection {
+    public:
+        Connection();
+        unsigned int SESR;
+        unsigned int ESE;
+
+        bool OCAS;
+        bool OPCsetBitScheduled;
+        bool OPCQueryScheduled;
+        bool WAIexecuting;
+        // a query of this connection is waiting for its deferred response
+        bool responseDeferred;
+        // set by createBlock(), sent instead of the (empty) result of the query
+        bool blockPending;
+        QByteArray block;
+
+        QList<QString> cmdQueue;
+
+        DataFormat dataFormat;
+        // true: little endian byte order for binary data (FORMat:BORDer SWAPped), false: big endian (NORMal)
+        bool swappedByteOrder;
+
+        std::set<QString> subscriptions;
+    };
+    // state of the current connection. If it has been closed while its command was executed, a detached state with
+    // the default values is returned, changes to it are discarded
+    Connection &state();
+    void execute(QString line, unsigned int connection);
+    // handles the result of a query/command for the current connection (sets error flags or emits the output)
+    void respond(QString response);
+
+    std::map<unsigned int, Connection> connections;
+    Connection closedConnection;
+    std::vector<QString> events;
+    unsigned long long eventSequence;
+    // the connection whose command is currently executed
+    unsigned int current;
 };
 
 #endif // SCPI_H
@@ -1,26 +1,68 @@
 #include "streamingserver.h"
 
 #include "json.hpp"
+#include "Util/metrics.h"
+
+#include <QtEndian>
+#include <QDebug>
+#include <cstring>
+#include <limits>
+
+static Metrics::Counter &droppedFramesMetric()
+{
+    static auto &dropped = Metrics::getInstance().counter("librevna_streaming_frames_dropped_total", "Frames dropped by the streaming servers because a client did not keep up");
+    return dropped;
+}
 
 StreamingServer::StreamingServer(int port)
 {
     this->port = port;
-    server.listen(QHostAddress::Any, port);
-    connect(&server, &QTcpServer::newConnection, [&](){
-        auto socket = server.nextPendingConnection();
-        sockets.insert(socket);
-
-        connect(socket, &QTcpSocket::stateChanged, [this, socket](QAbstractSocket::SocketState state){
-            if (state == QAbstractSocket::UnconnectedState)
-            {
-                sockets.erase(socket);
-                socket->deleteLater();
-            }
-        });
-    });
+    qRegisterMetaType<DeviceDriver::VNAMeasurement>();
+    qRegisterMetaType<DeviceDriver::SAMeasurement>();
+    worker = new StreamingWorker(port);
+    worker->moveToThread(&thread);
+    connect(&thread, &QThread::started, worker, &StreamingWorker::start);
+    connect(this, &StreamingServer::newVNAData, worker, &StreamingWorker::addVNAData);
+    connect(this, &StreamingServer::newSAData, worker, &StreamingWorker::addSAData);
+    // sockets have to be closed from within the worker thread
+    connect(this, &StreamingServer::stopWorker, worker, &StreamingWorker::stop, Qt::BlockingQueuedConnection);
+    thread.start();
+}
+
+StreamingServer::~StreamingServer()
+{
+    emit stopWorker();
+    thread.quit();
+    thread.wait();
+    delete worker;
+}
+
+void StreamingServer::addData(const DeviceDriver::VNAMeasurement &m, bool lastPointOfSweep)
+{
+    emit newVNAData(m, lastPointOfSweep);
+}
+
+void StreamingServer::addData(const DeviceDriver::SAMeasurement &m, bool lastPointOfSweep)
+{
+    emit newSAData(m, lastPointOfSweep);
+}
+
+void StreamingServer::setQueueLimit(unsigned long bytes)
+{
+    worker->queueLimit = bytes;
+}
+
+void StreamingServer::setDropPolicy(DropPolicy policy)
+{
+    worker->dropPolicy = policy;
+}
+
+std::vector<StreamingServer::ClientStatistics> StreamingServer::getStatistics()
+{
+    return worker->getStatistics();
 }
 
-void StreamingServer::addData(const DeviceDriver::VNAMeasurement &m)
+static nlohmann::json toJSON(const DeviceDriver::VNAMeasurement &m)
 {
     nlohmann::json j;
     j["pointNum"] = m.pointNum;
@@ -33,15 +75,10 @@ void StreamingServer::addData(const DeviceDriver::VNAMeasurement &m)
         jp[QString(p.first+"_imag").toStdString()] = p.second.imag();
     }
     j["measurements"] = jp;
-    std::string toSend = j.dump();
-    for(auto s : sockets) {
-        if(s->isOpen()) {
-            s->write(QByteArray::fromStdString(toSend+'\n'));
-        }
-    }
+    return j;
 }
 
-void StreamingServer::addData(const DeviceDriver::SAMeasurement &m)
+static nlohmann::json toJSON(const DeviceDriver::SAMeasurement &m)
 {
     nlohmann::json j;
     j["pointNum"] = m.pointNum;
@@ -51,10 +88,389 @@ void StreamingServer::addData(const DeviceDriver::SAMeasurement &m)
         jp[p.first.toStdString()] = p.second;
     }
     j["measurements"] = jp;
-    std::string toSend = j.dump();
-    for(auto s : sockets) {
-        if(s->isOpen()) {
-            s->write(QByteArray::fromStdString(toSend+'\n'));
+    return j;
+}
+
+template<typename T>
+static QByteArray encodeJSON(const std::vector<T> &points)
+{
+    nlohmann::json j;
+    if(points.size() == 1) {
+        j = toJSON(points[0]);
+    } else {
+        j = nlohmann::json::array();
+        for(auto &p : points) {
+            j.push_back(toJSON(p));
+        }
+    }
+    return QByteArray::fromStdString(j.dump()+'\n');
+}
+
+template<typename T>
+static uchar *put(uchar *dst, T value)
+{
+    qToLittleEndian(value, dst);
+    return dst + sizeof(T);
+}
+
+static uchar *putFloat(uchar *dst, double value, unsigned int sampleSize)
+{
+    if(sampleSize == 4) {
+        float f = value;
+        quint32 u;
+        memcpy(&u, &f, sizeof(u));
+        return put(dst, u);
+    } else {
+        quint64 u;
+        memcpy(&u, &value, sizeof(u));
+        return put(dst, u);
+    }
+}
+
+// Allocates the frame and fills in the header and channel names. Returns the position of the first point
+template<typename T>
+static uchar *createBinaryFrame(QByteArray &frame, const std::vector<T> &points, StreamingServer::FrameType type,
+                                unsigned int sampleSize, unsigned int valuesPerChannel, unsigned int stimulusValues, double Z0,
+                                std::vector<QString> &channels)
+{
+    QByteArray names;
+    channels.clear();
+    for(auto const &m : points[0].measurements) {
+        channels.push_back(m.first);
+        names.append(m.first.toLatin1());
+        names.append('\0');
+    }
+    unsigned long pointSize = stimulusValues * sizeof(double) + channels.size() * valuesPerChannel * sampleSize;
+    unsigned long frameSize = StreamingServer::binaryHeaderSize + names.size() + points.size() * pointSize;
+    frame.resize(frameSize);
+    auto dst = (uchar*) frame.data();
+    dst = put<quint32>(dst, StreamingServer::binaryMagic);
+    dst = put<quint8>(dst, StreamingServer::binaryVersion);
+    dst = put<quint8>(dst, (quint8) type);
+    dst = put<quint8>(dst, sampleSize);
+    dst = put<quint8>(dst, points.size() > 1 ? StreamingServer::binaryFlagCompleteSweep : 0);
+    dst = put<quint32>(dst, frameSize);
+    dst = put<quint32>(dst, points[0].pointNum);
+    dst = put<quint32>(dst, points.size());
+    dst = put<quint16>(dst, channels.size());
+    dst = put<quint16>(dst, names.size());
+    dst = putFloat(dst, Z0, sizeof(double));
+    memcpy(dst, names.constData(), names.size());
+    return dst + names.size();
+}
+
+QByteArray StreamingServer::encode(const std::vector<DeviceDriver::VNAMeasurement> &points, Format format)
+{
+    if(points.empty()) {
+        return QByteArray();
+    }
+    if(format == Format::JSON) {
+        return encodeJSON(points);
+    }
+    unsigned int sampleSize = format == Format::Binary32 ? 4 : 8;
+    QByteArray frame;
+    std::vector<QString> channels;
+    auto dst = createBinaryFrame(frame, points, FrameType::VNA, sampleSize, 2, 2, points[0].Z0, channels);
+    for(auto const &p : points) {
+        dst = putFloat(dst, p.frequency, sizeof(double));
+        dst = putFloat(dst, p.dBm, sizeof(double));
+        for(auto const &c : channels) {
+            auto it = p.measurements.find(c);
+            auto value = it != p.measurements.end() ? it->second : std::numeric_limits<double>::quiet_NaN();
+            dst = putFloat(dst, value.real(), sampleSize);
+            dst = putFloat(dst, value.imag(), sampleSize);
+        }
+    }
+    return frame;
+}
+
+QByteArray StreamingServer::encode(const std::vector<DeviceDriver::SAMeasurement> &points, Format format)
+{
+    if(points.empty()) {
+        return QByteArray();
+    }
+    if(format == Format::JSON) {
+        return encodeJSON(points);
+    }
+    unsigned int sampleSize = format == Format::Binary32 ? 4 : 8;
+    QByteArray frame;
+    std::vector<QString> channels;
+    auto dst = createBinaryFrame(frame, points, FrameType::SA, sampleSize, 1, 1, 0.0, channels);
+    for(auto const &p : points) {
+        dst = putFloat(dst, p.frequency, sizeof(double));
+        for(auto const &c : channels) {
+            auto it = p.measurements.find(c);
+            auto value = it != p.measurements.end() ? it->second : std::numeric_limits<double>::quiet_NaN();
+            dst = putFloat(dst, value, sampleSize);
+        }
+    }
+    return frame;
+}
+
+StreamingWorker::StreamingWorker(int port)
+    : queueLimit(4000000),
+      dropPolicy(StreamingServer::DropPolicy::DropOldest),
+      port(port),
+      server(nullptr),
+      statisticsTimer(nullptr),
+      sweepCounter(0)
+{
+
+}
+
+std::vector<StreamingServer::ClientStatistics> StreamingWorker::getStatistics()
+{
+    std::lock_guard<std::mutex> guard(statisticsMutex);
+    return statistics;
+}
+
+void StreamingWorker::start()
+{
+    // created here instead of the constructor, they have to live in the worker thread
+    server = new QTcpServer(this);
+    if(!server->listen(QHostAddress::Any, port)) {
+        qWarning() << "Streaming server failed to listen on port" << port << ":" << server->errorString();
+    }
+    connect(server, &QTcpServer::newConnection, this, [=](){
+        while(server->hasPendingConnections()) {
+            auto socket = server->nextPendingConnection();
+            clients[socket] = Client();
+
+            connect(socket, &QTcpSocket::readyRead, this, [this, socket](){
+                auto it = clients.find(socket);
+                while(it != clients.end() && socket->canReadLine()) {
+                    parseCommand(it->second, QString::fromLatin1(socket->readLine()).trimmed());
+                }
+            });
+            connect(socket, &QTcpSocket::bytesWritten, this, [this, socket](){
+                auto it = clients.find(socket);
+                if(it != clients.end()) {
+                    send(socket, it->second);
+                }
+            });
+            connect(socket, &QTcpSocket::stateChanged, this, [this, socket](QAbstractSocket::SocketState state){
+                if (state == QAbstractSocket::UnconnectedState)
+                {
+                    clients.erase(socket);
+                    socket->deleteLater();
+                    updateStatistics();
+                }
+            });
+        }
+        updateStatistics();
+    });
+    statisticsTimer = new QTimer(this);
+    connect(statisticsTimer, &QTimer::timeout, this, &StreamingWorker::updateStatistics);
+    statisticsTimer->start(statisticsInterval);
+    statisticsElapsed.start();
+}
+
+void StreamingWorker::stop()
+{
+    for(auto const &c : clients) {
+        // don't react to the state change when the socket gets closed
+        disconnect(c.first, nullptr, this, nullptr);
+    }
+    clients.clear();
+    // also deletes all sockets
+    delete server;
+    server = nullptr;
+    delete statisticsTimer;
+    statisticsTimer = nullptr;
+}
+
+void StreamingWorker::addVNAData(DeviceDriver::VNAMeasurement m, bool lastPointOfSweep)
+{
+    distribute(vnaSweep, m, lastPointOfSweep);
+}
+
+void StreamingWorker::addSAData(DeviceDriver::SAMeasurement m, bool lastPointOfSweep)
+{
+    distribute(saSweep, m, lastPointOfSweep);
+}
+
+void StreamingWorker::parseCommand(Client &client, QString cmd)
+{
+    if(cmd.isEmpty()) {
+        return;
+    }
+    auto params = cmd.toUpper().simplified().split(" ");
+    if(params.size() == 2 && params[0] == "FORMAT") {
+        if(params[1] == "JSON") {
+            client.format = StreamingServer::Format::JSON;
+            return;
+        } else if(params[1] == "BIN32") {
+            client.format = StreamingServer::Format::Binary32;
+            return;
+        } else if(params[1] == "BIN64") {
+            client.format = StreamingServer::Format::Binary64;
+            return;
+        }
+    } else if(params.size() == 2 && params[0] == "BATCH") {
+        if(params[1] == "POINT") {
+            client.sweepBatching = false;
+            return;
+        } else if(params[1] == "SWEEP") {
+            client.sweepBatching = true;
+            return;
+        }
+    }
+    qWarning() << "Streaming server on port" << port << "received invalid command:" << cmd;
+}
+
+template<typename T>
+void StreamingWorker::distribute(std::vector<T> &sweep, const T &m, bool lastPointOfSweep)
+{
+    bool batching = false;
+    for(auto const &c : clients) {
+        if(c.second.sweepBatching) {
+            batching = true;
+            break;
+        }
+    }
+    bool sweepComplete = false;
+    if(batching) {
+        if(m.pointNum == 0) {
+            sweep.clear();
+        }
+        if(sweep.size() == m.pointNum) {
+            sweep.push_back(m);
+            sweepComplete = lastPointOfSweep;
+        } else {
+            // missed the start of this sweep (or a point in between), wait for the next sweep
+            sweep.clear();
+        }
+    } else {
+        sweep.clear();
+    }
+
+    // every required frame is only encoded once, no matter how many clients receive it
+    std::map<StreamingServer::Format, QByteArray> pointFrames;
+    std::map<StreamingServer::Format, QByteArray> sweepFrames;
+    for(auto &c : clients) {
+        auto socket = c.first;
+        auto &client = c.second;
+        auto format = client.format;
+        if(!socket->isOpen() || client.closing) {
+            continue;
+        }
+        if(client.sweepBatching) {
+            if(!sweepComplete) {
+                continue;
+            }
+            if(!sweepFrames.count(format)) {
+                sweepFrames[format] = StreamingServer::encode(sweep, format);
+            }
+            enqueue(socket, client, sweepFrames[format]);
+        } else {
+            if(!pointFrames.count(format)) {
+                pointFrames[format] = StreamingServer::encode(std::vector<T>{m}, format);
+            }
+            enqueue(socket, client, pointFrames[format]);
+        }
+    }
+    if(sweepComplete) {
+        sweep.clear();
+    }
+    if(lastPointOfSweep) {
+        sweepCounter++;
+    }
+}
+
+void StreamingWorker::enqueue(QTcpSocket *socket, Client &client, const QByteArray &data)
+{
+    if(client.skipSweep) {
+        if(client.skippedSweep == sweepCounter) {
+            // the beginning of this sweep has already been dropped
+            client.framesDropped++;
+            client.bytesDropped += data.size();
+            droppedFramesMetric().increment();
+            return;
+        }
+        client.skipSweep = false;
+    }
+    client.queue.push_back(Frame{data, sweepCounter});
+    client.queuedBytes += data.size();
+    while(client.queuedBytes > queueLimit && !client.queue.empty()) {
+        switch(dropPolicy.load()) {
+        case StreamingServer::DropPolicy::DropOldest:
+            dropOldest(client);
+            break;
+        case StreamingServer::DropPolicy::DropSweeps: {
+            auto sweep = client.queue.front().sweep;
+            while(!client.queue.empty() && client.queue.front().sweep == sweep) {
+                dropOldest(client);
+            }
+            if(sweep == sweepCounter) {
+                client.skipSweep = true;
+                client.skippedSweep = sweep;
+            }
+        }
+            break;
+        case StreamingServer::DropPolicy::Disconnect:
+            qWarning() << "Streaming server on port" << port << "disconnects" << socket->peerAddress().toString() << "because it does not keep up with the data";
+            while(!client.queue.empty()) {
+                dropOldest(client);
+            }
+            client.closing = true;
+            // aborting immediately would remove the client while it is still in use
+            QTimer::singleShot(0, socket, [=](){
+                socket->abort();
+            });
+            return;
+        }
+    }
+    send(socket, client);
+}
+
+void StreamingWorker::dropOldest(Client &client)
+{
+    auto size = client.queue.front().data.size();
+    client.framesDropped++;
+    client.bytesDropped += size;
+    client.queuedBytes -= size;
+    droppedFramesMetric().increment();
+    client.queue.pop_front();
+}
+
+void StreamingWorker::send(QTcpSocket *socket, Client &client)
+{
+    // Only hand over as much data as the socket is able to send. Everything else stays in the
+    // (bounded) queue where the drop policy can be applied
+    while(!client.queue.empty() && socket->bytesToWrite() < socketBufferLimit) {
+        auto &frame = client.queue.front();
+        socket->write(frame.data);
+        client.framesSent++;
+        client.bytesSent += frame.data.size();
+        client.queuedBytes -= frame.data.size();
+        client.queue.pop_front();
+    }
+}
+
+void StreamingWorker::updateStatistics()
+{
+    auto elapsed = statisticsElapsed.restart();
+    std::vector<StreamingServer::ClientStatistics> stats;
+    for(auto &c : clients) {
+        auto socket = c.first;
+        auto &client = c.second;
+        if(elapsed > 0) {
+            client.throughput = (client.bytesSent - client.lastBytesSent) * 1000.0 / elapsed;
         }
+        client.lastBytesSent = client.bytesSent;
+        StreamingServer::ClientStatistics s;
+        s.address = socket->peerAddress().toString();
+        s.port = socket->peerPort();
+        s.format = client.format;
+        s.sweepBatching = client.sweepBatching;
+        s.framesSent = client.framesSent;
+        s.bytesSent = client.bytesSent;
+        s.framesDropped = client.framesDropped;
+        s.bytesDropped = client.bytesDropped;
+        s.queuedBytes = client.queuedBytes;
+        s.throughput = client.throughput;
+        stats.push_back(s);
     }
+    std::lock_guard<std::mutex> guard(statisticsMutex);
+    statistics = stats;
 }
@@ -3,25 +3,177 @@
 
 #include <QTcpServer>
 #include <QTcpSocket>
-#include <set>
+#include <QThread>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <map>
+#include <deque>
+#include <mutex>
+#include <atomic>
 
 #include "Device/devicedriver.h"
 
+class StreamingWorker;
+
+// All socket handling and encoding happens in a dedicated thread, this class only forwards data to it
 class StreamingServer : public QObject
 {
     Q_OBJECT
 public:
     StreamingServer(int port);
+    ~StreamingServer();
+
+    // Output format, selected by each client with the FORMAT command (JSON by default)
+    enum class Format {
+        JSON,
+        Binary32,
+        Binary64,
+    };
+
+    // What to do with a client whose queue is full (it is not reading the data as fast as it is generated)
+    enum class DropPolicy {
+        DropOldest, // drop the oldest queued frames until the new frame fits
+        DropSweeps, // drop the oldest queued sweep as a whole (including the remaining points of it, if it is still running)
+        Disconnect, // close the connection to the client
+    };
 
-    void addData(const DeviceDriver::VNAMeasurement &m);
-    void addData(const DeviceDriver::SAMeasurement &m);
+    void addData(const DeviceDriver::VNAMeasurement &m, bool lastPointOfSweep);
+    void addData(const DeviceDriver::SAMeasurement &m, bool lastPointOfSweep);
 
     int getPort() {return port;}
+    // Maximum number of bytes waiting to be sent per client
+    void setQueueLimit(unsigned long bytes);
+    void setDropPolicy(DropPolicy policy);
+
+    class ClientStatistics {
+    public:
+        QString address;
+        quint16 port;
+        Format format;
+        bool sweepBatching;
+        quint64 framesSent;
+        quint64 bytesSent;
+        quint64 framesDropped;
+        quint64 bytesDropped;
+        unsigned long queuedBytes;
+        // bytes per second, averaged over the last statistics interval
+        double throughput;
+    };
+    // Statistics of all connected clients, updated once per second
+    std::vector<ClientStatistics> getStatistics();
+
+    // Creates one frame containing all given points. For JSON, this is a single line with either an
+    // object (one point) or an array of objects (multiple points)
+    static QByteArray encode(const std::vector<DeviceDriver::VNAMeasurement> &points, Format format);
+    static QByteArray encode(const std::vector<DeviceDriver::SAMeasurement> &points, Format format);
+
+    /*
+     * Binary frames (all values little endian):
+     * Offset | Type    | Content
+     *      0 | uint32  | binaryMagic
+     *      4 | uint8   | binaryVersion
+     *      5 | uint8   | FrameType
+     *      6 | uint8   | bytes per sample value (4: float32, 8: float64)
+     *      7 | uint8   | flags, bit 0 set if the frame contains a complete sweep
+     *      8 | uint32  | total size of the frame in bytes (including this header)
+     *     12 | uint32  | point number of the first point in this frame
+     *     16 | uint32  | number of points in this frame
+     *     20 | uint16  | number of channels
+     *     22 | uint16  | size of the channel name block in bytes
+     *     24 | float64 | Z0 (VNA only, 0 for SA)
+     *     32 |         | channel names, each terminated by '\0'
+     * followed by the points, each consisting of
+     *   VNA: float64 frequency (or time in us for zero span), float64 dBm, real and imaginary part per channel
+     *   SA: float64 frequency (or time in us for zero span), value per channel
+     */
+    static constexpr quint32 binaryMagic = 0x4253564C; // "LVSB"
+    static constexpr quint8 binaryVersion = 1;
+    static constexpr unsigned int binaryHeaderSize = 32;
+    static constexpr quint8 binaryFlagCompleteSweep = 0x01;
+    enum class FrameType : quint8 {
+        VNA = 1,
+        SA = 2,
+    };
+
+signals:
+    void newVNAData(DeviceDriver::VNAMeasurement m, bool lastPointOfSweep);
+    void newSAData(DeviceDriver::SAMeasurement m, bool lastPointOfSweep);
+    void stopWorker();
 
 private:
     int port;
-    QTcpServer server;
-    std::set<QTcpSocket*> sockets;
+    QThread thread;
+    StreamingWorker *worker;
+};
+
+class StreamingWorker : public QObject
+{
+    Q_OBJECT
+public:
+    StreamingWorker(int port);
+
+    std::atomic<unsigned long> queueLimit;
+    std::atomic<StreamingServer::DropPolicy> dropPolicy;
+
+    std::vector<StreamingServer::ClientStatistics> getStatistics();
+
+public slots:
+    void start();
+    void stop();
+    void addVNAData(DeviceDriver::VNAMeasurement m, bool lastPointOfSweep);
+    void addSAData(DeviceDriver::SAMeasurement m, bool lastPointOfSweep);
+
+private:
+    class Frame {
+    public:
+        QByteArray data;
+        unsigned long sweep;
+    };
+    class Client {
+    public:
+        Client() : format(StreamingServer::Format::JSON), sweepBatching(false), queuedBytes(0), closing(false),
+            skipSweep(false), skippedSweep(0), framesSent(0), bytesSent(0), framesDropped(0), bytesDropped(0),
+            lastBytesSent(0), throughput(0) {}
+        StreamingServer::Format format;
+        // only send complete sweeps (one frame per sweep) instead of a frame per point
+        bool sweepBatching;
+        // frames not yet handed to the socket
+        std::deque<Frame> queue;
+        unsigned long queuedBytes;
+        // set when the client is about to be disconnected because of the drop policy
+        bool closing;
+        // set when the beginning of a sweep has been dropped, the remaining frames of it are dropped as well
+        bool skipSweep;
+        unsigned long skippedSweep;
+        quint64 framesSent, bytesSent;
+        quint64 framesDropped, bytesDropped;
+        quint64 lastBytesSent;
+        double throughput;
+    };
+    void parseCommand(Client &client, QString cmd);
+    template<typename T> void distribute(std::vector<T> &sweep, const T &m, bool lastPointOfSweep);
+    void enqueue(QTcpSocket *socket, Client &client, const QByteArray &data);
+    void dropOldest(Client &client);
+    void send(QTcpSocket *socket, Client &client);
+    void updateStatistics();
+
+    // Frames are only handed to the socket while it has less than this amount of data buffered
+    static constexpr qint64 socketBufferLimit = 65536;
+    static constexpr int statisticsInterval = 1000;
+
+    int port;
+    QTcpServer *server;
+    QTimer *statisticsTimer;
+    QElapsedTimer statisticsElapsed;
+    std::map<QTcpSocket*, Client> clients;
+    // points of the current sweep, only collected if at least one client uses sweep batching
+    std::vector<DeviceDriver::VNAMeasurement> vnaSweep;
+    std::vector<DeviceDriver::SAMeasurement> saSweep;
+    // incremented after every sweep, used to identify the frames belonging to the same sweep
+    unsigned long sweepCounter;
+
+    std::mutex statisticsMutex;
+    std::vector<StreamingServer::ClientStatistics> statistics;
 };
 
 #endif // STREAMINGSERVER_H
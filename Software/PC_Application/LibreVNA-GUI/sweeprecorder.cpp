@@ -0,0 +1,672 @@
+#include "sweeprecorder.h"
+
+#include "json.hpp"
+#include "Util/metrics.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDateTime>
+#include <QtEndian>
+#include <QDebug>
+#include <cstring>
+#include <map>
+#include <type_traits>
+
+template<typename T>
+static uchar *put(uchar *dst, T value)
+{
+    qToLittleEndian(value, dst);
+    return dst + sizeof(T);
+}
+
+template<typename T>
+static T get(const uchar *&src)
+{
+    auto value = qFromLittleEndian<T>(src);
+    src += sizeof(T);
+    return value;
+}
+
+static uchar *putDouble(uchar *dst, double value)
+{
+    quint64 u;
+    memcpy(&u, &value, sizeof(u));
+    return put(dst, u);
+}
+
+static double getDouble(const uchar *&src)
+{
+    auto u = get<quint64>(src);
+    double value;
+    memcpy(&value, &u, sizeof(value));
+    return value;
+}
+
+static uchar *putFloat(uchar *dst, float value)
+{
+    quint32 u;
+    memcpy(&u, &value, sizeof(u));
+    return put(dst, u);
+}
+
+static float getFloat(const uchar *&src)
+{
+    auto u = get<quint32>(src);
+    float value;
+    memcpy(&value, &u, sizeof(value));
+    return value;
+}
+
+static void appendValue(std::vector<float> &column, std::complex<double> value)
+{
+    column.push_back(value.real());
+    column.push_back(value.imag());
+}
+
+static void appendValue(std::vector<float> &column, double value)
+{
+    column.push_back(value);
+}
+
+static Metrics::Counter &droppedSweepsMetric()
+{
+    static auto &dropped = Metrics::getInstance().counter("librevna_recorder_sweeps_dropped_total", "Sweeps dropped by the recorder because writing did not keep up (or failed)");
+    return dropped;
+}
+
+static QByteArray createChunk(SweepRecorder::ChunkType type, quint32 stage, quint64 payloadSize, uchar *&payload)
+{
+    QByteArray chunk(SweepRecorder::chunkHeaderSize + payloadSize, Qt::Uninitialized);
+    auto dst = (uchar*) chunk.data();
+    dst = put<quint32>(dst, (quint32) type);
+    dst = put<quint32>(dst, stage);
+    payload = put<quint64>(dst, payloadSize);
+    return chunk;
+}
+
+static nlohmann::json settingsJSON(const SweepRecorder::Sweep &sweep)
+{
+    nlohmann::json j;
+    j["stage"] = SweepRecorder::StageToString(sweep.stage).toStdString();
+    nlohmann::json channels = nlohmann::json::array();
+    for(auto &c : sweep.channels) {
+        channels.push_back(c.toStdString());
+    }
+    j["channels"] = channels;
+    j["points"] = sweep.x.size();
+    if(sweep.isVNA()) {
+        j["Z0"] = sweep.Z0;
+    }
+    auto &s = sweep.settings;
+    nlohmann::json settings;
+    settings["type"] = s.type.toStdString();
+    settings["zerospan"] = s.zerospan;
+    settings["start"] = s.start;
+    settings["stop"] = s.stop;
+    settings["span"] = s.stop - s.start;
+    settings["bandwidth"] = s.bandwidth;
+    if(sweep.isVNA()) {
+        settings["powerStart"] = s.powerStart;
+        settings["powerStop"] = s.powerStop;
+    }
+    settings["averages"] = s.averages;
+    j["sweep"] = settings;
+    return j;
+}
+
+static QByteArray encodeSweep(const SweepRecorder::Sweep &sweep)
+{
+    auto points = sweep.x.size();
+    quint64 size = 2 * sizeof(quint64) + 2 * sizeof(quint32) + points * sizeof(double);
+    if(sweep.isVNA()) {
+        size += points * sizeof(double);
+    }
+    for(auto &column : sweep.data) {
+        size += column.size() * sizeof(float);
+    }
+    uchar *dst;
+    auto chunk = createChunk(SweepRecorder::ChunkType::Sweep, (quint32) sweep.stage, size, dst);
+    dst = put<quint64>(dst, sweep.number);
+    dst = put<qint64>(dst, sweep.timestamp);
+    dst = put<quint32>(dst, points);
+    dst = put<quint32>(dst, sweep.data.size());
+    for(auto x : sweep.x) {
+        dst = putDouble(dst, x);
+    }
+    if(sweep.isVNA()) {
+        for(auto dBm : sweep.dBm) {
+            dst = putDouble(dst, dBm);
+        }
+    }
+    for(auto &column : sweep.data) {
+        for(auto value : column) {
+            dst = putFloat(dst, value);
+        }
+    }
+    return chunk;
+}
+
+static QByteArray encodeIndex(const std::vector<SweepRecorder::IndexEntry> &entries, quint64 previousIndex)
+{
+    uchar *dst;
+    auto chunk = createChunk(SweepRecorder::ChunkType::Index, 0, 2 * sizeof(quint64) + entries.size() * SweepRecorder::indexEntrySize, dst);
+    dst = put<quint64>(dst, previousIndex);
+    dst = put<quint64>(dst, entries.size());
+    for(auto &e : entries) {
+        dst = put<quint64>(dst, e.offset);
+        dst = put<quint64>(dst, e.settingsOffset);
+        dst = put<quint32>(dst, (quint32) e.stage);
+        dst = put<quint32>(dst, 0);
+        dst = put<quint64>(dst, e.sweep);
+        dst = put<qint64>(dst, e.timestamp);
+    }
+    return chunk;
+}
+
+SweepRecorder::SweepRecorder()
+    : recording(false),
+      queuedBytes(0),
+      queueLimit(64 * 1024 * 1024),
+      maxFileSize(0),
+      maxFileDuration(0),
+      stopRequested(false),
+      statistics()
+{
+    for(int i=0;i<(int) Stage::Last;i++) {
+        current[i].stage = (Stage) i;
+        sweepCounter[i] = 0;
+    }
+}
+
+SweepRecorder::~SweepRecorder()
+{
+    stop();
+}
+
+QString SweepRecorder::StageToString(Stage s)
+{
+    switch(s) {
+    case Stage::VNARaw: return "VNARAW";
+    case Stage::VNACalibrated: return "VNACAL";
+    case Stage::VNADeembedded: return "VNADEEMB";
+    case Stage::SARaw: return "SARAW";
+    case Stage::SANormalized: return "SANORM";
+    case Stage::Last: break;
+    }
+    return "";
+}
+
+SweepRecorder::Stage SweepRecorder::StageFromString(QString s)
+{
+    for(int i=0;i<(int) Stage::Last;i++) {
+        if(s.compare(StageToString((Stage) i), Qt::CaseInsensitive) == 0) {
+            return (Stage) i;
+        }
+    }
+    return Stage::Last;
+}
+
+bool SweepRecorder::start(QString filename, std::set<Stage> stages)
+{
+    stop();
+    if(filename.isEmpty() || stages.empty() || !QFileInfo(filename).absoluteDir().exists()) {
+        return false;
+    }
+    this->stages = stages;
+    for(int i=0;i<(int) Stage::Last;i++) {
+        current[i].x.clear();
+        sweepCounter[i] = 0;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        this->filename = filename;
+        queue.clear();
+        queuedBytes = 0;
+        stopRequested = false;
+        statistics = Statistics();
+    }
+    thread = std::thread(&SweepRecorder::writer, this);
+    recording = true;
+    return true;
+}
+
+void SweepRecorder::stop()
+{
+    if(!recording) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopRequested = true;
+    }
+    cv.notify_one();
+    // the writer finishes the queued sweeps before closing the file
+    thread.join();
+    recording = false;
+}
+
+void SweepRecorder::setRotation(quint64 maxFileSize, unsigned int maxFileDuration)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    this->maxFileSize = maxFileSize;
+    this->maxFileDuration = maxFileDuration;
+}
+
+void SweepRecorder::setQueueLimit(quint64 bytes)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    queueLimit = bytes;
+}
+
+void SweepRecorder::setVNASweepSettings(const SweepSettings &s)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    VNASettings = s;
+}
+
+void SweepRecorder::setSASweepSettings(const SweepSettings &s)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    SASettings = s;
+}
+
+void SweepRecorder::addData(const DeviceDriver::VNAMeasurement &m, Stage stage, bool lastPointOfSweep)
+{
+    if(recording && stages.count(stage)) {
+        current[(int) stage].Z0 = m.Z0;
+        collect(current[(int) stage], m, lastPointOfSweep);
+    }
+}
+
+void SweepRecorder::addData(const DeviceDriver::SAMeasurement &m, Stage stage, bool lastPointOfSweep)
+{
+    if(recording && stages.count(stage)) {
+        current[(int) stage].Z0 = 0;
+        collect(current[(int) stage], m, lastPointOfSweep);
+    }
+}
+
+SweepRecorder::Statistics SweepRecorder::getStatistics()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return statistics;
+}
+
+size_t SweepRecorder::Sweep::size() const
+{
+    size_t size = (x.size() + dBm.size()) * sizeof(double);
+    for(auto &column : data) {
+        size += column.size() * sizeof(float);
+    }
+    return size;
+}
+
+template<typename T>
+void SweepRecorder::collect(Sweep &sweep, const T &m, bool lastPointOfSweep)
+{
+    constexpr bool isVNA = std::is_same<T, DeviceDriver::VNAMeasurement>::value;
+    if(m.pointNum == 0) {
+        // start of a new sweep
+        sweep.x.clear();
+        sweep.dBm.clear();
+        sweep.channels.clear();
+        for(auto &meas : m.measurements) {
+            sweep.channels.push_back(meas.first);
+        }
+        sweep.data.resize(sweep.channels.size());
+        for(auto &column : sweep.data) {
+            column.clear();
+        }
+        std::lock_guard<std::mutex> lock(mtx);
+        sweep.settings = isVNA ? VNASettings : SASettings;
+    } else if(m.pointNum != sweep.x.size() || m.measurements.size() != sweep.channels.size()) {
+        // missed a point or the measurements have changed, this sweep is incomplete
+        sweep.x.clear();
+        return;
+    }
+    if(sweep.settings.zerospan) {
+        sweep.x.push_back(m.us);
+        if constexpr (isVNA) {
+            // the measurement only contains the time
+            sweep.dBm.push_back(sweep.settings.powerStart);
+        }
+    } else {
+        sweep.x.push_back(m.frequency);
+        if constexpr (isVNA) {
+            sweep.dBm.push_back(m.dBm);
+        }
+    }
+    unsigned int i = 0;
+    for(auto &meas : m.measurements) {
+        appendValue(sweep.data[i++], meas.second);
+    }
+    if(!lastPointOfSweep) {
+        return;
+    }
+    sweep.timestamp = QDateTime::currentMSecsSinceEpoch();
+    sweep.number = sweepCounter[(int) sweep.stage]++;
+    auto size = sweep.size();
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if(queuedBytes + size > queueLimit) {
+            statistics.sweepsDropped++;
+            droppedSweepsMetric().increment();
+        } else {
+            // hand over a copy, keeping the allocated columns for the next sweep
+            queue.push_back(sweep);
+            queuedBytes += size;
+        }
+    }
+    cv.notify_one();
+    sweep.x.clear();
+}
+
+void SweepRecorder::writer()
+{
+    QFile file;
+    unsigned int fileNumber = 0;
+    qint64 fileOpened = 0;
+    quint64 offset = 0;
+    quint64 lastIndex = 0;
+    bool failed = false;
+    std::vector<IndexEntry> index;
+    // settings of each stage in the current file and the offsets of their chunks
+    std::map<Stage, nlohmann::json> settings;
+    std::map<Stage, quint64> settingsOffset;
+
+    QFileInfo info;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        info = QFileInfo(filename);
+    }
+
+    auto write = [&](const QByteArray &data) -> bool {
+        if(file.write(data) != data.size()) {
+            std::lock_guard<std::mutex> lock(mtx);
+            statistics.error = file.errorString();
+            failed = true;
+            return false;
+        }
+        offset += data.size();
+        std::lock_guard<std::mutex> lock(mtx);
+        statistics.bytesWritten += data.size();
+        return true;
+    };
+    auto writeIndex = [&]() {
+        auto indexOffset = offset;
+        if(write(encodeIndex(index, lastIndex))) {
+            lastIndex = indexOffset;
+            index.clear();
+        }
+    };
+    auto openFile = [&]() -> bool {
+        auto name = info.absolutePath() + "/" + info.completeBaseName() + "_" + QString("%1").arg(fileNumber++, 4, 10, QChar('0'));
+        if(!info.suffix().isEmpty()) {
+            name += "." + info.suffix();
+        }
+        file.setFileName(name);
+        if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            std::lock_guard<std::mutex> lock(mtx);
+            statistics.error = file.errorString();
+            failed = true;
+            return false;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            statistics.files++;
+            statistics.currentFile = name;
+        }
+        offset = 0;
+        lastIndex = 0;
+        index.clear();
+        settings.clear();
+        settingsOffset.clear();
+        fileOpened = QDateTime::currentMSecsSinceEpoch();
+        QByteArray header(fileHeaderSize, Qt::Uninitialized);
+        auto dst = (uchar*) header.data();
+        dst = put<quint32>(dst, fileMagic);
+        dst = put<quint16>(dst, fileVersion);
+        dst = put<quint16>(dst, 0);
+        dst = put<qint64>(dst, fileOpened);
+        return write(header);
+    };
+    auto closeFile = [&]() {
+        if(!file.isOpen()) {
+            return;
+        }
+        if(!failed) {
+            writeIndex();
+        }
+        if(!failed) {
+            QByteArray trailer(trailerSize, Qt::Uninitialized);
+            auto dst = (uchar*) trailer.data();
+            dst = put<quint64>(dst, lastIndex);
+            dst = put<quint32>(dst, indexMagic);
+            dst = put<quint32>(dst, 0);
+            write(trailer);
+        }
+        file.close();
+    };
+
+    while(true) {
+        std::unique_lock<std::mutex> lock(mtx);
+        cv.wait(lock, [this](){
+            return !queue.empty() || stopRequested;
+        });
+        if(queue.empty()) {
+            // stop requested and all sweeps written
+            break;
+        }
+        auto sweep = std::move(queue.front());
+        queue.pop_front();
+        queuedBytes -= sweep.size();
+        auto maxSize = maxFileSize;
+        auto maxDuration = maxFileDuration;
+        if(failed) {
+            statistics.sweepsDropped++;
+            droppedSweepsMetric().increment();
+            continue;
+        }
+        lock.unlock();
+
+        if(file.isOpen() && ((maxSize && offset >= maxSize)
+                             || (maxDuration && QDateTime::currentMSecsSinceEpoch() - fileOpened >= maxDuration * 1000LL))) {
+            closeFile();
+        }
+        if(!file.isOpen() && !openFile()) {
+            continue;
+        }
+        auto s = settingsJSON(sweep);
+        if(settings[sweep.stage] != s) {
+            auto json = QByteArray::fromStdString(s.dump());
+            uchar *dst;
+            auto chunk = createChunk(ChunkType::Settings, (quint32) sweep.stage, json.size(), dst);
+            memcpy(dst, json.data(), json.size());
+            auto chunkOffset = offset;
+            if(!write(chunk)) {
+                continue;
+            }
+            settings[sweep.stage] = s;
+            settingsOffset[sweep.stage] = chunkOffset;
+        }
+        IndexEntry entry;
+        entry.offset = offset;
+        entry.settingsOffset = settingsOffset[sweep.stage];
+        entry.stage = sweep.stage;
+        entry.sweep = sweep.number;
+        entry.timestamp = sweep.timestamp;
+        if(!write(encodeSweep(sweep))) {
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            statistics.sweepsRecorded++;
+        }
+        index.push_back(entry);
+        if(index.size() >= indexInterval) {
+            writeIndex();
+        }
+    }
+    closeFile();
+}
+
+bool SweepRecorder::readIndex(QString filename, std::vector<IndexEntry> &index)
+{
+    index.clear();
+    QFile file(filename);
+    if(!file.open(QIODevice::ReadOnly) || file.size() < fileHeaderSize + trailerSize) {
+        return false;
+    }
+    file.seek(file.size() - trailerSize);
+    auto trailer = file.read(trailerSize);
+    auto src = (const uchar*) trailer.constData();
+    auto indexOffset = get<quint64>(src);
+    if(get<quint32>(src) != indexMagic) {
+        return false;
+    }
+    // follow the chain of index chunks backwards, starting with the last one
+    std::vector<std::vector<IndexEntry>> chunks;
+    while(indexOffset) {
+        if(!file.seek(indexOffset)) {
+            return false;
+        }
+        auto header = file.read(chunkHeaderSize + 2 * sizeof(quint64));
+        if(header.size() != chunkHeaderSize + 2 * sizeof(quint64)) {
+            return false;
+        }
+        src = (const uchar*) header.constData();
+        if(get<quint32>(src) != (quint32) ChunkType::Index) {
+            return false;
+        }
+        get<quint32>(src);
+        get<quint64>(src);
+        auto previous = get<quint64>(src);
+        auto entries = get<quint64>(src);
+        auto data = file.read(entries * indexEntrySize);
+        if((quint64) data.size() != entries * indexEntrySize || (previous && previous >= indexOffset)) {
+            return false;
+        }
+        src = (const uchar*) data.constData();
+        std::vector<IndexEntry> chunk;
+        for(unsigned int i=0;i<entries;i++) {
+            IndexEntry e;
+            e.offset = get<quint64>(src);
+            e.settingsOffset = get<quint64>(src);
+            e.stage = (Stage) get<quint32>(src);
+            get<quint32>(src);
+            e.sweep = get<quint64>(src);
+            e.timestamp = get<qint64>(src);
+            chunk.push_back(e);
+        }
+        chunks.push_back(std::move(chunk));
+        indexOffset = previous;
+    }
+    for(auto it = chunks.rbegin(); it != chunks.rend(); it++) {
+        index.insert(index.end(), it->begin(), it->end());
+    }
+    return true;
+}
+
+bool SweepRecorder::readSweep(QString filename, const IndexEntry &entry, Sweep &sweep)
+{
+    QFile file(filename);
+    if(!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    auto header = file.read(fileHeaderSize);
+    auto src = (const uchar*) header.constData();
+    if(header.size() != fileHeaderSize || get<quint32>(src) != fileMagic) {
+        return false;
+    }
+    // reads the payload of the chunk at the given offset, checking its type and stage
+    auto readChunk = [&](quint64 offset, ChunkType type, QByteArray &payload) -> bool {
+        if(!file.seek(offset)) {
+            return false;
+        }
+        auto chunkHeader = file.read(chunkHeaderSize);
+        if(chunkHeader.size() != chunkHeaderSize) {
+            return false;
+        }
+        auto src = (const uchar*) chunkHeader.constData();
+        if(get<quint32>(src) != (quint32) type || get<quint32>(src) != (quint32) entry.stage) {
+            return false;
+        }
+        auto size = get<quint64>(src);
+        payload = file.read(size);
+        return (quint64) payload.size() == size;
+    };
+    QByteArray json, payload;
+    if(!readChunk(entry.settingsOffset, ChunkType::Settings, json) || !readChunk(entry.offset, ChunkType::Sweep, payload)) {
+        return false;
+    }
+    sweep.stage = entry.stage;
+    return decodeSettings((const uchar*) json.constData(), json.size(), sweep)
+            && decodeSweep((const uchar*) payload.constData(), payload.size(), sweep);
+}
+
+bool SweepRecorder::decodeSettings(const uchar *payload, quint64 size, Sweep &sweep)
+{
+    sweep.channels.clear();
+    sweep.Z0 = 0;
+    try {
+        auto j = nlohmann::json::parse(payload, payload + size);
+        for(auto &c : j.value("channels", nlohmann::json::array())) {
+            sweep.channels.push_back(QString::fromStdString(c.get<std::string>()));
+        }
+        sweep.Z0 = j.value("Z0", 0.0);
+        sweep.settings = SweepSettings();
+        if(j.contains("sweep")) {
+            auto &settings = j["sweep"];
+            sweep.settings.type = QString::fromStdString(settings.value("type", "FREQUENCY"));
+            sweep.settings.zerospan = settings.value("zerospan", false);
+            sweep.settings.start = settings.value("start", 0.0);
+            sweep.settings.stop = settings.value("stop", 0.0);
+            sweep.settings.bandwidth = settings.value("bandwidth", 0.0);
+            sweep.settings.powerStart = settings.value("powerStart", 0.0);
+            sweep.settings.powerStop = settings.value("powerStop", 0.0);
+            sweep.settings.averages = settings.value("averages", 1U);
+        }
+    } catch (const std::exception &e) {
+        qWarning() << "Invalid settings in recording:" << e.what();
+        return false;
+    }
+    return true;
+}
+
+bool SweepRecorder::decodeSweep(const uchar *payload, quint64 size, Sweep &sweep)
+{
+    if(size < 2 * sizeof(quint64) + 2 * sizeof(quint32)) {
+        return false;
+    }
+    auto src = payload;
+    sweep.number = get<quint64>(src);
+    sweep.timestamp = get<qint64>(src);
+    auto points = get<quint32>(src);
+    auto channels = get<quint32>(src);
+    auto valuesPerPoint = sweep.isVNA() ? 2 : 1;
+    quint64 expected = 2 * sizeof(quint64) + 2 * sizeof(quint32) + (quint64) points * sizeof(double) * (sweep.isVNA() ? 2 : 1)
+            + (quint64) points * channels * valuesPerPoint * sizeof(float);
+    if(size != expected || channels != sweep.channels.size()) {
+        return false;
+    }
+    sweep.x.resize(points);
+    for(auto &x : sweep.x) {
+        x = getDouble(src);
+    }
+    sweep.dBm.clear();
+    if(sweep.isVNA()) {
+        sweep.dBm.resize(points);
+        for(auto &dBm : sweep.dBm) {
+            dBm = getDouble(src);
+        }
+    }
+    sweep.data.resize(channels);
+    for(auto &column : sweep.data) {
+        column.resize(points * valuesPerPoint);
+        for(auto &value : column) {
+            value = getFloat(src);
+        }
+    }
+    return true;
+}
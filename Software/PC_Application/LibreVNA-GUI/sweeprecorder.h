@@ -0,0 +1,181 @@
+#ifndef SWEEPRECORDER_H
+#define SWEEPRECORDER_H
+
+#include "Device/devicedriver.h"
+
+#include <QString>
+#include <vector>
+#include <deque>
+#include <set>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+
+// Records complete sweeps of the selected data stages to append-only binary files. Sweeps are collected from the
+// measurement data and handed to a background thread which writes them. At most queueLimit bytes of sweeps wait
+// for the writer, further sweeps are dropped until it has caught up.
+class SweepRecorder
+{
+public:
+    SweepRecorder();
+    ~SweepRecorder();
+
+    enum class Stage : quint8 {
+        VNARaw = 0,
+        VNACalibrated = 1,
+        VNADeembedded = 2,
+        SARaw = 3,
+        SANormalized = 4,
+        Last,
+    };
+    static QString StageToString(Stage s);
+    static Stage StageFromString(QString s);
+
+    // Starts recording the given stages. The files are named <filename without extension>_<number>.<extension>,
+    // numbered from 0 and continued with the next number on rotation
+    bool start(QString filename, std::set<Stage> stages);
+    void stop();
+    bool isRecording() {return recording;}
+
+    // A new file is started when the current file exceeds the size or has been open for the duration (0: no limit)
+    void setRotation(quint64 maxFileSize, unsigned int maxFileDuration);
+    void setQueueLimit(quint64 bytes);
+
+    // Sweep settings of the VNA or SA, recorded in the settings chunks of its stages
+    class SweepSettings {
+    public:
+        SweepSettings() : type("FREQUENCY"), zerospan(false), start(0), stop(0), bandwidth(0), powerStart(0), powerStop(0), averages(1) {}
+        // FREQUENCY or POWER (VNA only)
+        QString type;
+        // the x values of the sweeps are the time in us instead of the frequency
+        bool zerospan;
+        // first and last frequency in Hz (identical for zero span and power sweeps)
+        double start, stop;
+        // IFBW (VNA) or RBW (SA) in Hz
+        double bandwidth;
+        // first and last stimulus level in dBm (VNA only, identical unless sweeping the power)
+        double powerStart, powerStop;
+        unsigned int averages;
+    };
+    // Applies to sweeps starting after the call
+    void setVNASweepSettings(const SweepSettings &s);
+    void setSASweepSettings(const SweepSettings &s);
+
+    void addData(const DeviceDriver::VNAMeasurement &m, Stage stage, bool lastPointOfSweep);
+    void addData(const DeviceDriver::SAMeasurement &m, Stage stage, bool lastPointOfSweep);
+
+    class Statistics {
+    public:
+        quint64 sweepsRecorded;
+        quint64 sweepsDropped;
+        quint64 bytesWritten;
+        unsigned int files;
+        QString currentFile;
+        // last error of the writer thread (empty if no error occurred)
+        QString error;
+    };
+    Statistics getStatistics();
+
+    /*
+     * File format (all values little endian)
+     *
+     * File header (16 bytes):
+     *   uint32 fileMagic, uint16 fileVersion, uint16 reserved, int64 creation time (ms since epoch)
+     * followed by chunks, each starting with
+     *   uint32 ChunkType, uint32 stage (0 for index chunks), uint64 size of the chunk payload in bytes
+     *
+     * ChunkType::Settings: JSON object (UTF-8) describing the following sweeps of this stage: "stage", "channels"
+     *   (names in the order of the sweep data), "points", "Z0" (VNA only) and "sweep" (object with the members of
+     *   SweepSettings: "type", "zerospan", "start", "stop", "span", "bandwidth", "powerStart" and "powerStop" (VNA
+     *   only) and "averages").
+     *   Written before the first sweep of a stage in every file and whenever one of these values changes.
+     * ChunkType::Sweep:
+     *   uint64 sweep number (per stage, counted from the start of the recording), int64 timestamp of the
+     *   last point (ms since epoch), uint32 number of points, uint32 number of channels, followed by columns:
+     *   float64 frequency (or time in us for zero span) of every point, float64 stimulus level in dBm of every
+     *   point (VNA only, the configured level for zero span), and for every channel either a complex float32 (real, imaginary) per point (VNA) or a
+     *   float32 per point (SA)
+     * ChunkType::Index: uint64 offset of the previous index chunk (0 if this is the first one), uint64 number of
+     *   entries, each entry (40 bytes) containing uint64 offset of the sweep chunk, uint64 offset of the settings
+     *   chunk which applies to the sweep, uint32 stage, uint32 reserved, uint64 sweep number, int64 timestamp. An index chunk is written after every indexInterval sweeps and
+     *   when the file is closed.
+     *
+     * File trailer (16 bytes, only present if the file was closed properly):
+     *   uint64 offset of the last index chunk, uint32 indexMagic, uint32 reserved
+     *
+     * Files that were not closed properly can still be read by walking through the chunks from the beginning.
+     */
+    static constexpr quint32 fileMagic = 0x5256584C; // "LXVR"
+    static constexpr quint16 fileVersion = 1;
+    static constexpr quint32 indexMagic = 0x5849564C; // "LVIX"
+    static constexpr unsigned int fileHeaderSize = 16;
+    static constexpr unsigned int chunkHeaderSize = 16;
+    static constexpr unsigned int trailerSize = 16;
+    static constexpr unsigned int indexInterval = 1024;
+    static constexpr unsigned int indexEntrySize = 40;
+    enum class ChunkType : quint32 {
+        Settings = 1,
+        Sweep = 2,
+        Index = 3,
+    };
+
+    class IndexEntry {
+    public:
+        quint64 offset;
+        quint64 settingsOffset;
+        Stage stage;
+        quint64 sweep;
+        qint64 timestamp;
+    };
+    class Sweep {
+    public:
+        Stage stage;
+        quint64 number;
+        qint64 timestamp;
+        double Z0;
+        SweepSettings settings;
+        std::vector<QString> channels;
+        std::vector<double> x;
+        // VNA only
+        std::vector<double> dBm;
+        // one column per channel, VNA: real and imaginary part interleaved, SA: one value per point
+        std::vector<std::vector<float>> data;
+        bool isVNA() const {return stage <= Stage::VNADeembedded;}
+        size_t size() const;
+    };
+    // Reads the index of a recorded file. Returns false if the file has no index (e.g. not closed properly)
+    static bool readIndex(QString filename, std::vector<IndexEntry> &index);
+    // Reads the sweep of an index entry together with the settings which apply to it
+    static bool readSweep(QString filename, const IndexEntry &entry, Sweep &sweep);
+    // Decode the payload of a settings chunk (channels, Z0 and sweep settings) or of a sweep chunk. The stage of the sweep must already be
+    // set and a sweep chunk can only be decoded after the settings which apply to it
+    static bool decodeSettings(const uchar *payload, quint64 size, Sweep &sweep);
+    static bool decodeSweep(const uchar *payload, quint64 size, Sweep &sweep);
+
+private:
+    template<typename T> void collect(Sweep &sweep, const T &m, bool lastPointOfSweep);
+    void writer();
+
+    std::atomic<bool> recording;
+    std::set<Stage> stages;
+    // sweeps currently being collected, one per stage
+    Sweep current[(int) Stage::Last];
+    quint64 sweepCounter[(int) Stage::Last];
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    // everything below is protected by mtx
+    std::deque<Sweep> queue;
+    quint64 queuedBytes;
+    quint64 queueLimit;
+    quint64 maxFileSize;
+    unsigned int maxFileDuration;
+    SweepSettings VNASettings, SASettings;
+    bool stopRequested;
+    QString filename;
+    Statistics statistics;
+    std::thread thread;
+};
+
+#endif // SWEEPRECORDER_H
@@ -6,35 +6,55 @@ TCPServer::TCPServer(int port)
 {
     this->port = port;
     qInfo() << "Listening on port" << port;
-    socket = nullptr;
+    lastConnection = 0;
     server.listen(QHostAddress::Any, port);
     connect(&server, &QTcpServer::newConnection, [&](){
-        // only one connection at a time
-        delete socket;
-        socket = server.nextPendingConnection();
+        auto socket = server.nextPendingConnection();
+        auto connection = ++lastConnection;
+        sockets[connection] = socket;
+        qInfo() << "SCPI connection" << connection << "from" << socket->peerAddress().toString();
         connect(socket, &QTcpSocket::readyRead, [=](){
             while(socket->canReadLine()) {
-                auto available = socket->bytesAvailable();
-                char data[available+1];
-                socket->readLine(data, sizeof(data));
-                auto line = QString(data);
-                emit received(line.trimmed());
+                auto line = QString::fromUtf8(socket->readLine());
+                emit received(line.trimmed(), connection);
             }
         });
-        connect(socket, &QTcpSocket::stateChanged, [&](QAbstractSocket::SocketState state){
+        connect(socket, &QTcpSocket::stateChanged, [=](QAbstractSocket::SocketState state){
             if (state == QAbstractSocket::UnconnectedState)
             {
+                sockets.erase(connection);
                 socket->deleteLater();
-                socket = nullptr;
+                emit disconnected(connection);
             }
         });
     });
 }
 
-bool TCPServer::send(QString line)
+TCPServer::~TCPServer()
 {
-    if (socket) {
-        socket->write(QByteArray::fromStdString(line.toStdString()+'\n'));
+    for(auto const &s : sockets) {
+        // the sockets are deleted together with the server, don't react to their state changes anymore
+        s.second->disconnect();
+        emit disconnected(s.first);
+    }
+}
+
+bool TCPServer::send(QString line, unsigned int connection)
+{
+    auto it = sockets.find(connection);
+    if (it != sockets.end()) {
+        it->second->write(QByteArray::fromStdString(line.toStdString()+'\n'));
+        return true;
+    } else {
+        return false;
+    }
+}
+
+bool TCPServer::sendBlock(QByteArray data, unsigned int connection)
+{
+    auto it = sockets.find(connection);
+    if (it != sockets.end()) {
+        it->second->write(data);
         return true;
     } else {
         return false;
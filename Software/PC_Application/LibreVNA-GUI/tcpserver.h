@@ -4,23 +4,30 @@
 #include <QObject>
 #include <QTcpServer>
 #include <QTcpSocket>
+#include <map>
 
 class TCPServer : public QObject
 {
     Q_OBJECT
 public:
     TCPServer(int port);
+    ~TCPServer();
 
     int getPort() {return port;}
 
 public slots:
-    bool send(QString line);
+    // Multiple clients can be connected at the same time, each one is identified by a connection number (starting at 1)
+    bool send(QString line, unsigned int connection);
+    // sends the data as is, without appending a newline
+    bool sendBlock(QByteArray data, unsigned int connection);
 signals:
-    void received(QString line);
+    void received(QString line, unsigned int connection);
+    void disconnected(unsigned int connection);
 private:
     int port;
     QTcpServer server;
-    QTcpSocket *socket;
+    std::map<unsigned int, QTcpSocket*> sockets;
+    unsigned int lastConnection;
 };
 
 #endif // TCPSERVER_H
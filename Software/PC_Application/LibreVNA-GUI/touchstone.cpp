@@ -10,7 +10,9 @@
 #include <cmath>
 #include <cctype>
 #include <string>
+#include <cstring>
 #include <QDebug>
+#include <QFile>
 
 using namespace std;
 
@@ -136,6 +138,149 @@ stringstream Touchstone::toString(Touchstone::Scale unit, Touchstone::Format for
 }
 
 Touchstone Touchstone::fromFile(string filename)
+{
+    QFile file(QString::fromStdString(filename));
+    if(!file.open(QIODevice::ReadOnly)) {
+        throw runtime_error("Unable to open file:" + filename);
+    }
+
+    unsigned int ports = portsFromFilename(filename);
+    auto ret = Touchstone(ports);
+
+    // map the file into memory if possible, read it otherwise (e.g. empty file)
+    QByteArray contents;
+    const char *begin = nullptr;
+    qint64 size = file.size();
+    auto mapped = size > 0 ? file.map(0, size) : nullptr;
+    if(mapped) {
+        begin = (const char*) mapped;
+    } else {
+        contents = file.readAll();
+        begin = contents.constData();
+        size = contents.size();
+    }
+    const char *end = begin + size;
+
+    Scale unit = Scale::GHz;
+    Format format = Format::RealImaginary;
+    double frequencyScale = 1e9;
+
+    bool option_line_found = false;
+    unsigned int parameter_cnt = 0;
+    unsigned int parameters_per_line;
+    if(ports == 1) {
+        parameters_per_line = 1;
+    } else if(ports == 3) {
+        parameters_per_line = 3;
+    } else {
+        parameters_per_line = 4;
+    }
+    const unsigned int parameters_per_point = ports * ports;
+    bool needs_sort = false;
+    const char *firstPointStart = nullptr;
+
+    Datapoint point;
+    point.S.reserve(parameters_per_point);
+
+    unsigned int lineCnt = 0;
+    const char *pos = begin;
+    while(pos < end) {
+        lineCnt++;
+        auto lineEnd = (const char*) memchr(pos, '\n', end - pos);
+        if(!lineEnd) {
+            lineEnd = end;
+        }
+        auto nextLine = lineEnd < end ? lineEnd + 1 : end;
+        // remove comments
+        auto contentEnd = (const char*) memchr(pos, '!', lineEnd - pos);
+        if(!contentEnd) {
+            contentEnd = lineEnd;
+        }
+        // remove leading whitespace
+        while(pos < contentEnd && Util::isWhitespace(*pos)) {
+            pos++;
+        }
+        if(pos == contentEnd) {
+            // line does only contain whitespace, skip line
+            pos = nextLine;
+            continue;
+        }
+
+        if (*pos == '#') {
+            // this is the option line
+            if (option_line_found) {
+                throw runtime_error("Additional option line present");
+            }
+            option_line_found = true;
+            parseOptionLine(string(pos, contentEnd), unit, format, ret.referenceImpedance);
+            switch(unit) {
+                case Scale::Hz: frequencyScale = 1.0; break;
+                case Scale::kHz: frequencyScale = 1e3; break;
+                case Scale::MHz: frequencyScale = 1e6; break;
+                case Scale::GHz: frequencyScale = 1e9; break;
+            }
+        } else {
+            // not the option line
+            if(!option_line_found) {
+                throw runtime_error("First dataline before option line");
+            }
+            if (parameter_cnt == 0) {
+                if(!firstPointStart) {
+                    firstPointStart = pos;
+                }
+                if(!Util::parseDouble(pos, contentEnd, point.frequency)) {
+                    throw runtime_error("Failed to parse frequency on line "+std::to_string(lineCnt));
+                }
+                point.frequency *= frequencyScale;
+                point.S.clear();
+            }
+            for(unsigned int i=0;i<parameters_per_line;i++) {
+                double part1, part2;
+                if(!Util::parseDouble(pos, contentEnd, part1) || !Util::parseDouble(pos, contentEnd, part2)) {
+                    throw runtime_error("Failed to parse parameters on line "+std::to_string(lineCnt)+" with frequency "+Unit::ToString(point.frequency,"Hz", " kMG", 10).toStdString());
+                }
+                switch(format) {
+                case Format::MagnitudeAngle:
+                    point.S.push_back(polar(part1, part2 / 180.0 * M_PI));
+                    break;
+                case Format::DBAngle:
+                    point.S.push_back(polar(pow(10, part1/20), part2 / 180.0 * M_PI));
+                    break;
+                case Format::RealImaginary:
+                    point.S.push_back(complex<double>(part1, part2));
+                    break;
+                }
+                parameter_cnt++;
+                if(parameter_cnt >= parameters_per_point) {
+                    parameter_cnt = 0;
+                    if(ports == 2) {
+                        // 2 port touchstone has S11 S21 S12 S22 order, swap S12 and S21
+                        swap(point.S[1], point.S[2]);
+                    }
+                    if(ret.m_datapoints.empty()) {
+                        // estimate the number of points from the size of the first one
+                        auto bytesPerPoint = nextLine - firstPointStart;
+                        ret.m_datapoints.reserve((end - firstPointStart) / bytesPerPoint + 1);
+                    } else if(ret.m_datapoints.back().frequency >= point.frequency) {
+                        needs_sort = true;
+                    }
+                    ret.m_datapoints.push_back(point);
+                    break;
+                }
+            }
+        }
+        pos = nextLine;
+    }
+    if(needs_sort) {
+        sort(ret.m_datapoints.begin(), ret.m_datapoints.end(), [](Datapoint &a, Datapoint &b) {
+           return a.frequency < b.frequency;
+        });
+    }
+    ret.filename = QString::fromStdString(filename);
+    return ret;
+}
+
+Touchstone Touchstone::fromFileLegacy(string filename)
 {
     ifstream file;
     file.open(filename);
@@ -144,14 +289,7 @@ Touchstone Touchstone::fromFile(string filename)
         throw runtime_error("Unable to open file:" + filename);
     }
 
-    // extract number of ports from filename
-    auto index_extension = filename.find_last_of('.');
-    if((filename[index_extension + 1] != 's' && filename[index_extension + 1] != 'S')
-            || filename[index_extension+2] < '1' || filename[index_extension+2] > '9'
-            || (filename[index_extension+3] != 'p' && filename[index_extension+3] != 'P')) {
-        throw runtime_error("Invalid filename extension");
-    }
-    unsigned int ports = filename[index_extension + 2] - '0';
+    unsigned int ports = portsFromFilename(filename);
     auto ret = Touchstone(ports);
 
     Scale unit = Scale::GHz;
@@ -185,50 +323,7 @@ Touchstone Touchstone::fromFile(string filename)
                 throw runtime_error("Additional option line present");
             }
             option_line_found = true;
-            transform(line.begin(), line.end(), line.begin(), ::toupper);
-            // check individual options
-            line.erase(0,1);
-            istringstream iss(line);
-            bool last_R = false;
-            string s;
-            for(;iss>>s;) {
-                if(last_R) {
-                    last_R = false;
-                    // read reference impedance
-                    ret.referenceImpedance = stod(s, nullptr);
-                    break;
-                }
-                if (!s.compare("HZ")) {
-                    unit = Scale::Hz;
-                } else if (!s.compare("KHZ")) {
-                    unit = Scale::kHz;
-                } else if (!s.compare("MHZ")) {
-                    unit = Scale::MHz;
-                } else if (!s.compare("GHZ")) {
-                    unit = Scale::GHz;
-                } else if (!s.compare("S")) {
-                    // S parameter, nothing to do
-                } else if (!s.compare("Y")) {
-                   throw runtime_error("Y parameters not supported");
-                } else if (!s.compare("Z")) {
-                    throw runtime_error("Z parameters not supported");
-                } else if (!s.compare("G")) {
-                    throw runtime_error("G parameters not supported");
-                } else if (!s.compare("H")) {
-                    throw runtime_error("H parameters not supported");
-                } else if(!s.compare("MA")) {
-                    format = Format::MagnitudeAngle;
-                } else if(!s.compare("DB")) {
-                    format = Format::DBAngle;
-                } else if(!s.compare("RI")) {
-                    format = Format::RealImaginary;
-                } else if(!s.compare("R")) {
-                    // next option is the reference impedance
-                    last_R = true;
-                } else {
-                    throw runtime_error("Unexpected option in option line");
-                }
-            }
+            parseOptionLine(line, unit, format, ret.referenceImpedance);
         } else {
             // not the option line
             if(!option_line_found) {
@@ -292,6 +387,66 @@ Touchstone Touchstone::fromFile(string filename)
     return ret;
 }
 
+unsigned int Touchstone::portsFromFilename(const string &filename)
+{
+    // extract number of ports from filename
+    auto index_extension = filename.find_last_of('.');
+    if((filename[index_extension + 1] != 's' && filename[index_extension + 1] != 'S')
+            || filename[index_extension+2] < '1' || filename[index_extension+2] > '9'
+            || (filename[index_extension+3] != 'p' && filename[index_extension+3] != 'P')) {
+        throw runtime_error("Invalid filename extension");
+    }
+    return filename[index_extension + 2] - '0';
+}
+
+void Touchstone::parseOptionLine(string line, Scale &unit, Format &format, double &referenceImpedance)
+{
+    transform(line.begin(), line.end(), line.begin(), ::toupper);
+    // check individual options
+    line.erase(0,1);
+    istringstream iss(line);
+    bool last_R = false;
+    string s;
+    for(;iss>>s;) {
+        if(last_R) {
+            last_R = false;
+            // read reference impedance
+            referenceImpedance = stod(s, nullptr);
+            break;
+        }
+        if (!s.compare("HZ")) {
+            unit = Scale::Hz;
+        } else if (!s.compare("KHZ")) {
+            unit = Scale::kHz;
+        } else if (!s.compare("MHZ")) {
+            unit = Scale::MHz;
+        } else if (!s.compare("GHZ")) {
+            unit = Scale::GHz;
+        } else if (!s.compare("S")) {
+            // S parameter, nothing to do
+        } else if (!s.compare("Y")) {
+           throw runtime_error("Y parameters not supported");
+        } else if (!s.compare("Z")) {
+            throw runtime_error("Z parameters not supported");
+        } else if (!s.compare("G")) {
+            throw runtime_error("G parameters not supported");
+        } else if (!s.compare("H")) {
+            throw runtime_error("H parameters not supported");
+        } else if(!s.compare("MA")) {
+            format = Format::MagnitudeAngle;
+        } else if(!s.compare("DB")) {
+            format = Format::DBAngle;
+        } else if(!s.compare("RI")) {
+            format = Format::RealImaginary;
+        } else if(!s.compare("R")) {
+            // next option is the reference impedance
+            last_R = true;
+        } else {
+            throw runtime_error("Unexpected option in option line");
+        }
+    }
+}
+
 double Touchstone::minFreq()
 {
     if (m_datapoints.size() > 0) {
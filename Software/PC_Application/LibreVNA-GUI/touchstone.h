@@ -36,6 +36,9 @@ public:
     void toFile(QString filename, Scale unit = Scale::GHz, Format format = Format::RealImaginary);
     std::stringstream toString(Scale unit = Scale::GHz, Format format = Format::RealImaginary);
     static Touchstone fromFile(std::string filename);
+    // Previous parser (reads the file line by line and converts the numbers with string streams). Considerably
+    // slower than fromFile() for large files, only kept as a reference for tests and benchmarks
+    static Touchstone fromFileLegacy(std::string filename);
     double minFreq();
     double maxFreq();
     unsigned int points() { return m_datapoints.size(); }
@@ -57,6 +60,9 @@ public:
 
 
 private:
+    static unsigned int portsFromFilename(const std::string &filename);
+    static void parseOptionLine(std::string line, Scale &unit, Format &format, double &referenceImpedance);
+
     unsigned int m_ports;
     double referenceImpedance;
     std::vector<Datapoint> m_datapoints;
@@ -1,6 +1,13 @@
 #include "utiltests.h"
 #include "portextensiontests.h"
 #include "parametertests.h"
+#include "streamingtests.h"
+#include "scpitests.h"
+#include "touchstonetests.h"
+#include "sweeprecordertests.h"
+#include "simulatortests.h"
+#include "packetlogtests.h"
+#include "protocoltests.h"
 
 #include <QtTest>
 
@@ -12,6 +19,13 @@ int main(int argc, char *argv[])
     status |= QTest::qExec(new UtilTests, argc, argv);
     status |= QTest::qExec(new PortExtensionTests, argc, argv);
     status |= QTest::qExec(new ParameterTests, argc, argv);
+    status |= QTest::qExec(new StreamingTests, argc, argv);
+    status |= QTest::qExec(new SCPITests, argc, argv);
+    status |= QTest::qExec(new TouchstoneTests, argc, argv);
+    status |= QTest::qExec(new SweepRecorderTests, argc, argv);
+    status |= QTest::qExec(new SimulatorTests, argc, argv);
+    status |= QTest::qExec(new PacketLogTests, argc, argv);
+    status |= QTest::qExec(new ProtocolTests, argc, argv);
 
     return status;
 }
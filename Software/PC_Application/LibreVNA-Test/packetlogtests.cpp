@@ -0,0 +1,361 @@
+#include "packetlogtests.h"
+
+#include "Device/LibreVNA/devicepacketlog.h"
+#include "Device/LibreVNA/devicepacketlogview.h"
+#include "Device/devicelog.h"
+#include "preferences.h"
+
+#include <thread>
+
+using namespace std;
+
+static vector<uint8_t> encode(const Protocol::PacketInfo &p)
+{
+    uint8_t buffer[1024];
+    auto length = Protocol::EncodePacket(p, buffer, sizeof(buffer));
+    return vector<uint8_t>(buffer, buffer + length);
+}
+
+// the frequency identifies the datapoint (the point number is only 16 bit wide)
+static vector<uint8_t> encodeDatapoint(uint64_t frequency, float value)
+{
+    Protocol::VNADatapoint<32> d;
+    d.pointNum = frequency;
+    d.frequency = frequency;
+    for(unsigned int i=0;i<4;i++) {
+        d.addValue(value, -value, 0, 1 << i);
+    }
+    Protocol::PacketInfo p;
+    p.type = Protocol::PacketType::VNADatapoint;
+    p.VNAdatapoint = &d;
+    return encode(p);
+}
+
+static vector<uint8_t> encodeDatapointBlock(uint64_t frequency, float value)
+{
+    Protocol::VNADatapoint<32> d;
+    d.pointNum = frequency;
+    d.frequency = frequency;
+    d.addValue(value, -value, 0, 1);
+    Protocol::VNADatapointBlock block;
+    block.clear(0);
+    block.addPoint(d);
+    Protocol::PacketInfo p;
+    p.type = Protocol::PacketType::VNADatapointBlock;
+    p.VNAdatapointBlock = &block;
+    return encode(p);
+}
+
+PacketLogTests::PacketLogTests()
+{
+
+}
+
+void PacketLogTests::init()
+{
+    auto &log = DevicePacketLog::getInstance();
+    log.setEnabled(true);
+    log.setExcluded(Protocol::PacketType::VNADatapoint, false);
+    log.setExcluded(Protocol::PacketType::VNADatapointBlock, false);
+    log.reset();
+}
+
+void PacketLogTests::cleanup()
+{
+    auto &log = DevicePacketLog::getInstance();
+    log.reset();
+    log.applyPreferences();
+}
+
+void PacketLogTests::RoundTrip()
+{
+    auto &log = DevicePacketLog::getInstance();
+
+    Protocol::PacketInfo p;
+    p.type = Protocol::PacketType::SweepSettings;
+    p.settings = {};
+    p.settings.f_start = 1000000;
+    p.settings.f_stop = 6000000000;
+    p.settings.points = 501;
+    auto settings = encode(p);
+    log.addPacket(p.type, settings.data(), settings.size());
+
+    // bytes in front of the packet are skipped when decoding
+    auto datapoint = encodeDatapoint(42, 0.5f);
+    datapoint.insert(datapoint.begin(), {0x01, 0x02});
+    log.addPacket(Protocol::PacketType::VNADatapoint, datapoint.data(), datapoint.size(), "LIBREVNA1234");
+
+    vector<uint8_t> invalid = {0x5A, 0x00, 0x01};
+    log.addInvalidBytes(invalid.data(), invalid.size(), "LIBREVNA1234");
+
+    auto entries = log.getEntries();
+    QVERIFY(entries.size() == 3);
+
+    QVERIFY(entries[0].type == DevicePacketLog::LogEntry::Type::Packet);
+    QCOMPARE(entries[0].serial, QString(""));
+    QVERIFY(entries[0].bytes == settings);
+    QVERIFY(entries[0].p);
+    QVERIFY(entries[0].p->type == Protocol::PacketType::SweepSettings);
+    QCOMPARE(entries[0].p->settings.f_stop, (uint64_t) 6000000000);
+    QCOMPARE(entries[0].p->settings.points, (uint16_t) 501);
+    QVERIFY(!entries[0].datapoint);
+    QVERIFY(qAbs(entries[0].timestamp.msecsTo(QDateTime::currentDateTimeUtc())) < 10000);
+
+    QCOMPARE(entries[1].serial, QString("LIBREVNA1234"));
+    QVERIFY(entries[1].p);
+    QVERIFY(entries[1].p->type == Protocol::PacketType::VNADatapoint);
+    QVERIFY(entries[1].datapoint);
+    QCOMPARE(entries[1].datapoint->frequency, (uint64_t) 42);
+    QCOMPARE(entries[1].datapoint->getNumValues(), 4U);
+    QCOMPARE(entries[1].datapoint->getValue(2).value, complex<double>(0.5, -0.5));
+
+    QVERIFY(entries[2].type == DevicePacketLog::LogEntry::Type::InvalidBytes);
+    QVERIFY(entries[2].bytes == invalid);
+    QVERIFY(!entries[2].p);
+
+    // decoding can be deferred, the packet type is known anyway
+    unsigned long long position = 0;
+    auto undecoded = log.getEntries(position, false);
+    QVERIFY(undecoded.size() == 3);
+    QVERIFY(undecoded[0].packetType == Protocol::PacketType::SweepSettings);
+    QVERIFY(undecoded[1].packetType == Protocol::PacketType::VNADatapoint);
+    QVERIFY(undecoded[2].packetType == Protocol::PacketType::None);
+    QVERIFY(!undecoded[1].p);
+    undecoded[1].decode();
+    QVERIFY(undecoded[1].datapoint);
+    QCOMPARE(undecoded[1].datapoint->frequency, (uint64_t) 42);
+
+    // saved logs can be loaded again
+    auto j = log.toJSON();
+    log.reset();
+    QVERIFY(log.getEntries().empty());
+    log.fromJSON(j);
+    auto loaded = log.getEntries();
+    QVERIFY(loaded.size() == 3);
+    QCOMPARE(loaded[0].timestamp, entries[0].timestamp);
+    QCOMPARE(loaded[0].p->settings.points, (uint16_t) 501);
+    QCOMPARE(loaded[1].datapoint->frequency, (uint64_t) 42);
+    QVERIFY(loaded[1].packetType == Protocol::PacketType::VNADatapoint);
+    QCOMPARE(loaded[1].serial, QString("LIBREVNA1234"));
+    QVERIFY(loaded[2].bytes == invalid);
+}
+
+void PacketLogTests::Filtering()
+{
+    auto &log = DevicePacketLog::getInstance();
+    Protocol::PacketInfo p;
+    p.type = Protocol::PacketType::RequestDeviceInfo;
+    auto request = encode(p);
+    auto datapoint = encodeDatapoint(1, 1.0f);
+
+    log.setEnabled(false);
+    QVERIFY(!log.isLogged(Protocol::PacketType::RequestDeviceInfo));
+    log.addPacket(p.type, request.data(), request.size());
+    log.addInvalidBytes(request.data(), request.size());
+    QVERIFY(log.getEntries().empty());
+    QCOMPARE(log.getUsedStorageSize(), 0UL);
+
+    log.setEnabled(true);
+    log.setExcluded(Protocol::PacketType::VNADatapoint, true);
+    QVERIFY(log.isExcluded(Protocol::PacketType::VNADatapoint));
+    QVERIFY(!log.isExcluded(Protocol::PacketType::RequestDeviceInfo));
+    log.addPacket(Protocol::PacketType::VNADatapoint, datapoint.data(), datapoint.size());
+    log.addPacket(p.type, request.data(), request.size());
+    auto entries = log.getEntries();
+    QVERIFY(entries.size() == 1);
+    QVERIFY(entries[0].p->type == Protocol::PacketType::RequestDeviceInfo);
+
+    log.setExcluded(Protocol::PacketType::VNADatapoint, false);
+    log.addPacket(Protocol::PacketType::VNADatapoint, datapoint.data(), datapoint.size());
+    QVERIFY(log.getEntries().size() == 2);
+
+    // without measurement data, neither single datapoints nor blocks are logged
+    auto &pref = Preferences::getInstance();
+    auto measurementData = pref.Debug.USBlogMeasurementData;
+    auto enabled = pref.Debug.USBlogEnabled;
+    pref.Debug.USBlogEnabled = true;
+    pref.Debug.USBlogMeasurementData = false;
+    log.applyPreferences();
+    pref.Debug.USBlogMeasurementData = measurementData;
+    pref.Debug.USBlogEnabled = enabled;
+    QVERIFY(log.isExcluded(Protocol::PacketType::VNADatapoint));
+    QVERIFY(log.isExcluded(Protocol::PacketType::VNADatapointBlock));
+    QVERIFY(log.isExcluded(Protocol::PacketType::SpectrumAnalyzerResult));
+    auto block = encodeDatapointBlock(2, 2.0f);
+    log.addPacket(Protocol::PacketType::VNADatapointBlock, block.data(), block.size());
+    log.addPacket(Protocol::PacketType::VNADatapoint, datapoint.data(), datapoint.size());
+    QVERIFY(log.getEntries().size() == 2);
+
+    log.setExcluded(Protocol::PacketType::VNADatapointBlock, false);
+    log.addPacket(Protocol::PacketType::VNADatapointBlock, block.data(), block.size());
+    entries = log.getEntries();
+    QVERIFY(entries.size() == 3);
+    QVERIFY(entries[2].p->type == Protocol::PacketType::VNADatapointBlock);
+}
+
+void PacketLogTests::Overwrite()
+{
+    auto &log = DevicePacketLog::getInstance();
+    unsigned long long position = 0;
+    QVERIFY(log.getEntries(position).empty());
+
+    auto addDatapoint = [&](uint64_t id) {
+        auto datapoint = encodeDatapoint(id, id);
+        log.addPacket(Protocol::PacketType::VNADatapoint, datapoint.data(), datapoint.size());
+    };
+    addDatapoint(0);
+    // all records have the same size, fill the log twice
+    auto recordSize = log.getUsedStorageSize();
+    uint64_t count = 2 * log.getMaxStorageSize() / recordSize;
+    for(uint64_t i=1;i<count;i++) {
+        addDatapoint(i);
+    }
+    QCOMPARE(log.getUsedStorageSize(), log.getMaxStorageSize());
+
+    unsigned long kept;
+    {
+        auto entries = log.getEntries();
+        kept = entries.size();
+        QVERIFY(kept > 0);
+        QVERIFY(kept <= log.getMaxStorageSize() / recordSize);
+        // only the newest entries are kept
+        for(unsigned long i=0;i<kept;i++) {
+            QVERIFY(entries[i].datapoint);
+            QCOMPARE(entries[i].datapoint->frequency, (uint64_t) (count - kept + i));
+        }
+    }
+
+    // the old position has been overwritten, continues with the oldest remaining entry
+    QVERIFY(log.getEntries(position).size() == kept);
+    QVERIFY(log.getEntries(position).empty());
+    addDatapoint(count);
+    auto continued = log.getEntries(position);
+    QVERIFY(continued.size() == 1);
+    QCOMPARE(continued[0].datapoint->frequency, count);
+}
+
+void PacketLogTests::ConcurrentWriters()
+{
+    auto &log = DevicePacketLog::getInstance();
+    constexpr unsigned int threads = 4;
+    constexpr unsigned int packets = 10000;
+
+    vector<thread> writers;
+    for(unsigned int t=0;t<threads;t++) {
+        writers.emplace_back([=, &log](){
+            auto serial = "LIBREVNA"+QString::number(t);
+            for(unsigned int i=0;i<packets;i++) {
+                auto datapoint = encodeDatapoint(t * packets + i, i);
+                log.addPacket(Protocol::PacketType::VNADatapoint, datapoint.data(), datapoint.size(), serial);
+            }
+        });
+    }
+
+    // read while the entries are added
+    unsigned long long position = 0;
+    vector<DevicePacketLog::LogEntry> entries;
+    auto readEntries = [&](){
+        for(auto &e : log.getEntries(position)) {
+            entries.push_back(e);
+        }
+    };
+    while(entries.size() < threads * packets && log.getUsedStorageSize() < log.getMaxStorageSize()) {
+        readEntries();
+    }
+    for(auto &w : writers) {
+        w.join();
+    }
+    readEntries();
+
+    vector<int> last(threads, -1);
+    for(auto &e : entries) {
+        QVERIFY(e.datapoint);
+        auto t = e.datapoint->frequency / packets;
+        auto i = e.datapoint->frequency % packets;
+        QVERIFY(t < threads);
+        QCOMPARE(e.serial, "LIBREVNA"+QString::number(t));
+        QCOMPARE(e.datapoint->getValue(0).value, complex<double>(i, -(double) i));
+        // the entries of one thread are in order
+        QVERIFY((int) i > last[t]);
+        last[t] = i;
+    }
+    if(log.getUsedStorageSize() < log.getMaxStorageSize()) {
+        // nothing has been overwritten, all entries must have been read
+        QVERIFY(entries.size() == threads * packets);
+    }
+}
+
+void PacketLogTests::PacketLogModel()
+{
+    auto &log = DevicePacketLog::getInstance();
+    Protocol::PacketInfo p;
+    p.type = Protocol::PacketType::RequestDeviceInfo;
+    auto request = encode(p);
+    log.addPacket(p.type, request.data(), request.size(), "1234");
+    for(unsigned int i=0;i<10;i++) {
+        auto datapoint = encodeDatapoint(i, i);
+        log.addPacket(Protocol::PacketType::VNADatapoint, datapoint.data(), datapoint.size(), "1234");
+    }
+
+    DevicePacketLogModel model;
+    QCOMPARE(model.rowCount(), 11);
+    QCOMPARE(model.data(model.index(0, 3)).toString(), QString("Type 15(RequestDeviceInfo)"));
+    QCOMPARE(model.data(model.index(1, 1)).toString(), QString("1234"));
+
+    // the content is decoded when the entry is expanded
+    auto entry = model.index(1, 0);
+    QVERIFY(model.hasChildren(entry));
+    QVERIFY(model.rowCount(entry) > 0);
+    auto child = model.index(0, 2, entry);
+    QVERIFY(child.isValid());
+    QCOMPARE(model.parent(child), entry);
+
+    // new entries are added in batches
+    log.addPacket(p.type, request.data(), request.size());
+    QTRY_COMPARE(model.rowCount(), 12);
+    QCOMPARE(model.data(model.index(11, 1)).toString(), QString("LibreVNA-GUI"));
+
+    model.setFilter("datapoint");
+    QTRY_COMPARE(model.rowCount(), 10);
+    QVERIFY(model.getEntryCount() == 12);
+    QCOMPARE(model.parent(model.index(0, 0, model.index(3, 0))), model.index(3, 0));
+    model.setFilter("");
+    QCOMPARE(model.rowCount(), 12);
+
+    model.clear();
+    QCOMPARE(model.rowCount(), 0);
+    model.reload();
+    QCOMPARE(model.rowCount(), 12);
+}
+
+void PacketLogTests::DeviceLogModel()
+{
+    ::DeviceLogModel model;
+    for(unsigned int i=0;i<100;i++) {
+        model.addLine("[1,"+QString(i % 10 ? "INF" : "ERR")+"] line "+QString::number(i));
+    }
+    // lines are inserted in one batch
+    QCOMPARE(model.rowCount(), 0);
+    QTRY_COMPARE(model.rowCount(), 100);
+    QCOMPARE(model.data(model.index(0, 0)).toString(), QString("[1,ERR] line 0"));
+    QVERIFY(model.data(model.index(0, 0), Qt::ForegroundRole).isValid());
+    QVERIFY(!model.data(model.index(1, 0), Qt::ForegroundRole).isValid());
+
+    model.setFilter("err");
+    QTRY_COMPARE(model.rowCount(), 10);
+    QCOMPARE(model.data(model.index(1, 0)).toString(), QString("[1,ERR] line 10"));
+    // lines added while filtering are filtered as well
+    model.addLine("[1,ERR] line 100");
+    model.addLine("[1,INF] line 101");
+    QTRY_COMPARE(model.rowCount(), 11);
+
+    model.setLineLimit(50);
+    QCOMPARE(model.rowCount(), 5);
+    QVERIFY(model.getLines().size() == 50);
+    QCOMPARE(model.data(model.index(0, 0)).toString(), QString("[1,ERR] line 60"));
+
+    model.setFilter("");
+    QCOMPARE(model.rowCount(), 50);
+    model.clear();
+    QCOMPARE(model.rowCount(), 0);
+}
@@ -0,0 +1,24 @@
+#ifndef PACKETLOGTESTS_H
+#define PACKETLOGTESTS_H
+
+#include <QtTest>
+
+class PacketLogTests : public QObject
+{
+    Q_OBJECT
+public:
+    PacketLogTests();
+
+private slots:
+    void init();
+    void cleanup();
+
+    void RoundTrip();
+    void Filtering();
+    void Overwrite();
+    void ConcurrentWriters();
+    void PacketLogModel();
+    void DeviceLogModel();
+};
+
+#endif // PACKETLOGTESTS_H
@@ -0,0 +1,233 @@
+#include "protocoltests.h"
+
+#include "../../VNA_embedded/Application/Communication/Protocol.hpp"
+
+#include <cmath>
+#include <random>
+
+using namespace std;
+
+static Protocol::VNADatapoint<32> createDatapoint(unsigned int pointNum = 123)
+{
+    Protocol::VNADatapoint<32> d;
+    d.pointNum = pointNum;
+    d.frequency = 1000000000 + pointNum * 1000;
+    d.cdBm = -1000;
+    for(unsigned int stage=0;stage<2;stage++) {
+        d.addValue(0.1 + stage, -0.2, stage, (int) Protocol::Source::Port1);
+        d.addValue(0.3, 0.4 - stage, stage, (int) Protocol::Source::Port2);
+        d.addValue(1.0, 0.0, stage, (int) Protocol::Source::Reference);
+    }
+    return d;
+}
+
+ProtocolTests::ProtocolTests()
+{
+
+}
+
+void ProtocolTests::CRC32()
+{
+    mt19937 rng(1);
+    vector<uint8_t> data(4096);
+    for(auto &d : data) {
+        d = rng();
+    }
+    // all lengths around the 8 byte blocks and all alignments
+    for(unsigned int offset=0;offset<8;offset++) {
+        for(unsigned int len=0;len<=64;len++) {
+            QCOMPARE(Protocol::CRC32(0, &data[offset], len), Protocol::CRC32Bitwise(0, &data[offset], len));
+        }
+    }
+    QCOMPARE(Protocol::CRC32(0, data.data(), data.size()), Protocol::CRC32Bitwise(0, data.data(), data.size()));
+    // known check value of the CRC-32 (ISO-HDLC)
+    QCOMPARE(Protocol::CRC32(0, "123456789", 9), (uint32_t) 0xCBF43926);
+    // the CRC can be calculated in chunks (as done for the firmware update)
+    uint32_t crc = 0;
+    for(unsigned int i=0;i<data.size();i+=333) {
+        crc = Protocol::CRC32(crc, &data[i], min(333U, (unsigned int) data.size() - i));
+    }
+    QCOMPARE(crc, Protocol::CRC32Bitwise(0, data.data(), data.size()));
+}
+
+void ProtocolTests::DatapointCRC()
+{
+    auto d = createDatapoint();
+    Protocol::PacketInfo p;
+    p.type = Protocol::PacketType::VNADatapoint;
+    p.VNAdatapoint = &d;
+
+    for(bool withCRC : {false, true}) {
+        uint8_t buffer[512];
+        auto len = Protocol::EncodePacket(p, buffer, sizeof(buffer), withCRC);
+        QVERIFY(len > 0);
+        uint32_t crc;
+        memcpy(&crc, &buffer[len - 4], sizeof(crc));
+        QCOMPARE(crc, withCRC ? Protocol::CRC32(0, buffer, len - 4) : (uint32_t) 0);
+
+        Protocol::PacketInfo decoded;
+        QCOMPARE(Protocol::DecodeBuffer(buffer, len, &decoded), len);
+        QVERIFY(decoded.type == Protocol::PacketType::VNADatapoint);
+        QVERIFY(decoded.VNAdatapoint->frequency == d.frequency);
+        QCOMPARE(decoded.VNAdatapoint->getNumValues(), d.getNumValues());
+        delete decoded.VNAdatapoint;
+
+        // corrupted datapoints are only detected with the CRC
+        buffer[10] ^= 0x01;
+        Protocol::DecodeBuffer(buffer, len, &decoded);
+        if(withCRC) {
+            QVERIFY(decoded.type == Protocol::PacketType::None);
+        } else {
+            QVERIFY(decoded.type == Protocol::PacketType::VNADatapoint);
+            delete decoded.VNAdatapoint;
+        }
+    }
+}
+
+void ProtocolTests::HalfPrecision()
+{
+    // every half converts to a float and back without change (except for the payload of NaNs)
+    for(unsigned int i=0;i<=UINT16_MAX;i++) {
+        uint16_t h = i;
+        float f = Protocol::HalfToFloat(h);
+        if(std::isnan(f)) {
+            QVERIFY((Protocol::FloatToHalf(f) & 0x7C00) == 0x7C00);
+            QVERIFY(Protocol::FloatToHalf(f) & 0x03FF);
+        } else {
+            QCOMPARE(Protocol::FloatToHalf(f), h);
+        }
+    }
+    QCOMPARE(Protocol::HalfToFloat(Protocol::FloatToHalf(1.0f)), 1.0f);
+    QCOMPARE(Protocol::HalfToFloat(Protocol::FloatToHalf(-65504.0f)), -65504.0f);
+    QVERIFY(std::isinf(Protocol::HalfToFloat(Protocol::FloatToHalf(1e6f))));
+    // smallest subnormal and rounding to nearest even
+    QCOMPARE(Protocol::HalfToFloat(Protocol::FloatToHalf(ldexpf(1.0f, -24))), ldexpf(1.0f, -24));
+    QCOMPARE(Protocol::FloatToHalf(1.0f + ldexpf(1.0f, -11)), (uint16_t) 0x3C00);
+    QCOMPARE(Protocol::FloatToHalf(1.0f + 3 * ldexpf(1.0f, -11)), (uint16_t) 0x3C02);
+    // random values (in the range of normal halfs) are converted with a relative error of at most 2^-11
+    mt19937 rng(2);
+    uniform_real_distribution<float> mantissa(0.5f, 1.0f);
+    uniform_int_distribution<int> exponent(-13, 15);
+    for(unsigned int i=0;i<10000;i++) {
+        float f = ldexpf(mantissa(rng), exponent(rng)) * (rng() & 0x01 ? 1 : -1);
+        float converted = Protocol::HalfToFloat(Protocol::FloatToHalf(f));
+        QVERIFY(fabsf(converted - f) <= fabsf(f) * ldexpf(1.0f, -11));
+    }
+}
+
+void ProtocolTests::DatapointBlock()
+{
+    for(uint8_t flags : {0, 1, 2, 3}) {
+        bool half = flags & Protocol::VNADatapointBlock::HalfPrecision;
+        bool omitted = flags & Protocol::VNADatapointBlock::FrequencyOmitted;
+        Protocol::VNADatapointBlock block;
+        block.clear(flags);
+        vector<Protocol::VNADatapoint<32>> points;
+        for(unsigned int i=0;i<5;i++) {
+            points.push_back(createDatapoint(100 + i));
+            QVERIFY(block.addPoint(points.back()));
+        }
+        // only consecutive points with the same values
+        auto other = createDatapoint(106);
+        QVERIFY(!block.addPoint(other));
+        other = createDatapoint(105);
+        other.addValue(1.0, 1.0, 3, (int) Protocol::Source::Port1);
+        QVERIFY(!block.addPoint(other));
+        QCOMPARE(block.getNumPoints(), (uint8_t) 5);
+
+        for(bool withCRC : {false, true}) {
+            Protocol::PacketInfo p;
+            p.type = Protocol::PacketType::VNADatapointBlock;
+            p.VNAdatapointBlock = &block;
+            uint8_t buffer[512];
+            auto len = Protocol::EncodePacket(p, buffer, sizeof(buffer), withCRC);
+            QVERIFY(len > 0);
+
+            Protocol::PacketInfo decoded;
+            QCOMPARE(Protocol::DecodeBuffer(buffer, len, &decoded), len);
+            QVERIFY(decoded.type == Protocol::PacketType::VNADatapointBlock);
+            QCOMPARE(decoded.VNAdatapointBlock->getFlags(), flags);
+            QCOMPARE(decoded.VNAdatapointBlock->getNumPoints(), (uint8_t) points.size());
+            for(unsigned int i=0;i<points.size();i++) {
+                Protocol::VNADatapoint<32> d;
+                QVERIFY(decoded.VNAdatapointBlock->getPoint(i, d));
+                QCOMPARE(d.pointNum, points[i].pointNum);
+                QCOMPARE(d.cdBm, points[i].cdBm);
+                QVERIFY(d.frequency == (omitted ? 0 : points[i].frequency));
+                QCOMPARE(d.getNumValues(), points[i].getNumValues());
+                for(unsigned int j=0;j<d.getNumValues();j++) {
+                    auto v = d.getValue(j);
+                    auto expected = points[i].getValue(j);
+                    QCOMPARE(v.flags, expected.flags);
+                    if(half) {
+                        // relative to the largest value of the point
+                        QVERIFY(abs(v.value - expected.value) < 1e-3);
+                    } else {
+                        QCOMPARE(v.value, expected.value);
+                    }
+                }
+            }
+            QVERIFY(!decoded.VNAdatapointBlock->getPoint(points.size(), other));
+            delete decoded.VNAdatapointBlock;
+
+            // corrupted blocks are only detected with the CRC
+            buffer[20] ^= 0x01;
+            Protocol::DecodeBuffer(buffer, len, &decoded);
+            if(withCRC) {
+                QVERIFY(decoded.type == Protocol::PacketType::None);
+            } else {
+                QVERIFY(decoded.type == Protocol::PacketType::VNADatapointBlock);
+                delete decoded.VNAdatapointBlock;
+            }
+        }
+    }
+}
+
+void ProtocolTests::DatapointBlockLimits()
+{
+    // the block is full before the packet exceeds the transmit buffer of the firmware
+    Protocol::VNADatapointBlock block;
+    block.clear(0);
+    unsigned int points = 0;
+    while(true) {
+        auto d = createDatapoint(points);
+        if(!block.addPoint(d)) {
+            break;
+        }
+        points++;
+    }
+    QVERIFY(points > 1);
+    Protocol::PacketInfo p;
+    p.type = Protocol::PacketType::VNADatapointBlock;
+    p.VNAdatapointBlock = &block;
+    uint8_t buffer[1024];
+    QVERIFY(Protocol::EncodePacket(p, buffer, sizeof(buffer)) <= 512);
+    // leaving out the frequency and using float16 allows more points per block
+    block.clear(Protocol::VNADatapointBlock::HalfPrecision | Protocol::VNADatapointBlock::FrequencyOmitted);
+    unsigned int compactPoints = 0;
+    while(true) {
+        auto d = createDatapoint(compactPoints);
+        if(!block.addPoint(d)) {
+            break;
+        }
+        compactPoints++;
+    }
+    QVERIFY(compactPoints > 2 * points);
+
+    // invalid payloads are rejected
+    uint8_t payload[Protocol::VNADatapointBlock::maxPayloadSize] = {};
+    QVERIFY(block.decode(payload, 5));
+    QCOMPARE(block.getNumPoints(), (uint8_t) 0);
+    QVERIFY(!block.decode(payload, 4));
+    payload[1] = 1;
+    QVERIFY(!block.decode(payload, 5));
+    payload[1] = 0;
+    payload[2] = 33;
+    QVERIFY(!block.decode(payload, 5 + 33));
+
+    // the frequency calculation of linear sweeps has no rounding errors
+    QVERIFY(Protocol::VNADatapointBlock::getPointFrequency(1000000, 6000000000, 1001, 0) == 1000000);
+    QVERIFY(Protocol::VNADatapointBlock::getPointFrequency(1000000, 6000000000, 1001, 1000) == 6000000000);
+    QVERIFY(Protocol::VNADatapointBlock::getPointFrequency(1000000, 6000000000, 1001, 500) == 3000500000);
+    QVERIFY(Protocol::VNADatapointBlock::getPointFrequency(1000000, 1000000, 1, 0) == 1000000);
+}
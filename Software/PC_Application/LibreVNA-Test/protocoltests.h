@@ -0,0 +1,20 @@
+#ifndef PROTOCOLTESTS_H
+#define PROTOCOLTESTS_H
+
+#include <QtTest>
+
+class ProtocolTests : public QObject
+{
+    Q_OBJECT
+public:
+    ProtocolTests();
+
+private slots:
+    void CRC32();
+    void DatapointCRC();
+    void HalfPrecision();
+    void DatapointBlock();
+    void DatapointBlockLimits();
+};
+
+#endif // PROTOCOLTESTS_H
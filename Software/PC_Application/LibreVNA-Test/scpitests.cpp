@@ -0,0 +1,469 @@
+#include "scpitests.h"
+
+#include "scpi.h"
+
+#include <QSignalSpy>
+#include <QDateTime>
+
+using namespace std;
+
+// The commands of the LibreVNA-GUI as documented in the programming guide
+static const QStringList guiCommands = {
+    "*IDN", "*RST", "*CLS", "*ESE", "*ESR", "*OPC", "*WAI", "*LST",
+    "FORMat:DATA", "FORMat:BORDer",
+    "EVENt:SUBScribe", "EVENt:UNSUBscribe", "EVENt:LIST",
+    "DEVice:DISConnect", "DEVice:CONNect", "DEVice:UPDATE", "DEVice:LIST", "DEVice:PREFerences",
+    "DEVice:APPLYPREFerences", "DEVice:MODE",
+    "DEVice:SETUP:SAVE", "DEVice:SETUP:LOAD",
+    "DEVice:REFerence:OUT", "DEVice:REFerence:IN",
+    "DEVice:STAtus:UNLOcked", "DEVice:STAtus:ADCOVERload", "DEVice:STAtus:UNLEVel",
+    "DEVice:STReaming:CLIents", "DEVice:STReaming:STATistics",
+    "DEVice:RECord:STARt", "DEVice:RECord:STOP", "DEVice:RECord:ACTive", "DEVice:RECord:ROTation",
+    "DEVice:RECord:STATistics", "DEVice:RECord:ERRor",
+    "DEVice:LATency:STARt", "DEVice:LATency:STOP", "DEVice:LATency:ACTive", "DEVice:LATency:SAVE",
+    "DEVice:METrics:LIST", "DEVice:METrics:VALue", "DEVice:METrics:RESet",
+    "DEVice:INFo:FWREVision", "DEVice:INFo:HWREVision", "DEVice:INFo:TEMPeratures",
+    "DEVice:INFo:LIMits:MINFrequency", "DEVice:INFo:LIMits:MAXFrequency", "DEVice:INFo:LIMits:MINIFBW",
+    "DEVice:INFo:LIMits:MAXIFBW", "DEVice:INFo:LIMits:MAXPoints", "DEVice:INFo:LIMits:MINPOWer",
+    "DEVice:INFo:LIMits:MAXPOWer", "DEVice:INFo:LIMits:MINRBW", "DEVice:INFo:LIMits:MAXRBW",
+    "DEVice:INFo:LIMits:MAXHARMonicfrequency",
+    "VNA:SWEEP",
+    "VNA:FREQuency:SPAN", "VNA:FREQuency:START", "VNA:FREQuency:CENTer", "VNA:FREQuency:STOP",
+    "VNA:FREQuency:FULL", "VNA:FREQuency:ZERO",
+    "VNA:POWer:START", "VNA:POWer:STOP",
+    "VNA:SWEEPTYPE",
+    "VNA:ACQuisition:RUN", "VNA:ACQuisition:STOP", "VNA:ACQuisition:IFBW", "VNA:ACQuisition:POINTS",
+    "VNA:ACQuisition:AVG", "VNA:ACQuisition:AVGLEVel", "VNA:ACQuisition:FINished",
+    "VNA:ACQuisition:SWEEPDATA", "VNA:ACQuisition:LIMit", "VNA:ACQuisition:SINGLE",
+    "VNA:STIMulus:LVL", "VNA:STIMulus:FREQuency",
+    "VNA:TRACe:LIST", "VNA:TRACe:DATA", "VNA:TRACe:AT", "VNA:TRACe:TOUCHSTONE", "VNA:TRACe:MAXFrequency",
+    "VNA:TRACe:MINFrequency", "VNA:TRACe:MAXAmplitude", "VNA:TRACe:MINAmplitude", "VNA:TRACe:NEW",
+    "VNA:TRACe:RENAME", "VNA:TRACe:PAUSE", "VNA:TRACe:RESUME", "VNA:TRACe:PAUSED",
+    "VNA:TRACe:DEEMBedding:ACTive", "VNA:TRACe:DEEMBedding:AVAILable", "VNA:TRACe:PARAMeter",
+    "VNA:TRACe:TYPE",
+    "VNA:CALibration:ACTivate", "VNA:CALibration:ACTIVE", "VNA:CALibration:NUMber", "VNA:CALibration:RESET",
+    "VNA:CALibration:ADD", "VNA:CALibration:TYPE", "VNA:CALibration:PORT", "VNA:CALibration:STANDARD",
+    "VNA:CALibration:MEASure", "VNA:CALibration:BUSY", "VNA:CALibration:SAVE", "VNA:CALibration:LOAD",
+    "VNA:CALibration:TERM",
+    "GENerator:FREQuency", "GENerator:LVL", "GENerator:PORT",
+    "SA:FREQuency:SPAN", "SA:FREQuency:START", "SA:FREQuency:CENTer", "SA:FREQuency:STOP",
+    "SA:FREQuency:FULL", "SA:FREQuency:ZERO",
+    "SA:ACQuisition:RUN", "SA:ACQuisition:STOP", "SA:ACQuisition:RBW", "SA:ACQuisition:WINDow",
+    "SA:ACQuisition:DETector", "SA:ACQuisition:AVG", "SA:ACQuisition:AVGLEVel", "SA:ACQuisition:FINished",
+    "SA:ACQuisition:LIMit", "SA:ACQuisition:SINGLE", "SA:ACQuisition:SIGid",
+    "SA:TRACKing:ENable", "SA:TRACKing:PORT", "SA:TRACKing:LVL", "SA:TRACKing:OFFset",
+    "SA:TRACKing:NORMalize:ENable", "SA:TRACKing:NORMalize:MEASure", "SA:TRACKing:NORMalize:LVL",
+    "SA:TRACe:LIST", "SA:TRACe:DATA", "SA:TRACe:AT", "SA:TRACe:MAXFrequency", "SA:TRACe:MINFrequency",
+    "SA:TRACe:MAXAmplitude", "SA:TRACe:MINAmplitude", "SA:TRACe:NEW", "SA:TRACe:RENAME", "SA:TRACe:PAUSE",
+    "SA:TRACe:RESUME", "SA:TRACe:PAUSED", "SA:TRACe:PARAMeter", "SA:TRACe:TYPE"
+};
+
+// Commands and queries of the example scripts (in the order in which they appear), without the de-embedding
+// commands whose nodes are only created at runtime
+static const QStringList exampleCommands = {
+    "*IDN?", ":DEV:CONN", ":DEV:CONN?", ":VNA:ACQ:STOP", ":DEV:MODE VNA", ":VNA:SWEEP FREQUENCY",
+    ":VNA:STIM:LVL -10", ":VNA:ACQ:IFBW 100", ":VNA:ACQ:AVG 1", ":VNA:ACQ:POINTS 501",
+    ":VNA:FREQuency:START 10000000", ":VNA:FREQuency:STOP 6000000000", ":VNA:ACQ:RUN", "*IDN?", "*ESR?",
+    ":DEV:CONN SIMULATION", ":DEV:CONN?", ":DEV:MODE VNA", ":VNA:SWEEP FREQUENCY", ":VNA:STIM:LVL -10",
+    ":VNA:ACQ:IFBW 10000", ":VNA:ACQ:AVG 1", ":VNA:ACQ:POINTS 1001", ":VNA:FREQuency:START 1000000",
+    ":VNA:FREQuency:STOP 6000000000", ":VNA:ACQ:RUN", ":DEV:MET:RES",
+    ":DEV:MET:VAL? librevna_vna_points_total", ":DEV:MET:VAL? librevna_vna_points_missed_total", "*IDN?",
+    ":DEV:CONN", ":DEV:CONN?", ":DEV:MODE VNA", ":VNA:SWEEP FREQUENCY", ":VNA:STIM:LVL -10",
+    ":VNA:ACQ:IFBW 100", ":VNA:ACQ:AVG 1", ":VNA:ACQ:POINTS 501", ":VNA:FREQuency:START 2000000000",
+    ":VNA:FREQuency:STOP 3500000000", ":VNA:ACQ:FIN?", ":VNA:TRACE:DATA? S11", "*IDN?", ":DEV:CONN",
+    ":DEV:CONN?", ":DEV:MODE GEN", ":GEN:LVL -20", ":GEN:FREQ 1000000000", ":GEN:PORT 1",
+    ":GEN:FREQ 1500000000", ":GEN:FREQ 1000000000", ":GEN:PORT 0"
+};
+
+// Creates the SCPI tree of the LibreVNA-GUI. The commands do not do anything, queries return their first parameter
+static void createGUITree(SCPI &scpi)
+{
+    map<QString, SCPINode*> nodes;
+    for(auto &c : guiCommands) {
+        auto levels = c.split(":");
+        SCPINode *node = &scpi;
+        QString prefix;
+        for(int i=0;i<levels.size()-1;i++) {
+            prefix += levels[i] + ":";
+            if(!nodes.count(prefix)) {
+                auto subnode = new SCPINode(levels[i]);
+                node->add(subnode);
+                nodes[prefix] = subnode;
+            }
+            node = nodes[prefix];
+        }
+        // common commands (e.g. *ESR) are already part of the tree, adding them again fails
+        auto cmd = new SCPICommand(levels.back(), [](QStringList) -> QString {
+            return SCPI::getResultName(SCPI::Result::Empty);
+        }, [](QStringList params) -> QString {
+            return params.size() > 0 ? params[0] : "1";
+        });
+        if(!node->add(cmd)) {
+            delete cmd;
+        }
+    }
+}
+
+SCPITests::SCPITests()
+{
+
+}
+
+void SCPITests::DataFormatSelection()
+{
+    SCPI scpi;
+    QSignalSpy spy(&scpi, &SCPI::output);
+    QVERIFY(scpi.getDataFormat() == SCPI::DataFormat::ASCII);
+    scpi.input(":FORM:DATA REAL,32");
+    QVERIFY(scpi.getDataFormat() == SCPI::DataFormat::Real32);
+    scpi.input(":FORMAT:DATA real,64");
+    QVERIFY(scpi.getDataFormat() == SCPI::DataFormat::Real64);
+    scpi.input(":FORM:DATA ASC");
+    QVERIFY(scpi.getDataFormat() == SCPI::DataFormat::ASCII);
+    // invalid format must not change the setting
+    scpi.input(":FORM:DATA REAL,16");
+    QVERIFY(scpi.getDataFormat() == SCPI::DataFormat::ASCII);
+    scpi.input(":FORM:DATA REAL,32;:FORM:DATA?;:FORM:BORD SWAP;:FORM:BORD?");
+    QCOMPARE(spy.count(), 2);
+    QCOMPARE(spy[0][0].toString(), QString("REAL,32"));
+    QCOMPARE(spy[1][0].toString(), QString("SWAPPED"));
+}
+
+void SCPITests::BinaryBlock()
+{
+    SCPI scpi;
+    auto node = new SCPINode("TEST");
+    scpi.add(node);
+    vector<double> values = {1.0, -2.5, 1e9};
+    QByteArray raw;
+    node->add(new SCPICommand("VALues", nullptr, [&](QStringList) -> QString {
+        return scpi.createBlock(values);
+    }));
+    node->add(new SCPICommand("RAW", nullptr, [&](QStringList) -> QString {
+        return scpi.createBlock(raw);
+    }));
+    QSignalSpy spy(&scpi, &SCPI::outputBlock);
+
+    // default byte order is big endian
+    scpi.input(":FORM:DATA REAL,32;:TEST:VAL?");
+    QCOMPARE(spy.count(), 1);
+    auto block = spy[0][0].toByteArray();
+    QVERIFY(block.startsWith("#212"));
+    QCOMPARE(block.size(), 4 + 12 + 1);
+    QCOMPARE(qFromBigEndian<float>(block.constData() + 4), 1.0f);
+    QCOMPARE(qFromBigEndian<float>(block.constData() + 8), -2.5f);
+    QCOMPARE(qFromBigEndian<float>(block.constData() + 12), 1e9f);
+
+    scpi.input(":FORM:DATA REAL,64;:FORM:BORD SWAPPED;:TEST:VAL?");
+    QCOMPARE(spy.count(), 2);
+    block = spy[1][0].toByteArray();
+    QVERIFY(block.startsWith("#224"));
+    QCOMPARE(block.size(), 4 + 24 + 1);
+    for(unsigned int i=0;i<values.size();i++) {
+        QCOMPARE(qFromLittleEndian<double>(block.constData() + 4 + i * sizeof(double)), values[i]);
+    }
+
+    // raw data, including bytes that are not valid in UTF-8
+    for(int i=0;i<256;i++) {
+        raw.append((char) i);
+    }
+    scpi.input(":TEST:RAW?");
+    QCOMPARE(spy.count(), 3);
+    QCOMPARE(spy[2][0].toByteArray(), QByteArray("#3256") + raw + '\n');
+}
+
+void SCPITests::BlockResponse()
+{
+    SCPI scpi;
+    auto node = new SCPINode("TEST");
+    scpi.add(node);
+    node->add(new SCPICommand("DATA", nullptr, [&](QStringList) -> QString {
+        auto root = node->getRoot();
+        if(root->getDataFormat() == SCPI::DataFormat::ASCII) {
+            return "0.5,0.25";
+        }
+        return root->createBlock({0.5, 0.25});
+    }));
+    QSignalSpy lines(&scpi, &SCPI::output);
+    QSignalSpy blocks(&scpi, &SCPI::outputBlock);
+    scpi.input(":TEST:DATA?");
+    QCOMPARE(lines.count(), 1);
+    QCOMPARE(lines[0][0].toString(), QString("0.5,0.25"));
+    scpi.input(":FORM:DATA REAL,64;:TEST:DATA?");
+    QCOMPARE(lines.count(), 1);
+    QCOMPARE(blocks.count(), 1);
+    auto block = blocks[0][0].toByteArray();
+    QVERIFY(block.startsWith("#216"));
+    QVERIFY(block.endsWith('\n'));
+    QCOMPARE(block.size(), 4 + 16 + 1);
+    QCOMPARE(qFromBigEndian<double>(block.constData() + 12), 0.25);
+
+    // text responses are never sent as blocks, even if they look like one
+    node->add(new SCPICommand("TEXT", nullptr, [](QStringList) -> QString {
+        return "#10";
+    }));
+    scpi.input(":TEST:TEXT?");
+    QCOMPARE(blocks.count(), 1);
+    QCOMPARE(lines.count(), 2);
+    QCOMPARE(lines[1][0].toString(), QString("#10"));
+}
+
+void SCPITests::MultipleConnections()
+{
+    SCPI scpi;
+    auto node = new SCPINode("TEST");
+    scpi.add(node);
+    QSignalSpy spy(&scpi, &SCPI::output);
+
+    // status registers and data format are separate for every connection
+    scpi.input(":INVALID:COMMAND", 1);
+    scpi.input(":FORM:DATA REAL,32", 1);
+    scpi.input("*ESR?;:FORM:DATA?", 2);
+    scpi.input("*ESR?;:FORM:DATA?", 1);
+    QCOMPARE(spy.count(), 4);
+    QCOMPARE(spy[0][0].toString(), QString("0"));
+    QCOMPARE(spy[0][1].toUInt(), 2U);
+    QCOMPARE(spy[1][0].toString(), QString("ASCII"));
+    QCOMPARE(spy[2][0].toString(), QString("32"));
+    QCOMPARE(spy[2][1].toUInt(), 1U);
+    QCOMPARE(spy[3][0].toString(), QString("REAL,32"));
+    spy.clear();
+
+    // a connection waiting for an operation must not block the others
+    node->setOperationPending(true);
+    scpi.input("*WAI", 1);
+    scpi.input("*OPC?", 2);
+    scpi.input(":FORM:BORD?", 1);
+    scpi.input(":FORM:BORD?", 2);
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy[0][0].toString(), QString("NORMAL"));
+    QCOMPARE(spy[0][1].toUInt(), 2U);
+    node->setOperationPending(false);
+    // the pending *OPC? of connection 2 and the queued query of connection 1 are answered now
+    QCOMPARE(spy.count(), 3);
+    QCOMPARE(spy[1][0].toString(), QString("1"));
+    QCOMPARE(spy[1][1].toUInt(), 2U);
+    QCOMPARE(spy[2][0].toString(), QString("NORMAL"));
+    QCOMPARE(spy[2][1].toUInt(), 1U);
+}
+
+void SCPITests::ClosedConnection()
+{
+    SCPI scpi;
+    auto node = new SCPINode("TEST");
+    scpi.add(node);
+    // the client disconnects while the query is executed (e.g. while it processes events)
+    node->add(new SCPICommand("CLOSE", nullptr, [&](QStringList) -> QString {
+        scpi.removeConnection(1);
+        return "1";
+    }));
+    QSignalSpy spy(&scpi, &SCPI::output);
+    scpi.input(":TEST:CLOSE?;:FORM:DATA REAL,32;:FORM:DATA?", 1);
+    QCOMPARE(spy.count(), 0);
+    // the closed connection must not have been recreated with the state of the remaining commands
+    scpi.input(":FORM:DATA?", 1);
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy[0][0].toString(), QString("ASCII"));
+}
+
+void SCPITests::DeferredResponse()
+{
+    SCPI scpi;
+    auto node = new SCPINode("TEST");
+    scpi.add(node);
+    std::vector<unsigned int> waiting;
+    node->add(new SCPICommand("WAIT", nullptr, [&](QStringList) -> QString {
+        waiting.push_back(scpi.deferResponse());
+        return SCPI::getResultName(SCPI::Result::Empty);
+    }));
+    auto createResponse = [&]() -> QString {
+        if(scpi.getDataFormat() == SCPI::DataFormat::ASCII) {
+            return "1";
+        } else {
+            return scpi.createBlock(std::vector<double>{1.0});
+        }
+    };
+    QSignalSpy spy(&scpi, &SCPI::output);
+    QSignalSpy blockSpy(&scpi, &SCPI::outputBlock);
+
+    scpi.input(":TEST:WAIT?", 1);
+    // held back until the deferred query has been answered
+    scpi.input("*ESR?", 1);
+    // other connections are not affected
+    scpi.input(":FORM:DATA REAL,64;:TEST:WAIT?", 2);
+    scpi.input("*ESR?", 3);
+    QCOMPARE(waiting.size(), (size_t) 2);
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy[0][1].toUInt(), 3U);
+
+    // the response is created in the context of its connection
+    scpi.deferredResponse(waiting[1], createResponse);
+    QCOMPARE(blockSpy.count(), 1);
+    QCOMPARE(blockSpy[0][0].toByteArray().left(3), QByteArray("#18"));
+    QCOMPARE(blockSpy[0][1].toUInt(), 2U);
+
+    scpi.deferredResponse(waiting[0], createResponse);
+    QCOMPARE(spy.count(), 3);
+    QCOMPARE(spy[1][0].toString(), QString("1"));
+    QCOMPARE(spy[1][1].toUInt(), 1U);
+    QCOMPARE(spy[2][0].toString(), QString("0"));
+    QCOMPARE(spy[2][1].toUInt(), 1U);
+
+    // responses for closed connections are dropped
+    scpi.input(":TEST:WAIT?", 4);
+    scpi.removeConnection(4);
+    scpi.deferredResponse(waiting[2], createResponse);
+    QCOMPARE(spy.count(), 3);
+}
+
+void SCPITests::Events()
+{
+    SCPI scpi;
+    scpi.addEvent("SWEEP");
+    scpi.addEvent("FLAGS");
+    QSignalSpy spy(&scpi, &SCPI::output);
+
+    scpi.input(":EVEN:LIST?", 1);
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy[0][0].toString(), QString("SWEEP,FLAGS"));
+    spy.clear();
+
+    // unknown events can not be subscribed to
+    scpi.input(":EVEN:SUBS SWEEP UNKNOWN", 1);
+    scpi.input(":EVEN:SUBS?;*ESR?", 1);
+    QCOMPARE(spy[0][0].toString(), QString("NONE"));
+    QCOMPARE(spy[1][0].toString(), QString("32"));
+    spy.clear();
+
+    scpi.input(":EVEN:SUBS sweep", 1);
+    scpi.input(":EVEN:SUBS", 2);
+    scpi.input(":EVEN:SUBS?", 2);
+    QCOMPARE(spy[0][0].toString(), QString("SWEEP,FLAGS"));
+    spy.clear();
+
+    // only subscribers receive an event, sequence numbers increase with every event
+    scpi.notify("FLAGS", "NONE");
+    scpi.notify("SWEEP", "VNA");
+    QCOMPARE(spy.count(), 3);
+    auto fields = spy[0][0].toString().split(",");
+    QCOMPARE(spy[0][1].toUInt(), 2U);
+    QCOMPARE(fields.size(), 4);
+    QCOMPARE(fields[0], QString("EVENT 1"));
+    QVERIFY(qAbs(fields[1].toLongLong() - QDateTime::currentMSecsSinceEpoch()) < 10000);
+    QCOMPARE(fields[2], QString("FLAGS"));
+    QCOMPARE(fields[3], QString("NONE"));
+    QVERIFY(spy[1][0].toString().startsWith("EVENT 2,"));
+    QVERIFY(spy[1][0].toString().endsWith(",SWEEP,VNA"));
+    QCOMPARE(spy[2][0].toString(), spy[1][0].toString());
+    spy.clear();
+
+    scpi.input(":EVEN:UNSUB SWEEP", 2);
+    scpi.input(":EVEN:UNSUB", 1);
+    scpi.notify("SWEEP");
+    QCOMPARE(spy.count(), 0);
+    scpi.notify("FLAGS", "OVERLOAD");
+    QCOMPARE(spy.count(), 1);
+    QVERIFY(spy[0][0].toString().startsWith("EVENT 4,"));
+    QCOMPARE(spy[0][1].toUInt(), 2U);
+}
+
+void SCPITests::CommandLookup()
+{
+    SCPI scpi;
+    createGUITree(scpi);
+    QSignalSpy spy(&scpi, &SCPI::output);
+    // short and long forms, in any case
+    scpi.input(":DEV:INF:LIM:MAXF?");
+    scpi.input(":device:info:limits:maxfrequency?");
+    scpi.input(":DEVice:INFo:LIMits:MAXFrequency?");
+    // partially abbreviated names are not allowed
+    scpi.input(":DEVI:INF:LIM:MAXF?");
+    scpi.input(":DEV:INF:LIM:MAXFREQ?");
+    // a node is not a command and vice versa
+    scpi.input(":DEV:INF?");
+    scpi.input(":DEV:LIST:X?");
+    // parameters are passed on, the last node is kept for commands without leading colon
+    scpi.input(":VNA:TRAC:DATA? s11;AT? s21");
+    QCOMPARE(spy.count(), 5);
+    QCOMPARE(spy[3][0].toString(), QString("S11"));
+    QCOMPARE(spy[4][0].toString(), QString("S21"));
+    scpi.input("*ESR?");
+    QCOMPARE(spy[5][0].toString(), QString("32"));
+
+    // renamed nodes are found by their new name only
+    auto node = new SCPINode("OLDname");
+    scpi.add(node);
+    node->add(new SCPICommand("VALue", nullptr, [](QStringList) -> QString {
+        return "2";
+    }));
+    QVERIFY(node->changeName("NEWname"));
+    scpi.input(":OLD:VAL?;:NEWNAME:VAL?;:NEW:VALUE?");
+    QCOMPARE(spy.count(), 8);
+    QCOMPARE(spy[6][0].toString(), QString("2"));
+    QCOMPARE(spy[7][0].toString(), QString("2"));
+}
+
+void SCPITests::AccessCallback()
+{
+    SCPI scpi;
+    createGUITree(scpi);
+    auto vna = new SCPINode("VNA2");
+    auto trace = new SCPINode("TRACe");
+    scpi.add(vna);
+    vna->add(trace);
+    vna->add(new SCPICommand("RUN", [](QStringList) -> QString {
+        return SCPI::getResultName(SCPI::Result::Empty);
+    }, nullptr));
+    trace->add(new SCPICommand("DATA", nullptr, [](QStringList) -> QString {
+        return "1";
+    }));
+    unsigned int vnaAccess = 0, traceAccess = 0;
+    vna->setAccessCallback([&](){
+        vnaAccess++;
+    });
+    trace->setAccessCallback([&](){
+        // called before the callbacks of the parent nodes
+        QCOMPARE(traceAccess, vnaAccess);
+        traceAccess++;
+    });
+
+    scpi.input(":VNA2:RUN");
+    QCOMPARE(vnaAccess, 1U);
+    QCOMPARE(traceAccess, 0U);
+    // relative to the last node
+    scpi.input(":VNA2:TRAC:DATA?;DATA?");
+    QCOMPARE(vnaAccess, 3U);
+    QCOMPARE(traceAccess, 2U);
+    // unknown commands and commands in other branches do not trigger the callbacks
+    scpi.input(":VNA2:TRAC:X?;:VNA2:Y;:DEV:LIST?");
+    QCOMPARE(vnaAccess, 3U);
+    QCOMPARE(traceAccess, 2U);
+}
+
+void SCPITests::ParseBenchmark()
+{
+    SCPI scpi;
+    createGUITree(scpi);
+    QString status;
+    connect(&scpi, &SCPI::output, [&](QString line){
+        status = line;
+    });
+    // every command of the mix must be part of the tree
+    for(auto &line : exampleCommands) {
+        scpi.input(line);
+        scpi.input("*ESR?");
+        QCOMPARE(status, QString("0"));
+    }
+    unsigned long responses = 0;
+    connect(&scpi, &SCPI::output, [&](){
+        responses++;
+    });
+    QBENCHMARK {
+        for(auto &line : exampleCommands) {
+            scpi.input(line);
+        }
+    }
+    QVERIFY(responses > 0);
+    scpi.input("*ESR?");
+    QCOMPARE(status, QString("0"));
+}
@@ -0,0 +1,25 @@
+#ifndef SCPITESTS_H
+#define SCPITESTS_H
+
+#include <QtTest>
+
+class SCPITests : public QObject
+{
+    Q_OBJECT
+public:
+    SCPITests();
+
+private slots:
+    void DataFormatSelection();
+    void BinaryBlock();
+    void BlockResponse();
+    void MultipleConnections();
+    void ClosedConnection();
+    void DeferredResponse();
+    void Events();
+    void CommandLookup();
+    void AccessCallback();
+    void ParseBenchmark();
+};
+
+#endif // SCPITESTS_H
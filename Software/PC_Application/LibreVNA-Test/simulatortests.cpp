@@ -0,0 +1,177 @@
+#include "simulatortests.h"
+
+#include "Device/LibreVNA/librevnasimulator.h"
+#include "Device/LibreVNA/librevnatcpdriver.h"
+
+using namespace std;
+
+static DeviceDriver::VNASettings VNASettings(int points)
+{
+    DeviceDriver::VNASettings s;
+    s.freqStart = 1000000;
+    s.freqStop = 3000000000;
+    s.dBmStart = -10;
+    s.dBmStop = -10;
+    s.IFBW = 10000;
+    s.points = points;
+    s.logSweep = false;
+    s.excitedPorts = {1, 2};
+    return s;
+}
+
+SimulatorTests::SimulatorTests()
+{
+
+}
+
+void SimulatorTests::VNASweep()
+{
+    LibreVNASimulator simulator;
+    simulator.setPointsPerSecond(0);
+    QVERIFY(simulator.start());
+    QVERIFY(simulator.isRunning());
+
+    LibreVNATCPDriver driver;
+    QVERIFY(driver.GetAvailableDevices().count("SIMULATION"));
+    QVERIFY(driver.connectDevice("SIMULATION", true));
+    QTRY_VERIFY(driver.supports(DeviceDriver::Feature::VNA));
+    QCOMPARE(driver.getInfo().Limits.VNA.ports, 2U);
+
+    QSignalSpy spy(&driver, &DeviceDriver::VNAmeasurementReceived);
+    QVERIFY(driver.setVNA(VNASettings(101)));
+    QTRY_VERIFY(spy.count() >= 101);
+    for(int i=0;i<101;i++) {
+        auto m = spy[i][0].value<DeviceDriver::VNAMeasurement>();
+        QCOMPARE(m.pointNum, (unsigned int) i);
+        QCOMPARE(m.frequency, 1000000.0 + i * 29990000.0);
+        for(auto name : {"S11", "S12", "S21", "S22"}) {
+            QVERIFY(m.measurements.count(name));
+        }
+        QVERIFY(abs(m.measurements["S11"]) < 0.25);
+        QVERIFY(abs(abs(m.measurements["S21"]) - 0.9 / (1.0 + m.frequency / 6e9)) < 0.01);
+    }
+
+    driver.disconnectDevice();
+    simulator.stop();
+    QVERIFY(!simulator.isRunning());
+    QVERIFY(!driver.GetAvailableDevices().count("SIMULATION"));
+}
+
+void SimulatorTests::DatapointFormats()
+{
+    // individual datapoints, blocks and blocks with reduced precision deliver the same points
+    for(auto format : {make_pair(false, false), make_pair(true, false), make_pair(true, true)}) {
+        LibreVNASimulator simulator;
+        simulator.setPointsPerSecond(0);
+        QVERIFY(simulator.start());
+
+        LibreVNATCPDriver driver;
+        for(auto s : driver.driverSpecificSettings()) {
+            if(s.name == "LibreVNATCPDriver.datapointBlocks") {
+                s.var.setValue(format.first);
+            } else if(s.name == "LibreVNATCPDriver.halfPrecision") {
+                s.var.setValue(format.second);
+            }
+        }
+        driver.GetAvailableDevices();
+        QVERIFY(driver.connectDevice("SIMULATION", true));
+        QTRY_VERIFY(driver.supports(DeviceDriver::Feature::VNA));
+
+        QSignalSpy spy(&driver, &DeviceDriver::VNAmeasurementReceived);
+        QVERIFY(driver.setVNA(VNASettings(1001)));
+        QTRY_VERIFY(spy.count() >= 1001);
+        for(int i=0;i<1001;i++) {
+            auto m = spy[i][0].value<DeviceDriver::VNAMeasurement>();
+            QCOMPARE(m.pointNum, (unsigned int) i);
+            // also exact when the driver calculates the frequency
+            QCOMPARE(m.frequency, 1000000.0 + i * 2999000.0);
+            QVERIFY(abs(m.measurements["S11"]) < 0.25);
+            QVERIFY(abs(abs(m.measurements["S21"]) - 0.9 / (1.0 + m.frequency / 6e9)) < 0.01);
+        }
+        driver.disconnectDevice();
+    }
+}
+
+void SimulatorTests::BlockLatency()
+{
+    // at a low point rate, a block of 100 points (10kHz IFBW, 2 ports) would take two seconds to fill up
+    LibreVNASimulator simulator;
+    simulator.setPointsPerSecond(50);
+    QVERIFY(simulator.start());
+
+    LibreVNATCPDriver driver;
+    driver.GetAvailableDevices();
+    QVERIFY(driver.connectDevice("SIMULATION", true));
+    QTRY_VERIFY(driver.supports(DeviceDriver::Feature::VNA));
+
+    QSignalSpy spy(&driver, &DeviceDriver::VNAmeasurementReceived);
+    QVERIFY(driver.setVNA(VNASettings(1001)));
+    // incomplete blocks are sent after a short time
+    QTRY_VERIFY_WITH_TIMEOUT(spy.count() >= 10, 1000);
+    for(int i=0;i<spy.count();i++) {
+        QCOMPARE(spy[i][0].value<DeviceDriver::VNAMeasurement>().pointNum, (unsigned int) i);
+    }
+    driver.disconnectDevice();
+}
+
+void SimulatorTests::SASweep()
+{
+    LibreVNASimulator simulator;
+    simulator.setPointsPerSecond(0);
+    QVERIFY(simulator.start());
+
+    LibreVNATCPDriver driver;
+    driver.GetAvailableDevices();
+    QVERIFY(driver.connectDevice("SIMULATION", true));
+    QTRY_VERIFY(driver.supports(DeviceDriver::Feature::SA));
+
+    DeviceDriver::SASettings s;
+    s.freqStart = 1000000000;
+    s.freqStop = 1001000000;
+    s.RBW = 10000;
+    s.window = DeviceDriver::SASettings::Window::None;
+    s.detector = DeviceDriver::SASettings::Detector::PPeak;
+    s.trackingGenerator = false;
+    s.trackingPort = 1;
+    s.trackingOffset = 0;
+    s.trackingPower = 0;
+    QSignalSpy spy(&driver, &DeviceDriver::SAmeasurementReceived);
+    QVERIFY(driver.setSA(s));
+    auto points = driver.getSApoints();
+    QVERIFY(points > 2);
+    QTRY_VERIFY((unsigned int) spy.count() >= points);
+    double peakFrequency = 0, peak = 0;
+    for(unsigned int i=0;i<points;i++) {
+        auto m = spy[i][0].value<DeviceDriver::SAMeasurement>();
+        QCOMPARE(m.pointNum, i);
+        if(m.measurements["PORT1"] > peak) {
+            peak = m.measurements["PORT1"];
+            peakFrequency = m.frequency;
+        }
+    }
+    // the tone is in the center of the span
+    QVERIFY(abs(peakFrequency - 1000500000.0) <= (s.freqStop - s.freqStart) / (points - 1));
+}
+
+void SimulatorTests::FaultInjection()
+{
+    LibreVNASimulator simulator;
+    simulator.setPointsPerSecond(0);
+    simulator.setFaultInjection(0.05, 0.05);
+    QVERIFY(simulator.start());
+
+    LibreVNATCPDriver driver;
+    driver.GetAvailableDevices();
+    QVERIFY(driver.connectDevice("SIMULATION", true));
+    QTRY_VERIFY(driver.supports(DeviceDriver::Feature::VNA));
+
+    QSignalSpy spy(&driver, &DeviceDriver::VNAmeasurementReceived);
+    QVERIFY(driver.setVNA(VNASettings(1001)));
+    // the driver has to resynchronize after every corrupted packet and keep delivering data
+    QTRY_VERIFY_WITH_TIMEOUT(spy.count() >= 5000, 20000);
+    auto stats = simulator.getStatistics();
+    QVERIFY(stats.packetsDropped > 0);
+    QVERIFY(stats.packetsCorrupted > 0);
+    QVERIFY(stats.pointsGenerated >= (quint64) spy.count());
+    driver.disconnectDevice();
+}
@@ -0,0 +1,20 @@
+#ifndef SIMULATORTESTS_H
+#define SIMULATORTESTS_H
+
+#include <QtTest>
+
+class SimulatorTests : public QObject
+{
+    Q_OBJECT
+public:
+    SimulatorTests();
+
+private slots:
+    void VNASweep();
+    void DatapointFormats();
+    void BlockLatency();
+    void SASweep();
+    void FaultInjection();
+};
+
+#endif // SIMULATORTESTS_H
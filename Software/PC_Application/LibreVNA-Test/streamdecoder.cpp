@@ -0,0 +1,111 @@
+#include "streamdecoder.h"
+
+#include <cstring>
+#include <cstdint>
+
+static constexpr char magic[] = {'L', 'V', 'S', 'B'};
+static constexpr int headerSize = 32;
+
+template<typename T>
+static T get(const uint8_t *src)
+{
+    // all values are little endian
+    uint64_t u = 0;
+    for(unsigned int i=0;i<sizeof(T);i++) {
+        u |= (uint64_t) src[i] << (8 * i);
+    }
+    T value;
+    if(sizeof(T) == 4) {
+        uint32_t u32 = u;
+        memcpy(&value, &u32, sizeof(T));
+    } else if(sizeof(T) == 2) {
+        uint16_t u16 = u;
+        memcpy(&value, &u16, sizeof(T));
+    } else if(sizeof(T) == 1) {
+        uint8_t u8 = u;
+        memcpy(&value, &u8, sizeof(T));
+    } else {
+        memcpy(&value, &u, sizeof(T));
+    }
+    return value;
+}
+
+void StreamDecoder::addData(const QByteArray &data)
+{
+    buffer.append(data);
+}
+
+bool StreamDecoder::nextFrame(Frame &frame)
+{
+    // synchronize to the start of a frame
+    auto start = buffer.indexOf(QByteArray(magic, sizeof(magic)));
+    if(start < 0) {
+        // keep the last bytes, they might be the beginning of the magic
+        buffer = buffer.right(sizeof(magic) - 1);
+        return false;
+    }
+    buffer.remove(0, start);
+    if(buffer.size() < headerSize) {
+        return false;
+    }
+    auto src = (const uint8_t*) buffer.constData();
+    auto version = get<uint8_t>(&src[4]);
+    auto type = get<uint8_t>(&src[5]);
+    auto sampleSize = get<uint8_t>(&src[6]);
+    auto flags = get<uint8_t>(&src[7]);
+    auto frameSize = get<uint32_t>(&src[8]);
+    if(version != 1 || (type != 1 && type != 2) || (sampleSize != 4 && sampleSize != 8) || frameSize < headerSize) {
+        // not a valid frame header, skip magic and try again
+        buffer.remove(0, sizeof(magic));
+        return nextFrame(frame);
+    }
+    if((unsigned int) buffer.size() < frameSize) {
+        // frame not complete yet
+        return false;
+    }
+    frame.type = (Frame::Type) type;
+    frame.completeSweep = flags & 0x01;
+    frame.sampleSize = sampleSize;
+    frame.firstPoint = get<uint32_t>(&src[12]);
+    auto points = get<uint32_t>(&src[16]);
+    auto channels = get<uint16_t>(&src[20]);
+    auto namesSize = get<uint16_t>(&src[22]);
+    frame.Z0 = get<double>(&src[24]);
+
+    auto pos = headerSize;
+    frame.channels.clear();
+    auto namesEnd = pos + namesSize;
+    while(pos < namesEnd) {
+        auto name = QString::fromLatin1((const char*) &src[pos]);
+        frame.channels.push_back(name);
+        pos += name.size() + 1;
+    }
+    auto readSample = [&]() -> double {
+        double value = sampleSize == 4 ? get<float>(&src[pos]) : get<double>(&src[pos]);
+        pos += sampleSize;
+        return value;
+    };
+    frame.points.clear();
+    for(unsigned int i=0;i<points;i++) {
+        Frame::Point p;
+        p.frequency = get<double>(&src[pos]);
+        pos += 8;
+        p.dBm = 0.0;
+        if(frame.type == Frame::Type::VNA) {
+            p.dBm = get<double>(&src[pos]);
+            pos += 8;
+        }
+        for(unsigned int j=0;j<channels;j++) {
+            if(frame.type == Frame::Type::VNA) {
+                auto real = readSample();
+                auto imag = readSample();
+                p.values.push_back(std::complex<double>(real, imag));
+            } else {
+                p.values.push_back(readSample());
+            }
+        }
+        frame.points.push_back(p);
+    }
+    buffer.remove(0, frameSize);
+    return true;
+}
@@ -0,0 +1,47 @@
+#ifndef STREAMDECODER_H
+#define STREAMDECODER_H
+
+#include <QByteArray>
+#include <QString>
+#include <vector>
+#include <complex>
+
+/*
+ * Reference decoder for the binary frames of the streaming servers. Intentionally independent
+ * of the GUI sources so it can serve as a template for client implementations
+ */
+class StreamDecoder
+{
+public:
+    class Frame {
+    public:
+        enum class Type {
+            VNA = 1,
+            SA = 2,
+        };
+        Type type;
+        bool completeSweep;
+        unsigned int sampleSize;
+        unsigned int firstPoint;
+        double Z0;
+        std::vector<QString> channels;
+        class Point {
+        public:
+            double frequency;
+            double dBm; // VNA only
+            // one value per channel (SA frames only use the real part)
+            std::vector<std::complex<double>> values;
+        };
+        std::vector<Point> points;
+    };
+
+    // Appends received data. Bytes before the start of a frame are skipped
+    void addData(const QByteArray &data);
+    // Extracts the next complete frame from the received data. Returns false if no complete frame is available
+    bool nextFrame(Frame &frame);
+
+private:
+    QByteArray buffer;
+};
+
+#endif // STREAMDECODER_H
@@ -0,0 +1,97 @@
+#include "streamingtests.h"
+
+#include "streamingserver.h"
+#include "streamdecoder.h"
+
+using namespace std;
+
+static vector<DeviceDriver::VNAMeasurement> createVNASweep(unsigned int points)
+{
+    vector<DeviceDriver::VNAMeasurement> sweep;
+    for(unsigned int i=0;i<points;i++) {
+        DeviceDriver::VNAMeasurement m;
+        m.pointNum = i;
+        m.Z0 = 50.0;
+        m.frequency = 1000000.0 + i * 12345.678;
+        m.dBm = -10.0;
+        m.measurements["S11"] = complex<double>(0.1 * i, -0.25);
+        m.measurements["S21"] = complex<double>(1.0 / (i + 1), 0.5 * i);
+        sweep.push_back(m);
+    }
+    return sweep;
+}
+
+StreamingTests::StreamingTests()
+{
+
+}
+
+void StreamingTests::BinaryVNAFrame()
+{
+    auto sweep = createVNASweep(101);
+    for(auto format : {StreamingServer::Format::Binary32, StreamingServer::Format::Binary64}) {
+        StreamDecoder decoder;
+        decoder.addData(StreamingServer::encode(sweep, format));
+        StreamDecoder::Frame frame;
+        QVERIFY(decoder.nextFrame(frame));
+        QVERIFY(frame.type == StreamDecoder::Frame::Type::VNA);
+        QVERIFY(frame.completeSweep);
+        QCOMPARE(frame.firstPoint, 0U);
+        QCOMPARE(frame.Z0, 50.0);
+        QCOMPARE(frame.channels.size(), (size_t) 2);
+        QCOMPARE(frame.channels[0], QString("S11"));
+        QCOMPARE(frame.channels[1], QString("S21"));
+        QCOMPARE(frame.points.size(), sweep.size());
+        double tolerance = format == StreamingServer::Format::Binary32 ? 1e-6 : 0.0;
+        for(unsigned int i=0;i<sweep.size();i++) {
+            auto &p = frame.points[i];
+            QCOMPARE(p.frequency, sweep[i].frequency);
+            QCOMPARE(p.dBm, sweep[i].dBm);
+            QVERIFY(abs(p.values[0] - sweep[i].measurements["S11"]) <= tolerance);
+            QVERIFY(abs(p.values[1] - sweep[i].measurements["S21"]) <= tolerance);
+        }
+        QVERIFY(!decoder.nextFrame(frame));
+    }
+}
+
+void StreamingTests::BinarySAFrame()
+{
+    DeviceDriver::SAMeasurement m;
+    m.pointNum = 17;
+    m.frequency = 2400000000.0;
+    m.measurements["PORT1"] = 1e-6;
+    m.measurements["PORT2"] = 3.5e-3;
+    StreamDecoder decoder;
+    decoder.addData(StreamingServer::encode({m}, StreamingServer::Format::Binary64));
+    StreamDecoder::Frame frame;
+    QVERIFY(decoder.nextFrame(frame));
+    QVERIFY(frame.type == StreamDecoder::Frame::Type::SA);
+    QVERIFY(!frame.completeSweep);
+    QCOMPARE(frame.firstPoint, 17U);
+    QCOMPARE(frame.points.size(), (size_t) 1);
+    QCOMPARE(frame.points[0].frequency, m.frequency);
+    QCOMPARE(frame.points[0].values[0].real(), 1e-6);
+    QCOMPARE(frame.points[0].values[1].real(), 3.5e-3);
+}
+
+void StreamingTests::FrameResynchronization()
+{
+    // JSON data received before switching to binary and frames split across several reads
+    auto sweep = createVNASweep(3);
+    QByteArray data = StreamingServer::encode({sweep[0]}, StreamingServer::Format::JSON);
+    for(auto &m : sweep) {
+        data += StreamingServer::encode({m}, StreamingServer::Format::Binary32);
+    }
+    StreamDecoder decoder;
+    StreamDecoder::Frame frame;
+    unsigned int frames = 0;
+    for(int i=0;i<data.size();i+=7) {
+        decoder.addData(data.mid(i, 7));
+        while(decoder.nextFrame(frame)) {
+            QCOMPARE(frame.firstPoint, frames);
+            QCOMPARE(frame.points.size(), (size_t) 1);
+            frames++;
+        }
+    }
+    QCOMPARE(frames, 3U);
+}
@@ -0,0 +1,18 @@
+#ifndef STREAMINGTESTS_H
+#define STREAMINGTESTS_H
+
+#include <QtTest>
+
+class StreamingTests : public QObject
+{
+    Q_OBJECT
+public:
+    StreamingTests();
+
+private slots:
+    void BinaryVNAFrame();
+    void BinarySAFrame();
+    void FrameResynchronization();
+};
+
+#endif // STREAMINGTESTS_H
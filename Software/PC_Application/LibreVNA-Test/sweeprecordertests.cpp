@@ -0,0 +1,318 @@
+#include "sweeprecordertests.h"
+
+#include "sweeprecorder.h"
+#include "Device/Playback/playbackdriver.h"
+
+using namespace std;
+
+static vector<DeviceDriver::VNAMeasurement> createVNASweep(unsigned int points, double offset)
+{
+    vector<DeviceDriver::VNAMeasurement> sweep;
+    for(unsigned int i=0;i<points;i++) {
+        DeviceDriver::VNAMeasurement m;
+        m.pointNum = i;
+        m.Z0 = 50.0;
+        m.frequency = 1000000.0 + i * 12345.678;
+        m.dBm = -10.0;
+        m.measurements["S11"] = complex<double>(0.1 * i, -0.25 + offset);
+        m.measurements["S21"] = complex<double>(1.0 / (i + 1), 0.5 * i);
+        sweep.push_back(m);
+    }
+    return sweep;
+}
+
+static void addSweep(SweepRecorder &recorder, const vector<DeviceDriver::VNAMeasurement> &sweep, SweepRecorder::Stage stage)
+{
+    for(unsigned int i=0;i<sweep.size();i++) {
+        recorder.addData(sweep[i], stage, i == sweep.size() - 1);
+    }
+}
+
+SweepRecorderTests::SweepRecorderTests()
+{
+
+}
+
+void SweepRecorderTests::RoundTrip()
+{
+    auto filename = dir.filePath("roundtrip.lvr");
+    SweepRecorder recorder;
+    SweepRecorder::SweepSettings settings;
+    settings.start = 1000000.0;
+    settings.stop = 1000000.0 + 200 * 12345.678;
+    settings.bandwidth = 1000;
+    settings.powerStart = settings.powerStop = -10.0;
+    settings.averages = 3;
+    recorder.setVNASweepSettings(settings);
+    QVERIFY(recorder.start(filename, {SweepRecorder::Stage::VNACalibrated, SweepRecorder::Stage::SARaw}));
+    QVERIFY(recorder.isRecording());
+    for(unsigned int i=0;i<10;i++) {
+        addSweep(recorder, createVNASweep(201, i), SweepRecorder::Stage::VNACalibrated);
+        // not selected for recording
+        addSweep(recorder, createVNASweep(201, i), SweepRecorder::Stage::VNARaw);
+        DeviceDriver::SAMeasurement m;
+        m.pointNum = 0;
+        m.frequency = 2000000.0;
+        m.measurements["PORT1"] = -20.0 - i;
+        recorder.addData(m, SweepRecorder::Stage::SARaw, true);
+    }
+    recorder.stop();
+    QVERIFY(!recorder.isRecording());
+
+    auto stats = recorder.getStatistics();
+    QCOMPARE(stats.sweepsRecorded, 20ULL);
+    QCOMPARE(stats.sweepsDropped, 0ULL);
+    QCOMPARE(stats.files, 1U);
+    QVERIFY(stats.error.isEmpty());
+    QCOMPARE(QFileInfo(stats.currentFile).fileName(), QString("roundtrip_0000.lvr"));
+    QCOMPARE((quint64) QFileInfo(stats.currentFile).size(), stats.bytesWritten);
+
+    vector<SweepRecorder::IndexEntry> index;
+    QVERIFY(SweepRecorder::readIndex(stats.currentFile, index));
+    QCOMPARE(index.size(), (size_t) 20);
+    unsigned int vnaSweeps = 0, saSweeps = 0;
+    for(auto &e : index) {
+        SweepRecorder::Sweep sweep;
+        QVERIFY(SweepRecorder::readSweep(stats.currentFile, e, sweep));
+        QVERIFY(sweep.stage == e.stage);
+        QCOMPARE(sweep.number, e.sweep);
+        QCOMPARE(sweep.timestamp, e.timestamp);
+        if(e.stage == SweepRecorder::Stage::VNACalibrated) {
+            QCOMPARE(sweep.number, (quint64) vnaSweeps);
+            auto reference = createVNASweep(201, vnaSweeps++);
+            QCOMPARE(sweep.Z0, 50.0);
+            QCOMPARE(sweep.channels.size(), (size_t) 2);
+            QCOMPARE(sweep.channels[0], QString("S11"));
+            QCOMPARE(sweep.channels[1], QString("S21"));
+            QCOMPARE(sweep.settings.type, QString("FREQUENCY"));
+            QVERIFY(!sweep.settings.zerospan);
+            QCOMPARE(sweep.settings.stop, settings.stop);
+            QCOMPARE(sweep.settings.bandwidth, 1000.0);
+            QCOMPARE(sweep.settings.powerStart, -10.0);
+            QCOMPARE(sweep.settings.averages, 3U);
+            QCOMPARE(sweep.x.size(), reference.size());
+            for(unsigned int i=0;i<reference.size();i++) {
+                QCOMPARE(sweep.x[i], reference[i].frequency);
+                QCOMPARE(sweep.dBm[i], reference[i].dBm);
+                QCOMPARE(sweep.data[0][2*i], (float) reference[i].measurements["S11"].real());
+                QCOMPARE(sweep.data[0][2*i+1], (float) reference[i].measurements["S11"].imag());
+                QCOMPARE(sweep.data[1][2*i], (float) reference[i].measurements["S21"].real());
+                QCOMPARE(sweep.data[1][2*i+1], (float) reference[i].measurements["S21"].imag());
+            }
+        } else {
+            QVERIFY(e.stage == SweepRecorder::Stage::SARaw);
+            QCOMPARE(sweep.channels.size(), (size_t) 1);
+            QCOMPARE(sweep.channels[0], QString("PORT1"));
+            QCOMPARE(sweep.x.size(), (size_t) 1);
+            QVERIFY(sweep.dBm.empty());
+            QCOMPARE(sweep.x[0], 2000000.0);
+            QCOMPARE(sweep.data[0][0], (float) (-20.0 - saSweeps++));
+        }
+    }
+    QCOMPARE(vnaSweeps, 10U);
+    QCOMPARE(saSweeps, 10U);
+}
+
+void SweepRecorderTests::IncompleteSweeps()
+{
+    auto filename = dir.filePath("incomplete.lvr");
+    SweepRecorder recorder;
+    QVERIFY(recorder.start(filename, {SweepRecorder::Stage::VNARaw}));
+    auto sweep = createVNASweep(101, 0);
+    // recording started in the middle of a sweep
+    for(unsigned int i=50;i<sweep.size();i++) {
+        recorder.addData(sweep[i], SweepRecorder::Stage::VNARaw, i == sweep.size() - 1);
+    }
+    // missing point
+    for(unsigned int i=0;i<sweep.size();i++) {
+        if(i != 20) {
+            recorder.addData(sweep[i], SweepRecorder::Stage::VNARaw, i == sweep.size() - 1);
+        }
+    }
+    addSweep(recorder, sweep, SweepRecorder::Stage::VNARaw);
+    recorder.stop();
+
+    auto stats = recorder.getStatistics();
+    QCOMPARE(stats.sweepsRecorded, 1ULL);
+    vector<SweepRecorder::IndexEntry> index;
+    QVERIFY(SweepRecorder::readIndex(stats.currentFile, index));
+    QCOMPARE(index.size(), (size_t) 1);
+    SweepRecorder::Sweep s;
+    QVERIFY(SweepRecorder::readSweep(stats.currentFile, index[0], s));
+    QCOMPARE(s.x.size(), sweep.size());
+}
+
+void SweepRecorderTests::ZeroSpan()
+{
+    auto filename = dir.filePath("zerospan.lvr");
+    SweepRecorder recorder;
+    SweepRecorder::SweepSettings settings;
+    settings.zerospan = true;
+    settings.start = settings.stop = 2000000000.0;
+    settings.powerStart = settings.powerStop = -20.0;
+    recorder.setVNASweepSettings(settings);
+    QVERIFY(recorder.start(filename, {SweepRecorder::Stage::VNARaw}));
+    for(unsigned int i=0;i<10;i++) {
+        DeviceDriver::VNAMeasurement m;
+        m.pointNum = i;
+        m.Z0 = 50.0;
+        m.us = 100.0 * i;
+        m.measurements["S11"] = complex<double>(0.5, 0.5);
+        recorder.addData(m, SweepRecorder::Stage::VNARaw, i == 9);
+    }
+    recorder.stop();
+
+    vector<SweepRecorder::IndexEntry> index;
+    QVERIFY(SweepRecorder::readIndex(recorder.getStatistics().currentFile, index));
+    QCOMPARE(index.size(), (size_t) 1);
+    SweepRecorder::Sweep sweep;
+    QVERIFY(SweepRecorder::readSweep(recorder.getStatistics().currentFile, index[0], sweep));
+    QVERIFY(sweep.settings.zerospan);
+    QCOMPARE(sweep.settings.start, 2000000000.0);
+    QCOMPARE(sweep.x.size(), (size_t) 10);
+    for(unsigned int i=0;i<10;i++) {
+        QCOMPARE(sweep.x[i], 100.0 * i);
+        QCOMPARE(sweep.dBm[i], -20.0);
+    }
+}
+
+void SweepRecorderTests::Rotation()
+{
+    auto filename = dir.filePath("rotation.lvr");
+    SweepRecorder recorder;
+    // each sweep takes about 6.5kB, start a new file after every four sweeps
+    recorder.setRotation(25000, 0);
+    QVERIFY(recorder.start(filename, {SweepRecorder::Stage::VNADeembedded}));
+    for(unsigned int i=0;i<20;i++) {
+        addSweep(recorder, createVNASweep(201, i), SweepRecorder::Stage::VNADeembedded);
+    }
+    recorder.stop();
+
+    auto stats = recorder.getStatistics();
+    QCOMPARE(stats.sweepsRecorded, 20ULL);
+    QCOMPARE(stats.files, 5U);
+    quint64 bytes = 0;
+    quint64 nextSweep = 0;
+    for(unsigned int i=0;i<stats.files;i++) {
+        auto name = dir.filePath(QString("rotation_%1.lvr").arg(i, 4, 10, QChar('0')));
+        bytes += QFileInfo(name).size();
+        vector<SweepRecorder::IndexEntry> index;
+        QVERIFY(SweepRecorder::readIndex(name, index));
+        QCOMPARE(index.size(), (size_t) 4);
+        for(auto &e : index) {
+            QCOMPARE(e.sweep, nextSweep++);
+            SweepRecorder::Sweep sweep;
+            // every file starts with its own settings
+            QVERIFY(SweepRecorder::readSweep(name, e, sweep));
+            QCOMPARE(sweep.channels.size(), (size_t) 2);
+        }
+    }
+    QCOMPARE(bytes, stats.bytesWritten);
+}
+
+void SweepRecorderTests::Playback()
+{
+    QTemporaryDir playbackDir;
+    SweepRecorder recorder;
+    // rotate after every sweep, the playback has to continue in the next file
+    recorder.setRotation(1, 0);
+    QVERIFY(recorder.start(playbackDir.filePath("playback.lvr"), {SweepRecorder::Stage::VNARaw}));
+    for(unsigned int i=0;i<3;i++) {
+        addSweep(recorder, createVNASweep(201, i), SweepRecorder::Stage::VNARaw);
+    }
+    recorder.stop();
+    QCOMPARE(recorder.getStatistics().files, 3U);
+
+    PlaybackDriver driver;
+    driver.setRecordingDirectory(playbackDir.path());
+    driver.setPacing(PlaybackDriver::Pacing::Fastest);
+    driver.setLoop(false);
+    auto devices = driver.GetAvailableDevices();
+    QCOMPARE(devices.size(), (size_t) 1);
+    QCOMPARE(*devices.begin(), QString("playback.lvr"));
+    QVERIFY(driver.connectDevice("playback.lvr", true));
+    QVERIFY(driver.supports(DeviceDriver::Feature::VNA));
+    QVERIFY(!driver.supports(DeviceDriver::Feature::SA));
+    QCOMPARE(driver.getInfo().Limits.VNA.ports, 2U);
+    QCOMPARE(driver.availableVNAMeasurements(), QStringList({"S11", "S21"}));
+
+    QSignalSpy spy(&driver, &DeviceDriver::VNAmeasurementReceived);
+    auto reference = createVNASweep(201, 0);
+    DeviceDriver::VNASettings s;
+    s.freqStart = reference.front().frequency;
+    s.freqStop = reference.back().frequency;
+    s.dBmStart = s.dBmStop = -10.0;
+    s.IFBW = 1000;
+    // twice the recorded points, every other point is interpolated
+    s.points = 401;
+    s.logSweep = false;
+    s.excitedPorts = {1, 2};
+    QVERIFY(driver.setVNA(s));
+    QTRY_COMPARE(spy.count(), 3 * 401);
+    for(unsigned int sweep=0;sweep<3;sweep++) {
+        reference = createVNASweep(201, sweep);
+        for(unsigned int i=0;i<401;i++) {
+            auto m = qvariant_cast<DeviceDriver::VNAMeasurement>(spy[sweep * 401 + i][0]);
+            QCOMPARE(m.pointNum, i);
+            QCOMPARE(m.Z0, 50.0);
+            auto &lower = reference[i / 2];
+            auto &upper = reference[(i + 1) / 2];
+            QVERIFY(abs(m.frequency - (lower.frequency + upper.frequency) / 2) < 1e-3);
+            auto expected = (lower.measurements["S11"] + upper.measurements["S11"]) / 2.0;
+            QVERIFY(abs(m.measurements["S11"] - expected) < 1e-5);
+        }
+    }
+    QVERIFY(driver.getStatus().contains("finished"));
+    driver.disconnectDevice();
+}
+
+void SweepRecorderTests::PlaybackZeroSpan()
+{
+    QTemporaryDir playbackDir;
+    SweepRecorder recorder;
+    SweepRecorder::SweepSettings settings;
+    settings.zerospan = true;
+    settings.start = settings.stop = 2000000000.0;
+    settings.powerStart = settings.powerStop = -20.0;
+    recorder.setVNASweepSettings(settings);
+    QVERIFY(recorder.start(playbackDir.filePath("zerospan.lvr"), {SweepRecorder::Stage::VNARaw}));
+    for(unsigned int i=0;i<10;i++) {
+        DeviceDriver::VNAMeasurement m;
+        m.pointNum = i;
+        m.Z0 = 50.0;
+        m.us = 100.0 * i;
+        m.frequency = settings.start;
+        m.dBm = settings.powerStart;
+        m.measurements["S11"] = complex<double>(0.1 * i, -0.1 * i);
+        recorder.addData(m, SweepRecorder::Stage::VNARaw, i == 9);
+    }
+    recorder.stop();
+
+    PlaybackDriver driver;
+    driver.setRecordingDirectory(playbackDir.path());
+    driver.setPacing(PlaybackDriver::Pacing::Fastest);
+    driver.setLoop(false);
+    QVERIFY(driver.GetAvailableDevices().count("zerospan.lvr"));
+    QVERIFY(driver.connectDevice("zerospan.lvr", true));
+
+    QSignalSpy spy(&driver, &DeviceDriver::VNAmeasurementReceived);
+    DeviceDriver::VNASettings s;
+    s.freqStart = s.freqStop = settings.start;
+    s.dBmStart = s.dBmStop = settings.powerStart;
+    s.IFBW = 1000;
+    s.points = 10;
+    s.logSweep = false;
+    s.excitedPorts = {1};
+    QVERIFY(driver.setVNA(s));
+    QTRY_COMPARE(spy.count(), 10);
+    // every point is replayed from its own sample, not looked up by frequency
+    for(unsigned int i=0;i<10;i++) {
+        auto m = qvariant_cast<DeviceDriver::VNAMeasurement>(spy[i][0]);
+        QCOMPARE(m.pointNum, i);
+        QCOMPARE(m.frequency, 2000000000.0);
+        QCOMPARE(m.us, 100.0 * i);
+        QCOMPARE(m.dBm, -20.0);
+        QVERIFY(abs(m.measurements["S11"] - complex<double>(0.1 * i, -0.1 * i)) < 1e-5);
+    }
+    driver.disconnectDevice();
+}
@@ -0,0 +1,23 @@
+#ifndef SWEEPRECORDERTESTS_H
+#define SWEEPRECORDERTESTS_H
+
+#include <QtTest>
+
+class SweepRecorderTests : public QObject
+{
+    Q_OBJECT
+public:
+    SweepRecorderTests();
+
+private slots:
+    void RoundTrip();
+    void IncompleteSweeps();
+    void ZeroSpan();
+    void Rotation();
+    void Playback();
+    void PlaybackZeroSpan();
+private:
+    QTemporaryDir dir;
+};
+
+#endif // SWEEPRECORDERTESTS_H
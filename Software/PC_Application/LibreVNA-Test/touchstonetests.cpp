@@ -0,0 +1,161 @@
+#include "touchstonetests.h"
+
+#include "touchstone.h"
+
+#include <random>
+#include <sstream>
+#include <iomanip>
+
+using namespace std;
+
+// Creates the data lines of a touchstone file with random values. Every point starts with the frequency,
+// followed by the parameters with at most valuesPerLine parameters per line
+static QByteArray createData(unsigned int ports, unsigned int points, double frequencyScale, unsigned int valuesPerLine, int precision, const char *newline = "\n")
+{
+    mt19937 gen(ports * 1000 + points);
+    uniform_real_distribution<double> dist(-1.0, 1.0);
+    stringstream ss;
+    ss << setprecision(precision);
+    for(unsigned int i=0;i<points;i++) {
+        ss << (1000000.0 + i * 1234567.0) / frequencyScale;
+        for(unsigned int j=0;j<ports * ports;j++) {
+            if(j > 0 && j % valuesPerLine == 0) {
+                ss << newline;
+            }
+            ss << " " << dist(gen) << " " << dist(gen) * 180.0;
+        }
+        ss << newline;
+    }
+    return QByteArray::fromStdString(ss.str());
+}
+
+TouchstoneTests::TouchstoneTests()
+{
+
+}
+
+void TouchstoneTests::initTestCase()
+{
+    QVERIFY(dir.isValid());
+    // 4 port file with 20k points for the benchmark
+    benchmarkFile = writeFile("benchmark.s4p", "# GHz S RI R 50\n" + createData(4, 20000, 1e9, 4, 17));
+}
+
+void TouchstoneTests::ParserEquivalence_data()
+{
+    QTest::addColumn<QString>("filename");
+
+    QTest::newRow("1 port, comments, CRLF") << writeFile("comments.s1p",
+        "! created by test\r\n"
+        "\r\n"
+        "# Hz S RI R 50 ! option line with comment\r\n"
+        "! data starts here\r\n"
+        + createData(1, 101, 1.0, 1, 10, " ! comment\r\n"));
+    QTest::newRow("2 port, MA, MHz, reference impedance") << writeFile("ma.s2p",
+        "# MHz S MA R 75\n" + createData(2, 201, 1e6, 4, 17));
+    QTest::newRow("2 port, whitespace and signs") << writeFile("whitespace.S2P",
+        "   #\tGHZ\tS\tRI\n"
+        "\t1.0\t+0.5  -0.25\t1e-3 +2.5E-2 \t0.125 0.0 .5 -.5   \n"
+        "  \n"
+        "2.0 0.5 -0.25 1e-3 2.5e-2 0.125 0.0 0.5 -0.5 ! trailing comment\n"
+        "3.0 1 2 3 4 5 6 7 8");
+    QTest::newRow("2 port, unsorted") << writeFile("unsorted.s2p",
+        "# GHz S RI\n"
+        "2.0 1 0 0 0 0 0 1 0\n"
+        "1.0 0 1 0 0 0 0 0 1\n"
+        "3.0 0 0 1 1 1 1 0 0\n");
+    QTest::newRow("3 port, dB, kHz, lowercase options") << writeFile("db.s3p",
+        "# khz s db r 50\n" + createData(3, 51, 1e3, 3, 6));
+    QTest::newRow("4 port, multi-line blocks") << writeFile("blocks.s4p",
+        "! 4 port data\n"
+        "# GHz S RI R 50\n" + createData(4, 101, 1e9, 4, 12));
+    QTest::newRow("empty") << writeFile("empty.s2p", "");
+    QTest::newRow("only options") << writeFile("options.s2p", "# GHz S RI R 50\n");
+
+    // measurements from the documentation
+    for(auto f : {"Mini-circuits_VAT-10+.s2p", "Murata_RF1419D.s2p", "Prototype_Isolation_SOLT+iso.s2p"}) {
+        auto path = QFINDTESTDATA(QString("../../../Documentation/Measurements/") + f);
+        if(!path.isEmpty()) {
+            QTest::newRow(f) << path;
+        }
+    }
+}
+
+void TouchstoneTests::ParserEquivalence()
+{
+    QFETCH(QString, filename);
+    auto reference = Touchstone::fromFileLegacy(filename.toStdString());
+    auto t = Touchstone::fromFile(filename.toStdString());
+    QCOMPARE(t.ports(), reference.ports());
+    QCOMPARE(t.getReferenceImpedance(), reference.getReferenceImpedance());
+    QCOMPARE(t.points(), reference.points());
+    QCOMPARE(t.getFilename(), reference.getFilename());
+    for(unsigned int i=0;i<t.points();i++) {
+        auto p = t.point(i);
+        auto ref = reference.point(i);
+        // numbers are converted with correct rounding by both parsers, results have to be identical
+        QCOMPARE(p.frequency, ref.frequency);
+        QCOMPARE(p.S.size(), ref.S.size());
+        for(unsigned int j=0;j<p.S.size();j++) {
+            QCOMPARE(p.S[j].real(), ref.S[j].real());
+            QCOMPARE(p.S[j].imag(), ref.S[j].imag());
+        }
+    }
+}
+
+void TouchstoneTests::InvalidFiles_data()
+{
+    QTest::addColumn<QString>("filename");
+
+    QTest::newRow("missing file") << dir.filePath("missing.s2p");
+    QTest::newRow("extension") << writeFile("extension.txt", "# GHz S RI\n1.0 0 0\n");
+    QTest::newRow("data before option line") << writeFile("first.s1p", "1.0 0 0\n# GHz S RI\n");
+    QTest::newRow("second option line") << writeFile("second.s1p", "# GHz S RI\n1.0 0 0\n# MHz S RI\n");
+    QTest::newRow("Y parameters") << writeFile("y.s1p", "# GHz Y RI\n1.0 0 0\n");
+    QTest::newRow("unknown option") << writeFile("option.s1p", "# GHz S XY\n1.0 0 0\n");
+    QTest::newRow("missing value") << writeFile("missing.s2p", "# GHz S RI\n1.0 0 0 0 0 0 0 0\n");
+    QTest::newRow("invalid value") << writeFile("invalid.s1p", "# GHz S RI\n1.0 0 abc\n");
+}
+
+void TouchstoneTests::InvalidFiles()
+{
+    QFETCH(QString, filename);
+    auto throws = [](std::function<Touchstone(std::string)> parse, QString filename) {
+        try {
+            parse(filename.toStdString());
+        } catch (const std::exception &) {
+            return true;
+        }
+        return false;
+    };
+    QVERIFY(throws(Touchstone::fromFileLegacy, filename));
+    QVERIFY(throws(Touchstone::fromFile, filename));
+}
+
+void TouchstoneTests::ParserBenchmark_data()
+{
+    QTest::addColumn<bool>("legacy");
+    QTest::newRow("legacy") << true;
+    QTest::newRow("fromFile") << false;
+}
+
+void TouchstoneTests::ParserBenchmark()
+{
+    QFETCH(bool, legacy);
+    unsigned int points = 0;
+    QBENCHMARK {
+        auto t = legacy ? Touchstone::fromFileLegacy(benchmarkFile.toStdString()) : Touchstone::fromFile(benchmarkFile.toStdString());
+        points = t.points();
+    }
+    QCOMPARE(points, 20000U);
+}
+
+QString TouchstoneTests::writeFile(QString name, QByteArray contents)
+{
+    auto path = dir.filePath(name);
+    QFile file(path);
+    if(file.open(QIODevice::WriteOnly)) {
+        file.write(contents);
+    }
+    return path;
+}
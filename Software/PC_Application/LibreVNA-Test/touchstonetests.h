@@ -0,0 +1,26 @@
+#ifndef TOUCHSTONETESTS_H
+#define TOUCHSTONETESTS_H
+
+#include <QtTest>
+
+class TouchstoneTests : public QObject
+{
+    Q_OBJECT
+public:
+    TouchstoneTests();
+
+private slots:
+    void initTestCase();
+    void ParserEquivalence_data();
+    void ParserEquivalence();
+    void InvalidFiles_data();
+    void InvalidFiles();
+    void ParserBenchmark_data();
+    void ParserBenchmark();
+private:
+    QString writeFile(QString name, QByteArray contents);
+    QTemporaryDir dir;
+    QString benchmarkFile;
+};
+
+#endif // TOUCHSTONETESTS_H
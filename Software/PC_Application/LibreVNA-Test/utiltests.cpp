@@ -2,6 +2,13 @@
 
 #include <vector>
 #include "util.h"
+#include "prbs.h"
+#include "numberformatter.h"
+#include "csv.h"
+#include "latencytracer.h"
+#include "metrics.h"
+
+#include <thread>
 
 using namespace std;
 
@@ -78,3 +85,284 @@ void UtilTests::FirmwareComparison()
     QVERIFY(Util::firmwareEqualOrHigher("2.2.2", "2.3") == false);
     QVERIFY(Util::firmwareEqualOrHigher("2.2", "2.3.1") == false);
 }
+
+void UtilTests::PRBSWordOutput()
+{
+    for(unsigned int bits=2;bits<=11;bits++) {
+        PRBS bitwise(bits);
+        PRBS wordwise(bits);
+        // the sequence repeats after 2^bits-1 bits, check several periods with varying word lengths
+        unsigned int checked = 0;
+        for(unsigned int n=0;checked < 4 * (1UL << bits);n = (n + 7) % 33) {
+            unsigned int expected = 0;
+            for(unsigned int i=0;i<n;i++) {
+                expected = (expected << 1) | (bitwise.next() ? 0x01 : 0x00);
+            }
+            QCOMPARE(wordwise.next(n), expected);
+            checked += n;
+        }
+    }
+}
+
+void UtilTests::NumberFormatting()
+{
+    // output has to be identical to QString::number
+    const double values[] = {0.0, 1.0, -1.0, 0.1, 1e-5, 123456.789, 1e6, -2.5e-300, 1e300, M_PI, 6.0e9, 0.000123456789,
+                             std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity()};
+    for(auto v : values) {
+        QCOMPARE(NumberFormatter().add(v).toString(), QString::number(v));
+        QCOMPARE(NumberFormatter().add(v, 10).toString(), QString::number(v, 'g', 10));
+        if(abs(v) < 1e15 && (v == 0.0 || abs(v) > 1e-12)) {
+            // fixed format only for values in a sensible range (no rounding of negative values to zero)
+            QCOMPARE(NumberFormatter().addFixed(v, 0).toString(), QString::number(v, 'f', 0));
+            QCOMPARE(NumberFormatter().addFixed(v, 12).toString(), QString::number(v, 'f', 12));
+        }
+        // shortest representation converts back to the identical value
+        QCOMPARE(NumberFormatter().addShortest(v).toString().toDouble(), v);
+    }
+    QCOMPARE(NumberFormatter().add(std::numeric_limits<double>::quiet_NaN()).toString(), QString("nan"));
+
+    NumberFormatter f;
+    f.add('[').addFixed(1e9, 0).add(',').add(0.5).add(',').add(-0.25).add("],");
+    f.chop();
+    QCOMPARE(f.toString(), QString("[1000000000,0.5,-0.25]"));
+    f.chop(100);
+    QVERIFY(f.isEmpty());
+}
+
+void UtilTests::NumberFormattingBenchmark_data()
+{
+    QTest::addColumn<bool>("formatter");
+    QTest::newRow("QString::number") << false;
+    QTest::newRow("NumberFormatter") << true;
+}
+
+void UtilTests::NumberFormattingBenchmark()
+{
+    // ASCII response of a trace with 100k points (as created by VNA:TRACe:DATA?)
+    QFETCH(bool, formatter);
+    constexpr unsigned int points = 100000;
+    std::vector<double> x, re, im;
+    for(unsigned int i=0;i<points;i++) {
+        x.push_back(100000 + i * 60000.0);
+        auto y = polar(0.9 - 0.5 * i / points, i * 0.01);
+        re.push_back(y.real());
+        im.push_back(y.imag());
+    }
+    QString result;
+    QBENCHMARK {
+        if(formatter) {
+            NumberFormatter ret(points * 48);
+            for(unsigned int i=0;i<points;i++) {
+                ret.add('[').addFixed(x[i], 0).add(',').add(re[i]).add(',').add(im[i]).add("],");
+            }
+            ret.chop();
+            result = ret.toString();
+        } else {
+            QString ret;
+            for(unsigned int i=0;i<points;i++) {
+                ret += "[" + QString::number(x[i], 'f', 0) + "," + QString::number(re[i]) + "," + QString::number(im[i]) + "],";
+            }
+            ret.chop(1);
+            result = ret;
+        }
+    }
+    QVERIFY(result.startsWith("[100000,0.9,0],[160000,"));
+}
+
+void UtilTests::CSVRoundTrip()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    CSV csv;
+    std::vector<double> x, y;
+    for(unsigned int i=0;i<10000;i++) {
+        x.push_back(1e6 + i * 12345.0);
+        y.push_back(sin(i * 0.1) * 1e-3);
+    }
+    // columns of different length are allowed
+    y.resize(5000);
+    csv.addColumn("Frequency", x);
+    csv.addColumn("S11_Real", y);
+    auto filename = dir.filePath("test.csv");
+    csv.toFile(filename);
+
+    auto read = CSV::fromFile(filename);
+    QCOMPARE(read.columns(), 2U);
+    QCOMPARE(read.getHeader(0), QString("Frequency"));
+    QCOMPARE(read.getHeader(1), QString("S11_Real"));
+    auto &readX = read.getColumn("Frequency");
+    auto &readY = read.getColumn(1);
+    QCOMPARE(readX.size(), x.size());
+    // missing values are read as 0
+    QCOMPARE(readY.size(), x.size());
+    for(unsigned int i=0;i<x.size();i++) {
+        // written with 10 significant digits
+        QVERIFY(abs(readX[i] - x[i]) <= abs(x[i]) * 1e-10);
+        if(i < y.size()) {
+            QVERIFY(abs(readY[i] - y[i]) <= abs(y[i]) * 1e-9);
+        } else {
+            QCOMPARE(readY[i], 0.0);
+        }
+    }
+}
+
+void UtilTests::CSVParsing()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    auto filename = dir.filePath("test.csv");
+    QFile file(filename);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("x;a;b;\r\n"
+               "1;+2.5; -3e-3 ;\r\n"
+               "\r\n"
+               "2;abc;4\r\n"
+               "3;1.5x\r\n"
+               "4;5;6");
+    file.close();
+
+    auto csv = CSV::fromFile(filename, ';');
+    QCOMPARE(csv.columns(), 3U);
+    QCOMPARE(csv.getHeader(2), QString("b"));
+    QCOMPARE(csv.getColumn(0), std::vector<double>({1.0, 0.0, 2.0, 3.0, 4.0}));
+    QCOMPARE(csv.getColumn(1), std::vector<double>({2.5, 0.0, 0.0, 0.0, 5.0}));
+    QCOMPARE(csv.getColumn(2), std::vector<double>({-3e-3, 0.0, 4.0, 0.0, 6.0}));
+    QCOMPARE(csv.getFilename(), filename);
+}
+
+void UtilTests::LatencyTracing()
+{
+    if(!LatencyTracer::isAvailable()) {
+        QSKIP("Compiled without latency tracing");
+    }
+    {
+        // recorded before the start, must not show up in the trace
+        LATENCY_SPAN("Ignored", "Test");
+    }
+    LatencyTracer::start();
+    QVERIFY(LatencyTracer::isActive());
+    {
+        LATENCY_SPAN("Main", "Test", 42);
+    }
+    constexpr unsigned int threads = 4;
+    constexpr unsigned int spansPerThread = 1000;
+    vector<thread> workers;
+    for(unsigned int i=0;i<threads;i++) {
+        workers.push_back(thread([=](){
+            LATENCY_THREAD_NAME("Worker "+QString::number(i));
+            for(unsigned int j=0;j<spansPerThread;j++) {
+                LATENCY_SPAN("Worker", "Test", j);
+            }
+        }));
+    }
+    // overflows the ring buffer, only the newest spans are kept
+    thread overflow([](){
+        LATENCY_THREAD_NAME("Overflow");
+        for(unsigned int j=0;j<LatencyTracer::bufferSize+100;j++) {
+            LATENCY_SPAN("Overflow", "Test", j);
+        }
+    });
+    // named but never records anything, must not allocate a buffer
+    thread idle([](){
+        LATENCY_THREAD_NAME("Idle");
+    });
+    for(auto &w : workers) {
+        w.join();
+    }
+    overflow.join();
+    idle.join();
+    LatencyTracer::stop();
+    QVERIFY(!LatencyTracer::isActive());
+    {
+        LATENCY_SPAN("Ignored", "Test");
+    }
+
+    auto j = LatencyTracer::toJSON();
+    QVERIFY(j["traceEvents"].is_array());
+    map<unsigned int, QString> threadNames;
+    map<QString, unsigned int> spans;
+    long long minOverflowValue = -1;
+    for(auto e : j["traceEvents"]) {
+        QVERIFY(e.contains("name"));
+        QVERIFY(e.contains("ph"));
+        if(e["ph"] == "M") {
+            if(e["name"] == "thread_name") {
+                threadNames[e["tid"].get<unsigned int>()] = QString::fromStdString(e["args"]["name"].get<string>());
+            }
+            continue;
+        }
+        QCOMPARE(e["ph"].get<string>(), string("X"));
+        QVERIFY(e["ts"].get<double>() >= 0.0);
+        QVERIFY(e["dur"].get<double>() >= 0.0);
+        auto name = QString::fromStdString(e["name"].get<string>());
+        auto threadName = threadNames[e["tid"].get<unsigned int>()];
+        spans[name]++;
+        if(name == "Main") {
+            QCOMPARE(e["args"]["value"].get<long long>(), 42LL);
+            QCOMPARE(threadName, QString("Main"));
+        } else if(name == "Overflow") {
+            QCOMPARE(threadName, QString("Overflow"));
+            auto value = e["args"]["value"].get<long long>();
+            if(minOverflowValue < 0 || value < minOverflowValue) {
+                minOverflowValue = value;
+            }
+        } else {
+            QVERIFY(threadName.startsWith("Worker "));
+        }
+    }
+    QVERIFY(!spans.count("Ignored"));
+    for(auto &t : threadNames) {
+        QVERIFY(t.second != "Idle");
+    }
+    QCOMPARE(spans["Main"], 1U);
+    QCOMPARE(spans["Worker"], threads * spansPerThread);
+    // the oldest overflowing spans have been overwritten, a full buffer remains
+    QCOMPARE(spans["Overflow"], LatencyTracer::bufferSize);
+    QCOMPARE(minOverflowValue, 100LL);
+}
+
+void UtilTests::MetricsRegistry()
+{
+    auto &m = Metrics::getInstance();
+    auto &c = m.counter("test_events_total", "Test events");
+    c.increment();
+    c.increment(4);
+    // the same name returns the same metric
+    QCOMPARE(&m.counter("test_events_total", "Test events"), &c);
+    QCOMPARE(c.get(), 5ULL);
+    QCOMPARE(m.find("test_events_total")->toString(), QString("5"));
+    QVERIFY(!m.find("test_unknown"));
+
+    auto &g = m.gauge("test_level", "Test level");
+    g.set(2.5);
+    QCOMPARE(g.toString(), QString("2.5"));
+
+    auto &h = m.histogram("test_duration_seconds", "Test durations", Metrics::Histogram::exponentialBounds(1.0, 2.0, 4));
+    for(int i=1;i<=100;i++) {
+        h.observe(i * 0.1);
+    }
+    QCOMPARE(h.getCount(), 100ULL);
+    QCOMPARE(h.getMean(), 5.05);
+    QCOMPARE(h.getLast(), 10.0);
+    QCOMPARE(h.getQuantile(0.5), 5.0);
+    QCOMPARE(h.toString(), QString("100,5.05,0.1,10,5,9.9,10"));
+
+    auto text = m.toText();
+    QVERIFY(text.contains("# TYPE test_events_total counter\ntest_events_total 5\n"));
+    QVERIFY(text.contains("# HELP test_level Test level\n# TYPE test_level gauge\ntest_level 2.5\n"));
+    // bucket counts are cumulative, a value equal to a bound belongs to that bucket
+    QVERIFY(text.contains("test_duration_seconds_bucket{le=\"1\"} 10\n"
+                          "test_duration_seconds_bucket{le=\"2\"} 20\n"
+                          "test_duration_seconds_bucket{le=\"4\"} 40\n"
+                          "test_duration_seconds_bucket{le=\"8\"} 80\n"
+                          "test_duration_seconds_bucket{le=\"+Inf\"} 100\n"
+                          "test_duration_seconds_sum 505\n"
+                          "test_duration_seconds_count 100\n"));
+    QVERIFY(m.getNames().contains("test_duration_seconds"));
+
+    m.reset();
+    QCOMPARE(c.get(), 0ULL);
+    QCOMPARE(g.get(), 0.0);
+    QCOMPARE(h.getCount(), 0ULL);
+}
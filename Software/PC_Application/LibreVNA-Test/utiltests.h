@@ -14,6 +14,14 @@ private slots:
     void IdealArcApproximation();
     void NoisyCircleApproximation();
     void FirmwareComparison();
+    void PRBSWordOutput();
+    void NumberFormatting();
+    void NumberFormattingBenchmark_data();
+    void NumberFormattingBenchmark();
+    void CSVRoundTrip();
+    void CSVParsing();
+    void LatencyTracing();
+    void MetricsRegistry();
 };
 
 #endif // UTILTESTS_H
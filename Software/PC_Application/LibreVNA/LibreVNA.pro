@@ -2,4 +2,5 @@ TEMPLATE = subdirs
 
 SUBDIRS += \
     ../LibreVNA-GUI \
-    ../LibreVNA-Test
+    ../LibreVNA-Test \
+    ../LibreVNA-Bench
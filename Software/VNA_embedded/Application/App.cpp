@@ -129,6 +129,10 @@ inline void App_Process() {
 					sweepActive = VNA::Setup(recv_packet.settings);
 					Communication::SendWithoutPayload(Protocol::PacketType::Ack);
 					break;
+				case Protocol::PacketType::DatapointFormat:
+					VNA::SetDatapointFormat(recv_packet.datapointFormat);
+					Communication::SendWithoutPayload(Protocol::PacketType::Ack);
+					break;
 				case Protocol::PacketType::ManualControl:
 					sweepActive = false;
 					last_measure_packet = recv_packet;
@@ -158,6 +162,8 @@ inline void App_Process() {
 					Communication::SendWithoutPayload(Protocol::PacketType::Ack);
 					break;
 				case Protocol::PacketType::RequestDeviceInfo: {
+					// first request of a (possibly different) host, forget the datapoint format of the previous one
+					VNA::SetDatapointFormat(Protocol::DatapointFormat {});
 					Communication::SendWithoutPayload(Protocol::PacketType::Ack);
 					Protocol::PacketInfo p;
 					p.type = Protocol::PacketType::DeviceInfo;
@@ -196,6 +202,7 @@ inline void App_Process() {
 				case Protocol::PacketType::SetIdle:
 					HW::SetMode(HW::Mode::Idle);
 					sweepActive = false;
+					VNA::SetDatapointFormat(Protocol::DatapointFormat {});
 					Communication::SendWithoutPayload(Protocol::PacketType::Ack);
 					break;
 		#ifdef HAS_FLASH
@@ -301,6 +308,8 @@ inline void App_Process() {
 				}
 			}
 			if(notification & FLAG_TRIGGER_OUT_ISR) {
+				// the sweep might be waiting for a trigger, do not hold back any points
+				VNA::SendPendingData(false);
 				// trigger output (from FPGA) changed level
 				bool set = Trigger::GetOutput();
 				switch(Trigger::GetMode()) {
@@ -331,6 +340,8 @@ inline void App_Process() {
 			USBPacketReceived(last_measure_packet);
 		}
 		HW::updateDeviceStatus();
+		// points are also passed on if the sweep slows down or stops
+		VNA::SendPendingData(true);
 	}
 }
 
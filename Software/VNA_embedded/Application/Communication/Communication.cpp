@@ -9,6 +9,7 @@ static uint8_t inputBuffer[1024];
 uint16_t inputCnt = 0;
 static Communication::Callback callback = nullptr;
 static uint8_t blockAcks = 0;
+static bool datapointCRC = false;
 
 void Communication::SetCallback(Callback cb) {
 	callback = cb;
@@ -46,7 +47,7 @@ bool Communication::Send(const Protocol::PacketInfo &packet) {
 //	DEBUG1_HIGH();
 	uint8_t outputBuffer[512];
 	uint16_t len = Protocol::EncodePacket(packet, outputBuffer,
-					sizeof(outputBuffer));
+					sizeof(outputBuffer), datapointCRC);
 //	DEBUG1_LOW();
 	return usb_transmit(outputBuffer, len);
 //	if (hUsbDeviceFS.dev_state == USBD_STATE_CONFIGURED) {
@@ -78,3 +79,7 @@ bool Communication::SendWithoutPayload(Protocol::PacketType type) {
 void Communication::BlockNextAck() {
 	blockAcks++;
 }
+
+void Communication::SetDatapointCRC(bool enabled) {
+	datapointCRC = enabled;
+}
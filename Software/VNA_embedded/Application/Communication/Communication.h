@@ -14,6 +14,8 @@ void SetCallback(Callback cb);
 void Input(const uint8_t *buf, uint16_t len);
 bool Send(const Protocol::PacketInfo &packet);
 void BlockNextAck();
+// VNADatapoints are sent with a CRC if enabled (requested by the host in the sweep settings)
+void SetDatapointCRC(bool enabled);
 bool SendWithoutPayload(Protocol::PacketType type);
 
 }
@@ -1,5 +1,6 @@
 #include "Protocol.hpp"
 #include <cstring>
+#include <cmath>
 #include "PacketConstants.h"
 
 /*
@@ -12,7 +13,59 @@
  */
 
 #define CRC32_POLYGON 0xEDB88320
+
+namespace {
+
+/*
+ * Lookup tables for the slicing-by-8 CRC32, calculated at compile time (8kB, stored in flash on the device).
+ * table[0] is the classic byte-wise table, table[k] advances the CRC of a byte by k additional zero bytes.
+ */
+struct CRC32Table {
+	uint32_t table[8][256];
+};
+
+constexpr CRC32Table createCRC32Table() {
+	CRC32Table t{};
+	for(uint32_t i = 0; i < 256; i++) {
+		uint32_t crc = i;
+		for(int k = 0; k < 8; k++) {
+			crc = crc & 1 ? (crc >> 1) ^ CRC32_POLYGON : crc >> 1;
+		}
+		t.table[0][i] = crc;
+	}
+	for(uint32_t i = 0; i < 256; i++) {
+		for(int k = 1; k < 8; k++) {
+			t.table[k][i] = (t.table[k-1][i] >> 8) ^ t.table[0][t.table[k-1][i] & 0xFF];
+		}
+	}
+	return t;
+}
+
+constexpr CRC32Table crc32 = createCRC32Table();
+
+}
+
 uint32_t Protocol::CRC32(uint32_t crc, const void *data, uint32_t len) {
+	const uint8_t *u8buf = (const uint8_t*) data;
+	auto &t = crc32.table;
+
+	crc = ~crc;
+	// process 8 bytes per iteration (assembled byte-wise, works on any alignment and endianness)
+	while (len >= 8) {
+		uint32_t one = crc ^ ((uint32_t) u8buf[0] | ((uint32_t) u8buf[1] << 8) | ((uint32_t) u8buf[2] << 16) | ((uint32_t) u8buf[3] << 24));
+		uint32_t two = (uint32_t) u8buf[4] | ((uint32_t) u8buf[5] << 8) | ((uint32_t) u8buf[6] << 16) | ((uint32_t) u8buf[7] << 24);
+		crc = t[7][one & 0xFF] ^ t[6][(one >> 8) & 0xFF] ^ t[5][(one >> 16) & 0xFF] ^ t[4][one >> 24]
+			^ t[3][two & 0xFF] ^ t[2][(two >> 8) & 0xFF] ^ t[1][(two >> 16) & 0xFF] ^ t[0][two >> 24];
+		u8buf += 8;
+		len -= 8;
+	}
+	while (len--) {
+		crc = (crc >> 8) ^ t[0][(crc ^ *u8buf++) & 0xFF];
+	}
+	return ~crc;
+}
+
+uint32_t Protocol::CRC32Bitwise(uint32_t crc, const void *data, uint32_t len) {
 	uint8_t *u8buf = (uint8_t*) data;
 	int k;
 
@@ -25,6 +78,252 @@ uint32_t Protocol::CRC32(uint32_t crc, const void *data, uint32_t len) {
 	return ~crc;
 }
 
+uint16_t Protocol::FloatToHalf(float f) {
+	uint32_t x;
+	memcpy(&x, &f, sizeof(x));
+	uint16_t sign = (x >> 16) & 0x8000;
+	x &= 0x7FFFFFFF;
+	if(x >= 0x38800000) {
+		// normal half (or too large)
+		if(x >= 0x7F800000) {
+			// infinity or NaN
+			return sign | 0x7C00 | (x > 0x7F800000 ? 0x200 : 0);
+		}
+		if(x >= 0x47800000) {
+			// too large, infinity
+			return sign | 0x7C00;
+		}
+		// rebias the exponent and round to nearest, ties to even. Without branches, the rounding depends on the data.
+		// A carry into the exponent is still correct (up to infinity)
+		x -= (uint32_t) (127 - 15) << 23;
+		x += 0xFFF + ((x >> 13) & 0x01);
+		return sign | (x >> 13);
+	}
+	// subnormal (or zero)
+	int32_t exponent = (int32_t) (x >> 23) - 127 + 15;
+	if(exponent < -10) {
+		return sign;
+	}
+	uint32_t mantissa = (x & 0x7FFFFF) | 0x800000;
+	uint32_t shift = 14 - exponent;
+	uint32_t half = mantissa >> shift;
+	uint32_t remainder = mantissa & ((1UL << shift) - 1);
+	uint32_t halfway = 1UL << (shift - 1);
+	if(remainder > halfway || (remainder == halfway && (half & 0x01))) {
+		half++;
+	}
+	return sign | half;
+}
+
+float Protocol::HalfToFloat(uint16_t h) {
+	uint32_t sign = (uint32_t) (h & 0x8000) << 16;
+	uint32_t exponent = (h >> 10) & 0x1F;
+	uint32_t mantissa = h & 0x3FF;
+	uint32_t x;
+	if(exponent == 0x1F) {
+		// infinity or NaN
+		x = sign | 0x7F800000 | (mantissa << 13);
+	} else if(exponent == 0) {
+		// subnormal (or zero)
+		float f = mantissa * (1.0f / 16777216.0f);
+		return sign ? -f : f;
+	} else {
+		x = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+	}
+	float f;
+	memcpy(&f, &x, sizeof(f));
+	return f;
+}
+
+namespace {
+
+// Scale factors of half precision values are powers of two within the range of normal floats (cheaper than ldexpf)
+int clampScaleExponent(int exponent) {
+	if(exponent > 126) {
+		return 126;
+	} else if(exponent < -126) {
+		return -126;
+	}
+	return exponent;
+}
+
+float powerOfTwo(int exponent) {
+	uint32_t bits = (uint32_t) (exponent + 127) << 23;
+	float f;
+	memcpy(&f, &bits, sizeof(f));
+	return f;
+}
+
+}
+
+void Protocol::VNADatapointBlock::clear(uint8_t flags) {
+	memset(payload, 0, headerSize);
+	payload[0] = flags;
+	size = headerSize;
+}
+
+uint16_t Protocol::VNADatapointBlock::pointSize() const {
+	uint8_t values = payload[2];
+	uint16_t ret = DPNT_POW_LVL_LEN;
+	if(!(payload[0] & FrequencyOmitted)) {
+		ret += DPNT_FREQ_LEN;
+	}
+	if(payload[0] & HalfPrecision) {
+		ret += 1 + values * 2 * sizeof(uint16_t);
+	} else {
+		ret += values * (DPNT_REAL_PART_LEN + DPNT_IMAG_PART_LEN);
+	}
+	return ret;
+}
+
+bool Protocol::VNADatapointBlock::addPoint(VNADatapoint<32> &point) {
+	uint8_t values = point.getNumValues();
+	uint8_t points = payload[1];
+	uint16_t first;
+	memcpy(&first, &payload[3], sizeof(first));
+	if(points == 0) {
+		// the first point defines the values of the block
+		payload[2] = values;
+		memcpy(&payload[3], &point.pointNum, sizeof(point.pointNum));
+		for(uint8_t i=0;i<values;i++) {
+			payload[headerSize + i] = point.getDescription(i);
+		}
+		size = headerSize + values;
+	} else {
+		if(points == UINT8_MAX || values != payload[2] || point.pointNum != (uint16_t) (first + points)) {
+			return false;
+		}
+		for(uint8_t i=0;i<values;i++) {
+			if(payload[headerSize + i] != point.getDescription(i)) {
+				return false;
+			}
+		}
+	}
+	uint16_t needed = pointSize();
+	if(size + needed > maxPayloadSize) {
+		if(points == 0) {
+			clear(payload[0]);
+		}
+		return false;
+	}
+	uint8_t *dest = &payload[size];
+	if(!(payload[0] & FrequencyOmitted)) {
+		memcpy(dest, &point.frequency, DPNT_FREQ_LEN);
+		dest += DPNT_FREQ_LEN;
+	}
+	memcpy(dest, &point.cdBm, DPNT_POW_LVL_LEN);
+	dest += DPNT_POW_LVL_LEN;
+	if(payload[0] & HalfPrecision) {
+		// scale the values to use the range of float16 (the largest value stays below 2^15, float16 goes up to 65504)
+		float max = 0.0f;
+		for(uint8_t i=0;i<values;i++) {
+			if(fabsf(point.getReal(i)) > max) {
+				max = fabsf(point.getReal(i));
+			}
+			if(fabsf(point.getImag(i)) > max) {
+				max = fabsf(point.getImag(i));
+			}
+		}
+		int exponent = 0;
+		if(max > 0.0f && std::isfinite(max)) {
+			uint32_t bits;
+			memcpy(&bits, &max, sizeof(bits));
+			// max is below 2^(biased exponent - 126)
+			exponent = clampScaleExponent(15 - ((int) (bits >> 23) - 126));
+		}
+		*dest++ = (uint8_t) (int8_t) exponent;
+		float scale = powerOfTwo(exponent);
+		for(uint8_t i=0;i<values;i++) {
+			uint16_t h = FloatToHalf(point.getReal(i) * scale);
+			memcpy(dest, &h, sizeof(h));
+			dest += sizeof(h);
+		}
+		for(uint8_t i=0;i<values;i++) {
+			uint16_t h = FloatToHalf(point.getImag(i) * scale);
+			memcpy(dest, &h, sizeof(h));
+			dest += sizeof(h);
+		}
+	} else {
+		for(uint8_t i=0;i<values;i++) {
+			float f = point.getReal(i);
+			memcpy(dest, &f, DPNT_REAL_PART_LEN);
+			dest += DPNT_REAL_PART_LEN;
+		}
+		for(uint8_t i=0;i<values;i++) {
+			float f = point.getImag(i);
+			memcpy(dest, &f, DPNT_IMAG_PART_LEN);
+			dest += DPNT_IMAG_PART_LEN;
+		}
+	}
+	size += needed;
+	payload[1]++;
+	return true;
+}
+
+bool Protocol::VNADatapointBlock::getPoint(uint8_t index, VNADatapoint<32> &point) const {
+	if(index >= payload[1]) {
+		return false;
+	}
+	uint8_t values = payload[2];
+	uint16_t first;
+	memcpy(&first, &payload[3], sizeof(first));
+	point.clear();
+	point.pointNum = first + index;
+	const uint8_t *src = &payload[headerSize + values + index * pointSize()];
+	if(!(payload[0] & FrequencyOmitted)) {
+		memcpy(&point.frequency, src, DPNT_FREQ_LEN);
+		src += DPNT_FREQ_LEN;
+	}
+	memcpy(&point.cdBm, src, DPNT_POW_LVL_LEN);
+	src += DPNT_POW_LVL_LEN;
+	float scale = 1.0f;
+	uint8_t valueSize = DPNT_REAL_PART_LEN;
+	if(payload[0] & HalfPrecision) {
+		scale = powerOfTwo(-clampScaleExponent((int8_t) *src++));
+		valueSize = sizeof(uint16_t);
+	}
+	const uint8_t *imag = src + values * valueSize;
+	for(uint8_t i=0;i<values;i++) {
+		float real, imaginary;
+		if(payload[0] & HalfPrecision) {
+			uint16_t h;
+			memcpy(&h, &src[i * valueSize], sizeof(h));
+			real = HalfToFloat(h) * scale;
+			memcpy(&h, &imag[i * valueSize], sizeof(h));
+			imaginary = HalfToFloat(h) * scale;
+		} else {
+			memcpy(&real, &src[i * valueSize], sizeof(real));
+			memcpy(&imaginary, &imag[i * valueSize], sizeof(imaginary));
+		}
+		uint8_t descr = payload[headerSize + i];
+		point.addValue(real, imaginary, descr >> DPNT_CONF_STAGE_OFFSET, descr & ((1 << DPNT_CONF_STAGE_OFFSET) - 1));
+	}
+	return true;
+}
+
+bool Protocol::VNADatapointBlock::encode(uint8_t *dest, uint16_t destSize) const {
+	if(size > destSize) {
+		return false;
+	}
+	memcpy(dest, payload, size);
+	return true;
+}
+
+bool Protocol::VNADatapointBlock::decode(const uint8_t *buffer, uint16_t len) {
+	clear(0);
+	if(len < headerSize || len > maxPayloadSize) {
+		return false;
+	}
+	memcpy(payload, buffer, len);
+	// the points are decoded into VNADatapoint<32>
+	if(payload[2] > 32 || len != headerSize + payload[2] + payload[1] * pointSize()) {
+		clear(0);
+		return false;
+	}
+	size = len;
+	return true;
+}
+
 uint16_t Protocol::DecodeBuffer(uint8_t *buf, uint16_t len, PacketInfo *info) {
     if (!info || !len) {
         info->type = PacketType::None;
@@ -66,7 +365,7 @@ uint16_t Protocol::DecodeBuffer(uint8_t *buf, uint16_t len, PacketInfo *info) {
 	/* The complete frame has been received, check checksum */
 	auto type = (PacketType) data[PCKT_TYPE_OFFSET];
     uint32_t crc = (uint32_t) data[length-4] | ((uint32_t) data[length-3] << 8) | ((uint32_t) data[length-2] << 16) | ((uint32_t) data[length-1] << 24);
-	if(type != PacketType::VNADatapoint) {
+	if(type != PacketType::VNADatapoint && type != PacketType::VNADatapointBlock) {
 		uint32_t compare = CRC32(0, data, length - PCKT_CRC_LEN);
 		if(crc != compare) {
 			// CRC mismatch, remove header
@@ -77,22 +376,34 @@ uint16_t Protocol::DecodeBuffer(uint8_t *buf, uint16_t len, PacketInfo *info) {
 		// Valid packet, copy packet type and payload
 		memcpy(info, &data[PCKT_TYPE_OFFSET], length - 7);
 	} else {
-		// Datapoint has the CRC set to zero
-		if(crc != 0x00000000) {
+		// Datapoints only carry a CRC if the host requested it in the sweep settings, otherwise the CRC is set to zero
+		if(crc != 0x00000000 && crc != CRC32(0, data, length - PCKT_CRC_LEN)) {
 			data += 1;
 			info->type = PacketType::None;
 			return data - buf;
 		}
-		// Create the datapoint
-		info->type = (PacketType) data[PCKT_TYPE_OFFSET];
-		info->VNAdatapoint = new VNADatapoint<32>;
-		info->VNAdatapoint->decode(&data[PCKT_PAYLOAD_OFFSET], length - PCKT_EXCL_PAYLOAD_LEN);
+		if(type == PacketType::VNADatapoint) {
+			// Create the datapoint
+			info->type = type;
+			info->VNAdatapoint = new VNADatapoint<32>;
+			info->VNAdatapoint->decode(&data[PCKT_PAYLOAD_OFFSET], length - PCKT_EXCL_PAYLOAD_LEN);
+		} else {
+			auto block = new VNADatapointBlock;
+			if(!block->decode(&data[PCKT_PAYLOAD_OFFSET], length - PCKT_EXCL_PAYLOAD_LEN)) {
+				delete block;
+				data += 1;
+				info->type = PacketType::None;
+				return data - buf;
+			}
+			info->type = type;
+			info->VNAdatapointBlock = block;
+		}
 	}
 
 	return data - buf + length;
 }
 
-uint16_t Protocol::EncodePacket(const PacketInfo &packet, uint8_t *dest, uint16_t destsize) {
+uint16_t Protocol::EncodePacket(const PacketInfo &packet, uint8_t *dest, uint16_t destsize, bool datapointCRC) {
    int16_t payload_size = 0;
 	switch (packet.type) {
 //	case PacketType::Datapoint: payload_size = sizeof(packet.datapoint); break;
@@ -110,6 +421,7 @@ uint16_t Protocol::EncodePacket(const PacketInfo &packet, uint8_t *dest, uint16_
     case PacketType::ReceiverCalPoint: payload_size = sizeof(packet.amplitudePoint); break;
     case PacketType::FrequencyCorrection: payload_size = sizeof(packet.frequencyCorrection); break;
     case PacketType::DeviceConfiguration: payload_size = sizeof(packet.deviceConfig); break;
+    case PacketType::DatapointFormat: payload_size = sizeof(packet.datapointFormat); break;
     case PacketType::Ack:
     case PacketType::PerformFirmwareUpdate:
     case PacketType::ClearFlash:
@@ -129,6 +441,7 @@ uint16_t Protocol::EncodePacket(const PacketInfo &packet, uint8_t *dest, uint16_
         // no payload
         break;
     case PacketType::VNADatapoint: payload_size = packet.VNAdatapoint->requiredBufferSize(); break;
+    case PacketType::VNADatapointBlock: payload_size = packet.VNAdatapointBlock->requiredBufferSize(); break;
     case PacketType::None:
         break;
     }
@@ -142,12 +455,18 @@ uint16_t Protocol::EncodePacket(const PacketInfo &packet, uint8_t *dest, uint16_
 	memcpy(&dest[PCKT_LENGTH_OFFSET], &overall_size, PCKT_LENGTH_LEN);
 	// Further encoding uses a special case for VNADatapoint packettype
 	uint32_t crc = 0x00000000;
-	if(packet.type == PacketType::VNADatapoint) {
-		// CRC calculation takes about 18us which is the bulk of the time required to encode and transmit a datapoint.
-		// Skip CRC for data points to optimize throughput
+	if(packet.type == PacketType::VNADatapoint || packet.type == PacketType::VNADatapointBlock) {
+		// The CRC of datapoints is optional: older host software rejects datapoints with a nonzero CRC (it used to be
+		// skipped because the bitwise CRC took about 18us per datapoint). Only calculate it if the host requested it.
 		dest[PCKT_TYPE_OFFSET] = (uint8_t) packet.type;
-		packet.VNAdatapoint->encode(&dest[PCKT_PAYLOAD_OFFSET], destsize - PCKT_EXCL_PAYLOAD_LEN);
-		crc = 0x00000000;
+		if(packet.type == PacketType::VNADatapoint) {
+			packet.VNAdatapoint->encode(&dest[PCKT_PAYLOAD_OFFSET], destsize - PCKT_EXCL_PAYLOAD_LEN);
+		} else {
+			packet.VNAdatapointBlock->encode(&dest[PCKT_PAYLOAD_OFFSET], destsize - PCKT_EXCL_PAYLOAD_LEN);
+		}
+		if(datapointCRC) {
+			crc = CRC32(0, dest, overall_size - PCKT_CRC_LEN);
+		}
 	} else {
 		// Copy rest of the packet
 		memcpy(&dest[PCKT_TYPE_OFFSET], &packet, payload_size + PCKT_TYPE_LEN); // one additional byte for the packet type
@@ -114,6 +114,10 @@ public:
     unsigned int getNumValues() {
         return num_values;
     }
+	// Direct access to the stored values (no conversion to double, no range check)
+	float getReal(unsigned int index) const {return real_values[index];}
+	float getImag(unsigned int index) const {return imag_values[index];}
+	uint8_t getDescription(unsigned int index) const {return descr_values[index];}
 
 	uint16_t requiredBufferSize() {
 		return DPNT_FREQ_LEN + DPNT_POW_LVL_LEN + DPNT_PNT_NUM_LEN +
@@ -133,6 +137,61 @@ private:
 	uint8_t num_values;
 };
 
+// IEEE 754 half precision (binary16) conversion, rounds to nearest
+uint16_t FloatToHalf(float f);
+float HalfToFloat(uint16_t h);
+
+/*
+ * Block of consecutive VNA points (PacketType::VNADatapointBlock). Sent instead of individual VNADatapoint packets if
+ * enabled by the host (see DatapointFormat). The points are encoded when they are added, the block only holds the
+ * encoded payload:
+ * - flags (1 byte), number of points (1 byte), values per point (1 byte), number of the first point (2 bytes)
+ * - description of the values (1 byte per value, the same for all points of the block)
+ * - per point: frequency/time (8 bytes, unless omitted), cdBm (2 bytes), real parts, imaginary parts
+ *
+ * Values are either float32 or float16. With float16, every point starts with an exponent (1 byte): the values have
+ * been multiplied by 2^exponent before the conversion to use the range of float16.
+ */
+class VNADatapointBlock {
+public:
+	enum Flags : uint8_t {
+		HalfPrecision = 0x01,
+		// the frequency of the points follows from the sweep settings, calculate it with getPointFrequency
+		FrequencyOmitted = 0x02,
+	};
+	// the complete packet fits into the transmit buffer of the firmware
+	static constexpr uint16_t maxPayloadSize = 512 - PCKT_EXCL_PAYLOAD_LEN;
+
+	VNADatapointBlock() {
+		clear(0);
+	}
+	// Removes all points, following points are encoded according to the flags
+	void clear(uint8_t flags);
+	// Returns false if the point can not be added to this block (block full, not consecutive or different values)
+	bool addPoint(VNADatapoint<32> &point);
+
+	uint8_t getFlags() const {return payload[0];}
+	uint8_t getNumPoints() const {return payload[1];}
+	bool getPoint(uint8_t index, VNADatapoint<32> &point) const;
+
+	uint16_t requiredBufferSize() const {return size;}
+	bool encode(uint8_t *dest, uint16_t destSize) const;
+	// Returns false if the payload is not a valid block
+	bool decode(const uint8_t *buffer, uint16_t size);
+
+	// Frequency of a point in a linear sweep (same calculation as in the firmware)
+	static uint64_t getPointFrequency(uint64_t f_start, uint64_t f_stop, uint16_t points, uint16_t pointNum) {
+		return points > 1 ? f_start + (f_stop - f_start) * pointNum / (points - 1) : f_start;
+	}
+
+private:
+	static constexpr uint16_t headerSize = 5;
+	uint16_t pointSize() const;
+
+	uint8_t payload[maxPayloadSize];
+	uint16_t size;
+};
+
 using Datapoint = struct _datapoint {
 	float real_S11, imag_S11;
 	float real_S21, imag_S21;
@@ -170,7 +229,8 @@ using SweepSettings = struct _sweepSettings {
 	 * 3: Trigger synchronization (not supported yet by hardware)
 	 */
 	uint8_t syncMode:2;
-	uint8_t unused1:1;
+	// if set, VNADatapoints are sent with a CRC. Older firmware ignores this bit and always sends a zero CRC
+	uint8_t datapointCRC:1;
 
 	uint16_t stages:3;
 	uint16_t port1Stage:3;
@@ -182,6 +242,15 @@ using SweepSettings = struct _sweepSettings {
     int16_t cdbm_excitation_stop; // in 1/100 dbm
 };
 
+using DatapointFormat = struct _datapointFormat {
+	// maximum number of points per VNADatapointBlock, 0 or 1 sends every point as a VNADatapoint
+	uint8_t pointsPerBlock;
+	uint8_t halfPrecision:1;
+	// leave out the frequency of the points in a linear sweep, it follows from the sweep settings
+	uint8_t omitFrequency:1;
+	uint8_t unused:6;
+};
+
 using ReferenceSettings = struct _referenceSettings {
 	uint32_t ExtRefOuputFreq;
 	uint8_t AutomaticSwitch:1;
@@ -489,7 +558,9 @@ enum class PacketType : uint8_t {
 	ClearTrigger = 29,
 	StopStatusUpdates = 30,
 	StartStatusUpdates = 31,
-	InitiateSweep = 32
+	InitiateSweep = 32,
+	VNADatapointBlock = 33,
+	DatapointFormat = 34,
 };
 
 using PacketInfo = struct _packetinfo {
@@ -509,18 +580,25 @@ using PacketInfo = struct _packetinfo {
         AmplitudeCorrectionPoint amplitudePoint;
         FrequencyCorrection frequencyCorrection;
         DeviceConfig deviceConfig;
+        DatapointFormat datapointFormat;
         /*
          * When encoding: Pointer may go invalid after call to EncodePacket
          * When decoding: VNADatapoint is created on heap by DecodeBuffer, freeing is up to the caller
          */
         VNADatapoint<32> *VNAdatapoint;
+        // same as VNAdatapoint
+        VNADatapointBlock *VNAdatapointBlock;
 	};
 };
 
 #pragma pack(pop)
 
+// Table driven (slicing-by-8)
 uint32_t CRC32(uint32_t crc, const void *data, uint32_t len);
+// Same result as CRC32 but calculated bit by bit. Much slower, only kept as a reference
+uint32_t CRC32Bitwise(uint32_t crc, const void *data, uint32_t len);
 uint16_t DecodeBuffer(uint8_t *buf, uint16_t len, PacketInfo *info);
-uint16_t EncodePacket(const PacketInfo &packet, uint8_t *dest, uint16_t destsize);
+// VNADatapoints are only protected by a CRC if datapointCRC is set (see SweepSettings::datapointCRC)
+uint16_t EncodePacket(const PacketInfo &packet, uint8_t *dest, uint16_t destsize, bool datapointCRC = false);
 
 }
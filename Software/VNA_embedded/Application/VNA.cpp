@@ -26,6 +26,11 @@ static uint8_t stageCnt;
 static uint32_t last_LO2;
 static double logMultiplier, logFrequency;
 static Protocol::VNADatapoint<32> data;
+// format of the running sweep and the format requested by the host for the next one
+static Protocol::DatapointFormat format = {};
+static Protocol::DatapointFormat nextFormat = {};
+static Protocol::VNADatapointBlock block;
+static uint32_t blockStartTime;
 static bool active = false;
 static bool waitingInStandby = false;
 static Si5351C::DriveStrength fixedPowerLowband;
@@ -45,6 +50,9 @@ static_assert(alternativePrescaler * alternativeSamplerate == 102400000UL, "alte
 static constexpr uint16_t alternativePhaseInc = 4096 * HW::DefaultIF2 / alternativeSamplerate;
 static_assert(alternativePhaseInc * alternativeSamplerate == 4096 * HW::DefaultIF2, "DFT can not be computed for 2.IF when using alternative samplerate");
 
+// points are not held back in an incomplete block for longer than this (in ms)
+static constexpr uint32_t maxBlockAge = 20;
+
 // Constants for USB buffer overflow prevention
 static constexpr uint16_t maxPointsBetweenHalts = 40;
 static constexpr uint32_t reservedUSBbuffer = maxPointsBetweenHalts * (sizeof(Protocol::Datapoint) + 8 /*USB packet overhead*/);
@@ -119,6 +127,7 @@ bool VNA::Setup(Protocol::SweepSettings s) {
 		settings.points = FPGA::MaxPoints;
 	}
 	settings = s;
+	Communication::SetDatapointCRC(s.datapointCRC);
 	// calculate factor between adjacent points for log sweep for faster calculation when sweeping
 	logMultiplier = pow((double) settings.f_stop / settings.f_start, 1.0 / (settings.points-1));
 	// Configure sweep
@@ -169,6 +178,17 @@ bool VNA::Setup(Protocol::SweepSettings s) {
 
 	zerospan = (s.f_start == s.f_stop) && (s.cdbm_excitation_start == s.cdbm_excitation_stop);
 
+	format = nextFormat;
+	uint8_t blockFlags = 0;
+	if(format.halfPrecision) {
+		blockFlags |= Protocol::VNADatapointBlock::HalfPrecision;
+	}
+	if(format.omitFrequency && !settings.logSweep && !zerospan) {
+		// the host calculates the frequency of the points in a linear sweep itself
+		blockFlags |= Protocol::VNADatapointBlock::FrequencyOmitted;
+	}
+	block.clear(blockFlags);
+
 	bool last_lowband = false;
 
 	uint16_t pointsWithoutHalt = 0;
@@ -292,14 +312,59 @@ void VNA::SetWaitingInStandby(bool waiting) {
 	waitingInStandby = waiting;
 }
 
-static void PassOnData() {
+void VNA::SetDatapointFormat(Protocol::DatapointFormat f) {
+	nextFormat = f;
+}
+
+static void SendBlock() {
+	if(!block.getNumPoints()) {
+		return;
+	}
 	Protocol::PacketInfo info;
-	info.type = Protocol::PacketType::VNADatapoint;
-	info.VNAdatapoint = &data;
+	info.type = Protocol::PacketType::VNADatapointBlock;
+	info.VNAdatapointBlock = &block;
 	Communication::Send(info);
+	block.clear(block.getFlags());
+}
+
+static void PassOnData() {
+	if(format.pointsPerBlock > 1) {
+		// combine consecutive points into blocks
+		if(!block.addPoint(data)) {
+			SendBlock();
+			block.addPoint(data);
+		}
+		if(block.getNumPoints() == 1) {
+			blockStartTime = HAL_GetTick();
+		}
+		if(block.getNumPoints() >= format.pointsPerBlock || data.pointNum == settings.points - 1
+				|| HAL_GetTick() - blockStartTime >= maxBlockAge) {
+			// the end of the sweep and old points are never held back
+			SendBlock();
+		}
+	} else {
+		Protocol::PacketInfo info;
+		info.type = Protocol::PacketType::VNADatapoint;
+		info.VNAdatapoint = &data;
+		Communication::Send(info);
+	}
 	data.clear();
 }
 
+static void SendOldBlock() {
+	if(block.getNumPoints() && HAL_GetTick() - blockStartTime >= maxBlockAge) {
+		SendBlock();
+	}
+}
+
+void VNA::SendPendingData(bool onlyOld) {
+	if(!active || format.pointsPerBlock <= 1) {
+		return;
+	}
+	// the block is filled in the interrupt context, it must only be sent from there as well
+	STM::DispatchToInterrupt(onlyOld ? SendOldBlock : SendBlock);
+}
+
 bool VNA::MeasurementDone(const FPGA::SamplingResult &result) {
 	if(!active) {
 		return false;
@@ -377,6 +442,8 @@ void VNA::SweepHalted() {
 	// are handled through the STM::DispatchToInterrupt functionality, ensuring that they do not interrupt each other
 	STM::DispatchToInterrupt([](){
 		LOG_DEBUG("Halted before point %d", pointCnt);
+		// the sweep might not resume for a while, do not hold back the points measured so far
+		SendBlock();
 		bool adcShiftRequired = false;
 		uint64_t frequency = getPointFrequency(pointCnt);
 		frequency = Cal::FrequencyCorrectionToDevice(frequency);
@@ -7,6 +7,10 @@
 namespace VNA {
 
 bool Setup(Protocol::SweepSettings s);
+// Takes effect with the next call of Setup
+void SetDatapointFormat(Protocol::DatapointFormat f);
+// Sends the points held back in an incomplete block (all of them or only those older than the block time limit)
+void SendPendingData(bool onlyOld);
 void InitiateSweep();
 bool GetStandbyMode();
 bool IsWaitingInStandby();